@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstring>
 #include <cstdio>
 #include <queue>
@@ -7,6 +8,7 @@
 #include "define/errors.h"
 #include "disk_structures.h"
 #include "block_access.h"
+#include "Disk.h"
 
 using namespace std;
 
@@ -163,6 +165,7 @@ int BPlusTree::bPlusInsert(Attribute val, recId recordId) {
 	num_of_entries = blockHeader.numEntries;
 
 	Index indices[num_of_entries + 1];
+	memset(indices, 0, sizeof(indices));  // keys as a leaf stores them (see getLeafKey())
 	Index current_leafEntry;
 	int current_leafEntryIndex = 0;
 	flag = 0;
@@ -205,17 +208,18 @@ int BPlusTree::bPlusInsert(Attribute val, recId recordId) {
 		current_leafEntryIndex++;
 	}
 
-	//leaf block has not reached max limit
-	if (num_of_entries != MAX_KEYS_LEAF) {
+	//leaf block has not reached max limit (the entries still fit in it together)
+	const int maxKeysInternal = getMaxKeysInternal();
+	const int middleIndexInternal = maxKeysInternal / 2;
+
+	if (getNumFittingLeaf(indices, current_leafEntryIndex) == current_leafEntryIndex) {
 
 		// increment blockHeader.numEntries and set this as header of block
 		blockHeader.numEntries = blockHeader.numEntries + 1;
 		setHeader(&blockHeader, blockNum);
 
-		// iterate through all the entries of indices array and populate the entries of block with them
-		for (int i = 0; i < current_leafEntryIndex; ++i) {
-			setLeafEntry(indices[i], blockNum, i);
-		}
+		// populate the entries of block with the entries of indices array
+		setLeafEntries(indices, current_leafEntryIndex, blockNum);
 
 		return SUCCESS;
 	} else { //leaf block is full- need a new leaf to make the entry; split the entries between the two blocks.
@@ -245,24 +249,31 @@ int BPlusTree::bPlusInsert(Attribute val, recId recordId) {
 		//store the block after leftBlk that appears in the linked list in prevRblock
 		int prevRblock = leftBlkHeader.rblock;
 
+		/*
+		 * the left block keeps the first half of the entries, and one more if there is an odd number
+		 * of them (91 of a full leaf for 2048 byte blocks); either half fits whatever its keys are
+		 */
+		const int leftKeys = (current_leafEntryIndex + 1) / 2;
+		const int rightKeys = current_leafEntryIndex - leftKeys;
+
 		/* Update left block header
-		 * - number of entries = 32
+		 * - number of entries = leftKeys
 		 * - right block = newRightBlkNum
 		 */
-		leftBlkHeader.numEntries = MIDDLE_INDEX_LEAF + 1;
+		leftBlkHeader.numEntries = leftKeys;
 		leftBlkHeader.rblock = newRightBlkNum;
 		setHeader(&leftBlkHeader, leftBlkNum);
 
 		//load the header of newRightBlk in newRightBlkHeader using BlockBuffer::getHeader()
 		HeadInfo newRightBlkHeader = getHeader(newRightBlkNum);
 		/* Update right block header
-		 * - number of entries = 32
+		 * - number of entries = rightKeys
 		 * - left block = leftBlkNum
 		 * - right block = prevRblock
 		 * - parent block = parent block of leftBlkNum
 		 */
 		newRightBlkHeader.blockType = IND_LEAF;
-		newRightBlkHeader.numEntries = MIDDLE_INDEX_LEAF + 1;
+		newRightBlkHeader.numEntries = rightKeys;
 		newRightBlkHeader.lblock = leftBlkNum;
 		newRightBlkHeader.pblock = leftBlkHeader.pblock;
 		newRightBlkHeader.rblock = prevRblock;
@@ -278,30 +289,16 @@ int BPlusTree::bPlusInsert(Attribute val, recId recordId) {
 		//store pblock of leftBlk in parBlkNum.
 		int parentBlock = leftBlkHeader.pblock;
 
-		// set the first 32 entries of leftBlk as the first 32 entries of indices array
-		int indices_iter;
-		for (indices_iter = 0; indices_iter <= MIDDLE_INDEX_LEAF; indices_iter++) {
-			setLeafEntry(indices[indices_iter], leftBlkNum, indices_iter);
-		}
-		// set the first 32 entries of newRightBlk as the next 32 entries of indices array
-		for (int rBlockIndexIter = 0; rBlockIndexIter <= MIDDLE_INDEX_LEAF; rBlockIndexIter++) {
-			setLeafEntry(indices[indices_iter], newRightBlkNum, rBlockIndexIter);
-			indices_iter++;
-		}
-		//********REPLACE
-		indices[0].attrVal.nval = 0;
-		indices[0].block = 0;
-		indices[0].slot = 0;
-		for (indices_iter = MIDDLE_INDEX_LEAF + 1; indices_iter < MAX_KEYS_LEAF; indices_iter++) {
-			setLeafEntry(indices[0], leftBlkNum, indices_iter);
-		}
+		// set the first half of the entries of indices array in leftBlk, and the second half in newRightBlk
+		setLeafEntries(indices, leftKeys, leftBlkNum);
+		setLeafEntries(indices + leftKeys, rightKeys, newRightBlkNum);
 
 		/*
-		 * store the attribute value of indices[31] in newAttrVal;
+		 * store the attribute value of indices[leftKeys - 1] in newAttrVal;
 		 * this is attribute value which needs to be inserted in the parent block
 		 */
 		Index leafentry;
-		leafentry = getLeafEntry(leftBlkNum, MIDDLE_INDEX_LEAF);
+		leafentry = indices[leftKeys - 1];
 		Attribute newAttrVal;
 
 		if (attrType == NUMBER)
@@ -310,6 +307,7 @@ int BPlusTree::bPlusInsert(Attribute val, recId recordId) {
 			strcpy(newAttrVal.sval, leafentry.attrVal.sval);
 
 		bool done = false;
+		int indices_iter;
 
 		/******Traverse the internal index blocks of the B+ Tree bottom up making insertions wherever required******/
 		//let done indicate whether the insertion is complete or not
@@ -371,7 +369,7 @@ int BPlusTree::bPlusInsert(Attribute val, recId recordId) {
 				}
 
 				// parentBlock has not reached max limit.
-				if (parentHeader.numEntries != MAX_KEYS_INTERNAL) {
+				if (parentHeader.numEntries != maxKeysInternal) {
 					// increment parheader.numEntries and update it as header of parblk
 					parentHeader.numEntries = parentHeader.numEntries + 1;
 					setHeader(&parentHeader, parentBlock);
@@ -408,25 +406,25 @@ int BPlusTree::bPlusInsert(Attribute val, recId recordId) {
 					leftBlkHeader = parentHeader;
 
 					/* Update left block header
-					   * - number of entries = 50
+					   * - number of entries = middleIndexInternal (50 for 2048 byte blocks)
 					   */
-					leftBlkHeader.numEntries = MIDDLE_INDEX_INTERNAL;
+					leftBlkHeader.numEntries = middleIndexInternal;
 					setHeader(&leftBlkHeader, leftBlkNum);
 
 					//load newRightBlkHeader
 					newRightBlkHeader = getHeader(newRightBlkNum);
 
 					/* Update right block header
-					   * - number of entries = 50
+					   * - number of entries = middleIndexInternal
 					   * - parent block = parent block of leftBlkNum
 					   */
 					newRightBlkHeader.blockType = IND_INTERNAL;
-					newRightBlkHeader.numEntries = MIDDLE_INDEX_INTERNAL;
+					newRightBlkHeader.numEntries = middleIndexInternal;
 					newRightBlkHeader.pblock = leftBlkHeader.pblock;
 					setHeader(&newRightBlkHeader, newRightBlkNum);
 
-					// set the first 50 entries of leftBlk as the first 50 entries of internalEntries array
-					for (indices_iter = 0; indices_iter < MIDDLE_INDEX_INTERNAL; ++indices_iter) {
+					// set the first middleIndexInternal entries of leftBlk as the first entries of internalEntries array
+					for (indices_iter = 0; indices_iter < middleIndexInternal; ++indices_iter) {
 						// TODO ::: REVIEW ::::
 //						if ((internal_entries[indices_iter].lChild == parentBlock) ||
 //						    (internal_entries[indices_iter].rChild == parentBlock)) {
@@ -443,16 +441,16 @@ int BPlusTree::bPlusInsert(Attribute val, recId recordId) {
 						setInternalEntry(internal_entries[indices_iter], leftBlkNum, indices_iter);
 					}
 
-					indices_iter = MIDDLE_INDEX_INTERNAL + 1;
-					// set the first 50 entries of newRightBlk as the entries from 51 to 100 of internalEntries array
-					for (int j = 0; j < MIDDLE_INDEX_INTERNAL; ++j) {
+					indices_iter = middleIndexInternal + 1;
+					// set the entries of newRightBlk as the entries after the middle entry of internalEntries array
+					for (int j = 0; j < middleIndexInternal; ++j) {
 						setInternalEntry(internal_entries[indices_iter], newRightBlkNum, j);
 						indices_iter++;
 					}
 
 					int childNum;
-					//iterate from 50 to 100:
-					for (int k = MIDDLE_INDEX_INTERNAL; k <= MAX_KEYS_INTERNAL; ++k) {
+					//iterate from middleIndexInternal to maxKeysInternal:
+					for (int k = middleIndexInternal; k <= maxKeysInternal; ++k) {
 						//assign the rchild block of ith index in internalEntries to childNum
 						childNum = internal_entries[k].rChild;
 
@@ -465,10 +463,10 @@ int BPlusTree::bPlusInsert(Attribute val, recId recordId) {
 					//update parBlkNum as the pblock of leftBlk.
 					parentBlock = leftBlkHeader.pblock;
 
-					/* update newAttrval to the attribute value of 50th entry in the internalEntries array;
+					/* update newAttrval to the attribute value of the middle entry in the internalEntries array;
 					 * this is attribute value which needs to be inserted in the parent block.
 					 */
-					newAttrVal = internal_entries[MIDDLE_INDEX_INTERNAL].attrVal;
+					newAttrVal = internal_entries[middleIndexInternal].attrVal;
 
 				}
 			} else //if parent == -1 i.e root is split now
@@ -745,15 +743,162 @@ recId BPlusTree::BPlusSearch(Attribute attrVal, int op, recId *prev_indexId) {
 	return {-1, -1};
 }
 
+/*
+ * Builds a B+ tree bottom-up from entries sorted on their attribute value and returns its root block,
+ * or E_DISKFULL (after releasing the blocks taken so far) if the disk runs out of blocks
+ *      - The leaves are filled in order and linked left to right
+ *      - Each level of internal blocks is then built over the one below it, with the entry between
+ *        two children holding the largest value of the left one (as a split in bPlusInsert leaves it)
+ *      - Each leaf takes as many entries as fit in it (see getNumFittingLeaf()), the last two sharing
+ *        what is left; the entries of an internal level are spread evenly over its blocks. Either way
+ *        no block is left with too few
+ */
+int BPlusTree::bulkLoad(std::vector<Index> &entries) {
+	std::vector<int> allocated;
+	bool diskFull = false;
+
+	/******Fill the leaves******/
+	const int numEntries = entries.size();
+
+	std::vector<int> level;          // blocks of the level being built
+	std::vector<Attribute> maxVals;  // largest attribute value under each of them
+	int next = 0;
+	while (next < numEntries || level.empty()) {
+		int leafBlockNum = getFreeBlock(IND_LEAF);
+		if (leafBlockNum == FAILURE) {
+			diskFull = true;
+			break;
+		}
+		allocated.push_back(leafBlockNum);
+
+		// (fewer of the entries always fit, so the leaf can give some of them to the next one)
+		int count = 0;
+		if (next < numEntries) {
+			count = getNumFittingLeaf(entries.data() + next, numEntries - next);
+			const int rest = numEntries - next - count;
+			if (rest > 0 && rest < count / 2)
+				count = (count + rest + 1) / 2;
+		}
+
+		HeadInfo leafHeader;
+		memset(&leafHeader, 0, sizeof(HeadInfo));
+		leafHeader.blockType = IND_LEAF;
+		leafHeader.pblock = -1;
+		leafHeader.lblock = level.empty() ? -1 : level.back();
+		leafHeader.rblock = -1;
+		leafHeader.numEntries = count;
+		setHeader(&leafHeader, leafBlockNum);
+
+		setLeafEntries(entries.data() + next, count, leafBlockNum);
+
+		// link the previous leaf to this one
+		if (!level.empty()) {
+			HeadInfo prevHeader = getHeader(level.back());
+			prevHeader.rblock = leafBlockNum;
+			setHeader(&prevHeader, level.back());
+		}
+
+		level.push_back(leafBlockNum);
+		Attribute maxVal;
+		memset(&maxVal, 0, sizeof(Attribute));
+		maxVals.push_back(count > 0 ? entries[next + count - 1].attrVal : maxVal);
+		next += count;
+	}
+
+	/******Build the internal levels up to the root******/
+	const int maxChildren = getMaxKeysInternal() + 1;
+	while (!diskFull && level.size() > 1) {
+		const int numChildren = level.size();
+		const int numNodes = (numChildren + maxChildren - 1) / maxChildren;
+
+		std::vector<int> parentLevel;
+		std::vector<Attribute> parentMaxVals;
+		int first = 0;
+		for (int nodeIndex = 0; nodeIndex < numNodes; nodeIndex++) {
+			int nodeBlockNum = getFreeBlock(IND_INTERNAL);
+			if (nodeBlockNum == FAILURE) {
+				diskFull = true;
+				break;
+			}
+			allocated.push_back(nodeBlockNum);
+
+			const int count = numChildren / numNodes + (nodeIndex < numChildren % numNodes ? 1 : 0);
+
+			HeadInfo nodeHeader;
+			memset(&nodeHeader, 0, sizeof(HeadInfo));
+			nodeHeader.blockType = IND_INTERNAL;
+			nodeHeader.pblock = -1;
+			nodeHeader.lblock = -1;
+			nodeHeader.rblock = -1;
+			nodeHeader.numEntries = count - 1;
+			setHeader(&nodeHeader, nodeBlockNum);
+
+			for (int i = 0; i < count - 1; i++) {
+				InternalEntry entry;
+				entry.lChild = level[first + i];
+				entry.attrVal = maxVals[first + i];
+				entry.rChild = level[first + i + 1];
+				setInternalEntry(entry, nodeBlockNum, i);
+			}
+
+			// the children get the new block as their parent
+			for (int i = 0; i < count; i++) {
+				HeadInfo childHeader = getHeader(level[first + i]);
+				childHeader.pblock = nodeBlockNum;
+				setHeader(&childHeader, level[first + i]);
+			}
+
+			parentLevel.push_back(nodeBlockNum);
+			parentMaxVals.push_back(maxVals[first + count - 1]);
+			first += count;
+		}
+		level.swap(parentLevel);
+		maxVals.swap(parentMaxVals);
+	}
+
+	if (diskFull) {
+		for (int blockNum : allocated)
+			deleteBlock(blockNum);
+		return E_DISKFULL;
+	}
+	return level[0];
+}
+
 int BPlusTree::getRootBlock() {
 	return this->rootBlock;
 }
 
+/*
+ * Number of keys that fit in an internal index block of the current block size
+ * (one leading lChild followed by attrVal, rChild pairs). Kept even so that a
+ * split of a full block leaves the same number of entries on both sides.
+ */
+int BPlusTree::getMaxKeysInternal() {
+	int maxKeys = (Disk::getBlockSize() - HEADER_SIZE - LCHILD_SIZE) / (ATTR_SIZE + RCHILD_SIZE);
+	return maxKeys & ~1;
+}
+
+/*
+ * Number of keys a leaf index block of the current block size holds at most.
+ * Odd for every supported block size, so a split leaves both halves the same size.
+ *      - a prefix compressed leaf holds twice as many entries with keys of ATTR_SIZE bytes, less
+ *        one, so that a split of a full leaf leaves two halves that fit whatever their keys are
+ *        (181 for 2048 byte blocks); how many fit below that depends on the keys
+ *        (see getNumFittingLeaf())
+ */
+int BPlusTree::getMaxKeysLeaf() {
+	if (Disk::getFormatVersion() < PREFIX_LEAF_VERSION)
+		return (Disk::getBlockSize() - HEADER_SIZE) / LEAF_ENTRY_SIZE;
+
+	int minKeys = (Disk::getBlockSize() - HEADER_SIZE - LEAF_PREFIX_INFO_SIZE) / (ATTR_SIZE + LEAF_RECID_SIZE);
+	return 2 * minKeys - 1;
+}
+
 int BPlusTree::bPlusDestroy(int blockNum) {
 	HeadInfo header;
 
 	// if the block_num lies outside valid range
-	if (blockNum < 0 || blockNum >= DISK_BLOCKS) {
+	if (blockNum < 0 || blockNum >= Disk::getNumBlocks()) {
 		return E_OUTOFBOUND;
 	}
 	header = getHeader(blockNum);
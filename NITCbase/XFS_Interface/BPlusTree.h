@@ -1,6 +1,7 @@
 #ifndef NITCBASE_BPLUSTREE_H
 #define NITCBASE_BPLUSTREE_H
 
+#include <vector>
 #include "define/constants.h"
 #include "define/errors.h"
 #include "disk_structures.h"
@@ -17,6 +18,9 @@ public:
 	int bPlusInsert(union Attribute attrVal, recId recordId);
 	recId BPlusSearch(union Attribute attrVal, int op, recId *prev_indexId);
 	static int bPlusDestroy(int blockNum);
+	static int bulkLoad(std::vector<Index> &entries);
+	static int getMaxKeysInternal();
+	static int getMaxKeysLeaf();
 };
 
 #endif //NITCBASE_BPLUSTREE_H
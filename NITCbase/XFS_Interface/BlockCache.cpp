@@ -0,0 +1,96 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include "define/constants.h"
+#include "BlockCache.h"
+#include "Disk.h"
+
+std::list<BlockCache::CachedBlock> BlockCache::blocks;
+std::unordered_map<int, std::list<BlockCache::CachedBlock>::iterator> BlockCache::index;
+int BlockCache::diskFd = -1;
+
+int BlockCache::openDisk() {
+	if (diskFd < 0)
+		diskFd = open(&DISK_PATH[0], O_RDWR);
+	return diskFd;
+}
+
+int BlockCache::writeBack(CachedBlock &block) {
+	if (!block.dirty)
+		return SUCCESS;
+	if (openDisk() < 0 ||
+	    pwrite(diskFd, block.data.data(), block.data.size(), Disk::getBlockOffset(block.blockNum)) !=
+	        (ssize_t) block.data.size())
+		return FAILURE;
+	block.dirty = false;
+	return SUCCESS;
+}
+
+/*
+ * Returns the cached image of the 'blockNum'th block, reading it from the disk if it is not cached
+ *      - The cache holds at most BLOCK_CACHE_SIZE bytes of blocks; the least recently used
+ *        block is dropped (and written back if it was changed) to make room
+ */
+unsigned char *BlockCache::getBlock(int blockNum) {
+	auto found = index.find(blockNum);
+	if (found != index.end()) {
+		blocks.splice(blocks.begin(), blocks, found->second);
+		return blocks.front().data.data();
+	}
+
+	const int blockSize = Disk::getBlockSize();
+	const size_t capacity = std::max(BLOCK_CACHE_SIZE / blockSize, 1);
+	if (blocks.size() >= capacity) {
+		// reuse the buffer of the least recently used block
+		writeBack(blocks.back());
+		index.erase(blocks.back().blockNum);
+		blocks.splice(blocks.begin(), blocks, std::prev(blocks.end()));
+	} else {
+		blocks.emplace_front();
+	}
+
+	CachedBlock &block = blocks.front();
+	block.blockNum = blockNum;
+	block.dirty = false;
+	block.data.resize(blockSize);
+	if (openDisk() < 0 ||
+	    pread(diskFd, block.data.data(), blockSize, Disk::getBlockOffset(blockNum)) != blockSize)
+		std::fill(block.data.begin(), block.data.end(), 0);
+	index[blockNum] = blocks.begin();
+	return block.data.data();
+}
+
+/*
+ * Marks the cached 'blockNum'th block as changed, to be written back to the disk
+ */
+void BlockCache::markDirty(int blockNum) {
+	auto found = index.find(blockNum);
+	if (found != index.end())
+		found->second->dirty = true;
+}
+
+/*
+ * Writes every changed block back to the disk
+ */
+int BlockCache::flush() {
+	int ret = SUCCESS;
+	for (CachedBlock &block : blocks) {
+		if (writeBack(block) != SUCCESS)
+			ret = FAILURE;
+	}
+	return ret;
+}
+
+/*
+ * Drops every cached block without writing it back (call flush() first to keep the changes)
+ * and closes the disk file, for when the disk is recreated, formatted or grown outside the cache
+ */
+void BlockCache::invalidate() {
+	blocks.clear();
+	index.clear();
+	if (diskFd >= 0) {
+		close(diskFd);
+		diskFd = -1;
+	}
+}
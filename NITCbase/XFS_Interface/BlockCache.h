@@ -0,0 +1,40 @@
+#ifndef NITCBASE_BLOCKCACHE_H
+#define NITCBASE_BLOCKCACHE_H
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * LRU cache of disk blocks shared by every command of the tool. A block is read
+ * from the disk once, the first time it is needed, and every header, slot map,
+ * record or index entry of it is then read and written in memory. Changed blocks
+ * are written back when they are evicted and by flush(), which runs after every
+ * command.
+ *
+ * A pointer returned by getBlock() stays valid only until the next call to
+ * getBlock(), which may evict the block.
+ */
+class BlockCache {
+public:
+	static unsigned char *getBlock(int blockNum);
+	static void markDirty(int blockNum);
+	static int flush();
+	static void invalidate();
+
+private:
+	struct CachedBlock {
+		int blockNum;
+		bool dirty;
+		std::vector<unsigned char> data;
+	};
+
+	static std::list<CachedBlock> blocks; // most recently used first
+	static std::unordered_map<int, std::list<CachedBlock>::iterator> index;
+	static int diskFd;
+
+	static int openDisk();
+	static int writeBack(CachedBlock &block);
+};
+
+#endif //NITCBASE_BLOCKCACHE_H
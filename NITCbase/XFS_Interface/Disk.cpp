@@ -1,24 +1,60 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <string>
+#include <iostream>
+#include <random>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "define/constants.h"
 #include "Disk.h"
 #include "disk_structures.h"
 #include "block_access.h"
+#include "BlockCache.h"
 
-int Disk::createDisk() {
-	FILE *disk = fopen(&DISK_PATH[0], "wb+");
-	if(disk == nullptr)
+/*
+ * Syncs the directory of the disk to storage, so that the files created, renamed or deleted in it
+ * stay that way
+ */
+static int syncDirectory() {
+	int dir = open(&DISK_DIR_PATH[0], O_RDONLY | O_DIRECTORY);
+	if (dir < 0)
 		return FAILURE;
-	fseek(disk, 0, SEEK_SET);
+	int ret = fsync(dir) == 0 ? SUCCESS : FAILURE;
+	close(dir);
+	return ret;
+}
 
-	// 16 MB
-	for(int i=0; i < DISK_SIZE; i++){
-		fputc(0,disk);
-	}
+int Disk::blockSize = LEGACY_BLOCK_SIZE;
+int Disk::numBlocks = LEGACY_DISK_BLOCKS;
+int Disk::formatVersion = 1;
+int Disk::diskId = 0;
+int Disk::checkpointLsn = 0;
+std::vector<int> Disk::mapBlocks;
 
-	fclose(disk);
-	return SUCCESS;
+/*
+ * Creates an empty disk of numBlocks blocks of blockSize bytes (16 MB by default)
+ * The file is only truncated to its size, so it is sparse: blocks that were never
+ * written take no space and read as zeros.
+ * The write-ahead log of the old disk is deleted, its changes are of no use to the new one,
+ * and so is a copy of the old disk left by an interrupted upgrade (see backUp()).
+ */
+int Disk::createDisk(int blockSize, int numBlocks) {
+	BlockCache::invalidate();
+	if (unlink(&DISK_WAL_PATH[0]) != 0 && errno != ENOENT)
+		return FAILURE;
+	if (unlink(&DISK_BACKUP_PATH[0]) != 0 && errno != ENOENT)
+		return FAILURE;
+	int disk = open(&DISK_PATH[0], O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (disk < 0)
+		return FAILURE;
+	int ret = ftruncate(disk, (off_t) numBlocks * blockSize) == 0 ? SUCCESS : FAILURE;
+	close(disk);
+	return ret;
 }
 
 Disk::~Disk() {
@@ -26,53 +62,343 @@ Disk::~Disk() {
 }
 
 int Disk::readBlock(unsigned char *block, int blockNum) {
+	if (blockNum < 0 || blockNum >= numBlocks)
+		return E_OUTOFBOUND;
+	memcpy(block, BlockCache::getBlock(blockNum), blockSize);
+	return SUCCESS;
+}
+
+int Disk::writeBlock(unsigned char *block, int blockNum) {
+	if (blockNum < 0 || blockNum >= numBlocks)
+		return E_OUTOFBOUND;
+	memcpy(BlockCache::getBlock(blockNum), block, blockSize);
+	BlockCache::markDirty(blockNum);
+	return SUCCESS;
+}
+
+/*
+ * Reads the geometry of the disk (block size, number of blocks and the blocks
+ * holding the block allocation map) from the superblock.
+ * Disks formatted before the superblock was introduced have no magic string
+ * and are read with the legacy geometry.
+ */
+void Disk::loadSuperBlock() {
+	blockSize = LEGACY_BLOCK_SIZE;
+	numBlocks = LEGACY_DISK_BLOCKS;
+	formatVersion = 1;
+	diskId = 0;
+	checkpointLsn = 0;
+	mapBlocks.clear();
+
 	FILE *disk = fopen(&DISK_PATH[0], "rb");
-	const int offset = blockNum * BLOCK_SIZE;
-	fseek(disk, offset, SEEK_SET);
-	fread(block, BLOCK_SIZE, 1, disk);
+	SuperBlock superBlock;
+	bool found = disk != nullptr && fread(&superBlock, sizeof(SuperBlock), 1, disk) == 1 &&
+	             memcmp(superBlock.magic, DISK_MAGIC, sizeof(superBlock.magic)) == 0;
+
+	if (found && superBlock.formatVersion <= DISK_FORMAT_VERSION && superBlock.blockSize >= MIN_BLOCK_SIZE &&
+	    superBlock.blockSize <= MAX_BLOCK_SIZE) {
+		blockSize = superBlock.blockSize;
+		numBlocks = superBlock.numBlocks;
+		formatVersion = superBlock.formatVersion;
+		diskId = superBlock.diskId;
+		checkpointLsn = superBlock.checkpointLsn;
+
+		mapBlocks.resize(superBlock.numMapBlocks);
+		fseeko(disk, (off_t) SUPERBLOCK * blockSize + HEADER_SIZE, SEEK_SET);
+		fread(mapBlocks.data(), sizeof(int32_t), superBlock.numMapBlocks, disk);
+	} else {
+		if (found)
+			std::cout << "Unsupported disk format version " << superBlock.formatVersion
+			          << ", reading it as a legacy disk" << std::endl;
+		for (int i = 0; i < LEGACY_BLOCK_ALLOCATION_MAP_SIZE; i++)
+			mapBlocks.push_back(i);
+	}
+
+	if (disk != nullptr)
+		fclose(disk);
+}
+
+int Disk::getBlockSize() {
+	return blockSize;
+}
+
+int Disk::getNumBlocks() {
+	return numBlocks;
+}
+
+int Disk::getFormatVersion() {
+	return formatVersion;
+}
+
+int Disk::getNumMapBlocks() {
+	return mapBlocks.size();
+}
+
+/*
+ * Block number of the 'mapBlockIndex'th block of the block allocation map
+ */
+int Disk::getMapBlock(int mapBlockIndex) {
+	return mapBlocks[mapBlockIndex];
+}
+
+/*
+ * Whether the write-ahead log of the disk holds changes NITCbase has not written to the disk yet
+ *      - a log left behind by a NITCbase that did not shut down cleanly; the next start of NITCbase
+ *        replays it, so the tool must not change the disk until then
+ *      - a log of another disk (see SuperBlock.diskId) or of another block size is never replayed
+ */
+bool Disk::hasPendingLog() {
+	FILE *log = fopen(&DISK_WAL_PATH[0], "rb");
+	if (log == nullptr)
+		return false;
+	LogFileHeader header;
+	bool found = fread(&header, sizeof(LogFileHeader), 1, log) == 1 &&
+	             memcmp(header.magic, WAL_MAGIC, sizeof(header.magic)) == 0;
+	struct stat logStat;
+	bool hasRecords = fstat(fileno(log), &logStat) == 0 && logStat.st_size > (off_t) sizeof(LogFileHeader);
+	fclose(log);
+	return found && hasRecords && header.diskId == diskId && header.blockSize == blockSize;
+}
+
+/*
+ * Byte offset of the 'blockNum'th block in the disk file
+ */
+off_t Disk::getBlockOffset(int blockNum) {
+	return (off_t) blockNum * blockSize;
+}
+
+/*
+ * Byte offset in the disk file of the block allocation map entry of the 'blockNum'th block
+ */
+off_t Disk::getAllocMapOffset(int blockNum) {
+	return getBlockOffset(mapBlocks[blockNum / blockSize]) + blockNum % blockSize;
+}
+
+/*
+ * Extends the disk by DISK_GROW_SIZE bytes (at least one block)
+ *      - Blocks for the block allocation map entries of the new blocks are taken from
+ *        the start of the new region and appended to the map block list in the superblock
+ *      - The new blocks are marked UNUSED_BLK in the block allocation map
+ * Legacy disks have no superblock to record the new size in and cannot grow.
+ * Returns SUCCESS, or E_DISKFULL if the disk cannot grow any further.
+ */
+int Disk::growDisk() {
+	if (formatVersion < 2)
+		return E_DISKFULL;
+
+	// the superblock holds at most (blockSize - HEADER_SIZE) / 4 map block numbers
+	long long maxBlocks = (long long) (blockSize - HEADER_SIZE) / sizeof(int32_t) * blockSize;
+	if (maxBlocks > INT32_MAX)
+		maxBlocks = INT32_MAX;
+	long long newNumBlocks = numBlocks + std::max(DISK_GROW_SIZE / blockSize, 1);
+	if (newNumBlocks > maxBlocks)
+		newNumBlocks = maxBlocks;
+	if (newNumBlocks <= numBlocks)
+		return E_DISKFULL;
+
+	// the new blocks are written to the file directly
+	BlockCache::flush();
+	BlockCache::invalidate();
+
+	const int oldNumBlocks = numBlocks;
+	const int oldNumMapBlocks = mapBlocks.size();
+	const int numMapBlocks = (newNumBlocks + blockSize - 1) / blockSize;
+	for (int blockNum = oldNumBlocks; (int) mapBlocks.size() < numMapBlocks; blockNum++)
+		mapBlocks.push_back(blockNum);
+
+	if (truncate(&DISK_PATH[0], (off_t) newNumBlocks * blockSize) != 0) {
+		mapBlocks.resize(oldNumMapBlocks);
+		return E_DISKFULL;
+	}
+	numBlocks = newNumBlocks;
+
+	FILE *disk = fopen(&DISK_PATH[0], "rb+");
+
+	// new map blocks: entries past the end of the disk are never handed out
+	std::vector<unsigned char> page(blockSize, (unsigned char) BMAP);
+	for (int mapIndex = oldNumMapBlocks; mapIndex < numMapBlocks; mapIndex++) {
+		fseeko(disk, getBlockOffset(mapBlocks[mapIndex]), SEEK_SET);
+		fwrite(page.data(), blockSize, 1, disk);
+	}
+
+	// the entries of the new blocks (after the new map blocks) are written as one run per map block
+	std::fill(page.begin(), page.end(), (unsigned char) UNUSED_BLK);
+	for (int blockNum = oldNumBlocks + numMapBlocks - oldNumMapBlocks; blockNum < numBlocks;) {
+		int runLength = std::min(blockSize - blockNum % blockSize, numBlocks - blockNum);
+		fseeko(disk, getAllocMapOffset(blockNum), SEEK_SET);
+		fwrite(page.data(), runLength, 1, disk);
+		blockNum += runLength;
+	}
+
 	fclose(disk);
+	writeSuperBlock();
+
+	return SUCCESS;
 }
 
-int Disk::writeBlock(unsigned char *block, int blockNum) {
+/*
+ * Sets the format version the disk is read and written with
+ * The superblock keeps the old version until writeSuperBlock() is called
+ */
+void Disk::setFormatVersion(int version) {
+	formatVersion = version;
+}
+
+/*
+ * Writes the geometry and the format version of the disk, and the list of its
+ * block allocation map blocks, to the superblock (straight to the file)
+ */
+void Disk::writeSuperBlock() {
+	SuperBlock superBlock;
+	memset(&superBlock, 0, sizeof(SuperBlock));
+	memcpy(superBlock.magic, DISK_MAGIC, sizeof(superBlock.magic));
+	superBlock.formatVersion = formatVersion;
+	superBlock.blockSize = blockSize;
+	superBlock.numBlocks = numBlocks;
+	superBlock.numMapBlocks = mapBlocks.size();
+	superBlock.diskId = diskId;
+	superBlock.checkpointLsn = checkpointLsn;
+	std::vector<int32_t> mapBlockNums(mapBlocks.begin(), mapBlocks.end());
+
 	FILE *disk = fopen(&DISK_PATH[0], "rb+");
-	int offset = blockNum * BLOCK_SIZE;
-	fseek(disk, offset, SEEK_SET);
-	fwrite(block, BLOCK_SIZE, 1, disk);
+	fseeko(disk, (off_t) SUPERBLOCK * blockSize, SEEK_SET);
+	fwrite(&superBlock, sizeof(SuperBlock), 1, disk);
+	fseeko(disk, (off_t) SUPERBLOCK * blockSize + HEADER_SIZE, SEEK_SET);
+	fwrite(mapBlockNums.data(), sizeof(int32_t), mapBlockNums.size(), disk);
 	fclose(disk);
 }
 
+/*
+ * Copies the disk to DISK_BACKUP_PATH, before it is converted in place
+ *      - The copy is written to DISK_BACKUP_TEMP_PATH and synced to storage before it is renamed,
+ *        so DISK_BACKUP_PATH only ever holds a complete copy
+ *      - Until dropBackup() deletes it, the next start of the tool puts the copy back (see
+ *        restoreBackup()) and NITCbase refuses to open the disk
+ */
+int Disk::backUp() {
+	BlockCache::flush();
+	int disk = open(&DISK_PATH[0], O_RDONLY);
+	if (disk < 0)
+		return FAILURE;
+	int backup = open(&DISK_BACKUP_TEMP_PATH[0], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (backup < 0) {
+		close(disk);
+		return FAILURE;
+	}
+
+	std::vector<char> buffer(DISK_COPY_BUFFER_SIZE);
+	int ret = SUCCESS;
+	ssize_t length = 0;
+	while (ret == SUCCESS && (length = read(disk, buffer.data(), buffer.size())) > 0) {
+		if (write(backup, buffer.data(), length) != length)
+			ret = FAILURE;
+	}
+	if (length < 0 || fsync(backup) != 0)
+		ret = FAILURE;
+	close(disk);
+	if (close(backup) != 0)
+		ret = FAILURE;
+
+	if (ret != SUCCESS || rename(&DISK_BACKUP_TEMP_PATH[0], &DISK_BACKUP_PATH[0]) != 0) {
+		unlink(&DISK_BACKUP_TEMP_PATH[0]);
+		return FAILURE;
+	}
+	return syncDirectory();
+}
+
+/*
+ * Writes the changes to the disk out, syncs it to storage and deletes the copy backUp() made,
+ * once the disk has been converted
+ */
+int Disk::dropBackup() {
+	if (BlockCache::flush() != SUCCESS)
+		return FAILURE;
+	BlockCache::invalidate();
+	int disk = open(&DISK_PATH[0], O_RDWR);
+	if (disk < 0)
+		return FAILURE;
+	int ret = fsync(disk) == 0 ? SUCCESS : FAILURE;
+	close(disk);
+	if (ret != SUCCESS || unlink(&DISK_BACKUP_PATH[0]) != 0)
+		return FAILURE;
+	return syncDirectory();
+}
+
+/*
+ * Puts back the copy of the disk backUp() made, if a conversion of the disk was interrupted
+ * before dropBackup() deleted it (call before loadSuperBlock())
+ *      - The copy replaces the disk in a single rename
+ * Returns whether there was a copy to put back.
+ */
+bool Disk::restoreBackup() {
+	unlink(&DISK_BACKUP_TEMP_PATH[0]);
+	if (rename(&DISK_BACKUP_PATH[0], &DISK_PATH[0]) != 0)
+		return false;
+	BlockCache::invalidate();
+	syncDirectory();
+	return true;
+}
+
 /*
  * Formats the disk
+ * Write the superblock and the block allocation map
  * Set the reserved_blocks entries in block allocation map
  * Set Relcat and Attrcat
+ *
+ * The block allocation map takes ceil(numBlocks / blockSize) blocks. The first
+ * three of them are blocks 1-3 (as on the legacy disk) so that the catalogs stay
+ * in blocks 4 and 5; any further map blocks follow the catalogs from block 6.
  */
-void Disk::formatDisk() {
-	FILE *disk = fopen(&DISK_PATH[0], "wb+");
-	const int reserved_blocks = 6;
-	const int offset = DISK_SIZE;
+void Disk::formatDisk(int blockSize, int numBlocks) {
+	BlockCache::invalidate();
+	const int numMapBlocks = (numBlocks + blockSize - 1) / blockSize;
 
-	fseek(disk, 0, SEEK_SET);
-	unsigned char blockAllocationMap[BLOCK_SIZE * BLOCK_ALLOCATION_MAP_SIZE];
+	std::vector<int32_t> mapBlockNums;
+	for (int i = 0; i < numMapBlocks; i++)
+		mapBlockNums.push_back(i < 3 ? i + 1 : ATTRCAT_BLOCK + i - 2);
+	const int reserved_blocks = numMapBlocks <= 3 ? ATTRCAT_BLOCK + 1 : mapBlockNums.back() + 1;
+
+	std::vector<unsigned char> blockAllocationMap(numMapBlocks * blockSize, (unsigned char) UNUSED_BLK);
 
 	// reserved_blocks Entries in Block Allocation Map (Used)
 	for (int i = 0; i < reserved_blocks; i++) {
-		if (i >= 0 && i <= 3)
-            blockAllocationMap[i] = (unsigned char) BMAP;
+		if (i == RELCAT_BLOCK || i == ATTRCAT_BLOCK)
+			blockAllocationMap[i] = (unsigned char) REC;
 		else
-            blockAllocationMap[i] = (unsigned char) REC;
-	}
-
-	// Remaining Entries in Block Allocation Map are marked Unused
-	for (int i = reserved_blocks; i < BLOCK_SIZE * BLOCK_ALLOCATION_MAP_SIZE; i++)
-        blockAllocationMap[i] = (unsigned char) UNUSED_BLK;
-	fwrite(blockAllocationMap, BLOCK_SIZE * BLOCK_ALLOCATION_MAP_SIZE, 1, disk);
-
-	// Remaining Locations of Disk initialised to 0
-	for (int i = BLOCK_SIZE * BLOCK_ALLOCATION_MAP_SIZE; i < offset; i++) {
-		fputc(0, disk);
+			blockAllocationMap[i] = (unsigned char) BMAP;
 	}
-	fclose(disk);
-
+	// Entries past the end of the disk are never handed out
+	for (int i = numBlocks; i < numMapBlocks * blockSize; i++)
+		blockAllocationMap[i] = (unsigned char) BMAP;
+
+	// Every location of the disk is initialised to 0: truncating the file to no size and back
+	// leaves it sparse, so only the superblock and the map blocks below are actually written
+	int disk = open(&DISK_PATH[0], O_RDWR | O_CREAT, 0644);
+	ftruncate(disk, 0);
+	ftruncate(disk, (off_t) numBlocks * blockSize);
+
+	// Superblock followed by the list of block allocation map blocks
+	std::vector<unsigned char> block(blockSize, 0);
+	SuperBlock superBlock;
+	memset(&superBlock, 0, sizeof(SuperBlock));
+	memcpy(superBlock.magic, DISK_MAGIC, sizeof(superBlock.magic));
+	superBlock.formatVersion = DISK_FORMAT_VERSION;
+	superBlock.blockSize = blockSize;
+	superBlock.numBlocks = numBlocks;
+	superBlock.numMapBlocks = numMapBlocks;
+	// a nonzero id no other disk is likely to have
+	std::random_device random;
+	std::uniform_int_distribution<int32_t> ids(1, INT32_MAX);
+	superBlock.diskId = ids(random);
+	memcpy(block.data(), &superBlock, sizeof(SuperBlock));
+	memcpy(block.data() + HEADER_SIZE, mapBlockNums.data(), numMapBlocks * sizeof(int32_t));
+	pwrite(disk, block.data(), blockSize, (off_t) SUPERBLOCK * blockSize);
+
+	for (int i = 0; i < numMapBlocks; i++)
+		pwrite(disk, blockAllocationMap.data() + i * blockSize, blockSize, (off_t) mapBlockNums[i] * blockSize);
+	close(disk);
+
+	Disk::loadSuperBlock();
     Disk::add_disk_metainfo();
 }
 
@@ -104,7 +430,7 @@ void Disk::add_disk_metainfo() {
         else
             slot_map[slotNum] = SLOT_UNOCCUPIED;
     }
-    setSlotmap(slot_map, SLOTMAP_SIZE_RELCAT_ATTRCAT, BLOCK_ALLOCATION_MAP_SIZE);
+    setSlotmap(slot_map, SLOTMAP_SIZE_RELCAT_ATTRCAT, RELCAT_BLOCK);
 
     /*
      * Create and Add 2 Records into Block 4 (Relation Catalog)
@@ -1,16 +1,46 @@
 #ifndef NITCBASE_DISK_H
 #define NITCBASE_DISK_H
 
+#include <sys/types.h>
+#include <vector>
+#include "define/constants.h"
 
 class Disk {
 public:
 	Disk();
 	~Disk();
-	static int createDisk();
+	static int createDisk(int blockSize = DEFAULT_BLOCK_SIZE, int numBlocks = DEFAULT_DISK_BLOCKS);
 	static int readBlock(unsigned char *block, int blockNum); // Use this wherever a block is being written (eg. ba_insert)
 	static int writeBlock(unsigned char *block, int blockNum); // Use this wherever a block is being read
-	static void formatDisk();
+	static void formatDisk(int blockSize = DEFAULT_BLOCK_SIZE, int numBlocks = DEFAULT_DISK_BLOCKS);
     static void add_disk_metainfo();
+
+	// Disk geometry, read from the superblock by loadSuperBlock()
+	static void loadSuperBlock();
+	static int getBlockSize();
+	static int getNumBlocks();
+	static int getFormatVersion();
+	static int getNumMapBlocks();
+	static int getMapBlock(int mapBlockIndex);
+	static bool hasPendingLog();
+	static off_t getBlockOffset(int blockNum);
+	static off_t getAllocMapOffset(int blockNum);
+	static int growDisk();
+	static void setFormatVersion(int version);
+	static void writeSuperBlock();
+
+	// Copy of the disk kept while it is converted in place
+	static int backUp();
+	static int dropBackup();
+	static bool restoreBackup();
+
+private:
+	static int blockSize;
+	static int numBlocks;
+	static int formatVersion;
+	static int diskId;
+	static int checkpointLsn;
+	static std::vector<int> mapBlocks;
 };
 
 
@@ -59,6 +59,11 @@ int OpenRelTable::openRelation(char relationName[ATTR_SIZE]) {
 		return E_RELNOTEXIST;
 	}
 
+	// the record commands work on arrays of ATTR_SIZE attributes only
+	if (hasPackedRecords(relationName)) {
+		return E_PACKEDRECORDS;
+	}
+
 	/* check if relation is already open
 	 *      if yes, return open relation id
 	 *  otherwise search for a free slot in open relation table
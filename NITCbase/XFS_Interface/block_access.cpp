@@ -1,13 +1,18 @@
+#include <algorithm>
 #include <cstdio>
+#include <cstdlib>
 #include <string>
 #include <cstring>
 #include <iostream>
+#include <vector>
 #include "define/constants.h"
 #include "define/errors.h"
 #include "disk_structures.h"
 #include "schema.h"
 #include "OpenRelTable.h"
 #include "BPlusTree.h"
+#include "Disk.h"
+#include "BlockCache.h"
 
 int getFreeRecBlock();
 
@@ -334,6 +339,12 @@ int ba_delete(char relName[ATTR_SIZE]) {
 	while (curr_block != -1) {
 		struct HeadInfo header = getHeader(curr_block);
 		next_block = header.rblock;
+		// and the overflow blocks holding the long strings of its records
+		for (int overflow_block = header.pblock; overflow_block != -1;) {
+			int next_overflow_block = getHeader(overflow_block).rblock;
+			deleteBlock(overflow_block);
+			overflow_block = next_overflow_block;
+		}
 		deleteBlock(curr_block);
 		curr_block = next_block;
 	}
@@ -476,12 +487,11 @@ int ba_renameattr(char relName[ATTR_SIZE], char oldName[ATTR_SIZE], char newName
  * If Not returns UNUSED_BLK: 3
  */
 int getBlockType(int blocknum) {
-	FILE *disk = fopen(&DISK_PATH[0], "rb");
-	fseek(disk, 0, SEEK_SET);
-	unsigned char blockAllocationMap[4 * BLOCK_SIZE];
-	fread(blockAllocationMap, 4 * BLOCK_SIZE, 1, disk);
-	fclose(disk);
-	return (int32_t) (blockAllocationMap[blocknum]);
+	if (blocknum < 0 || blocknum >= Disk::getNumBlocks())
+		return E_OUTOFBOUND;
+	const int blockSize = Disk::getBlockSize();
+	unsigned char *mapBlock = BlockCache::getBlock(Disk::getMapBlock(blocknum / blockSize));
+	return (int32_t) mapBlock[blocknum % blockSize];
 }
 
 /*
@@ -489,10 +499,7 @@ int getBlockType(int blocknum) {
  */
 HeadInfo getHeader(int blockNum) {
 	HeadInfo header;
-	FILE *disk = fopen(&DISK_PATH[0], "rb");
-	fseek(disk, blockNum * BLOCK_SIZE, SEEK_SET);
-	fread(&header, 32, 1, disk);
-	fclose(disk);
+	memcpy(&header, BlockCache::getBlock(blockNum), HEADER_SIZE);
 	return header;
 }
 
@@ -500,76 +507,146 @@ HeadInfo getHeader(int blockNum) {
  * Writes header for 'blockNum'th block into disk given the header information
  */
 void setHeader(struct HeadInfo *header, int blockNum) {
-	FILE *disk = fopen(&DISK_PATH[0], "rb+");
-	fseek(disk, blockNum * BLOCK_SIZE, SEEK_SET);
-	fwrite(header, 32, 1, disk);
-	fclose(disk);
+	memcpy(BlockCache::getBlock(blockNum), header, HEADER_SIZE);
+	BlockCache::markDirty(blockNum);
+}
+
+/*
+ * Returns the number of bytes the slotmap of a record block of numSlots slots takes on the disk
+ */
+int getSlotmapSize(int numSlots) {
+	if (Disk::getFormatVersion() < BITMAP_SLOT_MAP_VERSION)
+		return numSlots;
+	return (numSlots + 7) / 8;
+}
+
+/*
+ * Returns the number of slots of the record blocks of a relation with records of recordSize bytes
+ *      - As many as fit in a block with their slotmap
+ */
+int getSlotsPerBlock(int recordSize) {
+	const int space = Disk::getBlockSize() - HEADER_SIZE;
+	if (Disk::getFormatVersion() < BITMAP_SLOT_MAP_VERSION)
+		return space / (recordSize + 1);
+
+	int numSlots = (long long) space * 8 / (recordSize * 8 + 1);
+	while (getSlotmapSize(numSlots) + numSlots * recordSize > space)
+		numSlots--;
+	return numSlots;
+}
+
+/*
+ * Checks the slotmap of the record block image at block for slotNum
+ */
+bool isSlotOccupied(const unsigned char *block, int slotNum) {
+	if (Disk::getFormatVersion() < BITMAP_SLOT_MAP_VERSION)
+		return block[HEADER_SIZE + slotNum] == SLOT_OCCUPIED;
+	return (block[HEADER_SIZE + slotNum / 8] >> (slotNum % 8)) & 1;
 }
 
 /*
- * Reads slotmap for 'blockNum'th block from disk
+ * Reads slotmap for 'blockNum'th block from disk, as one SLOT_OCCUPIED or SLOT_UNOCCUPIED byte per slot
  */
 void getSlotmap(unsigned char *SlotMap, int blockNum) {
-	FILE *disk = fopen(&DISK_PATH[0], "rb+");
-	fseek(disk, blockNum * BLOCK_SIZE, SEEK_SET);
-	RecBlock R;
-	fread(&R, BLOCK_SIZE, 1, disk);
-	int numSlots = R.numSlots;
-	memcpy(SlotMap, R.slotMap_Records, numSlots);
-	fclose(disk);
+	HeadInfo header = getHeader(blockNum);
+	const unsigned char *slotmap = BlockCache::getBlock(blockNum) + HEADER_SIZE;
+	if (Disk::getFormatVersion() < BITMAP_SLOT_MAP_VERSION) {
+		memcpy(SlotMap, slotmap, header.numSlots);
+		return;
+	}
+	for (int slot = 0; slot < header.numSlots; slot++)
+		SlotMap[slot] = (slotmap[slot / 8] >> (slot % 8)) & 1 ? SLOT_OCCUPIED : SLOT_UNOCCUPIED;
 }
 
 /*
  * Writes slotmap for 'blockNum'th block into disk given the number of blocks occupied
  */
 void setSlotmap(unsigned char *SlotMap, int no_of_slots, int blockNum) {
-	FILE *disk = fopen(&DISK_PATH[0], "rb+");
-	fseek(disk, blockNum * BLOCK_SIZE + 32, SEEK_SET);
-	fwrite(SlotMap, no_of_slots, 1, disk);
-	fclose(disk);
+	unsigned char *slotmap = BlockCache::getBlock(blockNum) + HEADER_SIZE;
+	if (Disk::getFormatVersion() < BITMAP_SLOT_MAP_VERSION) {
+		memcpy(slotmap, SlotMap, no_of_slots);
+	} else {
+		memset(slotmap, 0, getSlotmapSize(no_of_slots));
+		for (int slot = 0; slot < no_of_slots; slot++) {
+			if (SlotMap[slot] == SLOT_OCCUPIED)
+				slotmap[slot / 8] |= 1 << (slot % 8);
+		}
+	}
+	BlockCache::markDirty(blockNum);
 }
 
+/*
+ * Finds the first unused block in the block allocation map, marks it as 'block_type' and returns it
+ * The map is scanned one map block at a time so that its size does not depend on the disk size
+ * The disk is grown when it has no unused block left
+ */
 int getFreeBlock(int block_type) {
-
-	FILE *disk = fopen(&DISK_PATH[0], "rb+");
-	fseek(disk, 0, SEEK_SET);
-	unsigned char blockAllocationMap[4 * BLOCK_SIZE];
-	fread(blockAllocationMap, 4 * BLOCK_SIZE, 1, disk);
-	for (int iter = 0; iter < 4 * BLOCK_SIZE; iter++) {
-		if ((int32_t) (blockAllocationMap[iter]) == UNUSED_BLK) {
-			blockAllocationMap[iter] = (unsigned char) block_type;
-			fseek(disk, 0, SEEK_SET);
-			fwrite(blockAllocationMap, BLOCK_SIZE * 4, 1, disk);
-			fclose(disk);
-			return iter;
+	const int blockSize = Disk::getBlockSize();
+	const int numBlocks = Disk::getNumBlocks();
+
+	for (int mapIndex = 0; mapIndex < Disk::getNumMapBlocks(); mapIndex++) {
+		const int mapBlockNum = Disk::getMapBlock(mapIndex);
+		unsigned char *blockAllocationMap = BlockCache::getBlock(mapBlockNum);
+		const int entries = std::min(blockSize, numBlocks - mapIndex * blockSize);
+		unsigned char *unused = (unsigned char *) memchr(blockAllocationMap, UNUSED_BLK, entries);
+		if (unused != nullptr) {
+			*unused = (unsigned char) block_type;
+			BlockCache::markDirty(mapBlockNum);
+			return mapIndex * blockSize + (int) (unused - blockAllocationMap);
 		}
 	}
 
+	// every block is in use: grow the disk and hand out one of the new blocks
+	if (Disk::growDisk() == SUCCESS)
+		return getFreeBlock(block_type);
+
 	return FAILURE;
 }
 
 /*
- *
+ * Finds the first run of 'count' consecutive unused blocks in the block allocation map, marks them
+ * as 'block_type' and returns the first of them
+ * The disk is grown until such a run exists; returns FAILURE if it cannot grow any further
  */
-int getFreeRecBlock() {
-	// TODO: Title for this
-	FILE *disk = fopen(&DISK_PATH[0], "rb+");
-	fseek(disk, 0, SEEK_SET);
-
-	unsigned char blockAllocationMap[4 * BLOCK_SIZE];
-	fread(blockAllocationMap, 4 * BLOCK_SIZE, 1, disk);
-
-	for (int iter = 0; iter < 4 * BLOCK_SIZE; iter++) {
-		if ((int32_t) (blockAllocationMap[iter]) == UNUSED_BLK) {
-			blockAllocationMap[iter] = (unsigned char) REC;
-			fseek(disk, 0, SEEK_SET);
-			fwrite(blockAllocationMap, BLOCK_SIZE * 4, 1, disk);
-			fclose(disk);
-			return iter;
+int getFreeBlockRun(int count, int block_type) {
+	while (true) {
+		const int blockSize = Disk::getBlockSize();
+		const int numBlocks = Disk::getNumBlocks();
+
+		int runStart = -1, runLength = 0;
+		for (int mapIndex = 0; mapIndex < Disk::getNumMapBlocks() && runLength < count; mapIndex++) {
+			unsigned char *blockAllocationMap = BlockCache::getBlock(Disk::getMapBlock(mapIndex));
+			for (int iter = 0; iter < blockSize && mapIndex * blockSize + iter < numBlocks; iter++) {
+				if ((int32_t) (blockAllocationMap[iter]) != UNUSED_BLK) {
+					runLength = 0;
+					continue;
+				}
+				if (runLength == 0)
+					runStart = mapIndex * blockSize + iter;
+				if (++runLength == count)
+					break;
+			}
+		}
+
+		if (runLength == count) {
+			for (int blockNum = runStart; blockNum < runStart + count; blockNum++) {
+				const int mapBlockNum = Disk::getMapBlock(blockNum / blockSize);
+				BlockCache::getBlock(mapBlockNum)[blockNum % blockSize] = (unsigned char) block_type;
+				BlockCache::markDirty(mapBlockNum);
+			}
+			return runStart;
 		}
+
+		if (Disk::growDisk() != SUCCESS)
+			return FAILURE;
 	}
+}
 
-	return FAILURE;
+/*
+ * Finds the first unused block and marks it as a record block
+ */
+int getFreeRecBlock() {
+	return getFreeBlock(REC);
 }
 
 /* Finds a free slot either from :
@@ -675,32 +752,29 @@ int getRecord(Attribute *rec, int blockNum, int slotNum) {
 	if (slotNum < 0 || slotNum > (numOfSlots - 1))
 		return E_OUTOFBOUND;
 
-	FILE *disk = fopen(&DISK_PATH[0], "rb+");
 	int BlockType = getBlockType(blockNum);
 
 	if (BlockType == REC) {
-		RecBlock R;
-		fseek(disk, blockNum * BLOCK_SIZE, SEEK_SET);
-		fread(&R, BLOCK_SIZE, 1, disk);
-		int numSlots = R.numSlots;
+		int numSlots = Header.numSlots;
+		int numAttrs = Header.numAttrs;
 
-		if (R.slotMap_Records[slotNum] == SLOT_UNOCCUPIED)
+		unsigned char *block = BlockCache::getBlock(blockNum);
+		if (!isSlotOccupied(block, slotNum))
 			return E_FREESLOT;
-		int numAttrs = R.numAttrs;
 
 		/* offset :
-		 *         slotmap size ( = numSlots ) +
+		 *         header size ( = 32 ) +
+		 *         slotmap size ( = getSlotmapSize(numSlots) ) +
 		 *         size of records coming before current record ( = slotNum * numAttrs * ATTR_SIZE )
 		 */
-		memcpy(rec, (R.slotMap_Records + numSlots + (slotNum * numAttrs * ATTR_SIZE)), numAttrs * ATTR_SIZE);
-		fclose(disk);
+		memcpy(rec, block + HEADER_SIZE + getSlotmapSize(numSlots) + slotNum * numAttrs * ATTR_SIZE,
+		       numAttrs * ATTR_SIZE);
 		return SUCCESS;
 	} else if (BlockType == IND_INTERNAL) {
 		//TODO
 	} else if (BlockType == IND_LEAF) {
 		//TODO
 	} else {
-		fclose(disk);
 		return FAILURE;
 	}
 }
@@ -718,25 +792,23 @@ int setRecord(Attribute *rec, int blockNum, int slotNum) {
 		return E_OUTOFBOUND;
 
 	int BlockType = getBlockType(blockNum);
-	FILE *disk = fopen(&DISK_PATH[0], "rb+");
 
 	if (BlockType == REC) {
 		/* offset :
-		 *          size of blocks coming before current block ( = blockNum * BLOCK_SIZE ) +
+		 *          size of blocks coming before current block ( = blockNum * block size ) +
 		 *          header size ( = 32 ) +
-		 *          slot_map size ( = numSlots ) +
+		 *          slot_map size ( = getSlotmapSize(numSlots) ) +
 		 *          size of records coming before current record ( = slotNum * numAttrs * ATTR_SIZE )
 		 */
-		fseek(disk, blockNum * BLOCK_SIZE + 32 + numOfSlots + slotNum * numAttrs * ATTR_SIZE, SEEK_SET);
-		fwrite(rec, numAttrs * ATTR_SIZE, 1, disk);
-		fclose(disk);
+		memcpy(BlockCache::getBlock(blockNum) + HEADER_SIZE + getSlotmapSize(numOfSlots) +
+		       slotNum * numAttrs * ATTR_SIZE, rec, numAttrs * ATTR_SIZE);
+		BlockCache::markDirty(blockNum);
 		return SUCCESS;
 	} else if (BlockType == IND_INTERNAL) {
 		//TODO
 	} else if (BlockType == IND_LEAF) {
 		//TODO
 	} else {
-		fclose(disk);
 		return FAILURE;
 	}
 }
@@ -887,6 +959,67 @@ int setAttrCatEntry(int relationId, char attrName[ATTR_SIZE], Attribute *attrCat
 	return E_ATTRNOTEXIST;
 }
 
+/*
+ * Returns the format an attribute is stored in, from its attribute catalog entry
+ */
+int getAttrFormat(Attribute *attrCatEntry) {
+	int format = (int) attrCatEntry[ATTRCAT_PRIMARY_FLAG_INDEX].nval;
+	if (format >= FORMAT_COMPRESSED)
+		format -= FORMAT_COMPRESSED;
+	if (format >= FORMAT_COLUMNAR)
+		format -= FORMAT_COLUMNAR;
+	return format < FORMAT_DOUBLE ? FORMAT_DEFAULT : format;
+}
+
+/*
+ * Checks whether the relation of an attribute has columnar record blocks, from its attribute
+ * catalog entry
+ */
+bool isColumnar(Attribute *attrCatEntry) {
+	return (int) attrCatEntry[ATTRCAT_PRIMARY_FLAG_INDEX].nval % FORMAT_COMPRESSED >= FORMAT_COLUMNAR;
+}
+
+/*
+ * Checks whether the relation of an attribute has compressed record blocks, from its attribute
+ * catalog entry
+ */
+bool isCompressed(Attribute *attrCatEntry) {
+	return (int) attrCatEntry[ATTRCAT_PRIMARY_FLAG_INDEX].nval >= FORMAT_COMPRESSED;
+}
+
+/*
+ * Returns the number of bytes an attribute of the given format takes in a record
+ */
+int getFormatSize(int format) {
+	if (format == FORMAT_DOUBLE || format == FORMAT_INT64)
+		return 8;
+	if (format == FORMAT_INT32)
+		return 4;
+	if (format == FORMAT_DEFAULT || format == FORMAT_VARCHAR)
+		return ATTR_SIZE;
+	return format - FORMAT_CHAR;
+}
+
+/*
+ * Checks whether some attribute of relName is stored in a format other than FORMAT_DEFAULT,
+ * or the relation has columnar or compressed record blocks
+ *      - The records of such a relation are not arrays of ATTR_SIZE attributes, so they can
+ *        only be read by exportRelation()
+ */
+bool hasPackedRecords(char relName[ATTR_SIZE]) {
+	Attribute attrCatEntry[NO_OF_ATTRS_RELCAT_ATTRCAT];
+	for (int curr_block = ATTRCAT_BLOCK; curr_block != -1; curr_block = getHeader(curr_block).rblock) {
+		for (int slotIter = 0; slotIter < SLOTMAP_SIZE_RELCAT_ATTRCAT; slotIter++) {
+			if (getRecord(attrCatEntry, curr_block, slotIter) == SUCCESS &&
+					strcmp(attrCatEntry[ATTRCAT_REL_NAME_INDEX].sval, relName) == 0 &&
+					(getAttrFormat(attrCatEntry) != FORMAT_DEFAULT || isColumnar(attrCatEntry) ||
+					 isCompressed(attrCatEntry)))
+				return true;
+		}
+	}
+	return false;
+}
+
 ///*
 // * 20 = leftChildPointerSize + ATTR_SIZE
 // */
@@ -905,18 +1038,16 @@ int setAttrCatEntry(int relationId, char attrName[ATTR_SIZE], Attribute *attrCat
  *      - Marks the Block UNUSED_BLK in Block Allocation Map
  */
 int deleteBlock(int blockNum) {
-	FILE *disk;
-	disk = fopen(&DISK_PATH[0], "rb+");
+	const int blockSize = Disk::getBlockSize();
 
 	/* Clear the data present in the block */
-	fseek(disk, BLOCK_SIZE * blockNum, SEEK_SET);
-	for (int i = 0; i < BLOCK_SIZE; i++)
-		fputc(0, disk);
+	memset(BlockCache::getBlock(blockNum), 0, blockSize);
+	BlockCache::markDirty(blockNum);
 
 	/* Mark this block as UNUSED in the Block Allocation Map */
-	fseek(disk, blockNum, SEEK_SET);
-	fputc((unsigned char) UNUSED_BLK, disk);
-	fclose(disk);
+	const int mapBlockNum = Disk::getMapBlock(blockNum / blockSize);
+	BlockCache::getBlock(mapBlockNum)[blockNum % blockSize] = (unsigned char) UNUSED_BLK;
+	BlockCache::markDirty(mapBlockNum);
 
 	return SUCCESS;
 }
@@ -952,12 +1083,9 @@ int deleteRelCatEntry(recId relcat_recid, Attribute relcat_rec[6]) {
 	relcat_slotmap[relcat_recid.slot] = SLOT_UNOCCUPIED;
 	setSlotmap(relcat_slotmap, 20, relcat_recid.block);
 
-	FILE *disk = fopen(&DISK_PATH[0], "rb+");
-	fseek(disk, (relcat_recid.block) * BLOCK_SIZE + HEADER_SIZE + SLOTMAP_SIZE_RELCAT_ATTRCAT +
-	            relcat_recid.slot * NO_OF_ATTRS_RELCAT_ATTRCAT * ATTR_SIZE, SEEK_SET);
-	for (int i = 0; i < 16 * 6; i++)
-		fputc(0, disk);
-	fclose(disk);
+	memset(BlockCache::getBlock(relcat_recid.block) + HEADER_SIZE + getSlotmapSize(SLOTMAP_SIZE_RELCAT_ATTRCAT) +
+	       relcat_recid.slot * NO_OF_ATTRS_RELCAT_ATTRCAT * ATTR_SIZE, 0, NO_OF_ATTRS_RELCAT_ATTRCAT * ATTR_SIZE);
+	BlockCache::markDirty(relcat_recid.block);
 
 	return SUCCESS;
 }
@@ -971,12 +1099,9 @@ int deleteRelCatEntry(recId relcat_recid, Attribute relcat_rec[6]) {
  */
 int deleteAttrCatEntry(recId attrcat_recid) {
 	/* Clear the Attribute Catalog Record present in the given (Slot & Block) of the Disk */
-	FILE *disk = fopen(&DISK_PATH[0], "rb+");
-	fseek(disk, (attrcat_recid.block) * BLOCK_SIZE + HEADER_SIZE + SLOTMAP_SIZE_RELCAT_ATTRCAT +
-	            (attrcat_recid.slot) * NO_OF_ATTRS_RELCAT_ATTRCAT * ATTR_SIZE, SEEK_SET);
-	for (int i = 0; i < ATTR_SIZE * NO_OF_ATTRS_RELCAT_ATTRCAT; i++)
-		fputc(0, disk);
-	fclose(disk);
+	memset(BlockCache::getBlock(attrcat_recid.block) + HEADER_SIZE + getSlotmapSize(SLOTMAP_SIZE_RELCAT_ATTRCAT) +
+	       attrcat_recid.slot * NO_OF_ATTRS_RELCAT_ATTRCAT * ATTR_SIZE, 0, ATTR_SIZE * NO_OF_ATTRS_RELCAT_ATTRCAT);
+	BlockCache::markDirty(attrcat_recid.block);
 
 	/* Update the Header and SlotMap for Attribute Catalog */
 	struct HeadInfo header = getHeader(attrcat_recid.block);
@@ -1036,14 +1161,12 @@ int compareAttributes(union Attribute attr1, union Attribute attr2, int attrType
 
 InternalEntry getInternalEntry(int block, int entryNum) {
 	InternalEntry rec;
-	FILE *disk = fopen(&DISK_PATH[0], "rb");
-	fseek(disk, block * BLOCK_SIZE + HEADER_SIZE + entryNum * (LCHILD_SIZE+ATTR_SIZE), SEEK_SET);
+	unsigned char *entry = BlockCache::getBlock(block) + HEADER_SIZE + entryNum * (LCHILD_SIZE+ATTR_SIZE);
 
-	fread(&rec.lChild, 4, 1, disk);
-	fread(&rec.attrVal, 16, 1, disk);
-	fread(&rec.rChild, 4, 1, disk);
+	memcpy(&rec.lChild, entry, 4);
+	memcpy(&rec.attrVal, entry + 4, 16);
+	memcpy(&rec.rChild, entry + 20, 4);
 
-	fclose(disk);
 //	std::cout << "DEBUG-GET\n";
 //	std::cout << "lchild: " << rec.lChild << ", ";
 //	std::cout << "key_val: " << (int) rec.attrVal.nval << ", ";
@@ -1072,26 +1195,162 @@ void setInternalEntry(InternalEntry internalEntry, int block, int offset) {
 //			internalEntry.rChild = entry.rChild;
 //	}
 
-	FILE *disk = fopen(&DISK_PATH[0], "rb+");
-	fseek(disk, block * BLOCK_SIZE + HEADER_SIZE + offset * (LCHILD_SIZE+ATTR_SIZE), SEEK_SET);
-	fwrite(&internalEntry.lChild, 4, 1, disk);
-	fwrite(&internalEntry.attrVal, 16, 1, disk);
-	fwrite(&internalEntry.rChild, 4, 1, disk);
-	fclose(disk);
+	unsigned char *entry = BlockCache::getBlock(block) + HEADER_SIZE + offset * (LCHILD_SIZE+ATTR_SIZE);
+	memcpy(entry, &internalEntry.lChild, 4);
+	memcpy(entry + 4, &internalEntry.attrVal, 16);
+	memcpy(entry + 20, &internalEntry.rChild, 4);
+	BlockCache::markDirty(block);
+}
+
+/*
+ * The key of attrVal as it is stored in a leaf
+ *      - the bytes a comparison does not look at (those after the double of a NUMBER, or after
+ *        the end of a STRING that is not a long string) are zeroed, so that the leaf can leave
+ *        them out (see setLeafEntries())
+ */
+Attribute getLeafKey(Attribute attrVal, int attrType) {
+	unsigned char *bytes = (unsigned char *) &attrVal;
+	if (attrType == NUMBER) {
+		memset(bytes + sizeof(double), 0, ATTR_SIZE - sizeof(double));
+	} else if (!(bytes[LONG_STRING_PREFIX] == LONG_STRING_MARKER &&
+	             memchr(attrVal.sval, '\0', LONG_STRING_PREFIX) == nullptr)) {
+		int length = strnlen(attrVal.sval, ATTR_SIZE);
+		memset(bytes + length, 0, ATTR_SIZE - length);
+	}
+	return attrVal;
+}
+
+// number of bytes of the key up to its last byte that is not zero
+static int getKeyLength(const Attribute &key) {
+	const unsigned char *bytes = (const unsigned char *) &key;
+	int length = ATTR_SIZE;
+	while (length > 0 && bytes[length - 1] == 0)
+		length--;
+	return length;
+}
+
+// number of leading bytes, at most length, that two keys share
+static int getSharedLength(const Attribute &key1, const Attribute &key2, int length) {
+	const unsigned char *bytes1 = (const unsigned char *) &key1;
+	const unsigned char *bytes2 = (const unsigned char *) &key2;
+	int shared = 0;
+	while (shared < length && bytes1[shared] == bytes2[shared])
+		shared++;
+	return shared;
+}
+
+/*
+ * Number of the first count entries that fit in a leaf together (see setLeafEntries())
+ */
+int getNumFittingLeaf(Index *entries, int count) {
+	count = std::min(count, BPlusTree::getMaxKeysLeaf());
+	if (Disk::getFormatVersion() < PREFIX_LEAF_VERSION)
+		return count;
+
+	const int space = Disk::getBlockSize() - HEADER_SIZE - LEAF_PREFIX_INFO_SIZE;
+	int sharedLength = ATTR_SIZE, keyLength = 0;
+	for (int i = 0; i < count; i++) {
+		sharedLength = getSharedLength(entries[0].attrVal, entries[i].attrVal, sharedLength);
+		keyLength = std::max(keyLength, getKeyLength(entries[i].attrVal));
+		int prefixLength = std::min(sharedLength, keyLength);
+		if (prefixLength + (i + 1) * (keyLength - prefixLength + LEAF_RECID_SIZE) > space)
+			return i;
+	}
+	return count;
 }
 
+/*
+ * Entry number offset of a leaf
+ *      - a leaf of a disk before PREFIX_LEAF_VERSION holds LEAF_ENTRY_SIZE byte entries
+ *      - a prefix compressed leaf holds, after the header, the length of the prefix its keys share
+ *        and the width of the rest of a key (a byte each), the prefix, then the entries: the rest
+ *        of the key (its trailing zero bytes left out), the 4 byte block and the 2 byte slot
+ */
 Index getLeafEntry(int leaf, int offset) {
 	Index rec;
-	FILE *disk = fopen(&DISK_PATH[0], "rb");
-	fseek(disk, leaf * BLOCK_SIZE + HEADER_SIZE + offset * LEAF_ENTRY_SIZE, SEEK_SET);
-	fread(&rec, sizeof(rec), 1, disk);
-	fclose(disk);
+	unsigned char *block = BlockCache::getBlock(leaf);
+	if (Disk::getFormatVersion() < PREFIX_LEAF_VERSION) {
+		memcpy(&rec, block + HEADER_SIZE + offset * LEAF_ENTRY_SIZE, sizeof(rec));
+		return rec;
+	}
+
+	const int prefixLength = block[HEADER_SIZE];
+	const int keyWidth = block[HEADER_SIZE + 1];
+	unsigned char *prefix = block + HEADER_SIZE + LEAF_PREFIX_INFO_SIZE;
+	unsigned char *entry = prefix + prefixLength + offset * (keyWidth + LEAF_RECID_SIZE);
+
+	uint16_t slot;
+	memset(&rec.attrVal, 0, ATTR_SIZE);
+	memcpy(&rec.attrVal, prefix, prefixLength);
+	memcpy((unsigned char *) &rec.attrVal + prefixLength, entry, keyWidth);
+	memcpy(&rec.block, entry + keyWidth, sizeof(int32_t));
+	memcpy(&slot, entry + keyWidth + sizeof(int32_t), sizeof(uint16_t));
+	rec.slot = slot;
 	return rec;
 }
 
+/*
+ * Writes rec as entry number offset of a leaf
+ *      - of a prefix compressed leaf, offset has to be one of its entries (numEntries of the
+ *        header), and every entry is written again
+ */
 void setLeafEntry(Index rec, int leaf, int offset) {
-	FILE *disk = fopen(&DISK_PATH[0], "rb+");
-	fseek(disk, leaf * BLOCK_SIZE + HEADER_SIZE + offset * LEAF_ENTRY_SIZE, SEEK_SET);
-	fwrite(&rec, sizeof(rec), 1, disk);
-	fclose(disk);
+	if (Disk::getFormatVersion() < PREFIX_LEAF_VERSION) {
+		memcpy(BlockCache::getBlock(leaf) + HEADER_SIZE + offset * LEAF_ENTRY_SIZE, &rec, sizeof(rec));
+		BlockCache::markDirty(leaf);
+		return;
+	}
+
+	const int numEntries = getHeader(leaf).numEntries;
+	std::vector<Index> entries(numEntries);
+	for (int i = 0; i < numEntries; i++)
+		entries[i] = getLeafEntry(leaf, i);
+	entries[offset] = rec;
+	setLeafEntries(entries.data(), numEntries, leaf);
+}
+
+/*
+ * Writes count entries, in order, as the entries of a leaf (its numEntries is set by the caller)
+ *      - returns E_OUTOFBOUND if they do not fit in a leaf together (see getNumFittingLeaf())
+ *      - the entries of a leaf of a disk before PREFIX_LEAF_VERSION after the count'th are zeroed
+ */
+int setLeafEntries(Index *entries, int count, int leaf) {
+	if (count < 0 || getNumFittingLeaf(entries, count) < count)
+		return E_OUTOFBOUND;
+
+	unsigned char *block = BlockCache::getBlock(leaf);
+	if (Disk::getFormatVersion() < PREFIX_LEAF_VERSION) {
+		const int maxKeys = BPlusTree::getMaxKeysLeaf();
+		memset(block + HEADER_SIZE, 0, maxKeys * LEAF_ENTRY_SIZE);
+		for (int i = 0; i < count; i++)
+			memcpy(block + HEADER_SIZE + i * LEAF_ENTRY_SIZE, &entries[i], sizeof(Index));
+		BlockCache::markDirty(leaf);
+		return SUCCESS;
+	}
+
+	// the bytes every key shares (no more than the longest key has)
+	int sharedLength = ATTR_SIZE, keyLength = 0;
+	for (int i = 0; i < count; i++) {
+		sharedLength = getSharedLength(entries[0].attrVal, entries[i].attrVal, sharedLength);
+		keyLength = std::max(keyLength, getKeyLength(entries[i].attrVal));
+	}
+	const int prefixLength = std::min(sharedLength, keyLength);
+	const int keyWidth = keyLength - prefixLength;
+
+	block[HEADER_SIZE] = prefixLength;
+	block[HEADER_SIZE + 1] = keyWidth;
+	unsigned char *entry = block + HEADER_SIZE + LEAF_PREFIX_INFO_SIZE;
+	if (count > 0)
+		memcpy(entry, &entries[0].attrVal, prefixLength);
+	entry += prefixLength;
+
+	for (int i = 0; i < count; i++) {
+		uint16_t slot = entries[i].slot;
+		memcpy(entry, (unsigned char *) &entries[i].attrVal + prefixLength, keyWidth);
+		memcpy(entry + keyWidth, &entries[i].block, sizeof(int32_t));
+		memcpy(entry + keyWidth + sizeof(int32_t), &slot, sizeof(uint16_t));
+		entry += keyWidth + LEAF_RECID_SIZE;
+	}
+	BlockCache::markDirty(leaf);
+	return SUCCESS;
 }
@@ -13,6 +13,9 @@ int ba_delete(char relName[ATTR_SIZE]);
 void add_disk_metainfo();
 HeadInfo getHeader(int blockNum);
 void setHeader(struct HeadInfo *header, int blockNum);
+int getSlotmapSize(int numSlots);
+int getSlotsPerBlock(int recordSize);
+bool isSlotOccupied(const unsigned char *block, int slotNum);
 void getSlotmap(unsigned char *SlotMap, int blockNum);
 void setSlotmap(unsigned char *SlotMap, int no_of_slots, int blockNum);
 int getRecord(Attribute *rec, int blockNum, int slotNum);
@@ -22,8 +25,14 @@ int getAttrCatEntry(int relationId, char attrname[16], Attribute *attrcat_entry)
 int getAttrCatEntry(int relationId, int offset, Attribute *attrCatEntry);
 int setRelCatEntry(int relationId, Attribute *relcat_entry);
 int setAttrCatEntry(int relationId, char attrName[ATTR_SIZE], Attribute *attrCatEntry);
+int getAttrFormat(Attribute *attrCatEntry);
+bool isColumnar(Attribute *attrCatEntry);
+bool isCompressed(Attribute *attrCatEntry);
+int getFormatSize(int format);
+bool hasPackedRecords(char relName[ATTR_SIZE]);
 
 int getFreeBlock(int block_type);
+int getFreeBlockRun(int count, int block_type);
 int getBlockType(int blocknum);
 //InternalEntry getEntry(int block, int entry_number);
 int compareAttributes(union Attribute attr1, union Attribute attr2, int attrType);
@@ -31,7 +40,10 @@ int deleteBlock(int blockNum);
 
 InternalEntry getInternalEntry(int block, int entryNum);
 void setInternalEntry(InternalEntry internalEntry, int block, int offset);
+Attribute getLeafKey(Attribute attrVal, int attrType);
+int getNumFittingLeaf(Index *entries, int count);
 Index getLeafEntry(int leaf, int offset);
 void setLeafEntry(Index rec, int leaf, int offset);
+int setLeafEntries(Index *entries, int count, int leaf);
 
 #endif //NITCBASE_BLOCK_ACCESS_H
@@ -0,0 +1,98 @@
+#include <cstdint>
+#include <cstring>
+#include "define/constants.h"
+#include "block_compression.h"
+#include "Disk.h"
+
+// Shortest repeated string the compressed data codes as a match
+#define LZ_MIN_MATCH 4
+
+/*
+ * Reads a length continued in the bytes at *in (each 255 adds 255, and the first byte below
+ * 255 ends it) into *length
+ */
+static int readLength(const unsigned char **in, const unsigned char *end, int *length) {
+	int byte;
+	do {
+		if (*in == end)
+			return FAILURE;
+		byte = *(*in)++;
+		*length += byte;
+	} while (byte == 255);
+	return SUCCESS;
+}
+
+/*
+ * Expands the size bytes of compressed data at src into exactly expandedSize bytes at dst
+ *      - The data is a run of sequences, each a token byte, literals and a match: a string of at
+ *        least LZ_MIN_MATCH bytes copied from offset bytes back in the output
+ *      - The high 4 bits of the token are the number of literals and the low 4 bits the length
+ *        of the match less LZ_MIN_MATCH, either at 15 continued in the bytes that follow (see
+ *        readLength()); the 2 byte offset of the match follows the literals
+ *      - The last sequence ends with its literals
+ *      - Returns FAILURE if the data is corrupt
+ */
+static int lzExpand(const unsigned char *src, int size, unsigned char *dst, int expandedSize) {
+	const unsigned char *in = src;
+	const unsigned char *inEnd = src + size;
+	unsigned char *out = dst;
+	unsigned char *outEnd = dst + expandedSize;
+
+	while (in < inEnd) {
+		int token = *in++;
+		int literalLength = token >> 4;
+		if (literalLength == 15 && readLength(&in, inEnd, &literalLength) != SUCCESS)
+			return FAILURE;
+		if (literalLength > inEnd - in || literalLength > outEnd - out)
+			return FAILURE;
+		memcpy(out, in, literalLength);
+		in += literalLength;
+		out += literalLength;
+		if (in == inEnd)
+			break;
+
+		if (inEnd - in < 2)
+			return FAILURE;
+		int offset = in[0] | (in[1] << 8);
+		in += 2;
+		int matchLength = token & 15;
+		if (matchLength == 15 && readLength(&in, inEnd, &matchLength) != SUCCESS)
+			return FAILURE;
+		matchLength += LZ_MIN_MATCH;
+		if (offset == 0 || offset > out - dst || matchLength > outEnd - out)
+			return FAILURE;
+
+		// byte by byte, as the match may overlap the bytes it produces
+		const unsigned char *match = out - offset;
+		for (int i = 0; i < matchLength; i++)
+			out[i] = match[i];
+		out += matchLength;
+	}
+
+	return out == outEnd ? SUCCESS : FAILURE;
+}
+
+/*
+ * Returns the size in bytes of a compressed record block once it is expanded
+ */
+int getExpandedBlockSize() {
+	return Disk::getBlockSize() * COMPRESSED_FRAME_BLOCKS;
+}
+
+/*
+ * Expands the compressed record block read from the disk into expanded (getExpandedBlockSize()
+ * bytes), with the header of a REC block
+ *      - Returns FAILURE if the block is corrupt
+ */
+int expandBlock(const unsigned char *block, unsigned char *expanded) {
+	int32_t dataSize;
+	memcpy(&dataSize, block + HEADER_SIZE, sizeof(int32_t));
+	if (dataSize < 0 || dataSize > Disk::getBlockSize() - COMPRESSED_HEADER_SIZE)
+		return FAILURE;
+
+	int32_t blockType = REC;
+	memcpy(expanded, block, HEADER_SIZE);
+	memcpy(expanded, &blockType, sizeof(int32_t));
+	return lzExpand(block + COMPRESSED_HEADER_SIZE, dataSize, expanded + HEADER_SIZE,
+			getExpandedBlockSize() - HEADER_SIZE);
+}
@@ -0,0 +1,23 @@
+#ifndef NITCBASE_BLOCK_COMPRESSION_H
+#define NITCBASE_BLOCK_COMPRESSION_H
+
+#include "define/constants.h"
+
+/*
+ * A record block of a compressed relation is stored on the disk as its header (with blockType
+ * COMPRESSED_REC), the number of bytes of compressed data (4 bytes) and the data: the rest of
+ * the block as it is expanded, COMPRESSED_FRAME_BLOCKS blocks in all, compressed with an LZ77
+ * coder in the manner of LZ4. The records of the block, its slotmap included, are laid out in
+ * the expanded block as in any record block of numSlots slots.
+ *
+ * The tool only reads compressed blocks (to export the records of a compressed relation);
+ * they are written by NITCbase.
+ */
+
+// Number of bytes of a compressed record block before the compressed data
+#define COMPRESSED_HEADER_SIZE (HEADER_SIZE + 4)
+
+int getExpandedBlockSize();
+int expandBlock(const unsigned char *block, unsigned char *expanded);
+
+#endif //NITCBASE_BLOCK_COMPRESSION_H
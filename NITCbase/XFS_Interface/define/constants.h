@@ -3,8 +3,20 @@
 
 // Path to disk
 #define DISK_PATH "../Disk/disk"
+// Directory of the disk and the files kept with it
+#define DISK_DIR_PATH "../Disk"
 // Path to run copy of the disk
 #define DISK_RUN_COPY_PATH "../Disk/disk_run_copy"
+// Path to the write-ahead log NITCbase keeps for the disk
+#define DISK_WAL_PATH "../Disk/wal"
+// Magic string at the start of the write-ahead log
+#define WAL_MAGIC "NITCWAL"
+// Path to the copy of the disk kept while it is converted in place (see Disk::backUp())
+#define DISK_BACKUP_PATH "../Disk/disk_backup"
+// Path the copy of the disk is written to before it is complete
+#define DISK_BACKUP_TEMP_PATH "../Disk/disk_backup.tmp"
+// Bytes copied at a time when the disk is backed up
+#define DISK_COPY_BUFFER_SIZE (1 << 20)
 // Path to Files directory
 #define Files_Path "../Files/"
 // Path to Input_Files directory inside the Files directory
@@ -14,12 +26,8 @@
 // Path to Batch_Execution_Files directory inside the Files directory
 #define BATCH_FILES_PATH "../Files/Batch_Execution_Files/"
 
-// Size of Block in bytes
-#define BLOCK_SIZE 2048
 // Size of an attribute in bytes
 #define ATTR_SIZE 16
-// Size of Disk in bytes
-#define DISK_SIZE 16 * 1024 * 1024
 // Size of Header of a block in bytes (not including slotmap)
 #define HEADER_SIZE 32
 // Size of field Lchild in bytes
@@ -36,17 +44,65 @@
 #define INDEX_BLOCK_UNUSED_BYTES 8
 // Size of an Internal Index Entry in the Internal Index Block (in bytes)
 #define INTERNAL_ENTRY_SIZE 24
-// Size of an Leaf Index Entry in the Leaf Index Block (in bytes)
+// Size of an Leaf Index Entry in the Leaf Index Block of a disk before PREFIX_LEAF_VERSION (in bytes)
 #define LEAF_ENTRY_SIZE 32
+// Size of the record id of an entry of a prefix compressed leaf (4 byte block, 2 byte slot)
+#define LEAF_RECID_SIZE 6
+// Size of the key prefix length and key width at the start of a prefix compressed leaf (in bytes)
+#define LEAF_PREFIX_INFO_SIZE 2
+
+// The block size, the number of blocks and the blocks of the block allocation map
+// are read from the superblock at runtime (see Disk::getBlockSize() and friends)
+// Disk block number of the superblock
+#define SUPERBLOCK 0
+// Magic string at the start of the superblock
+#define DISK_MAGIC "NITCBASE"
+// Latest on-disk format version (1 is the legacy disk without a superblock)
+#define DISK_FORMAT_VERSION 5
+// First format version whose record blocks have a bitmap slot map (bit s of byte s / 8 set if
+// slot s is occupied); the record blocks of older disks have one SLOT_OCCUPIED or SLOT_UNOCCUPIED
+// byte per slot
+#define BITMAP_SLOT_MAP_VERSION 3
+// First format version that may hold compressed record blocks (see block_compression.h)
+#define COMPRESSED_BLOCK_VERSION 4
+// Number of blocks of records a compressed record block holds once it is expanded
+#define COMPRESSED_FRAME_BLOCKS 4
+// First format version whose leaf index blocks are prefix compressed (see setLeafEntries())
+#define PREFIX_LEAF_VERSION 5
+// Smallest supported block size in bytes
+#define MIN_BLOCK_SIZE 2048
+// Largest supported block size in bytes
+#define MAX_BLOCK_SIZE 65536
+// Block size used by FDISK when none is given
+#define DEFAULT_BLOCK_SIZE 2048
+// Number of blocks used by FDISK when none is given
+#define DEFAULT_DISK_BLOCKS 8192
+// Smallest number of blocks a disk can be formatted with
+#define MIN_DISK_BLOCKS 64
+// Size of Block in bytes on a legacy disk
+#define LEGACY_BLOCK_SIZE 2048
+// Number of blocks on a legacy disk
+#define LEGACY_DISK_BLOCKS 8192
+// Number of blocks given for Block Allocation Map on a legacy disk
+#define LEGACY_BLOCK_ALLOCATION_MAP_SIZE 4
+// Number of bytes added to the disk each time it runs out of free blocks
+#define DISK_GROW_SIZE (16 * 1024 * 1024)
+
+// Size of the buffer IMPORT reads the csv file through when counting its lines (in bytes)
+#define IMPORT_BUFFER_SIZE (1024 * 1024)
+// Size of the buffer EXPORT formats records into before writing them out (in bytes)
+#define EXPORT_BUFFER_SIZE (1024 * 1024)
+// Longest text of a number written by EXPORT ("%f" of the largest double, with its sign)
+// (see exportRelation() for the longest text of a string)
+#define EXPORT_MAX_NUMBER_LENGTH 320
+
+// Bytes of disk blocks kept in memory by the block cache (see BlockCache)
+#define BLOCK_CACHE_SIZE (16 * 1024 * 1024)
 
-// Number of block in disk
-#define DISK_BLOCKS 8192
 // Total number of blocks available in the Buffer (Capacity of the Buffer in blocks)
 #define BUFFER_CAPACITY 32
 // Maximum number of relations allowed to be open and cached in Cache Layer.
 #define MAX_OPEN 12
-// Number of blocks given for Block Allocation Map in the disk
-#define BLOCK_ALLOCATION_MAP_SIZE 4
 
 // Number of attributes present in one entry / record of the Relation Catalog
 #define RELCAT_NO_ATTRS 6
@@ -91,6 +147,11 @@
 #define UNUSED_BLK 3
 // Block type for the block allocation map
 #define BMAP 4
+// Block type for an Overflow Block, holding the long strings of a record block (its pblock)
+#define OVERFLOW_BLK 5
+// Block type in the header of a compressed record block on the disk (its type is REC in the
+// Block Allocation Map)
+#define COMPRESSED_REC 6
 
 // Operators
 // Equal to
@@ -152,22 +213,44 @@
 #define ATTRCAT_ATTR_NAME_INDEX 1
 // Index for Attribute Type attribute of an attribute catalog entry
 #define ATTRCAT_ATTR_TYPE_INDEX 2
-// Index for Primary Flag attribute of an attribute catalog entry
+// Index for Primary Flag attribute of an attribute catalog entry (it holds the format of the attribute)
 #define ATTRCAT_PRIMARY_FLAG_INDEX 3
 // Index for Root Block attribute of an attribute catalog entry
 #define ATTRCAT_ROOT_BLOCK_INDEX 4
 // Index for Offset attribute of an attribute catalog entry
 #define ATTRCAT_OFFSET_INDEX 5
 
+// Formats an attribute is stored in, kept in the Primary Flag of its attribute catalog entry
+// NUMBER or STRING in ATTR_SIZE bytes (any value below FORMAT_DOUBLE, such as the -1 of older disks)
+#define FORMAT_DEFAULT -1
+// NUMBER as an 8 byte double
+#define FORMAT_DOUBLE 2
+// NUMBER as a 4 byte integer
+#define FORMAT_INT32 3
+// NUMBER as an 8 byte integer
+#define FORMAT_INT64 4
+// STRING of up to MAX_STRING_LENGTH bytes, those of ATTR_SIZE bytes or more kept in overflow blocks
+#define FORMAT_VARCHAR 5
+// STRING of at most n < ATTR_SIZE characters in n bytes, stored as FORMAT_CHAR + n
+#define FORMAT_CHAR 16
+// Added to the format of every attribute of a relation with columnar record blocks, whose
+// blocks keep the values of each attribute together (in numSlots * size bytes, in attribute order)
+#define FORMAT_COLUMNAR 1024
+// Added to the format of every attribute of a relation with compressed record blocks (after
+// FORMAT_COLUMNAR, if the relation is also columnar)
+#define FORMAT_COMPRESSED 2048
+
+// Longest string of a VARCHAR attribute
+#define MAX_STRING_LENGTH 1024
+// Number of bytes of a long string kept in its attribute, before LONG_STRING_MARKER, the
+// offset (2 bytes) of the string in its overflow block and the block number (4 bytes)
+#define LONG_STRING_PREFIX 8
+// Byte after the prefix of a long string
+#define LONG_STRING_MARKER 0xFF
+
 // Global variables for B+ Tree Layer
-// Maximum number of keys allowed in an Internal Node of a B+ tree
-#define MAX_KEYS_INTERNAL 100
-// Index of the middle element in an Internal Node of a B+ tree
-#define MIDDLE_INDEX_INTERNAL 50
-// Maximum number of keys allowed in a Leaf Node of a B+ tree
-#define MAX_KEYS_LEAF 63
-// Index of the middle element in a Leaf Node of a B+ tree
-#define MIDDLE_INDEX_LEAF 31
+// The fanout of B+ tree nodes depends on the block size, see BPlusTree::getMaxKeysInternal()
+// and BPlusTree::getMaxKeysLeaf() (100 and 63 keys for 2048 byte blocks)
 
 // Name strings for Relation Catalog and Attribute Catalog (as it is stored in the Relation catalog)
 #define RELCAT_RELNAME "RELATIONCAT"
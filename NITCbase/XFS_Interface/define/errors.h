@@ -58,4 +58,7 @@
 // Error: Cannot rename a relation to 'temp'
 #define E_RENAMETOTEMP -26
 
+// Error: The records of the relation are packed in formats that only EXPORT reads
+#define E_PACKEDRECORDS -27
+
 #endif  // NITCBASE_ERRORS_H
\ No newline at end of file
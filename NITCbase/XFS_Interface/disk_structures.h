@@ -34,18 +34,32 @@ typedef struct AttrCatEntry {
 	int offset;             // offset of the attribute in the relation
 } AttrCatEntry;
 
-typedef struct RecBlock {
-	int32_t blockType;
-	int32_t pblock;
-	int32_t lblock;
-	int32_t rblock;
-	int32_t numEntries;
-	int32_t numAttrs;
-	int32_t numSlots;
-	unsigned char reserved[4];
-	unsigned char slotMap_Records[BLOCK_SIZE - 104];
-	unsigned char unused[72];
-} RecBlock;
+/*
+ * Layout of the superblock (block SUPERBLOCK of a disk of format version 2 onwards).
+ * It is followed, at offset HEADER_SIZE, by numMapBlocks int32_t block numbers of
+ * the blocks holding the block allocation map, in order.
+ */
+typedef struct SuperBlock {
+	char magic[8];
+	int32_t formatVersion;
+	int32_t blockSize;
+	int32_t numBlocks;
+	int32_t numMapBlocks;
+	int32_t diskId;        // random id FDISK gives the disk, also kept in its write-ahead log
+	int32_t checkpointLsn; // last LSN of the write-ahead log at its last checkpoint
+} SuperBlock;
+
+/*
+ * Header at the start of the write-ahead log NITCbase keeps for the disk
+ * (its records follow, the tool only looks at whether there are any)
+ */
+typedef struct LogFileHeader {
+	char magic[8];
+	int32_t blockSize;
+	int32_t startLsn;
+	int32_t diskId;
+	unsigned char reserved[12];
+} LogFileHeader;
 
 typedef struct HeadInfo {
 	int32_t blockType;
@@ -73,7 +87,6 @@ typedef struct Index {
 	union Attribute attrVal;
 	int32_t block;
 	int32_t slot;
-	unsigned char unused[8];
 } Index;
 
 #endif //NITCBASE_DISK_STRUCTURES_H
@@ -1,12 +1,22 @@
 #include <iostream>
+#include <algorithm>
+#include <charconv>
 #include <cstdio>
 #include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
 #include "external_fs_commands.h"
 #include "disk_structures.h"
 #include "block_access.h"
 #include "OpenRelTable.h"
 #include "algebra.h"
 #include "schema.h"
+#include "Disk.h"
+#include "BPlusTree.h"
+#include "BlockCache.h"
+#include "block_compression.h"
 
 using namespace std;
 
@@ -118,11 +128,12 @@ void dump_attrcat() {
 }
 
 void dumpBlockAllocationMap() {
-	FILE *disk = fopen(&DISK_PATH[0], "rb+");
-	fseek(disk, 0, SEEK_SET);
-	unsigned char blockAllocationMap[4 * BLOCK_SIZE];
-	fread(blockAllocationMap, 4 * BLOCK_SIZE, 1, disk);
-	fclose(disk);
+	const int blockSize = Disk::getBlockSize();
+	const int numBlocks = Disk::getNumBlocks();
+	unsigned char *blockAllocationMap = (unsigned char *) malloc(Disk::getNumMapBlocks() * blockSize);
+
+	for (int mapIndex = 0; mapIndex < Disk::getNumMapBlocks(); mapIndex++)
+		Disk::readBlock(blockAllocationMap + mapIndex * blockSize, Disk::getMapBlock(mapIndex));
 
 	int blockNum;
 	char s[ATTR_SIZE];
@@ -135,16 +146,16 @@ void dumpBlockAllocationMap() {
 
 	FILE *fp_export = fopen(fileName, "w");
 
-	for (blockNum = 0; blockNum < 4; blockNum++) {
-		fputs("Block ", fp_export);
-		sprintf(s, "%d", blockNum);
-		fputs(s, fp_export);
-		fputs(": Block Allocation Map\n", fp_export);
-	}
-	for (blockNum = 4; blockNum < 8192; blockNum++) {
+	for (blockNum = 0; blockNum < numBlocks; blockNum++) {
 		fputs("Block ", fp_export);
 		sprintf(s, "%d", blockNum);
 		fputs(s, fp_export);
+		if (blockNum == SUPERBLOCK && Disk::getFormatVersion() >= 2) {
+			fputs(": Superblock\n", fp_export);
+		}
+		else if ((int32_t) (blockAllocationMap[blockNum]) == BMAP) {
+			fputs(": Block Allocation Map\n", fp_export);
+		}
 		if ((int32_t) (blockAllocationMap[blockNum]) == UNUSED_BLK) {
 			fputs(": Unused Block\n", fp_export);
 		}
@@ -157,9 +168,13 @@ void dumpBlockAllocationMap() {
 		if ((int32_t) (blockAllocationMap[blockNum]) == IND_LEAF) {
 			fputs(": Leaf Index Block\n", fp_export);
 		}
+		if ((int32_t) (blockAllocationMap[blockNum]) == OVERFLOW_BLK) {
+			fputs(": Overflow Block\n", fp_export);
+		}
 	}
 
 	fclose(fp_export);
+	free(blockAllocationMap);
 }
 
 void ls() {
@@ -177,126 +192,155 @@ void ls() {
 	std::cout << "\n";
 }
 
-int importRelation(char *fileName) {
+/*
+ * Splits a csv line into its fields, each cut to ATTR_SIZE - 1 characters; at most maxFields are kept
+ * Returns the number of fields in the line, or -1 if one of them is empty (null values are not allowed)
+ */
+static int splitCsvLine(const char *line, int maxFields, char fields[][ATTR_SIZE]) {
+	int numFields = 0;
+	while (true) {
+		const char *end = strchr(line, ',');
+		int length = end == nullptr ? strlen(line) : end - line;
+		if (length == 0)
+			return -1;
+		if (numFields < maxFields) {
+			int copied = std::min(length, ATTR_SIZE - 1);
+			memcpy(fields[numFields], line, copied);
+			fields[numFields][copied] = '\0';
+		}
+		numFields++;
+		if (end == nullptr)
+			return numFields;
+		line = end + 1;
+	}
+}
+
+/*
+ * Number of lines in the file after the current position (counting a last line with no '\n')
+ */
+static long long countRemainingLines(FILE *file) {
+	off_t start = ftello(file);
+	std::vector<char> buffer(IMPORT_BUFFER_SIZE);
+	long long numLines = 0;
+	char last = '\n';
+	size_t length;
+	while ((length = fread(buffer.data(), 1, buffer.size(), file)) > 0) {
+		numLines += std::count(buffer.data(), buffer.data() + length, '\n');
+		last = buffer[length - 1];
+	}
+	if (last != '\n')
+		numLines++;
+	fseeko(file, start, SEEK_SET);
+	return numLines;
+}
 
+/*
+ * Imports a csv file as a new relation named after the file
+ *      - The first line holds the attribute names; the types are inferred from the first record
+ *      - The catalog entries are created once, then the file is streamed and its records are written
+ *        as fully packed record blocks into one contiguous run of blocks taken up front (blocks
+ *        anywhere on the disk are used if no run is long enough and the disk cannot grow)
+ *      - A B+ tree is built bottom-up on each of the numIndexAttrs attributes in indexAttrs from the
+ *        entries collected while the records are written
+ * On any error nothing of the relation is left on the disk.
+ */
+int importRelation(char *fileName, int numIndexAttrs, char indexAttrs[][ATTR_SIZE]) {
 	FILE *file = fopen(fileName, "r");
+	char *line = nullptr;
+	size_t lineCapacity = 0;
+	ssize_t lineLength;
 
 	/*
-	 *  GET ATTRIBUTE NAMES FROM FIRST LINE OF FILE
+	 *  GET ATTRIBUTE NAMES FROM FIRST LINE OF FILE (spaces and tabs are dropped)
 	 */
-	char *firstLine = (char *) malloc(sizeof(char));
-	int numOfCharactersInLine = 1;
-	int currentCharacter, previousCharacter;
-	int numOfAttributes = 1;
-	previousCharacter = ',';
-	while ((currentCharacter = fgetc(file)) != '\n') {
-		if (currentCharacter == EOF)
-			break;
-		while (currentCharacter == ' ' || currentCharacter == '\t' || currentCharacter == '\n') {
-			currentCharacter = fgetc(file);
-		}
-		if (currentCharacter == EOF)
-			break;
-		if (currentCharacter == ',') {
-			numOfAttributes++;
-			if (previousCharacter == currentCharacter) {
-				cout << "Null values are not allowed in attribute names\n";
-				return FAILURE;
-			}
-		}
-		firstLine[numOfCharactersInLine - 1] = currentCharacter;
-		numOfCharactersInLine++;
-		firstLine = (char *) realloc(firstLine, (numOfCharactersInLine) * sizeof(char));
-		previousCharacter = currentCharacter;
+	lineLength = getline(&line, &lineCapacity, file);
+	if (lineLength < 0)
+		lineLength = 0;
+	int headerLength = 0;
+	for (int i = 0; i < lineLength && line[i] != '\n'; i++) {
+		if (line[i] != ' ' && line[i] != '\t')
+			line[headerLength++] = line[i];
 	}
+	line[headerLength] = '\0';
 
-	if (previousCharacter == ',') {
+	int numOfAttributes = splitCsvLine(line, 0, nullptr);
+	if (numOfAttributes < 0) {
 		cout << "Null values are not allowed in attribute names\n";
+		free(line);
+		fclose(file);
 		return FAILURE;
 	}
+	if (numOfAttributes > 125) {
+		free(line);
+		fclose(file);
+		return E_MAXATTRS;
+	}
 
-    if (numOfAttributes > 125) {
-        return E_MAXATTRS;
-    }
-
-	firstLine[numOfCharactersInLine - 1] = '\0';
-	int currentCharIndexInLine = 0, attrOffsetIterator, attributeIndexIterator;
 	char attributeNames[numOfAttributes][ATTR_SIZE];
-	attrOffsetIterator = 0;
-	while (attrOffsetIterator < numOfAttributes) {
-		attributeIndexIterator = 0;
-		while (((firstLine[currentCharIndexInLine] != ',') && (firstLine[currentCharIndexInLine] != '\0')) &&
-		       (attributeIndexIterator < ATTR_SIZE - 1)) {
-			if (checkIfInvalidCharacter(firstLine[currentCharIndexInLine])) {
-				cout << "Invalid character : '" << firstLine[currentCharIndexInLine] << "' in attribute name\n";
+	splitCsvLine(line, numOfAttributes, attributeNames);
+	for (int attrOffset = 0; attrOffset < numOfAttributes; attrOffset++) {
+		for (char *name = attributeNames[attrOffset]; *name != '\0'; name++) {
+			if (checkIfInvalidCharacter(*name)) {
+				cout << "Invalid character : '" << *name << "' in attribute name\n";
+				free(line);
+				fclose(file);
 				return FAILURE;
 			}
-			attributeNames[attrOffsetIterator][attributeIndexIterator++] = firstLine[currentCharIndexInLine++];
 		}
-		if (attributeIndexIterator == ATTR_SIZE - 1) {
-			while (firstLine[currentCharIndexInLine] != ',')
-				currentCharIndexInLine++;
+	}
+
+	// attributes to build a B+ tree on (each once)
+	std::vector<int> indexOffsets;
+	for (int i = 0; i < numIndexAttrs; i++) {
+		int attrOffset = 0;
+		while (attrOffset < numOfAttributes && strcmp(attributeNames[attrOffset], indexAttrs[i]) != 0)
+			attrOffset++;
+		if (attrOffset == numOfAttributes) {
+			free(line);
+			fclose(file);
+			return E_ATTRNOTEXIST;
 		}
-		attributeNames[attrOffsetIterator][attributeIndexIterator] = '\0';
-		attrOffsetIterator++;
-		currentCharIndexInLine++;
+		if (std::find(indexOffsets.begin(), indexOffsets.end(), attrOffset) == indexOffsets.end())
+			indexOffsets.push_back(attrOffset);
 	}
-	currentCharIndexInLine = 0;
 
 	/*
-	 *  INFER ATTRIBUTE TYPES FROM SECOND LINE OF FILE
+	 *  INFER ATTRIBUTE TYPES FROM THE FIRST RECORD
 	 */
-	char *secondLine = (char *) malloc(sizeof(char));
-	numOfCharactersInLine = 1;
-	while ((currentCharacter = fgetc(file)) != '\n') {
-		if (currentCharacter == EOF)
+	const long long maxRecords = countRemainingLines(file);
+	char fields[numOfAttributes][ATTR_SIZE];
+	int attrTypes[numOfAttributes];
+	char *record = nullptr;
+	int lineNumber = 1;
+	while ((lineLength = getline(&line, &lineCapacity, file)) >= 0) {
+		lineNumber++;
+		record = line + strspn(line, " \t\n");
+		if (*record != '\0')
 			break;
-		secondLine[numOfCharactersInLine - 1] = currentCharacter;
-		numOfCharactersInLine++;
-		secondLine = (char *) realloc(secondLine, (numOfCharactersInLine) * sizeof(char));
 	}
-	secondLine[numOfCharactersInLine - 1] = '\0';
-	currentCharIndexInLine = 0;
-	char secondLineFields[numOfAttributes][ATTR_SIZE];
-	int attrTypes[numOfAttributes];
-	attrOffsetIterator = 0;
-	while (attrOffsetIterator < numOfAttributes) {
-		attributeIndexIterator = 0;
-		while (((secondLine[currentCharIndexInLine] != ',') && (secondLine[currentCharIndexInLine] != '\0')) &&
-		       (attributeIndexIterator < ATTR_SIZE - 1)) {
-			secondLineFields[attrOffsetIterator][attributeIndexIterator++] = secondLine[currentCharIndexInLine++];
-		}
-		secondLineFields[attrOffsetIterator][attributeIndexIterator] = '\0';
-		attrTypes[attrOffsetIterator] = checkAttrTypeOfValue(secondLineFields[attrOffsetIterator]);
-
-		attrOffsetIterator++;
-		currentCharIndexInLine++;
+	for (int attrOffset = 0; attrOffset < numOfAttributes; attrOffset++)
+		fields[attrOffset][0] = '\0';
+	if (lineLength >= 0) {
+		record[strcspn(record, "\n")] = '\0';
+		splitCsvLine(record, numOfAttributes, fields);
 	}
+	for (int attrOffset = 0; attrOffset < numOfAttributes; attrOffset++)
+		attrTypes[attrOffset] = checkAttrTypeOfValue(fields[attrOffset]);
 
 	// EXTRACT RELATION NAME FROM FILE PATH
-	currentCharIndexInLine = 0;
 	char relationName[ATTR_SIZE];
-	int fileNameIterator = strlen(fileName) - 1;
-	while (fileName[fileNameIterator] != '.') {
-		fileNameIterator--;
-	}
-	fileNameIterator--;
-	int end = fileNameIterator;
-	while (fileName[fileNameIterator] != '/') {
-		fileNameIterator--;
-	}
-	int start;
-	int relname_iter;
-	for (start = fileNameIterator + 1, relname_iter = 0;
-	     start <= end && relname_iter < ATTR_SIZE - 1; start++, relname_iter++) {
-		relationName[relname_iter] = fileName[start];
-	}
-	if (relname_iter == ATTR_SIZE - 1) {
+	const char *baseName = strrchr(fileName, '/') + 1;
+	int nameLength = strrchr(fileName, '.') - baseName;
+	if (nameLength > ATTR_SIZE - 1) {
 		cout << "File name is more than 15 characters, trimming to get relation name\n";
+		nameLength = ATTR_SIZE - 1;
 	}
-	relationName[relname_iter] = '\0';
+	memcpy(relationName, baseName, nameLength);
+	relationName[nameLength] = '\0';
 
 	if (std::strcmp(relationName, TEMP) == 0) {
+		free(line);
+		fclose(file);
 		return E_CREATETEMP;
 	}
 
@@ -305,6 +349,8 @@ int importRelation(char *fileName) {
 	ret = createRel(relationName, numOfAttributes, attributeNames, attrTypes);
 	if (ret != SUCCESS) {
 		cout << "Import not possible as createRel failed\n";
+		free(line);
+		fclose(file);
 		return ret;
 	}
 
@@ -312,146 +358,310 @@ int importRelation(char *fileName) {
 	int relId = OpenRelTable::openRelation(relationName);
 	if (relId == E_CACHEFULL) {
 		cout << "Import not possible as openRel failed\n";
+		ba_delete(relationName);
+		free(line);
+		fclose(file);
 		return FAILURE;
 	}
 
-	// Skip first line containing attribute names
-	file = fopen(fileName, "r");
-	while ((currentCharacter = fgetc(file)) != '\n')
-		continue;
-
-	char *currentLineAsCharArray = (char *) malloc(sizeof(char));
-	numOfCharactersInLine = 1;
-
-	int lineNumber = 2;
-	while (true) {
-		currentCharacter = fgetc(file);
-		if (currentCharacter == EOF)
-			break;
-		while (currentCharacter == ' ' || currentCharacter == '\t' || currentCharacter == '\n') {
-			currentCharacter = fgetc(file);
-		}
-		if (currentCharacter == EOF)
-			break;
-		numOfCharactersInLine = 1;
-		int numOfFieldsInLine = 0;
-		previousCharacter = ',';
-
-
-		while ((currentCharacter != '\n') && (currentCharacter != EOF)) {
+	Attribute relCatEntry[NO_OF_ATTRS_RELCAT_ATTRCAT];
+	getRelCatEntry(relId, relCatEntry);
+	const int numSlots = (int) relCatEntry[RELCAT_NO_SLOTS_PER_BLOCK_INDEX].nval;
+	const int recordSize = numOfAttributes * ATTR_SIZE;
 
-			if (currentCharacter == ',')
-				numOfFieldsInLine++;
-			if (currentCharacter == previousCharacter && currentCharacter == ',') {
-				OpenRelTable::closeRelation(relId);
-				ba_delete(relationName);
-				cout << "Null values are not allowed in attribute fields\n";
-				return FAILURE;
-			}
-			currentLineAsCharArray[numOfCharactersInLine - 1] = currentCharacter;
-			numOfCharactersInLine++;
-			currentLineAsCharArray = (char *) realloc(currentLineAsCharArray, (numOfCharactersInLine) * sizeof(char));
-			previousCharacter = currentCharacter;
+	/*
+	 *  TAKE THE RECORD BLOCKS (enough for a record on every remaining line)
+	 */
+	std::vector<int> blocks;
+	const long long numBlocksNeeded = (maxRecords + numSlots - 1) / numSlots;
+	int firstBlock = numBlocksNeeded > 0 ? getFreeBlockRun(numBlocksNeeded, REC) : FAILURE;
+	if (firstBlock != FAILURE) {
+		for (int i = 0; i < numBlocksNeeded; i++)
+			blocks.push_back(firstBlock + i);
+	} else {
+		int blockNum;
+		while ((long long) blocks.size() < numBlocksNeeded && (blockNum = getFreeBlock(REC)) != FAILURE)
+			blocks.push_back(blockNum);
+	}
 
-			currentCharacter = fgetc(file);
+	std::vector<int> rootBlocks;
+	auto abortImport = [&](int error) {
+		for (int rootBlock : rootBlocks)
+			BPlusTree::bPlusDestroy(rootBlock);
+		for (int blockNum : blocks)
+			deleteBlock(blockNum);
+		OpenRelTable::closeRelation(relId);
+		ba_delete(relationName);
+		free(line);
+		fclose(file);
+		return error;
+	};
+	if ((long long) blocks.size() < numBlocksNeeded)
+		return abortImport(E_DISKFULL);
 
+	/*
+	 *  STREAM THE RECORDS INTO THE BLOCKS
+	 */
+	std::vector<unsigned char> block(Disk::getBlockSize(), 0);
+	std::vector<std::vector<Index>> indexEntries(indexOffsets.size());
+	Attribute recordValues[numOfAttributes];
+	int numRecords = 0, blockIndex = 0, slot = 0;
+
+	// writes out the block being filled, linked to the blocks before and after it
+	auto writeRecordBlock = [&](bool last) {
+		HeadInfo header;
+		memset(&header, 0, sizeof(HeadInfo));
+		header.blockType = REC;
+		header.pblock = -1;
+		header.lblock = blockIndex > 0 ? blocks[blockIndex - 1] : -1;
+		header.rblock = last ? -1 : blocks[blockIndex + 1];
+		header.numEntries = slot;
+		header.numAttrs = numOfAttributes;
+		header.numSlots = numSlots;
+		memcpy(block.data(), &header, HEADER_SIZE);
+		if (Disk::getFormatVersion() < BITMAP_SLOT_MAP_VERSION) {
+			memset(block.data() + HEADER_SIZE, SLOT_OCCUPIED, slot);
+			memset(block.data() + HEADER_SIZE + slot, SLOT_UNOCCUPIED, numSlots - slot);
+		} else {
+			// the first slot bytes whole, then the bits of the rest of the slots
+			memset(block.data() + HEADER_SIZE, 0, getSlotmapSize(numSlots));
+			memset(block.data() + HEADER_SIZE, 0xFF, slot / 8);
+			if (slot % 8 != 0)
+				block[HEADER_SIZE + slot / 8] = (1 << (slot % 8)) - 1;
 		}
+		Disk::writeBlock(block.data(), blocks[blockIndex]);
+	};
 
-		if (previousCharacter == ',') {
-			OpenRelTable::closeRelation(relId);
-			ba_delete(relationName);
+	for (; lineLength >= 0; lineLength = getline(&line, &lineCapacity, file), lineNumber++) {
+		record = line + strspn(line, " \t\n");
+		if (*record == '\0')
+			continue;
+		record[strcspn(record, "\n")] = '\0';
 
+		int numOfFieldsInLine = splitCsvLine(record, numOfAttributes, fields);
+		if (numOfFieldsInLine < 0) {
 			cout << "Null values are not allowed in attribute fields\n";
-			return FAILURE;
+			return abortImport(FAILURE);
 		}
-		if (numOfAttributes != numOfFieldsInLine + 1) {
-			OpenRelTable::closeRelation(relId);
-			ba_delete(relationName);
-
+		if (numOfFieldsInLine != numOfAttributes) {
 			cout << "Mismatch in number of attributes\n";
-			return FAILURE;
+			return abortImport(FAILURE);
 		}
-		currentLineAsCharArray[numOfCharactersInLine - 1] = '\0';
-		currentCharIndexInLine = 0;
-
-		char attributesCharArray[numOfAttributes][ATTR_SIZE];
-		attrOffsetIterator = 0;
-		while (attrOffsetIterator < numOfAttributes) {
-			attributeIndexIterator = 0;
-
-			while (((currentLineAsCharArray[currentCharIndexInLine] != ',') &&
-			        (currentLineAsCharArray[currentCharIndexInLine] != '\0')) &&
-			       (attributeIndexIterator < ATTR_SIZE - 1)) {
-				attributesCharArray[attrOffsetIterator][attributeIndexIterator++] = currentLineAsCharArray[currentCharIndexInLine++];
-			}
-			if (attributeIndexIterator == ATTR_SIZE - 1) {
-				while (currentLineAsCharArray[currentCharIndexInLine] != ',')
-					currentCharIndexInLine++;
-			}
-			currentCharIndexInLine++;
-			attributesCharArray[attrOffsetIterator][attributeIndexIterator] = '\0';
-
-			attrOffsetIterator++;
-		}
-
-		Attribute record[numOfAttributes];
-		int retValue = constructRecordFromAttrsArray(numOfAttributes, record, attributesCharArray, attrTypes);
 
+		int retValue = constructRecordFromAttrsArray(numOfAttributes, recordValues, fields, attrTypes);
 		if (retValue == E_ATTRTYPEMISMATCH) {
-			OpenRelTable::closeRelation(relId);
-			ba_delete(relationName);
-
-			return E_ATTRTYPEMISMATCH;
+			return abortImport(E_ATTRTYPEMISMATCH);
 		} else if (retValue == E_INVALID) {
-			OpenRelTable::closeRelation(relId);
-			ba_delete(relationName);
-
 			cout << "Invalid character at line " << lineNumber << " in file \n";
-			return FAILURE;
+			return abortImport(FAILURE);
 		}
 
-		int retVal = ba_insert(relId, record);
+		if (slot == numSlots) {
+			writeRecordBlock(false);
+			blockIndex++;
+			slot = 0;
+		}
+		memcpy(block.data() + HEADER_SIZE + getSlotmapSize(numSlots) + slot * recordSize, recordValues, recordSize);
+		for (size_t i = 0; i < indexOffsets.size(); i++) {
+			Index entry;
+			memset(&entry, 0, sizeof(Index));
+			entry.attrVal = getLeafKey(recordValues[indexOffsets[i]], attrTypes[indexOffsets[i]]);
+			entry.block = blocks[blockIndex];
+			entry.slot = slot;
+			indexEntries[i].push_back(entry);
+		}
+		slot++;
+		numRecords++;
+	}
 
-		if (retVal != SUCCESS) {
-			OpenRelTable::closeRelation(relId);
-			ba_delete(relationName);
+	// release the blocks left over by blank lines
+	const int numBlocksUsed = numRecords > 0 ? blockIndex + 1 : 0;
+	if (numBlocksUsed > 0)
+		writeRecordBlock(true);
+	for (int i = numBlocksUsed; i < (int) blocks.size(); i++)
+		deleteBlock(blocks[i]);
+	blocks.resize(numBlocksUsed);
 
-			cout << "Insert failed at line"<< lineNumber << " in file"  << endl;
-			return retVal;
-		}
-		if (currentCharacter == EOF)
-			break;
+	/*
+	 *  BUILD THE B+ TREES
+	 */
+	Attribute attrCatEntry[NO_OF_ATTRS_RELCAT_ATTRCAT];
+	for (size_t i = 0; i < indexOffsets.size(); i++) {
+		const int attrType = attrTypes[indexOffsets[i]];
+		std::sort(indexEntries[i].begin(), indexEntries[i].end(), [attrType](const Index &a, const Index &b) {
+			int cmpVal = compareAttributes(a.attrVal, b.attrVal, attrType);
+			if (cmpVal != 0)
+				return cmpVal < 0;
+			return a.block != b.block ? a.block < b.block : a.slot < b.slot;
+		});
+		int rootBlock = BPlusTree::bulkLoad(indexEntries[i]);
+		std::vector<Index>().swap(indexEntries[i]);
+		if (rootBlock < 0)
+			return abortImport(rootBlock);
+		rootBlocks.push_back(rootBlock);
+	}
 
-		lineNumber++;
+	/*
+	 *  UPDATE THE CATALOGS
+	 */
+	relCatEntry[RELCAT_NO_RECORDS_INDEX].nval = numRecords;
+	relCatEntry[RELCAT_FIRST_BLOCK_INDEX].nval = blocks.empty() ? -1 : blocks.front();
+	relCatEntry[RELCAT_LAST_BLOCK_INDEX].nval = blocks.empty() ? -1 : blocks.back();
+	setRelCatEntry(relId, relCatEntry);
+
+	for (size_t i = 0; i < indexOffsets.size(); i++) {
+		getAttrCatEntry(relId, attributeNames[indexOffsets[i]], attrCatEntry);
+		attrCatEntry[ATTRCAT_ROOT_BLOCK_INDEX].nval = rootBlocks[i];
+		setAttrCatEntry(relId, attributeNames[indexOffsets[i]], attrCatEntry);
 	}
+
 	OpenRelTable::closeRelation(relId);
+	free(line);
 	fclose(file);
 	return SUCCESS;
 }
 
-int exportRelation(char *relname, char *filename) {
-	FILE *fp_export = fopen(filename, "w");
+/*
+ * Writes the 'used' bytes at the start of buffer to fd
+ */
+static int writeAll(int fd, const char *buffer, size_t used) {
+	while (used > 0) {
+		ssize_t written = write(fd, buffer, used);
+		if (written < 0)
+			return FAILURE;
+		buffer += written;
+		used -= written;
+	}
+	return SUCCESS;
+}
 
-	if (!fp_export) {
-		cout << " Invalid file path" << endl;
-		return FAILURE;
+/*
+ * Copies the long string of a VARCHAR attribute to out, from the overflow block it is stored in
+ *      - attr holds a prefix of the string, LONG_STRING_MARKER, the offset of the string in its
+ *        overflow block and the block number; the string is stored there as its 2 byte length and
+ *        its bytes
+ * Returns the end of the string.
+ */
+static char *formatLongString(char *out, Attribute *attr) {
+	uint16_t offset;
+	int32_t blockNum;
+	memcpy(&offset, attr->sval + LONG_STRING_PREFIX + 2, sizeof(uint16_t));
+	memcpy(&blockNum, attr->sval + LONG_STRING_PREFIX + 4, sizeof(int32_t));
+
+	const unsigned char *block = BlockCache::getBlock(blockNum);
+	uint16_t length;
+	memcpy(&length, block + offset, sizeof(uint16_t));
+	length = std::min<int>(length, MAX_STRING_LENGTH);
+	memcpy(out, block + offset + 2, length);
+	return out + length;
+}
+
+/*
+ * Copies the string attribute attr to out, which has room for MAX_STRING_LENGTH bytes
+ *      - A long string is read from its overflow block (see formatLongString())
+ * Returns the end of the string (it is not terminated).
+ */
+char *formatString(char *out, Attribute *attr) {
+	if ((unsigned char) attr->sval[LONG_STRING_PREFIX] == LONG_STRING_MARKER &&
+	    memchr(attr->sval, '\0', LONG_STRING_PREFIX) == nullptr)
+		return formatLongString(out, attr);
+	size_t length = strnlen(attr->sval, ATTR_SIZE);
+	memcpy(out, attr->sval, length);
+	return out + length;
+}
+
+/*
+ * Formats the record rec (of the given attribute types) as a csv line at out, numbers
+ * the way printf("%f") does. Returns the end of the line.
+ */
+static char *formatRecord(char *out, Attribute *rec, int *attrType, int numOfAttrs) {
+	for (int l = 0; l < numOfAttrs; l++) {
+		if (attrType[l] == NUMBER)
+			out = std::to_chars(out, out + EXPORT_MAX_NUMBER_LENGTH, rec[l].nval, std::chars_format::fixed, 6).ptr;
+		else
+			out = formatString(out, &rec[l]);
+		*out++ = (l != numOfAttrs - 1) ? ',' : '\n';
+	}
+	return out;
+}
+
+/*
+ * Copies the record in slotNum of the numSlots records at records, with its attributes packed in
+ * the given formats at attrOffset, to rec
+ *      - A columnar block keeps the values of attribute l together, from numSlots * attrOffset[l]
+ */
+void unpackRecord(const unsigned char *records, int numSlots, int slotNum, bool columnar, int recordSize,
+		int *attrFormat, int *attrOffset, int numOfAttrs, Attribute *rec) {
+	for (int l = 0; l < numOfAttrs; l++) {
+		const int format = attrFormat[l];
+		const unsigned char *recPtr;
+		if (columnar)
+			recPtr = records + numSlots * attrOffset[l] + slotNum * getFormatSize(format);
+		else
+			recPtr = records + slotNum * recordSize + attrOffset[l];
+		if (format == FORMAT_DOUBLE) {
+			memcpy(&rec[l].nval, recPtr, sizeof(double));
+		} else if (format == FORMAT_INT32) {
+			int32_t value;
+			memcpy(&value, recPtr, sizeof(int32_t));
+			rec[l].nval = value;
+		} else if (format == FORMAT_INT64) {
+			int64_t value;
+			memcpy(&value, recPtr, sizeof(int64_t));
+			rec[l].nval = (double) value;
+		} else if (format == FORMAT_DEFAULT || format == FORMAT_VARCHAR) {
+			memcpy(&rec[l], recPtr, ATTR_SIZE);
+		} else {
+			// a string of the declared length is not terminated
+			memset(rec[l].sval, 0, ATTR_SIZE);
+			memcpy(rec[l].sval, recPtr, format - FORMAT_CHAR);
+		}
 	}
+}
 
-	HeadInfo headInfo;
-	Attribute relcat_rec[6];
+/*
+ * Reads the record block blockNum into block, which has room for getExpandedBlockSize() bytes
+ *      - A compressed record block is expanded (see block_compression.h), so the caller always
+ *        sees the header, slotmap and records of an ordinary record block
+ */
+int readRecordBlock(unsigned char *block, int blockNum) {
+	Disk::readBlock(block, blockNum);
+	if (((HeadInfo *) block)->blockType != COMPRESSED_REC)
+		return SUCCESS;
+	std::vector<unsigned char> compressed(block, block + Disk::getBlockSize());
+	return expandBlock(compressed.data(), block);
+}
 
-	int firstBlock, numOfAttrs;
-	int slotNum;
-	for (slotNum = 0; slotNum < SLOTMAP_SIZE_RELCAT_ATTRCAT; slotNum++) {
-		int retval = getRecord(relcat_rec, RELCAT_BLOCK, slotNum);
-		if (retval == SUCCESS && strcmp(relcat_rec[0].sval, relname) == 0) {
+/*
+ * Writes the records of relname to filename as csv, with a header line of the attribute names
+ *      - Every block of the relation (and of the catalogs) is read from the disk once
+ *      - The records of a relation with packed attributes or columnar blocks (see
+ *        hasPackedRecords()) are unpacked one at a time
+ *      - A compressed record block is expanded once it is read (see block_compression.h)
+ *      - Whole blocks of records are formatted into an EXPORT_BUFFER_SIZE buffer, which is
+ *        written out with a single write() whenever it cannot take another record
+ */
+int exportRelation(char *relname, char *filename) {
+	// (room for a compressed record block once it is expanded)
+	std::vector<unsigned char> blockData(getExpandedBlockSize());
+	unsigned char *block = blockData.data();
+	HeadInfo *header = (HeadInfo *) block;
+
+	// find the relation in the relation catalog
+	int firstBlock = -1, numOfAttrs = 0;
+	bool found = false;
+	Disk::readBlock(block, RELCAT_BLOCK);
+	for (int slotNum = 0; slotNum < SLOTMAP_SIZE_RELCAT_ATTRCAT; slotNum++) {
+		Attribute *relcat_rec = (Attribute *) (block + HEADER_SIZE + getSlotmapSize(header->numSlots)) + slotNum * RELCAT_NO_ATTRS;
+		if (isSlotOccupied(block, slotNum) && strcmp(relcat_rec[0].sval, relname) == 0) {
 			firstBlock = (int) relcat_rec[3].nval;
 			numOfAttrs = (int) relcat_rec[1].nval;
+			found = true;
 			break;
 		}
 	}
 
-	if (slotNum == SLOTMAP_SIZE_RELCAT_ATTRCAT) {
+	if (!found) {
 		cout << "The relation does not exist\n";
 		return FAILURE;
 	}
@@ -460,91 +670,298 @@ int exportRelation(char *relname, char *filename) {
 		return FAILURE;
 	}
 
-	Attribute rec[6];
-
-	int recBlock_Attrcat = ATTRCAT_BLOCK;
-	int nextRecBlock_Attrcat;
-
-	// Array for attribute names and types
-	int attrNo = 0;
+	// Array for attribute names and types, from the Attribute Catalog blocks
 	char attrName[numOfAttrs][ATTR_SIZE];
 	int attrType[numOfAttrs];
-
-	/*
-	 * Searching the Attribute Catalog Disk Blocks
-	 * for finding and storing all the attributes of the given relation
-	 */
-	while (recBlock_Attrcat != -1) {
-		headInfo = getHeader(recBlock_Attrcat);
-		nextRecBlock_Attrcat = headInfo.rblock;
-		for (slotNum = 0; slotNum < SLOTMAP_SIZE_RELCAT_ATTRCAT; slotNum++) {
-			int retval = getRecord(rec, recBlock_Attrcat, slotNum);
-			if (retval == SUCCESS && strcmp(rec[0].sval, relname) == 0) {
+	int attrFormat[numOfAttrs];
+	bool columnar = false;
+	int attrNo = 0;
+	for (int attrCatBlock = ATTRCAT_BLOCK; attrCatBlock != -1; attrCatBlock = header->rblock) {
+		Disk::readBlock(block, attrCatBlock);
+		Attribute *records = (Attribute *) (block + HEADER_SIZE + getSlotmapSize(header->numSlots));
+		for (int slotNum = 0; slotNum < header->numSlots && attrNo < numOfAttrs; slotNum++) {
+			Attribute *rec = records + slotNum * ATTRCAT_NO_ATTRS;
+			if (isSlotOccupied(block, slotNum) && strcmp(rec[0].sval, relname) == 0) {
 				// Attribute belongs to this Relation - add info to array
 				strcpy(attrName[attrNo], rec[1].sval);
 				attrType[attrNo] = (int) rec[2].nval;
+				attrFormat[attrNo] = getAttrFormat(rec);
+				columnar = isColumnar(rec);
 				attrNo++;
 			}
 		}
-		recBlock_Attrcat = nextRecBlock_Attrcat;
 	}
 
-	// Write the Attribute names to o/p file
+	int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		cout << " Invalid file path" << endl;
+		return FAILURE;
+	}
+
+	bool packed = columnar;
+	int packedRecordSize = 0;
+	int attrOffset[numOfAttrs];
 	for (attrNo = 0; attrNo < numOfAttrs; attrNo++) {
-		fputs(attrName[attrNo], fp_export);
-		if (attrNo != numOfAttrs - 1)
-			fputs(",", fp_export);
+		packed = packed || attrFormat[attrNo] != FORMAT_DEFAULT;
+		attrOffset[attrNo] = packedRecordSize;
+		packedRecordSize += getFormatSize(attrFormat[attrNo]);
 	}
+	Attribute unpacked[numOfAttrs];
 
-	fputs("\n", fp_export);
+	std::vector<char> buffer(EXPORT_BUFFER_SIZE);
+	// longest line a record can take
+	const size_t maxLineLength = (size_t) numOfAttrs * (std::max(EXPORT_MAX_NUMBER_LENGTH, MAX_STRING_LENGTH) + 1);
+	char *out = buffer.data();
+	int ret = SUCCESS;
 
-	int block_num = firstBlock;
-	int num_slots;
-	int num_attrs;
+	// Write the Attribute names
+	for (attrNo = 0; attrNo < numOfAttrs; attrNo++) {
+		size_t length = strnlen(attrName[attrNo], ATTR_SIZE);
+		memcpy(out, attrName[attrNo], length);
+		out += length;
+		*out++ = (attrNo != numOfAttrs - 1) ? ',' : '\n';
+	}
 
 	/*
 	 * Iterate over the record blocks of this relation
 	 * Linked list traversal
 	 */
-	while (block_num != -1) {
-		headInfo = getHeader(block_num);
-
-		num_slots = headInfo.numSlots;
-		num_attrs = headInfo.numAttrs;
-		nextRecBlock_Attrcat = headInfo.rblock;
-
-		unsigned char slotmap[num_slots];
-		getSlotmap(slotmap, block_num);
-
-		Attribute A[num_attrs];
-		slotNum = 0;
-		// Go through all slots and write the record entry to file
-		for (slotNum = 0; slotNum < num_slots; slotNum++) {
-			if (slotmap[slotNum] == SLOT_OCCUPIED) {
-				getRecord(A, block_num, slotNum);
-				char s[ATTR_SIZE];
-				for (int l = 0; l < numOfAttrs; l++) {
-					if (attrType[l] == NUMBER) {
-						sprintf(s, "%f", A[l].nval);
-						fputs(s, fp_export);
-					}
-					if (attrType[l] == STRING) {
-						fputs(A[l].sval, fp_export);
-					}
-					if (l != numOfAttrs - 1)
-						fputs(",", fp_export);
+	for (int blockNum = firstBlock; blockNum != -1 && ret == SUCCESS; blockNum = header->rblock) {
+		if (readRecordBlock(block, blockNum) != SUCCESS) {
+			cout << "Block " << blockNum << " of the relation is corrupt\n";
+			ret = FAILURE;
+			break;
+		}
+		const int numSlots = header->numSlots;
+		const int numAttrs = header->numAttrs;
+		Attribute *records = (Attribute *) (block + HEADER_SIZE + getSlotmapSize(numSlots));
+
+		for (int slotNum = 0; slotNum < numSlots; slotNum++) {
+			if (!isSlotOccupied(block, slotNum))
+				continue;
+			if ((size_t) (buffer.data() + buffer.size() - out) < maxLineLength) {
+				ret = writeAll(fd, buffer.data(), out - buffer.data());
+				out = buffer.data();
+				if (ret != SUCCESS)
+					break;
+			}
+			if (packed) {
+				unpackRecord((unsigned char *) records, numSlots, slotNum, columnar, packedRecordSize, attrFormat,
+						attrOffset, numOfAttrs, unpacked);
+				out = formatRecord(out, unpacked, attrType, numOfAttrs);
+			} else {
+				out = formatRecord(out, records + slotNum * numAttrs, attrType, numOfAttrs);
+			}
+		}
+	}
+
+	if (ret == SUCCESS)
+		ret = writeAll(fd, buffer.data(), out - buffer.data());
+	if (close(fd) != 0)
+		ret = FAILURE;
+	if (ret != SUCCESS)
+		cout << "Could not write to " << filename << endl;
+	return ret;
+}
+
+/*
+ * Rewrites the record block blockNum, with a byte per slot in its slotmap, as a block of newSlots
+ * slots with a bitmap
+ *      - The records are made of columns of the given sizes, each kept together from numSlots times
+ *        the sizes of the columns before it: a row block is one column of the record size, a
+ *        columnar block has a column per attribute
+ *      - Every record keeps its slot, so the record ids in the indexes stay valid
+ */
+static void upgradeRecordBlock(int blockNum, int newSlots, const std::vector<int> &columnSizes) {
+	const int blockSize = Disk::getBlockSize();
+	std::vector<unsigned char> oldBlock(blockSize), newBlock(blockSize, 0);
+	Disk::readBlock(oldBlock.data(), blockNum);
+
+	HeadInfo header;
+	memcpy(&header, oldBlock.data(), HEADER_SIZE);
+	const int oldSlots = header.numSlots;
+	header.numSlots = newSlots;
+	memcpy(newBlock.data(), &header, HEADER_SIZE);
+
+	for (int slot = 0; slot < oldSlots; slot++) {
+		if (oldBlock[HEADER_SIZE + slot] == SLOT_OCCUPIED)
+			newBlock[HEADER_SIZE + slot / 8] |= 1 << (slot % 8);
+	}
+
+	const unsigned char *oldRecords = oldBlock.data() + HEADER_SIZE + oldSlots;
+	unsigned char *newRecords = newBlock.data() + HEADER_SIZE + getSlotmapSize(newSlots);
+	int columnOffset = 0;
+	for (int columnSize : columnSizes) {
+		memcpy(newRecords + newSlots * columnOffset, oldRecords + oldSlots * columnOffset, oldSlots * columnSize);
+		columnOffset += columnSize;
+	}
+	Disk::writeBlock(newBlock.data(), blockNum);
+}
+
+/*
+ * Converts the record blocks of a disk of format version 2 to those of BITMAP_SLOT_MAP_VERSION,
+ * which have a bit per slot in their slotmap instead of a byte
+ *      - The catalogs keep their SLOTMAP_SIZE_RELCAT_ATTRCAT slots per block; every other relation
+ *        gets the slots the smaller slotmap leaves room for, in its relation catalog entry too
+ */
+static void upgradeSlotmaps() {
+	struct RelationInfo {
+		char name[ATTR_SIZE];
+		int firstBlock;
+		int relcatBlock, relcatSlot;
+		std::vector<int> attrFormat;
+		bool columnar;
+	};
+	std::vector<RelationInfo> relations;
+	std::vector<int> relcatBlocks, attrcatBlocks;
+
+	// read the catalogs while the disk still has byte slotmaps
+	const int blockSize = Disk::getBlockSize();
+	unsigned char block[blockSize];
+	HeadInfo *header = (HeadInfo *) block;
+	for (int blockNum = RELCAT_BLOCK; blockNum != -1; blockNum = header->rblock) {
+		Disk::readBlock(block, blockNum);
+		relcatBlocks.push_back(blockNum);
+		Attribute *records = (Attribute *) (block + HEADER_SIZE + getSlotmapSize(header->numSlots));
+		for (int slotNum = 0; slotNum < header->numSlots; slotNum++) {
+			Attribute *rec = records + slotNum * RELCAT_NO_ATTRS;
+			if (!isSlotOccupied(block, slotNum))
+				continue;
+			RelationInfo relation;
+			memcpy(relation.name, rec[RELCAT_REL_NAME_INDEX].sval, ATTR_SIZE);
+			relation.firstBlock = (int) rec[RELCAT_FIRST_BLOCK_INDEX].nval;
+			relation.relcatBlock = blockNum;
+			relation.relcatSlot = slotNum;
+			relation.attrFormat.resize((int) rec[RELCAT_NO_ATTRIBUTES_INDEX].nval, FORMAT_DEFAULT);
+			relation.columnar = false;
+			relations.push_back(relation);
+		}
+	}
+	for (int blockNum = ATTRCAT_BLOCK; blockNum != -1; blockNum = header->rblock) {
+		Disk::readBlock(block, blockNum);
+		attrcatBlocks.push_back(blockNum);
+		Attribute *records = (Attribute *) (block + HEADER_SIZE + getSlotmapSize(header->numSlots));
+		for (int slotNum = 0; slotNum < header->numSlots; slotNum++) {
+			Attribute *rec = records + slotNum * ATTRCAT_NO_ATTRS;
+			if (!isSlotOccupied(block, slotNum))
+				continue;
+			for (RelationInfo &relation : relations) {
+				int offset = (int) rec[ATTRCAT_OFFSET_INDEX].nval;
+				if (strcmp(relation.name, rec[ATTRCAT_REL_NAME_INDEX].sval) == 0 &&
+				    offset < (int) relation.attrFormat.size()) {
+					relation.attrFormat[offset] = getAttrFormat(rec);
+					relation.columnar = isColumnar(rec);
 				}
-				fputs("\n", fp_export);
 			}
 		}
+	}
+
+	Disk::setFormatVersion(BITMAP_SLOT_MAP_VERSION);
+
+	const std::vector<int> catalogColumns = {NO_OF_ATTRS_RELCAT_ATTRCAT * ATTR_SIZE};
+	for (int blockNum : relcatBlocks)
+		upgradeRecordBlock(blockNum, SLOTMAP_SIZE_RELCAT_ATTRCAT, catalogColumns);
+	for (int blockNum : attrcatBlocks)
+		upgradeRecordBlock(blockNum, SLOTMAP_SIZE_RELCAT_ATTRCAT, catalogColumns);
 
-		block_num = nextRecBlock_Attrcat;
+	for (RelationInfo &relation : relations) {
+		if (strcmp(relation.name, RELCAT_RELNAME) == 0 || strcmp(relation.name, ATTRCAT_RELNAME) == 0)
+			continue;
+
+		std::vector<int> columns;
+		int recordSize = 0;
+		for (int format : relation.attrFormat) {
+			recordSize += getFormatSize(format);
+			if (relation.columnar)
+				columns.push_back(getFormatSize(format));
+		}
+		if (!relation.columnar)
+			columns.push_back(recordSize);
+
+		const int numSlots = getSlotsPerBlock(recordSize);
+		for (int blockNum = relation.firstBlock; blockNum != -1; blockNum = getHeader(blockNum).rblock)
+			upgradeRecordBlock(blockNum, numSlots, columns);
+
+		Disk::readBlock(block, relation.relcatBlock);
+		Attribute *rec = (Attribute *) (block + HEADER_SIZE + getSlotmapSize(header->numSlots)) +
+		                 relation.relcatSlot * RELCAT_NO_ATTRS;
+		rec[RELCAT_NO_SLOTS_PER_BLOCK_INDEX].nval = numSlots;
+		Disk::writeBlock(block, relation.relcatBlock);
 	}
+}
 
-	fclose(fp_export);
-	return SUCCESS;
+/*
+ * Converts the leaf index blocks of a disk before PREFIX_LEAF_VERSION to prefix compressed ones
+ *      - A leaf of LEAF_ENTRY_SIZE byte entries holds no more entries than fit in a prefix
+ *        compressed leaf whatever their keys are, so every leaf is converted in place
+ */
+static void upgradeLeaves() {
+	std::vector<int> leaves;
+	for (int blockNum = 0; blockNum < Disk::getNumBlocks(); blockNum++) {
+		if (getBlockType(blockNum) == IND_LEAF)
+			leaves.push_back(blockNum);
+	}
+
+	Disk::setFormatVersion(PREFIX_LEAF_VERSION);
+
+	for (int blockNum : leaves) {
+		const int numEntries = getHeader(blockNum).numEntries;
+		unsigned char *block = BlockCache::getBlock(blockNum);
+		std::vector<Index> entries(numEntries);
+		for (int i = 0; i < numEntries; i++)
+			memcpy(&entries[i], block + HEADER_SIZE + i * LEAF_ENTRY_SIZE, sizeof(Index));
+		setLeafEntries(entries.data(), numEntries, blockNum);
+	}
 }
 
+/*
+ * Converts a disk of format version 2 or later to DISK_FORMAT_VERSION
+ *      - The record blocks of a disk before BITMAP_SLOT_MAP_VERSION get bitmap slotmaps (see
+ *        upgradeSlotmaps())
+ *      - COMPRESSED_BLOCK_VERSION only adds compressed record blocks, which an older disk has
+ *        none of, so nothing else changes
+ *      - The leaf index blocks of a disk before PREFIX_LEAF_VERSION are prefix compressed (see
+ *        upgradeLeaves())
+ *      - The converted blocks are written out before the superblock records the new version
+ *      - The blocks are converted in place, with a copy of the disk kept until the new version
+ *        is on storage (see Disk::backUp()): if the conversion is interrupted, the next start of
+ *        the tool puts the old disk back, and the upgrade can simply be run again
+ * A legacy disk has no superblock to record the version in and cannot be converted. Neither can
+ * a disk whose write-ahead log holds changes, which are only replayed onto the old format.
+ */
+int upgradeDisk() {
+	if (Disk::getFormatVersion() < 2) {
+		cout << "A legacy disk cannot be upgraded, format it with fdisk" << endl;
+		return FAILURE;
+	}
+	if (Disk::getFormatVersion() >= DISK_FORMAT_VERSION) {
+		cout << "The disk is already of format version " << Disk::getFormatVersion() << endl;
+		return SUCCESS;
+	}
+	if (Disk::hasPendingLog()) {
+		cout << "The write-ahead log holds changes to the disk: start NITCbase to recover them first" << endl;
+		return FAILURE;
+	}
+	if (Disk::backUp() != SUCCESS) {
+		cout << "Could not copy the disk to " << DISK_BACKUP_PATH << endl;
+		return FAILURE;
+	}
+
+	if (Disk::getFormatVersion() < BITMAP_SLOT_MAP_VERSION)
+		upgradeSlotmaps();
+	if (Disk::getFormatVersion() < PREFIX_LEAF_VERSION)
+		upgradeLeaves();
+	Disk::setFormatVersion(DISK_FORMAT_VERSION);
+
+	BlockCache::flush();
+	BlockCache::invalidate();
+	Disk::writeSuperBlock();
+	if (Disk::dropBackup() != SUCCESS) {
+		cout << "Could not sync the disk, the old disk is kept at " << DISK_BACKUP_PATH << endl;
+		return FAILURE;
+	}
+	return SUCCESS;
+}
 
 void writeHeaderToFile(FILE *fp_export, HeadInfo h) {
 	writeHeaderFieldToFile(fp_export, h.blockType);
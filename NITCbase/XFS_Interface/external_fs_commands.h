@@ -1,12 +1,20 @@
 #ifndef NITCBASE_EXTERNAL_FS_COMMANDS_H
 #define NITCBASE_EXTERNAL_FS_COMMANDS_H
 
+#include "define/constants.h"
+#include "disk_structures.h"
+
 void dump_relcat();
 void dump_attrcat();
 void dumpBlockAllocationMap();
 void ls();
-int importRelation(char *fileName);
+int importRelation(char *fileName, int numIndexAttrs = 0, char indexAttrs[][ATTR_SIZE] = nullptr);
 int exportRelation(char *relname, char *filename);
+char *formatString(char *out, Attribute *attr);
+int readRecordBlock(unsigned char *block, int blockNum);
+void unpackRecord(const unsigned char *records, int numSlots, int slotNum, bool columnar, int recordSize,
+		int *attrFormat, int *attrOffset, int numOfAttrs, Attribute *rec);
+int upgradeDisk();
 bool checkIfInvalidCharacter(char character);
 
 #endif //NITCBASE_EXTERNAL_FS_COMMANDS_H
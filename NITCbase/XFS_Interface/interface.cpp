@@ -2,8 +2,10 @@
 #include <fstream>
 #include <string>
 #include <cstring>
+#include <algorithm>
 #include <iomanip>
 #include <queue>
+#include <vector>
 #include <readline/readline.h>
 #include <readline/history.h>
 
@@ -12,11 +14,13 @@
 #include "interface.h"
 #include "schema.h"
 #include "Disk.h"
+#include "BlockCache.h"
 #include "OpenRelTable.h"
 #include "block_access.h"
 #include "algebra.h"
 #include "external_fs_commands.h"
 #include "BPlusTree.h"
+#include "block_compression.h"
 
 using namespace std;
 
@@ -65,11 +69,30 @@ void printBPlusTree(int rootBlock, int attrType);
 int exportBPlusTreeBlocks(int blockNum, int attrType, FILE *fp_export);
 
 
+/*
+ * Whether a command leaves the disk as it is (FDISK replaces the disk, and its write-ahead log with it)
+ */
+bool leavesDiskUnchanged(const string &input_command) {
+	const regex *commands[] = {&help, &ex, &echo, &run, &fdisk, &dump_rel, &dump_attr, &dump_bmap, &exprt, &schema,
+	                           &list_all, &bplus_tree, &print_table, &bplus_blocks};
+	for (const regex *command : commands) {
+		if (regex_match(input_command, *command))
+			return true;
+	}
+	return false;
+}
+
 /* TODO: RETURN 0 here means Success, return -1 (EXIT or FAILURE) means quit XFS,
  * I have done wherever i saw, check all that you added once again Jezzy
  */
 int regexMatchAndExecute(const string input_command) {
 	smatch m;
+	if (!leavesDiskUnchanged(input_command) && Disk::hasPendingLog()) {
+		cout << "The write-ahead log holds changes that are not on the disk yet: start NITCbase to recover them"
+		     << " (or FDISK to discard the disk) first" << endl;
+		return FAILURE;
+	}
+
 	if (regex_match(input_command, help)) {
 		display_help();
 	} else if (regex_match(input_command, ex)) {
@@ -133,11 +156,40 @@ int regexMatchAndExecute(const string input_command) {
 		cout << " successfully to: " << filePath << endl;
 
 	} else if (regex_match(input_command, fdisk)) {
-		Disk::createDisk();
-		Disk::formatDisk();
+		regex_search(input_command, m, fdisk);
+		long long blockSize = m[1].matched ? stoll(string(m[1]).substr(0, 12)) : DEFAULT_BLOCK_SIZE;
+		long long numBlocks = m[2].matched ? stoll(string(m[2]).substr(0, 12)) : DEFAULT_DISK_BLOCKS;
+
+		// the block size must be a power of 2, and the superblock must be able to list every block of the map
+		if (blockSize < MIN_BLOCK_SIZE || blockSize > MAX_BLOCK_SIZE || (blockSize & (blockSize - 1)) != 0) {
+			cout << "Block size must be a power of 2 between " << MIN_BLOCK_SIZE << " and " << MAX_BLOCK_SIZE << endl;
+			return FAILURE;
+		}
+		long long maxBlocks = (blockSize - HEADER_SIZE) / (long long) sizeof(int32_t) * blockSize;
+		if (maxBlocks > INT32_MAX)
+			maxBlocks = INT32_MAX;
+		if (numBlocks < MIN_DISK_BLOCKS || numBlocks > maxBlocks) {
+			cout << "Number of blocks must be between " << MIN_DISK_BLOCKS << " and " << maxBlocks
+			     << " for a block size of " << blockSize << endl;
+			return FAILURE;
+		}
+
+		if (Disk::createDisk(blockSize, numBlocks) != SUCCESS) {
+			cout << "Could not create the disk" << endl;
+			return FAILURE;
+		}
+		Disk::formatDisk(blockSize, numBlocks);
 		// Re-initialize OpenRelTable
 		OpenRelTable::initializeOpenRelationTable();
-		cout << "Disk formatted" << endl;
+		cout << "Disk formatted (" << numBlocks << " blocks of " << blockSize << " bytes)" << endl;
+	} else if (regex_match(input_command, upgrade_disk)) {
+		if (upgradeDisk() != SUCCESS) {
+			cout << "Upgrade Command Failed" << endl;
+			return FAILURE;
+		}
+		// the relation catalog entries now have more slots per block
+		OpenRelTable::initializeOpenRelationTable();
+		cout << "Disk is of format version " << Disk::getFormatVersion() << endl;
  	} else if (regex_match(input_command, print_table)) {
 		regex_search(input_command, m, print_table);
 		string tableName = m[1];
@@ -183,7 +235,15 @@ int regexMatchAndExecute(const string input_command) {
 		fclose(file);
 		string Filename = m[1];
 
-		int ret = importRelation(filepath);
+		/* Get the attributes to index from the input command */
+		vector<string> index_tokens = m[2].matched ? extract_tokens(m[2]) : vector<string>();
+		int index_count = index_tokens.size();
+		char index_list[index_count + 1][ATTR_SIZE];
+		for (int attr_no = 0; attr_no < index_count; attr_no++) {
+			string_to_char_array(index_tokens[attr_no], index_list[attr_no], ATTR_SIZE - 1);
+		}
+
+		int ret = importRelation(filepath, index_count, index_list);
 		if (ret == SUCCESS) {
 			cout << "Imported from " << complete_filepath << " successfully" << endl;
 		} else {
@@ -647,6 +707,13 @@ int regexMatchAndExecute(const string input_command) {
 
 int main(int argc, char* argv[]) {
 
+	// Putting back the disk of an upgrade that was interrupted
+	if (Disk::restoreBackup())
+		cout << "An upgrade of the disk was interrupted, the disk is back to its old format version" << endl;
+
+	// Reading the disk geometry from the superblock
+	Disk::loadSuperBlock();
+
 	// Initializing Open Relation Table
 	OpenRelTable::initializeOpenRelationTable();
 
@@ -655,6 +722,7 @@ int main(int argc, char* argv[]) {
 		string run_command("run ");
 		run_command.append(argv[2]);
 		int ret = regexMatchAndExecute(run_command);
+		BlockCache::flush();
 		if (ret == EXIT) {
 			return 0;
 		}
@@ -667,6 +735,7 @@ int main(int argc, char* argv[]) {
 			add_history(buf);
 		}
 		int ret = regexMatchAndExecute(string(buf));
+		BlockCache::flush();
 		free(buf);
 		if (ret == EXIT) {
 			return 0;
@@ -898,8 +967,9 @@ int executeCommandsFromFile(const string fileName) {
 }
 
 void display_help() {
-	printf("fdisk \n\t -Format disk \n\n");
-	printf("import <filename> \n\t -loads relations from the UNIX filesystem to the XFS disk. \n\n");
+	printf("fdisk [blocksize <bytes>] [blocks <count>] \n\t -Format disk (default: %d blocks of %d bytes) \n\n", DEFAULT_DISK_BLOCKS, DEFAULT_BLOCK_SIZE);
+	printf("upgrade disk \n\t -convert the record and index blocks of the disk to the current format version (needs room for a copy of the disk) \n\n");
+	printf("import <filename> [index <attr1>,<attr2>...] \n\t -loads relations from the UNIX filesystem to the XFS disk, building a B+ tree on each listed attribute. \n\n");
 	printf("export <tablename> <filename>.csv \n\t -export a relation from XFS disk to UNIX file system. \n\n");
 	printf("print table <tablename> \n\t-print all the rows of a relation in the XFS disk. \n\n");
 	printf("ls \n\t  -list the names of all relations in the xfs disk. \n\n");
@@ -976,6 +1046,8 @@ void printErrorMsg(int ret) {
         cout << "Error: Cannot create relation named 'temp' as it is used for internal purposes" << endl;
     else if (ret == E_TARGETNAMETEMP)
         cout << "Error: Cannot create a target relation named 'temp' as it is used for internal purposes" << endl;
+    else if (ret == E_PACKEDRECORDS)
+        cout << "Error: The records of this relation are packed; only EXPORT can read them" << endl;
 
 }
 
@@ -1324,6 +1396,8 @@ int printRows(char relname[ATTR_SIZE]){
 	int attrNo = 0;
 	char attrName[numOfAttrs][ATTR_SIZE];
 	int attrType[numOfAttrs];
+	int attrFormat[numOfAttrs];
+	bool columnar = false;
 
 	/*
 	 * Searching the Attribute Catalog Disk Blocks
@@ -1338,6 +1412,8 @@ int printRows(char relname[ATTR_SIZE]){
 				// Attribute belongs to this Relation - add info to array
 				strcpy(attrName[attrNo], rec[1].sval);
 				attrType[attrNo] = (int) rec[2].nval;
+				attrFormat[attrNo] = getAttrFormat(rec);
+				columnar = isColumnar(rec);
 				attrNo++;
 			}
 		}
@@ -1359,49 +1435,63 @@ int printRows(char relname[ATTR_SIZE]){
 	}
 	cout << std::endl;
 
-	int block_num = firstBlock;
-	int num_slots;
-	int num_attrs;
+	// records with packed attributes or in columnar blocks are unpacked one at a time
+	bool packed = columnar;
+	int packedRecordSize = 0;
+	int attrOffset[numOfAttrs];
+	for (attrNo = 0; attrNo < numOfAttrs; attrNo++) {
+		packed = packed || attrFormat[attrNo] != FORMAT_DEFAULT;
+		attrOffset[attrNo] = packedRecordSize;
+		packedRecordSize += getFormatSize(attrFormat[attrNo]);
+	}
+	Attribute unpacked[numOfAttrs];
+	// longest text of a value (see exportRelation())
+	std::vector<char> text(std::max(EXPORT_MAX_NUMBER_LENGTH, MAX_STRING_LENGTH) + 1);
+
+	// (room for a compressed record block once it is expanded)
+	std::vector<unsigned char> blockData(getExpandedBlockSize());
+	unsigned char *block = blockData.data();
+	HeadInfo *header = (HeadInfo *) block;
 
 	/*
 	 * Iterate over the record blocks of this relation
 	 * Linked list traversal
 	 */
-	while (block_num != -1) {
-		headInfo = getHeader(block_num);
-
-		num_slots = headInfo.numSlots;
-		num_attrs = headInfo.numAttrs;
-		nextRecBlock_Attrcat = headInfo.rblock;
+	for (int blockNum = firstBlock; blockNum != -1; blockNum = header->rblock) {
+		if (readRecordBlock(block, blockNum) != SUCCESS) {
+			cout << "Block " << blockNum << " of the relation is corrupt\n";
+			return FAILURE;
+		}
+		const int numSlots = header->numSlots;
+		Attribute *records = (Attribute *) (block + HEADER_SIZE + getSlotmapSize(numSlots));
+
+		// Go through all slots and write the record entry to console
+		for (slotNum = 0; slotNum < numSlots; slotNum++) {
+			if (!isSlotOccupied(block, slotNum))
+				continue;
+			Attribute *A = records + slotNum * header->numAttrs;
+			if (packed) {
+				unpackRecord((unsigned char *) records, numSlots, slotNum, columnar, packedRecordSize, attrFormat,
+						attrOffset, numOfAttrs, unpacked);
+				A = unpacked;
+			}
 
-		unsigned char slotmap[num_slots];
-		getSlotmap(slotmap, block_num);
-
-		Attribute A[num_attrs];
-		slotNum = 0;
-		// Go through all slots and write the record entry to file
-		for (slotNum = 0; slotNum < num_slots; slotNum++) {
-			if (slotmap[slotNum] == SLOT_OCCUPIED) {
-				getRecord(A, block_num, slotNum);
-
-				cout << "| ";
-				for (int l = 0; l < numOfAttrs; l++) {
-					if (attrType[l] == NUMBER) {
-						char s[ATTR_SIZE];
-						sprintf(s, "%-15.2f", A[l].nval);
-						printTabular(s, ATTR_SIZE - 1);
-
-					} else if (attrType[l] == STRING) {
-						printTabular(A[l].sval, ATTR_SIZE - 1);
-					}
-					cout << " | ";
+			cout << "| ";
+			for (int l = 0; l < numOfAttrs; l++) {
+				if (attrType[l] == NUMBER) {
+					if (attrFormat[l] == FORMAT_INT32 || attrFormat[l] == FORMAT_INT64)
+						snprintf(text.data(), text.size(), "%lld", (long long) A[l].nval);
+					else
+						snprintf(text.data(), text.size(), "%.2f", A[l].nval);
+				} else {
+					*formatString(text.data(), &A[l]) = '\0';
 				}
-
-				cout << std::endl;
+				printTabular(text.data(), ATTR_SIZE - 1);
+				cout << " | ";
 			}
-		}
 
-		block_num = nextRecBlock_Attrcat;
+			cout << std::endl;
+		}
 	}
 
 	return SUCCESS;
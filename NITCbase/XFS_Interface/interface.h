@@ -5,11 +5,12 @@
 
 /* External File System Commands */
 std::regex help("\\s*HELP\\s*;?", std::regex_constants::icase);
-std::regex fdisk("\\s*FDISK\\s*;?", std::regex_constants::icase);
+std::regex fdisk("\\s*FDISK(?:\\s+BLOCKSIZE\\s+([0-9]+))?(?:\\s+BLOCKS\\s+([0-9]+))?\\s*;?", std::regex_constants::icase);
+std::regex upgrade_disk("\\s*UPGRADE\\s+DISK\\s*;?", std::regex_constants::icase);
 std::regex dump_rel("\\s*DUMP\\s+RELCAT\\s*;?", std::regex_constants::icase);
 std::regex dump_attr("\\s*DUMP\\s+ATTRCAT\\s*;?", std::regex_constants::icase);
 std::regex dump_bmap("\\s*DUMP\\s+BMAP\\s*;?", std::regex_constants::icase);
-std::regex imp("\\s*IMPORT\\s+([a-zA-Z0-9_-]+\\.csv)\\s*;?", std::regex_constants::icase);
+std::regex imp("\\s*IMPORT\\s+([a-zA-Z0-9_-]+\\.csv)(?:\\s+INDEX\\s+((?:[#A-Za-z0-9_-]+\\s*,\\s*)*[#A-Za-z0-9_-]+))?\\s*;?", std::regex_constants::icase);
 std::regex exprt("\\s*EXPORT\\s+([A-Za-z0-9_-]+)\\s+([a-zA-Z0-9_-]+\\.csv)\\s*;?", std::regex_constants::icase);
 std::regex schema("\\s*SCHEMA\\s+([A-Za-z0-9_-]+)\\s*;?", std::regex_constants::icase);
 std::regex list_all("\\s*LS\\s*;?", std::regex_constants::icase);
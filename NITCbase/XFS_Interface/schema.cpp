@@ -5,6 +5,7 @@
 #include "block_access.h"
 #include "OpenRelTable.h"
 #include "BPlusTree.h"
+#include "Disk.h"
 
 #include <string>
 #include <cstring>
@@ -187,7 +188,7 @@ int dropIndex(char *relationName, char *attrName){
  */
 Attribute *make_relcatrec(char relname[ATTR_SIZE], int nAttrs, int nRecords, int firstBlock, int lastBlock) {
 	Attribute *relcatrec = (Attribute *) malloc(sizeof(Attribute) * 6);
-	int nSlotsPerBlock = (2016 / (16 * nAttrs + 1));
+	int nSlotsPerBlock = getSlotsPerBlock(ATTR_SIZE * nAttrs);
 	strcpy(relcatrec[0].sval, relname);
 	relcatrec[1].nval = nAttrs;
 	relcatrec[2].nval = nRecords;
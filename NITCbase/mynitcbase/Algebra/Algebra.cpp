@@ -1,8 +1,24 @@
 #include "Algebra.h"
+#include "ResultWriter.h"
+#include "../Scheduler/TaskScheduler.h"
 #include <iostream>
 #include <cstring>
 #include <cstdio>  // For sscanf
 #include <cstdlib> // For atoi
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
 using namespace std;
 /* used to select all the records that satisfy a condition.
 the arguments of the function are
@@ -31,6 +47,295 @@ bool isNumber(char *str)
     return ret == 1 && len == strlen(str);
 }
 
+/* The whole string of a value passed on by the frontend: value itself, or, if
+   it is a long string (see setString()), the string in longValue. */
+static char *getValueString(char value[ATTR_SIZE], string *longValue)
+{
+    Attribute attr;
+    memcpy(&attr, value, ATTR_SIZE);
+    if (!isLongString(attr))
+    {
+        return value;
+    }
+    getString(attr, longValue);
+    return longValue->data();
+}
+
+/* Converts a value passed on by the frontend to an attribute of a STRING
+   attribute of the given format. A long string is kept as it is for a VARCHAR
+   attribute (if it is at most MAX_STRING_LENGTH bytes), and is cut short to
+   ATTR_SIZE - 1 bytes for any other, as the frontend used to do. */
+static int toStringAttribute(char value[ATTR_SIZE], int format, Attribute *attr)
+{
+    memcpy(attr, value, ATTR_SIZE);
+    if (!isLongString(*attr))
+    {
+        return SUCCESS;
+    }
+
+    string longValue;
+    int ret = getString(*attr, &longValue);
+    if (ret != SUCCESS)
+    {
+        return ret;
+    }
+    if (format == FORMAT_VARCHAR)
+    {
+        return longValue.size() > MAX_STRING_LENGTH ? E_ATTRTYPEMISMATCH : SUCCESS;
+    }
+    memset(attr->sVal, 0, ATTR_SIZE);
+    memcpy(attr->sVal, longValue.data(), ATTR_SIZE - 1);
+    return SUCCESS;
+}
+
+// number of threads a full scan is split across, 0 for one per core
+static int scanThreads = 0;
+
+// number of threads to split work of numTasks independent tasks across
+static int getScanThreads(int numTasks)
+{
+    int numThreads = scanThreads;
+    if (numThreads == 0)
+    {
+        numThreads = TaskScheduler::getNumThreads();
+    }
+    return max(1, min(numThreads, numTasks));
+}
+
+// runs worker as numThreads tasks of the scheduler, the calling thread taking part
+static void runOnThreads(int numThreads, const function<void()> &worker)
+{
+    TaskGroup group;
+    for (int i = 0; i < numThreads; i++)
+    {
+        group.run([&worker]()
+                  {
+                      worker();
+                      return SUCCESS;
+                  });
+    }
+    group.wait();
+}
+
+static bool satisfies(int cmpVal, int op)
+{
+    return (op == NE && cmpVal != 0) ||
+           (op == LT && cmpVal < 0) ||
+           (op == LE && cmpVal <= 0) ||
+           (op == EQ && cmpVal == 0) ||
+           (op == GT && cmpVal > 0) ||
+           (op == GE && cmpVal >= 0);
+}
+
+/* Scans every record of the relation in parallel and appends to `result`, in
+   the order of a serial scan, the attributes at attrOffsets[0..nAttrs-1] of
+   each record whose attribute at condOffset satisfies `op attrVal` (of every
+   record if condOffset is -1).
+
+   The record blocks are collected from the block list first and split into
+   morsels of SCAN_MORSEL_BLOCKS blocks. The worker threads take morsels one at a
+   time until none are left, so a thread that is slowed down does not hold up
+   the others. Each morsel has its own result list and the lists are joined
+   once every thread is done.
+
+   Each block is read a column at a time (see RecBuffer::getColumn()): first
+   the attribute of the condition, then only the attributes to be returned, so
+   of a columnar relation the other attributes are never touched. */
+static void parallelScan(int relId, int condOffset, int condType, Attribute attrVal, int op,
+                         int nAttrs, int attrOffsets[], vector<Attribute> *result)
+{
+    RelCatEntry relCatEntry;
+    RelCacheTable::getRelCatEntry(relId, &relCatEntry);
+    RecordLayout layout;
+    RelCacheTable::getRecordLayout(relId, &layout);
+
+    vector<int> blocks;
+    for (int block = relCatEntry.firstBlk; block != -1;)
+    {
+        blocks.push_back(block);
+        RecBuffer recBuffer(block);
+        HeadInfo head;
+        recBuffer.getHeader(&head);
+        block = head.rblock;
+    }
+
+    const int numMorsels = (blocks.size() + SCAN_MORSEL_BLOCKS - 1) / SCAN_MORSEL_BLOCKS;
+    const int numThreads = getScanThreads(numMorsels);
+
+    vector<vector<Attribute>> morselResults(numMorsels);
+    atomic<int> nextMorsel(0);
+    auto worker = [&]()
+    {
+        vector<Attribute> column;
+        vector<int> slots;
+        SlotMap slotMap;
+        for (int morsel = nextMorsel++; morsel < numMorsels; morsel = nextMorsel++)
+        {
+            vector<Attribute> &out = morselResults[morsel];
+            const int end = min((int)blocks.size(), (morsel + 1) * SCAN_MORSEL_BLOCKS);
+            for (int i = morsel * SCAN_MORSEL_BLOCKS; i < end; i++)
+            {
+                RecBuffer recBuffer(blocks[i], &layout);
+                HeadInfo head;
+                recBuffer.getHeader(&head);
+                recBuffer.getSlotMap(&slotMap);
+                column.resize(head.numSlots);
+
+                // the occupied slots whose record satisfies the condition
+                slots.clear();
+                if (condOffset != -1)
+                {
+                    recBuffer.getColumn(column.data(), condOffset);
+                }
+                for (int slot = slotMap.nextOccupied(0); slot < head.numSlots; slot = slotMap.nextOccupied(slot + 1))
+                {
+                    if (condOffset != -1 && !satisfies(compareAttrs(column[slot], attrVal, condType), op))
+                    {
+                        continue;
+                    }
+                    slots.push_back(slot);
+                }
+                if (slots.empty())
+                {
+                    continue;
+                }
+
+                const size_t base = out.size();
+                out.resize(base + slots.size() * nAttrs);
+                for (int j = 0; j < nAttrs; j++)
+                {
+                    recBuffer.getColumn(column.data(), attrOffsets[j]);
+                    for (size_t k = 0; k < slots.size(); k++)
+                    {
+                        out[base + k * nAttrs + j] = column[slots[k]];
+                    }
+                }
+            }
+        }
+    };
+
+    runOnThreads(numThreads, worker);
+
+    for (vector<Attribute> &morselResult : morselResults)
+    {
+        result->insert(result->end(), morselResult.begin(), morselResult.end());
+    }
+}
+
+/* Appends the records collected by parallelScan() to the target relation,
+   whole blocks at a time (see BlockAccess::bulkAppend()) */
+static int appendRecords(int targetRelId, vector<Attribute> &records, int nAttrs)
+{
+    int appended = 0;
+    return BlockAccess::bulkAppend(targetRelId, records.data(), records.size() / nAttrs, &appended);
+}
+
+// a row of one side of a hash join, with the hash of its join attribute
+struct JoinEntry
+{
+    uint32_t hash;
+    uint32_t row;
+};
+
+static uint32_t hashAttr(const Attribute &attr, int attrType)
+{
+    // FNV-1a over the bytes compareAttrs() looks at
+    uint64_t hash = 14695981039346656037ULL;
+    if (attrType == NUMBER)
+    {
+        double value = attr.nVal == 0 ? 0.0 : attr.nVal;  // -0 equals 0
+        unsigned char bytes[sizeof(double)];
+        memcpy(bytes, &value, sizeof(double));
+        for (unsigned char byte : bytes)
+        {
+            hash = (hash ^ byte) * 1099511628211ULL;
+        }
+    }
+    else if (isLongString(attr))
+    {
+        string value;
+        getString(attr, &value);
+        for (unsigned char c : value)
+        {
+            hash = (hash ^ c) * 1099511628211ULL;
+        }
+    }
+    else
+    {
+        for (int i = 0; i < ATTR_SIZE && attr.sVal[i] != '\0'; i++)
+        {
+            hash = (hash ^ (unsigned char)attr.sVal[i]) * 1099511628211ULL;
+        }
+    }
+    return (uint32_t)(hash ^ (hash >> 32));
+}
+
+/* Radix-partitions the rows of one side of a hash join on the low radixBits
+   bits of the hash of their join attribute. Each thread hashes a contiguous
+   share of the rows and counts them per partition; the counts give every thread
+   its own range within each partition, which it then fills without locking.
+   The rows of partition p end up in entries[partitionStart[p] ..
+   partitionStart[p + 1]), in the order they were read. */
+static void partitionRows(const vector<Attribute> &records, int nAttrs, int keyOffset, int keyType,
+                          int radixBits, int numThreads, vector<JoinEntry> *entries,
+                          vector<size_t> *partitionStart)
+{
+    const size_t numRows = records.size() / nAttrs;
+    const int numPartitions = 1 << radixBits;
+    const size_t share = (numRows + numThreads - 1) / numThreads;
+
+    vector<uint32_t> hashes(numRows);
+    vector<vector<size_t>> counts(numThreads, vector<size_t>(numPartitions, 0));
+    atomic<int> nextShare(0);
+    runOnThreads(numThreads, [&]()
+                 {
+                     int t = nextShare++;
+                     for (size_t row = t * share; row < min(numRows, (t + 1) * share); row++)
+                     {
+                         hashes[row] = hashAttr(records[row * nAttrs + keyOffset], keyType);
+                         counts[t][hashes[row] & (numPartitions - 1)]++;
+                     }
+                 });
+
+    // turn the counts into the position each thread writes its next row to
+    partitionStart->assign(numPartitions + 1, 0);
+    size_t position = 0;
+    for (int p = 0; p < numPartitions; p++)
+    {
+        (*partitionStart)[p] = position;
+        for (int t = 0; t < numThreads; t++)
+        {
+            size_t count = counts[t][p];
+            counts[t][p] = position;
+            position += count;
+        }
+    }
+    (*partitionStart)[numPartitions] = position;
+
+    entries->resize(numRows);
+    nextShare = 0;
+    runOnThreads(numThreads, [&]()
+                 {
+                     int t = nextShare++;
+                     for (size_t row = t * share; row < min(numRows, (t + 1) * share); row++)
+                     {
+                         JoinEntry entry = {hashes[row], (uint32_t)row};
+                         (*entries)[counts[t][entry.hash & (numPartitions - 1)]++] = entry;
+                     }
+                 });
+}
+
+int Algebra::setScanThreads(int numThreads)
+{
+    if (numThreads < 0 || numThreads > MAX_SCAN_THREADS)
+    {
+        return E_INVALID;
+    }
+    scanThreads = numThreads;
+    TaskScheduler::reserve(numThreads);
+    return SUCCESS;
+}
+
 int Algebra::select(char srcRel[ATTR_SIZE], char targetRel[ATTR_SIZE], char attr[ATTR_SIZE], int op, char strVal[ATTR_SIZE])
 {
     int srcRelId = OpenRelTable::getRelId(srcRel);
@@ -54,9 +359,11 @@ int Algebra::select(char srcRel[ATTR_SIZE], char targetRel[ATTR_SIZE], char attr
     Attribute attrVal;
     if (type == NUMBER)
     {
-        if (isNumber(strVal))
+        string longValue;
+        char *numVal = getValueString(strVal, &longValue);
+        if (isNumber(numVal))
         { // the isNumber() function is implemented below
-            attrVal.nVal = atof(strVal);
+            attrVal.nVal = atof(numVal);
         }
         else
         {
@@ -65,7 +372,11 @@ int Algebra::select(char srcRel[ATTR_SIZE], char targetRel[ATTR_SIZE], char attr
     }
     else if (type == STRING)
     {
-        strcpy(attrVal.sVal, strVal);
+        ret = toStringAttribute(strVal, attrCatEntry.format, &attrVal);
+        if (ret != SUCCESS)
+        {
+            return ret;
+        }
     }
 
     /*** Creating and opening the target relation ***/
@@ -85,6 +396,7 @@ int Algebra::select(char srcRel[ATTR_SIZE], char targetRel[ATTR_SIZE], char attr
     // (will store the attribute types of rel).
     char attr_names[src_nAttrs][ATTR_SIZE];
     int attr_types[src_nAttrs];
+    int attr_formats[src_nAttrs];
 
     /*iterate through 0 to src_nAttrs-1 :
         get the i'th attribute's AttrCatEntry using AttrCacheTable::getAttrCatEntry()
@@ -97,12 +409,14 @@ int Algebra::select(char srcRel[ATTR_SIZE], char targetRel[ATTR_SIZE], char attr
         AttrCacheTable::getAttrCatEntry(srcRelId, i, &attrCatEntry);
         strcpy(attr_names[i], attrCatEntry.attrName);
         attr_types[i] = attrCatEntry.attrType;
+        attr_formats[i] = attrCatEntry.format;
     }
 
     /* Create the relation for target relation by calling Schema::createRel()
        by providing appropriate arguments */
     // if the createRel returns an error code, then return that value.
-    ret = Schema::createRel(targetRel, src_nAttrs, attr_names, attr_types);
+    // (the target stores its attributes in the formats and blocks of the source)
+    ret = Schema::createRel(targetRel, src_nAttrs, attr_names, attr_types, attr_formats, attrCatEntry.columnar);
     if (ret != SUCCESS)
     {
         return ret;
@@ -120,30 +434,39 @@ int Algebra::select(char srcRel[ATTR_SIZE], char targetRel[ATTR_SIZE], char attr
     }
 
     /*** Selecting and inserting records into the target relation ***/
-    /* Before calling the search function, reset the search to start from the
-       first using RelCacheTable::resetSearchIndex() */
+    if (attrCatEntry.rootBlock == -1)
+    {
+        // without an index every record is read: split the scan across threads
+        int attrOffsets[src_nAttrs];
+        for (int i = 0; i < src_nAttrs; i++)
+        {
+            attrOffsets[i] = i;
+        }
+        vector<Attribute> records;
+        parallelScan(srcRelId, attrCatEntry.offset, type, attrVal, op, src_nAttrs, attrOffsets, &records);
+
+        ret = appendRecords(targetRelId, records, src_nAttrs);
+        if (ret != SUCCESS)
+        {
+            Schema::closeRel(targetRel);
+            Schema::deleteRel(targetRel);
+            return ret;
+        }
+        return Schema::closeRel(targetRel);
+    }
 
     Attribute record[src_nAttrs];
 
-    /*
-        The BlockAccess::search() function can either do a linearSearch or
-        a B+ tree search. Hence, reset the search index of the relation in the
-        relation cache using RelCacheTable::resetSearchIndex().
-        Also, reset the search index in the attribute cache for the select
-        condition attribute with name given by the argument `attr`. Use
-        AttrCacheTable::resetSearchIndex().
-        Both these calls are necessary to ensure that search begins from the
-        first record.
-    */
-    RelCacheTable::resetSearchIndex(srcRelId);
-    AttrCacheTable::resetSearchIndex(srcRelId, attr);
+    // the B+ tree search keeps its position in the cursor, which starts at the
+    // first record
+    ScanCursor cursor;
 
     // read every record that satisfies the condition by repeatedly calling
     // BlockAccess::search() until there are no more records to be read
-    while (BlockAccess::search(srcRelId, record, attr, attrVal, op) == SUCCESS)
+    while (BlockAccess::search(srcRelId, record, attr, attrVal, op, &cursor) == SUCCESS)
     {
-        // ret = BlockAccess::insert(targetRelId, record);
-        ret = BlockAccess::insert(targetRelId, record);
+        // the target was created above, so records only go after its last one
+        ret = BlockAccess::append(targetRelId, record);
 
         // if (insert fails) {
         //     close the targetrel(by calling Schema::closeRel(targetrel))
@@ -221,11 +544,13 @@ int Algebra::insert(char relName[ATTR_SIZE], int nAttrs, char record[][ATTR_SIZE
         {
             // if the char array record[i] can be converted to a number
             // (check this using isNumber() function)
-            if (isNumber(record[i]))
+            string longValue;
+            char *numVal = getValueString(record[i], &longValue);
+            if (isNumber(numVal))
             {
                 /* convert the char array to numeral and store it
                    at recordValues[i].nVal using atof() */
-                recordValues[i].nVal = atof(record[i]);
+                recordValues[i].nVal = atof(numVal);
             }
             else
             {
@@ -235,7 +560,11 @@ int Algebra::insert(char relName[ATTR_SIZE], int nAttrs, char record[][ATTR_SIZE
         else if (type == STRING)
         {
             // copy record[i] to recordValues[i].sVal
-            strcpy(recordValues[i].sVal, record[i]);
+            int ret = toStringAttribute(record[i], attrCatEntry.format, &recordValues[i]);
+            if (ret != SUCCESS)
+            {
+                return ret;
+            }
         }
     }
 
@@ -249,175 +578,519 @@ int Algebra::insert(char relName[ATTR_SIZE], int nAttrs, char record[][ATTR_SIZE
     return BlockAccess::insert(relId, recordValues);
 }
 
-int Algebra::project(char srcRel[ATTR_SIZE], char targetRel[ATTR_SIZE])
+// looks up the relation of plan and the types of its attributes
+static int resolveInsertPlan(InsertPlan *plan)
 {
-
-    int srcRelId = OpenRelTable::getRelId(srcRel);
-
-    // if srcRel is not open in open relation table, return E_RELNOTOPEN
-    if (srcRelId == E_RELNOTOPEN)
+    plan->relId = -1;
+    if (strcmp(plan->relName, RELCAT_RELNAME) == 0 || strcmp(plan->relName, ATTRCAT_RELNAME) == 0)
     {
-        return E_RELNOTOPEN;
+        return E_NOTPERMITTED;
     }
 
-    // get RelCatEntry of srcRel using RelCacheTable::getRelCatEntry()
-    RelCatEntry srcRelCatEntry;
-    RelCacheTable::getRelCatEntry(srcRelId, &srcRelCatEntry);
-
-    // get the no. of attributes present in relation from the fetched RelCatEntry.
-    int numAttrs = srcRelCatEntry.numAttrs;
-
-    // attrNames and attrTypes will be used to store the attribute names
-    // and types of the source relation respectively
-    char attrNames[numAttrs][ATTR_SIZE];
-    int attrTypes[numAttrs];
-
-    /*iterate through every attribute of the source relation :
-        - get the AttributeCat entry of the attribute with offset.
-          (using AttrCacheTable::getAttrCatEntry())
-        - fill the arrays `attrNames` and `attrTypes` that we declared earlier
-          with the data about each attribute
-    */
-    for (int i = 0; i < numAttrs; i++)
+    unsigned int generation = OpenRelTable::getGeneration();
+    int relId = OpenRelTable::getRelId(plan->relName);
+    if (relId == E_RELNOTOPEN)
     {
-        AttrCatEntry attrCatEntry;
-        AttrCacheTable::getAttrCatEntry(srcRelId, i, &attrCatEntry);
-        strcpy(attrNames[i], attrCatEntry.attrName);
-        attrTypes[i] = attrCatEntry.attrType;
+        return E_RELNOTOPEN;
     }
 
-    /*** Creating and opening the target relation ***/
-
-    // Create a relation for target relation by calling Schema::createRel()
-    // by providing appropriate arguments
-    int ret = Schema::createRel(targetRel, numAttrs, attrNames, attrTypes);
-
-    // if the createRel returns an error code, then return that value.
+    RelCatEntry relCatEntry;
+    int ret = RelCacheTable::getRelCatEntry(relId, &relCatEntry);
     if (ret != SUCCESS)
     {
         return ret;
     }
 
-    // Open the newly created target relation by calling OpenRelTable::openRel()
-    // and get the target relid
-    int targetRelId = OpenRelTable::openRel(targetRel);
-
-    // If opening fails, delete the target relation by calling Schema::deleteRel() of
-    // return the error value returned from openRel().
-    if (targetRelId < 0 || targetRelId >= MAX_OPEN)
+    plan->attrTypes.resize(relCatEntry.numAttrs);
+    plan->attrFormats.resize(relCatEntry.numAttrs);
+    for (int i = 0; i < relCatEntry.numAttrs; i++)
     {
-        Schema::deleteRel(targetRel);
-        return targetRelId;
+        AttrCatEntry attrCatEntry;
+        AttrCacheTable::getAttrCatEntry(relId, i, &attrCatEntry);
+        plan->attrTypes[i] = attrCatEntry.attrType;
+        plan->attrFormats[i] = attrCatEntry.format;
     }
+    plan->relId = relId;
+    plan->generation = generation;
+    return SUCCESS;
+}
 
-    /*** Inserting projected records into the target relation ***/
-
-    // Take care to reset the searchIndex before calling the project function
-    // using RelCacheTable::resetSearchIndex()
-    RelCacheTable::resetSearchIndex(srcRelId);
-
-    Attribute record[numAttrs];
-
-    while (BlockAccess::project(srcRelId, record) == SUCCESS)
+/*
+    The same as insert(relName, ...), for a relation looked up through plan: the
+    rel-id and attribute types found by the first insert are used for as long as
+    no relation is closed.
+*/
+int Algebra::insert(InsertPlan *plan, int nAttrs, char record[][ATTR_SIZE])
+{
+    if (plan->relId == -1 || plan->generation != OpenRelTable::getGeneration())
     {
-        // record will contain the next record
-
-        // ret = BlockAccess::insert(targetRelId, proj_record);
-        ret = BlockAccess::insert(targetRelId, record);
-
+        int ret = resolveInsertPlan(plan);
         if (ret != SUCCESS)
         {
-            Schema::closeRel(targetRel);
-            Schema::deleteRel(targetRel);
             return ret;
         }
     }
-    // Close the targetRel by calling Schema::closeRel()
-    return Schema::closeRel(targetRel);
-}
-
-int Algebra::project(char srcRel[ATTR_SIZE], char targetRel[ATTR_SIZE], int tar_nAttrs, char tar_Attrs[][ATTR_SIZE])
-{
-    int srcRelId = OpenRelTable::getRelId(srcRel);
-
-    if (srcRelId == E_RELNOTOPEN)
-        return srcRelId;
-
-    RelCatEntry relCatEntry;
-    RelCacheTable::getRelCatEntry(srcRelId, &relCatEntry);
-
-    int src_nAttrs = relCatEntry.numAttrs;
-
-    int attrOffsets[tar_nAttrs];
-    int attrTypes[tar_nAttrs];
 
-    for (int i = 0; i < tar_nAttrs; i++)
+    if ((int)plan->attrTypes.size() != nAttrs)
     {
-        AttrCatEntry attrCatEntry;
-        int ret = AttrCacheTable::getAttrCatEntry(srcRelId, tar_Attrs[i], &attrCatEntry);
-
-        if (ret != SUCCESS)
-            return ret;
-
-        attrOffsets[i] = attrCatEntry.offset;
-        attrTypes[i] = attrCatEntry.attrType;
+        return E_NATTRMISMATCH;
     }
 
-    int ret = Schema::createRel(targetRel, tar_nAttrs, tar_Attrs, attrTypes);
-    if (ret != SUCCESS)
-        return ret;
-
-    int tarRelId = OpenRelTable::openRel(targetRel);
-
-    if (tarRelId < 0 || tarRelId >= MAX_OPEN)
-        return tarRelId;
-
-    Attribute record[src_nAttrs];
-
-    RelCacheTable::resetSearchIndex(srcRelId);
-    while (BlockAccess::project(srcRelId, record) == SUCCESS)
+    Attribute recordValues[nAttrs];
+    for (int i = 0; i < nAttrs; i++)
     {
-
-        Attribute projRecord[tar_nAttrs];
-
-        for (int i = 0; i < tar_nAttrs; i++)
-            projRecord[i] = record[attrOffsets[i]];
-
-        int ret = BlockAccess::insert(tarRelId, projRecord);
-
-        if (ret != SUCCESS)
+        if (plan->attrTypes[i] == NUMBER)
         {
-            OpenRelTable::closeRel(tarRelId);
-            Schema::deleteRel(targetRel);
-            return ret;
+            // (the same numbers as isNumber() accepts, without scanning them twice)
+            string longValue;
+            char *numVal = getValueString(record[i], &longValue);
+            char *end;
+            recordValues[i].nVal = strtod(numVal, &end);
+            while (isspace((unsigned char)*end))
+            {
+                end++;
+            }
+            if (end == numVal || *end != '\0')
+            {
+                return E_ATTRTYPEMISMATCH;
+            }
+        }
+        else
+        {
+            int ret = toStringAttribute(record[i], plan->attrFormats[i], &recordValues[i]);
+            if (ret != SUCCESS)
+            {
+                return ret;
+            }
         }
     }
 
-    Schema::closeRel(targetRel);
-
-    return SUCCESS;
+    return BlockAccess::insert(plan->relId, recordValues);
 }
 
-int Algebra::join(
-    char srcRelation1[ATTR_SIZE], char srcRelation2[ATTR_SIZE],
-    char targetRelation[ATTR_SIZE], char attribute1[ATTR_SIZE],
-    char attribute2[ATTR_SIZE])
+// a chunk of a csv file (a run of whole lines) and the records parsed from it
+struct CsvChunk
 {
-
-    // get the srcRelation1's rel-id using OpenRelTable::getRelId() method
-    int srcRelId1 = OpenRelTable::getRelId(srcRelation1);
-
-    // get the srcRelation2's rel-id using OpenRelTable::getRelId() method
-    int srcRelId2 = OpenRelTable::getRelId(srcRelation2);
-
-    // if either of the two source relations is not open
-    //     return E_RELNOTOPEN
-    if (srcRelId1 == E_RELNOTOPEN || srcRelId2 == E_RELNOTOPEN)
+    const char *begin, *end;
+    vector<Attribute> records;
+    int rows = 0;            // rows parsed before the first bad one
+    int error = SUCCESS;     // error of the row after them, if there is one
+    const char *errorMsg = "";
+};
+
+// parses a number as isNumber() accepts it (strtod() reads what sscanf() reads
+// for %f): surrounding whitespace is allowed
+static bool parseNumber(const char *begin, const char *end, double *value)
+{
+    // strtod() needs a terminated string, and the field is followed by the
+    // rest of the file: it is copied, to the stack unless it is very long
+    char text[64];
+    string longText;
+    const size_t length = end - begin;
+    char *copy = text;
+    if (length < sizeof(text))
     {
-        return E_RELNOTOPEN;
+        memcpy(text, begin, length);
+        text[length] = '\0';
+    }
+    else
+    {
+        longText.assign(begin, end);
+        copy = &longText[0];
     }
 
-    AttrCatEntry attrCatEntry1, attrCatEntry2;
+    char *parsed;
+    *value = strtod(copy, &parsed);
+    if (parsed == copy)
+    {
+        return false;
+    }
+    while (isspace((unsigned char)*parsed))
+    {
+        parsed++;
+    }
+    return parsed == copy + length;
+}
+
+/* Parses the lines of chunk into records of a relation with the given attribute
+   types and formats. Fields are split on commas, and neither may be empty nor
+   may a row have a different number of fields (in the first row of the file,
+   that is reported as E_NATTRMISMATCH, as a single INSERT would). Strings
+   longer than ATTR_SIZE - 1 are cut short, except those of a VARCHAR attribute,
+   which are kept as long strings. Parsing stops at the first bad row. */
+static void parseCsvChunk(CsvChunk *chunk, const vector<int> &attrTypes, const vector<int> &attrFormats,
+                          bool firstChunk)
+{
+    const int nAttrs = attrTypes.size();
+    Attribute record[nAttrs];
+    // (a guess of the number of rows, from the length of the first one)
+    const char *firstLineEnd = (const char *)memchr(chunk->begin, '\n', chunk->end - chunk->begin);
+    if (firstLineEnd != nullptr)
+    {
+        chunk->records.reserve((chunk->end - chunk->begin) / (firstLineEnd - chunk->begin + 1) * nAttrs * 5 / 4);
+    }
+
+    for (const char *line = chunk->begin; line < chunk->end;)
+    {
+        const char *lineEnd = (const char *)memchr(line, '\n', chunk->end - line);
+        if (lineEnd == nullptr)
+        {
+            lineEnd = chunk->end;
+        }
+
+        bool nullValue = false, typeMismatch = false;
+        int field = 0;
+        for (const char *value = line;; field++)
+        {
+            const char *valueEnd = (const char *)memchr(value, ',', lineEnd - value);
+            if (valueEnd == nullptr)
+            {
+                valueEnd = lineEnd;
+            }
+            if (valueEnd == value)
+            {
+                nullValue = true;
+                break;
+            }
+
+            if (field < nAttrs)
+            {
+                if (attrTypes[field] == NUMBER)
+                {
+                    typeMismatch = typeMismatch || !parseNumber(value, valueEnd, &record[field].nVal);
+                }
+                else if (attrFormats[field] == FORMAT_VARCHAR)
+                {
+                    typeMismatch = typeMismatch || valueEnd - value > MAX_STRING_LENGTH;
+                    setString(&record[field], value, min((int)(valueEnd - value), MAX_STRING_LENGTH));
+                }
+                else
+                {
+                    int length = min((int)(valueEnd - value), ATTR_SIZE - 1);
+                    memset(record[field].sVal, 0, ATTR_SIZE);
+                    memcpy(record[field].sVal, value, length);
+                }
+            }
+
+            if (valueEnd == lineEnd)
+            {
+                field++;
+                break;
+            }
+            value = valueEnd + 1;
+        }
+
+        if (nullValue)
+        {
+            chunk->error = FAILURE;
+            chunk->errorMsg = "Null values not allowed in attribute values";
+            return;
+        }
+        if (field != nAttrs)
+        {
+            chunk->error = firstChunk && chunk->rows == 0 ? E_NATTRMISMATCH : FAILURE;
+            chunk->errorMsg = "Mismatch in number of attributes";
+            return;
+        }
+        if (typeMismatch)
+        {
+            chunk->error = E_ATTRTYPEMISMATCH;
+            return;
+        }
+
+        chunk->records.insert(chunk->records.end(), record, record + nAttrs);
+        chunk->rows++;
+        line = lineEnd + 1;
+    }
+}
+
+/*
+    Inserts the rows of the csv file at filePath into relName, up to the first
+    row that cannot be inserted.
+
+    The file is mapped into memory and split into chunks of about
+    LOAD_CHUNK_SIZE bytes that end at the end of a line. The chunks are parsed
+    by tasks of the scheduler, a round of them at a time: while the records of
+    one round are appended to the relation, whole blocks at a time, the next
+    round is parsed. The rows inserted, the size of the file and the time taken
+    are returned in stats, along with the line of the row that was not inserted
+    and, if FAILURE is returned, what was wrong with it.
+*/
+int Algebra::load(char relName[ATTR_SIZE], const char *filePath, LoadStats *stats)
+{
+    auto start = chrono::steady_clock::now();
+
+    InsertPlan plan;
+    strcpy(plan.relName, relName);
+    int ret = resolveInsertPlan(&plan);
+    if (ret != SUCCESS)
+    {
+        stats->errorLine = 1;
+        return ret;
+    }
+
+    int fd = open(filePath, O_RDONLY);
+    if (fd < 0)
+    {
+        return FAILURE;
+    }
+    struct stat fileStat;
+    fstat(fd, &fileStat);
+    const size_t size = fileStat.st_size;
+    stats->bytes = size;
+
+    const char *data = nullptr;
+    if (size > 0)
+    {
+        data = (const char *)mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            close(fd);
+            return FAILURE;
+        }
+        madvise((void *)data, size, MADV_SEQUENTIAL);
+    }
+
+    vector<CsvChunk> chunks;
+    for (size_t offset = 0; offset < size;)
+    {
+        size_t end = min(offset + LOAD_CHUNK_SIZE, size);
+        const char *newline = (const char *)memchr(data + end, '\n', size - end);
+        end = newline == nullptr ? size : newline - data + 1;
+
+        chunks.emplace_back();
+        chunks.back().begin = data + offset;
+        chunks.back().end = data + end;
+        offset = end;
+    }
+
+    const int numChunks = chunks.size();
+    const int roundChunks = max(LOAD_ROUND_CHUNKS, 2 * TaskScheduler::getNumThreads());
+    auto parseRound = [&](int first, TaskGroup *group)
+    {
+        for (int i = first; i < min(first + roundChunks, numChunks); i++)
+        {
+            group->run([&chunks, &plan, i]()
+                       {
+                           parseCsvChunk(&chunks[i], plan.attrTypes, plan.attrFormats, i == 0);
+                           return SUCCESS;
+                       });
+        }
+    };
+
+    // an index dropped for want of disk space does not stop the load
+    bool indexReleased = false;
+
+    unique_ptr<TaskGroup> parsing(new TaskGroup());
+    parseRound(0, parsing.get());
+    for (int first = 0; first < numChunks && ret == SUCCESS; first += roundChunks)
+    {
+        parsing->wait();
+        unique_ptr<TaskGroup> next(new TaskGroup());
+        parseRound(first + roundChunks, next.get());
+
+        for (int i = first; i < min(first + roundChunks, numChunks); i++)
+        {
+            CsvChunk &chunk = chunks[i];
+            int appended = 0;
+            ret = BlockAccess::bulkAppend(plan.relId, chunk.records.data(), chunk.rows, &appended);
+            stats->rows += appended;
+            if (ret == E_INDEX_BLOCKS_RELEASED)
+            {
+                indexReleased = true;
+                ret = SUCCESS;
+            }
+            if (ret == SUCCESS)
+            {
+                ret = chunk.error;
+                stats->error = chunk.errorMsg;
+            }
+            vector<Attribute>().swap(chunk.records);
+
+            if (ret != SUCCESS)
+            {
+                stats->errorLine = stats->rows + 1;
+                next->cancel(ret);
+                break;
+            }
+        }
+        parsing = move(next);
+    }
+    parsing.reset();  // (its tasks read the file)
+    if (ret == SUCCESS && indexReleased)
+    {
+        ret = E_INDEX_BLOCKS_RELEASED;
+    }
+
+    if (data != nullptr)
+    {
+        munmap((void *)data, size);
+    }
+    close(fd);
+
+    stats->seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return ret;
+}
+
+int Algebra::project(char srcRel[ATTR_SIZE], char targetRel[ATTR_SIZE])
+{
+
+    int srcRelId = OpenRelTable::getRelId(srcRel);
+
+    // if srcRel is not open in open relation table, return E_RELNOTOPEN
+    if (srcRelId == E_RELNOTOPEN)
+    {
+        return E_RELNOTOPEN;
+    }
+
+    // get RelCatEntry of srcRel using RelCacheTable::getRelCatEntry()
+    RelCatEntry srcRelCatEntry;
+    RelCacheTable::getRelCatEntry(srcRelId, &srcRelCatEntry);
+
+    // get the no. of attributes present in relation from the fetched RelCatEntry.
+    int numAttrs = srcRelCatEntry.numAttrs;
+
+    // attrNames and attrTypes will be used to store the attribute names
+    // and types of the source relation respectively
+    char attrNames[numAttrs][ATTR_SIZE];
+    int attrTypes[numAttrs];
+    int attrFormats[numAttrs];
+    bool columnar = false;
+
+    /*iterate through every attribute of the source relation :
+        - get the AttributeCat entry of the attribute with offset.
+          (using AttrCacheTable::getAttrCatEntry())
+        - fill the arrays `attrNames` and `attrTypes` that we declared earlier
+          with the data about each attribute
+    */
+    for (int i = 0; i < numAttrs; i++)
+    {
+        AttrCatEntry attrCatEntry;
+        AttrCacheTable::getAttrCatEntry(srcRelId, i, &attrCatEntry);
+        strcpy(attrNames[i], attrCatEntry.attrName);
+        attrTypes[i] = attrCatEntry.attrType;
+        attrFormats[i] = attrCatEntry.format;
+        columnar = attrCatEntry.columnar;
+    }
+
+    /*** Creating and opening the target relation ***/
+
+    // Create a relation for target relation by calling Schema::createRel()
+    // by providing appropriate arguments
+    int ret = Schema::createRel(targetRel, numAttrs, attrNames, attrTypes, attrFormats, columnar);
+
+    // if the createRel returns an error code, then return that value.
+    if (ret != SUCCESS)
+    {
+        return ret;
+    }
+
+    // Open the newly created target relation by calling OpenRelTable::openRel()
+    // and get the target relid
+    int targetRelId = OpenRelTable::openRel(targetRel);
+
+    // If opening fails, delete the target relation by calling Schema::deleteRel() of
+    // return the error value returned from openRel().
+    if (targetRelId < 0 || targetRelId >= MAX_OPEN)
+    {
+        Schema::deleteRel(targetRel);
+        return targetRelId;
+    }
+
+    /*** Inserting projected records into the target relation ***/
+
+    // every record is copied, so the scan is split across threads
+    int attrOffsets[numAttrs];
+    for (int i = 0; i < numAttrs; i++)
+    {
+        attrOffsets[i] = i;
+    }
+    vector<Attribute> records;
+    parallelScan(srcRelId, -1, NUMBER, Attribute(), EQ, numAttrs, attrOffsets, &records);
+
+    ret = appendRecords(targetRelId, records, numAttrs);
+    if (ret != SUCCESS)
+    {
+        Schema::closeRel(targetRel);
+        Schema::deleteRel(targetRel);
+        return ret;
+    }
+    // Close the targetRel by calling Schema::closeRel()
+    return Schema::closeRel(targetRel);
+}
+
+int Algebra::project(char srcRel[ATTR_SIZE], char targetRel[ATTR_SIZE], int tar_nAttrs, char tar_Attrs[][ATTR_SIZE])
+{
+    int srcRelId = OpenRelTable::getRelId(srcRel);
+
+    if (srcRelId == E_RELNOTOPEN)
+        return srcRelId;
+
+    int attrOffsets[tar_nAttrs];
+    int attrTypes[tar_nAttrs];
+    int attrFormats[tar_nAttrs];
+    bool columnar = false;
+
+    for (int i = 0; i < tar_nAttrs; i++)
+    {
+        AttrCatEntry attrCatEntry;
+        int ret = AttrCacheTable::getAttrCatEntry(srcRelId, tar_Attrs[i], &attrCatEntry);
+
+        if (ret != SUCCESS)
+            return ret;
+
+        attrOffsets[i] = attrCatEntry.offset;
+        attrTypes[i] = attrCatEntry.attrType;
+        attrFormats[i] = attrCatEntry.format;
+        columnar = attrCatEntry.columnar;
+    }
+
+    int ret = Schema::createRel(targetRel, tar_nAttrs, tar_Attrs, attrTypes, attrFormats, columnar);
+    if (ret != SUCCESS)
+        return ret;
+
+    int tarRelId = OpenRelTable::openRel(targetRel);
+
+    if (tarRelId < 0 || tarRelId >= MAX_OPEN)
+        return tarRelId;
+
+    // the threads of the scan project the records as they read them
+    vector<Attribute> records;
+    parallelScan(srcRelId, -1, NUMBER, Attribute(), EQ, tar_nAttrs, attrOffsets, &records);
+
+    ret = appendRecords(tarRelId, records, tar_nAttrs);
+    if (ret != SUCCESS)
+    {
+        OpenRelTable::closeRel(tarRelId);
+        Schema::deleteRel(targetRel);
+        return ret;
+    }
+
+    Schema::closeRel(targetRel);
+
+    return SUCCESS;
+}
+
+int Algebra::join(
+    char srcRelation1[ATTR_SIZE], char srcRelation2[ATTR_SIZE],
+    char targetRelation[ATTR_SIZE], char attribute1[ATTR_SIZE],
+    char attribute2[ATTR_SIZE])
+{
+
+    // get the srcRelation1's rel-id using OpenRelTable::getRelId() method
+    int srcRelId1 = OpenRelTable::getRelId(srcRelation1);
+
+    // get the srcRelation2's rel-id using OpenRelTable::getRelId() method
+    int srcRelId2 = OpenRelTable::getRelId(srcRelation2);
+
+    // if either of the two source relations is not open
+    //     return E_RELNOTOPEN
+    if (srcRelId1 == E_RELNOTOPEN || srcRelId2 == E_RELNOTOPEN)
+    {
+        return E_RELNOTOPEN;
+    }
+
+    AttrCatEntry attrCatEntry1, attrCatEntry2;
     // get the attribute catalog entries for the following from the attribute cache
     // (using AttrCacheTable::getAttrCatEntry())
     // - attrCatEntry1 = attribute1 of srcRelation1
@@ -488,20 +1161,6 @@ int Algebra::join(
         }
     }
 
-    // if rel2 does not have an index on attr2
-    //     create it using BPlusTree:bPlusCreate()
-    //     if call fails, return the appropriate error code
-    //     (if your implementation is correct, the only error code that will
-    //      be returned here is E_DISKFULL)
-    if (attrCatEntry2.rootBlock == -1)
-    {
-        int ret = BPlusTree::bPlusCreate(srcRelId2, attribute2);
-        if (ret != SUCCESS)
-        {
-            return ret;
-        }
-    }
-
     int numOfAttributesInTarget = numOfAttributes1 + numOfAttributes2 - 1;
     // Note: The target relation has number of attributes one less than
     // nAttrs1+nAttrs2 (Why?)
@@ -509,6 +1168,7 @@ int Algebra::join(
     // declare the following arrays to store the details of the target relation
     char targetRelAttrNames[numOfAttributesInTarget][ATTR_SIZE];
     int targetRelAttrTypes[numOfAttributesInTarget];
+    int targetRelAttrFormats[numOfAttributesInTarget];
 
     // iterate through all the attributes in both the source relations and
     // update targetRelAttrNames[],targetRelAttrTypes[] arrays excluding attribute2
@@ -520,6 +1180,7 @@ int Algebra::join(
         AttrCacheTable::getAttrCatEntry(srcRelId1, i, &attrCatBuff1);
         strcpy(targetRelAttrNames[index], attrCatBuff1.attrName);
         targetRelAttrTypes[index] = attrCatBuff1.attrType;
+        targetRelAttrFormats[index] = attrCatBuff1.format;
         index++;
     }
 
@@ -533,12 +1194,15 @@ int Algebra::join(
         }
         strcpy(targetRelAttrNames[index], attrCatBuff2.attrName);
         targetRelAttrTypes[index] = attrCatBuff2.attrType;
+        targetRelAttrFormats[index] = attrCatBuff2.format;
         index++;
     }
 
     // create the target relation using the Schema::createRel() function
     // by providing appropriate arguments
-    ret = Schema::createRel(targetRelation, numOfAttributesInTarget, targetRelAttrNames, targetRelAttrTypes);
+    // (the target stores its attributes in the formats of the sources)
+    ret = Schema::createRel(targetRelation, numOfAttributesInTarget, targetRelAttrNames, targetRelAttrTypes,
+                            targetRelAttrFormats);
 
     // if createRel() returns an error, return that error
     if (ret != SUCCESS)
@@ -558,68 +1222,693 @@ int Algebra::join(
         return newRelId;
     }
 
-    Attribute record1[numOfAttributes1];
-    Attribute record2[numOfAttributes2];
-    Attribute targetRecord[numOfAttributesInTarget];
+    /*** Radix hash join ***/
+    /* Both relations are read with parallel scans. Their rows are then
+       partitioned on the hash of the join attribute into partitions whose
+       build side (the smaller relation) fits in the cache, and the threads
+       take one partition at a time: they build a hash table over its build
+       rows and probe it with its probe rows. The joined records of a partition
+       are appended to the target relation as soon as the partition is done, so
+       only the output of the partitions being joined is held in memory. */
+    int allOffsets1[numOfAttributes1], allOffsets2[numOfAttributes2];
+    for (int i = 0; i < numOfAttributes1; i++)
+    {
+        allOffsets1[i] = i;
+    }
+    for (int i = 0; i < numOfAttributes2; i++)
+    {
+        allOffsets2[i] = i;
+    }
+    vector<Attribute> records1, records2;
+    parallelScan(srcRelId1, -1, NUMBER, Attribute(), EQ, numOfAttributes1, allOffsets1, &records1);
+    parallelScan(srcRelId2, -1, NUMBER, Attribute(), EQ, numOfAttributes2, allOffsets2, &records2);
+
+    const bool buildOnFirst = records1.size() < records2.size();
+    const size_t buildBytes = buildOnFirst ? records1.size() * sizeof(Attribute)
+                                           : records2.size() * sizeof(Attribute);
+
+    // enough partitions for each to fit in JOIN_PARTITION_SIZE, and to keep
+    // every thread busy
+    const int numThreads = getScanThreads(MAX_SCAN_THREADS);
+    int radixBits = 0;
+    while (radixBits < JOIN_MAX_RADIX_BITS &&
+           ((buildBytes >> radixBits) > JOIN_PARTITION_SIZE || (1 << radixBits) < 4 * numThreads))
+    {
+        radixBits++;
+    }
+    const int numPartitions = 1 << radixBits;
+
+    const int attrType = attrCatEntry1.attrType;
+    vector<JoinEntry> entries1, entries2;
+    vector<size_t> partitionStart1, partitionStart2;
+    partitionRows(records1, numOfAttributes1, attrCatEntry1.offset, attrType, radixBits, numThreads,
+                  &entries1, &partitionStart1);
+    partitionRows(records2, numOfAttributes2, attrCatEntry2.offset, attrType, radixBits, numThreads,
+                  &entries2, &partitionStart2);
+
+    atomic<int> nextPartition(0);
+    // the first error an append returned; the partitions left are not joined
+    atomic<int> appendRet(SUCCESS);
+    auto joinPartitions = [&]()
+    {
+        vector<int> buckets, chain;
+        vector<Attribute> output;
+        for (int p = nextPartition++; p < numPartitions && appendRet == SUCCESS; p = nextPartition++)
+        {
+            const JoinEntry *build = buildOnFirst ? &entries1[partitionStart1[p]] : &entries2[partitionStart2[p]];
+            const JoinEntry *probe = buildOnFirst ? &entries2[partitionStart2[p]] : &entries1[partitionStart1[p]];
+            const size_t numBuild = buildOnFirst ? partitionStart1[p + 1] - partitionStart1[p]
+                                                 : partitionStart2[p + 1] - partitionStart2[p];
+            const size_t numProbe = buildOnFirst ? partitionStart2[p + 1] - partitionStart2[p]
+                                                 : partitionStart1[p + 1] - partitionStart1[p];
+            if (numBuild == 0 || numProbe == 0)
+            {
+                continue;
+            }
 
-    // this loop is to get every record of the srcRelation1 one by
-    RelCacheTable::resetSearchIndex(srcRelId1);
-    AttrCacheTable::resetSearchIndex(srcRelId1, attribute1);
-    while (BlockAccess::project(srcRelId1, record1) == SUCCESS)
+            // chained hash table on the hash bits above the radix bits
+            size_t numBuckets = 1;
+            while (numBuckets < numBuild)
+            {
+                numBuckets <<= 1;
+            }
+            buckets.assign(numBuckets, -1);
+            chain.resize(numBuild);
+            for (size_t i = 0; i < numBuild; i++)
+            {
+                size_t bucket = (build[i].hash >> radixBits) & (numBuckets - 1);
+                chain[i] = buckets[bucket];
+                buckets[bucket] = i;
+            }
+
+            output.clear();
+            for (size_t j = 0; j < numProbe; j++)
+            {
+                size_t bucket = (probe[j].hash >> radixBits) & (numBuckets - 1);
+                for (int i = buckets[bucket]; i != -1; i = chain[i])
+                {
+                    if (build[i].hash != probe[j].hash)
+                    {
+                        continue;
+                    }
+                    const Attribute *record1 = &records1[(size_t)(buildOnFirst ? build[i].row : probe[j].row) * numOfAttributes1];
+                    const Attribute *record2 = &records2[(size_t)(buildOnFirst ? probe[j].row : build[i].row) * numOfAttributes2];
+                    if (compareAttrs(record1[attrCatEntry1.offset], record2[attrCatEntry2.offset], attrType) != 0)
+                    {
+                        continue;
+                    }
+
+                    // the target record holds srcRelation1's attribute values
+                    // followed by srcRelation2's (except for attribute2)
+                    output.insert(output.end(), record1, record1 + numOfAttributes1);
+                    for (int k = 0; k < numOfAttributes2; k++)
+                    {
+                        if (k != attrCatEntry2.offset)
+                        {
+                            output.push_back(record2[k]);
+                        }
+                    }
+                }
+            }
+
+            int appendError = appendRecords(newRelId, output, numOfAttributesInTarget);
+            if (appendError != SUCCESS)
+            {
+                int expected = SUCCESS;
+                appendRet.compare_exchange_strong(expected, appendError);
+            }
+        }
+    };
+    runOnThreads(getScanThreads(numPartitions), joinPartitions);
+
+    ret = appendRet;
+    if (ret != SUCCESS)
     {
+        // close the target relation by calling OpenRelTable::closeRel()
+        // delete targetRelation (by calling Schema::deleteRel())
+        Schema::closeRel(targetRelation);
+        Schema::deleteRel(targetRelation);
+        return ret;
+    }
 
-        // reset the search index of `srcRelation2` in the relation cache
-        // using RelCacheTable::resetSearchIndex()
-        RelCacheTable::resetSearchIndex(srcRelId2);
+    // close the target relation by calling OpenRelTable::closeRel()
+    return Schema::closeRel(targetRelation);
+}
 
-        // reset the search index of `attribute2` in the attribute cache
-        // using AttrCacheTable::resetSearchIndex()
-        AttrCacheTable::resetSearchIndex(srcRelId2, attribute2);
+// converts strVal to an Attribute of the type of attribute attr of the relation
+static int getConditionValue(int relId, char attr[ATTR_SIZE], char strVal[ATTR_SIZE], Attribute *attrVal)
+{
+    AttrCatEntry attrCatEntry;
+    int ret = AttrCacheTable::getAttrCatEntry(relId, attr, &attrCatEntry);
+    if (ret != SUCCESS)
+    {
+        return ret;
+    }
 
-        // this loop is to get every record of the srcRelation2 which satisfies
-        // the following condition:
-        // record1.attribute1 = record2.attribute2 (i.e. Equi-Join condition)
-        while (BlockAccess::search(
-                   srcRelId2, record2, attribute2, record1[attrCatEntry1.offset], EQ) == SUCCESS)
+    if (attrCatEntry.attrType == NUMBER)
+    {
+        string longValue;
+        char *numVal = getValueString(strVal, &longValue);
+        if (!isNumber(numVal))
         {
+            return E_ATTRTYPEMISMATCH;
+        }
+        attrVal->nVal = atof(numVal);
+        return SUCCESS;
+    }
+
+    return toStringAttribute(strVal, attrCatEntry.format, attrVal);
+}
+
+/*
+    Streams the records of srcRel that satisfy `attr op strVal` (every record if
+    attr is an empty string) to stdout, or to outFile when one is given.
+    Only tar_Attrs are written (all the attributes if tar_nAttrs is 0).
+    No target relation is created, so no disk blocks are allocated and the
+    catalogs are left untouched.
+*/
+int Algebra::stream(char srcRel[ATTR_SIZE], int tar_nAttrs, char tar_Attrs[][ATTR_SIZE],
+                    char attr[ATTR_SIZE], int op, char strVal[ATTR_SIZE], const char *outFile, int *rowCount)
+{
+    *rowCount = 0;
 
-            // copy srcRelation1's and srcRelation2's attribute values(except
-            // for attribute2 in rel2) from record1 and record2 to targetRecord
-            // respectively
-            int index = 0;
-            for (int i = 0; i < numOfAttributes1; i++)
+    int srcRelId = OpenRelTable::getRelId(srcRel);
+    if (srcRelId == E_RELNOTOPEN)
+    {
+        return E_RELNOTOPEN;
+    }
+
+    RelCatEntry srcRelCatEntry;
+    RelCacheTable::getRelCatEntry(srcRelId, &srcRelCatEntry);
+    int src_nAttrs = srcRelCatEntry.numAttrs;
+
+    // a projection on no attributes is a projection on all of them
+    int nAttrs = (tar_nAttrs == 0) ? src_nAttrs : tar_nAttrs;
+
+    // find the offsets, names and types of the attributes to be written
+    int attrOffsets[nAttrs];
+    int attrTypes[nAttrs];
+    char attrNames[nAttrs][ATTR_SIZE];
+    for (int i = 0; i < nAttrs; i++)
+    {
+        AttrCatEntry attrCatEntry;
+        int ret = (tar_nAttrs == 0) ? AttrCacheTable::getAttrCatEntry(srcRelId, i, &attrCatEntry)
+                                    : AttrCacheTable::getAttrCatEntry(srcRelId, tar_Attrs[i], &attrCatEntry);
+        if (ret != SUCCESS)
+        {
+            return ret;
+        }
+
+        attrOffsets[i] = attrCatEntry.offset;
+        attrTypes[i] = attrCatEntry.attrType;
+        strcpy(attrNames[i], attrCatEntry.attrName);
+    }
+
+    // convert strVal to an attribute of the type of the condition attribute
+    bool hasCondition = (attr[0] != '\0');
+    Attribute attrVal;
+    if (hasCondition)
+    {
+        int ret = getConditionValue(srcRelId, attr, strVal, &attrVal);
+        if (ret != SUCCESS)
+        {
+            return ret;
+        }
+    }
+
+    // everything is validated, so only now open the output
+    FILE *file = stdout;
+    if (outFile != nullptr)
+    {
+        file = fopen(outFile, "w");
+        if (file == nullptr)
+        {
+            return FAILURE;
+        }
+    }
+    else
+    {
+        // keep anything already written through cout ahead of the rows
+        cout.flush();
+    }
+
+    {
+        ResultWriter writer(file);
+
+        // the console gets a header line; csv files are kept importable
+        // with INSERT INTO ... VALUES FROM, which expects no header
+        if (outFile == nullptr)
+        {
+            writer.writeRow(attrNames, nAttrs);
+        }
+
+        ScanCursor cursor;
+        Attribute record[src_nAttrs];
+        Attribute projRecord[nAttrs];
+        while ((hasCondition ? BlockAccess::search(srcRelId, record, attr, attrVal, op, &cursor)
+                             : BlockAccess::project(srcRelId, record, &cursor)) == SUCCESS)
+        {
+            for (int i = 0; i < nAttrs; i++)
             {
-                targetRecord[index] = record1[i];
-                index++;
+                projRecord[i] = record[attrOffsets[i]];
             }
+            writer.writeRow(projRecord, attrTypes, nAttrs);
+            (*rowCount)++;
+        }
+    }
+
+    if (outFile != nullptr)
+    {
+        fclose(file);
+    }
+
+    return SUCCESS;
+}
+
+
+/*
+    Running state of one group of an aggregation. min/max hold attribute
+    values (NUMBER or STRING), sum is only meaningful for NUMBER attributes.
+*/
+struct AggregateState
+{
+    Attribute group;
+    int count;
+    double sum;
+    Attribute min;
+    Attribute max;
+};
+
+static void initAggregate(AggregateState *state, Attribute *group)
+{
+    if (group != nullptr)
+    {
+        state->group = *group;
+    }
+    state->count = 0;
+    state->sum = 0;
+}
+
+// aggOffset is -1 for COUNT(*), in which case only the count is maintained
+static void accumulate(AggregateState *state, Attribute record[], int aggOffset, int aggType)
+{
+    state->count++;
+    if (aggOffset == -1)
+    {
+        return;
+    }
+
+    Attribute value = record[aggOffset];
+    if (aggType == NUMBER)
+    {
+        state->sum += value.nVal;
+    }
+    if (state->count == 1 || compareAttrs(value, state->min, aggType) < 0)
+    {
+        state->min = value;
+    }
+    if (state->count == 1 || compareAttrs(value, state->max, aggType) > 0)
+    {
+        state->max = value;
+    }
+}
+
+static Attribute aggregateResult(AggregateState *state, int func)
+{
+    Attribute result;
+    if (func == AGG_COUNT)
+        result.nVal = state->count;
+    else if (func == AGG_SUM)
+        result.nVal = state->sum;
+    else if (func == AGG_AVG)
+        result.nVal = state->sum / state->count;
+    else if (func == AGG_MIN)
+        result = state->min;
+    else
+        result = state->max;
+    return result;
+}
+
+// key under which a group value is hashed
+static string groupKey(Attribute *group, int groupType)
+{
+    if (groupType == STRING)
+    {
+        string key;
+        getString(*group, &key);
+        return key;
+    }
+    double value = (group->nVal == 0) ? 0 : group->nVal; // -0 and 0 are one group
+    return string((char *)&value, sizeof(value));
+}
+
+/*
+    Sort based aggregation, used once the number of groups no longer fits in
+    the hash table. The qualifying records are copied into a temporary
+    relation, a B+ tree is built on the group attribute and the records are
+    read back in ascending order of the group attribute (a GE search from the
+    smallest key), so that each group is a contiguous run and only one group
+    needs to be held in memory at a time.
+*/
+static int sortAggregate(char srcRel[ATTR_SIZE], int func, int aggOffset, int aggType, char groupAttr[ATTR_SIZE],
+                         int groupType, char attr[ATTR_SIZE], int op, char strVal[ATTR_SIZE], int resultTypes[],
+                         ResultWriter *writer, int *rowCount)
+{
+    char tempRel[ATTR_SIZE] = TEMP;
+
+    int ret = (attr[0] != '\0') ? Algebra::select(srcRel, tempRel, attr, op, strVal)
+                                : Algebra::project(srcRel, tempRel);
+    if (ret != SUCCESS)
+    {
+        return ret;
+    }
+
+    int tempRelId = OpenRelTable::openRel(tempRel);
+    if (tempRelId < 0 || tempRelId >= MAX_OPEN)
+    {
+        Schema::deleteRel(tempRel);
+        return tempRelId;
+    }
+
+    Attribute minVal;
+    ret = BPlusTree::bPlusCreate(tempRelId, groupAttr);
+    if (ret == SUCCESS)
+    {
+        ret = BPlusTree::bPlusMin(tempRelId, groupAttr, &minVal);
+    }
+    if (ret != SUCCESS)
+    {
+        OpenRelTable::closeRel(tempRelId);
+        Schema::deleteRel(tempRel);
+        return ret;
+    }
+
+    RelCatEntry tempRelCatEntry;
+    RelCacheTable::getRelCatEntry(tempRelId, &tempRelCatEntry);
+    Attribute record[tempRelCatEntry.numAttrs];
+
+    AttrCatEntry groupAttrCatEntry;
+    AttrCacheTable::getAttrCatEntry(tempRelId, groupAttr, &groupAttrCatEntry);
+    int groupOffset = groupAttrCatEntry.offset;
+
+    AggregateState state;
+    bool inGroup = false;
+    Attribute row[2];
+
+    ScanCursor cursor;
+    while (BlockAccess::search(tempRelId, record, groupAttr, minVal, GE, &cursor) == SUCCESS)
+    {
+        // a new value of the group attribute ends the current group
+        if (inGroup && compareAttrs(record[groupOffset], state.group, groupType) != 0)
+        {
+            row[0] = state.group;
+            row[1] = aggregateResult(&state, func);
+            writer->writeRow(row, resultTypes, 2);
+            (*rowCount)++;
+            inGroup = false;
+        }
+        if (!inGroup)
+        {
+            initAggregate(&state, &record[groupOffset]);
+            inGroup = true;
+        }
+        accumulate(&state, record, aggOffset, aggType);
+    }
+    if (inGroup)
+    {
+        row[0] = state.group;
+        row[1] = aggregateResult(&state, func);
+        writer->writeRow(row, resultTypes, 2);
+        (*rowCount)++;
+    }
+
+    OpenRelTable::closeRel(tempRelId);
+    return Schema::deleteRel(tempRel);
+}
+
+/*
+    Computes func over aggAttr ("*" for COUNT(*)) of the records of srcRel
+    that satisfy `attr op strVal` (every record if attr is an empty string),
+    one result row per value of groupAttr (a single row if groupAttr is an
+    empty string), and streams the result to stdout.
+
+    Groups are collected in a hash table; if there are more than
+    AGG_MAX_GROUPS of them the aggregation is redone with sortAggregate().
+    Without a condition or grouping, COUNT is answered from the relation
+    catalog and MIN/MAX on an indexed attribute from the ends of its B+ tree,
+    without reading any record block.
+*/
+int Algebra::aggregate(char srcRel[ATTR_SIZE], int func, char aggAttr[ATTR_SIZE], char groupAttr[ATTR_SIZE],
+                       char attr[ATTR_SIZE], int op, char strVal[ATTR_SIZE], int *rowCount)
+{
+    *rowCount = 0;
+
+    int srcRelId = OpenRelTable::getRelId(srcRel);
+    if (srcRelId == E_RELNOTOPEN)
+    {
+        return E_RELNOTOPEN;
+    }
+
+    RelCatEntry srcRelCatEntry;
+    RelCacheTable::getRelCatEntry(srcRelId, &srcRelCatEntry);
+
+    // COUNT(*) has no attribute to aggregate on
+    bool countAll = (strcmp(aggAttr, "*") == 0);
+    if (countAll && func != AGG_COUNT)
+    {
+        return E_INVALID;
+    }
+
+    AttrCatEntry aggAttrCatEntry;
+    int aggOffset = -1, aggType = NUMBER;
+    if (!countAll)
+    {
+        int ret = AttrCacheTable::getAttrCatEntry(srcRelId, aggAttr, &aggAttrCatEntry);
+        if (ret != SUCCESS)
+        {
+            return ret;
+        }
+        aggOffset = aggAttrCatEntry.offset;
+        aggType = aggAttrCatEntry.attrType;
+
+        if ((func == AGG_SUM || func == AGG_AVG) && aggType != NUMBER)
+        {
+            return E_ATTRTYPEMISMATCH;
+        }
+    }
+
+    bool grouped = (groupAttr[0] != '\0');
+    int groupOffset = -1, groupType = NUMBER;
+    if (grouped)
+    {
+        AttrCatEntry groupAttrCatEntry;
+        int ret = AttrCacheTable::getAttrCatEntry(srcRelId, groupAttr, &groupAttrCatEntry);
+        if (ret != SUCCESS)
+        {
+            return ret;
+        }
+        groupOffset = groupAttrCatEntry.offset;
+        groupType = groupAttrCatEntry.attrType;
+    }
+
+    bool hasCondition = (attr[0] != '\0');
+    Attribute attrVal;
+    if (hasCondition)
+    {
+        int ret = getConditionValue(srcRelId, attr, strVal, &attrVal);
+        if (ret != SUCCESS)
+        {
+            return ret;
+        }
+    }
+
+    // result columns are (group, aggregate) or just (aggregate)
+    const char *funcNames[] = {"COUNT", "SUM", "MIN", "MAX", "AVG"};
+    int resultTypes[2];
+    char resultNames[2][ATTR_SIZE];
+    int nResultAttrs = 0;
+    if (grouped)
+    {
+        resultTypes[nResultAttrs] = groupType;
+        strcpy(resultNames[nResultAttrs], groupAttr);
+        nResultAttrs++;
+    }
+    resultTypes[nResultAttrs] = (func == AGG_MIN || func == AGG_MAX) ? aggType : NUMBER;
+    snprintf(resultNames[nResultAttrs], ATTR_SIZE, "%s(%s)", funcNames[func], aggAttr);
+    nResultAttrs++;
+
+    cout.flush();
+    ResultWriter writer(stdout);
+    writer.writeRow(resultNames, nResultAttrs);
 
-            for (int i = 0; i < numOfAttributes2; i++)
+    Attribute result;
+
+    /*** Answering from the catalog or the index without a scan ***/
+    if (!grouped && !hasCondition)
+    {
+        if (func == AGG_COUNT)
+        {
+            result.nVal = srcRelCatEntry.numRecs;
+            writer.writeRow(&result, resultTypes, 1);
+            *rowCount = 1;
+            return SUCCESS;
+        }
+
+        if ((func == AGG_MIN || func == AGG_MAX) && aggAttrCatEntry.rootBlock != -1)
+        {
+            int ret = (func == AGG_MIN) ? BPlusTree::bPlusMin(srcRelId, aggAttr, &result)
+                                        : BPlusTree::bPlusMax(srcRelId, aggAttr, &result);
+            if (ret == SUCCESS)
             {
-                if (i == attrCatEntry2.offset)
-                {
-                    continue;
-                }
-                targetRecord[index] = record2[i];
-                index++;
+                writer.writeRow(&result, resultTypes, 1);
+                *rowCount = 1;
             }
+            return (ret == E_NOTFOUND) ? SUCCESS : ret;
+        }
+    }
 
-            // insert the current record into the target relation by calling
-            // BlockAccess::insert()
+    /*** Hash aggregation ***/
+    unordered_map<string, AggregateState> groups;
+    AggregateState total;
+    initAggregate(&total, nullptr);
+    bool overflow = false;
 
-            ret = BlockAccess::insert(newRelId, targetRecord);
+    ScanCursor cursor;
+    Attribute record[srcRelCatEntry.numAttrs];
+    while ((hasCondition ? BlockAccess::search(srcRelId, record, attr, attrVal, op, &cursor)
+                         : BlockAccess::project(srcRelId, record, &cursor)) == SUCCESS)
+    {
+        if (!grouped)
+        {
+            accumulate(&total, record, aggOffset, aggType);
+            continue;
+        }
 
-            if (ret != SUCCESS)
+        string key = groupKey(&record[groupOffset], groupType);
+        auto iter = groups.find(key);
+        if (iter == groups.end())
+        {
+            if (groups.size() == AGG_MAX_GROUPS)
             {
+                overflow = true;
+                break;
+            }
+            iter = groups.emplace(key, AggregateState()).first;
+            initAggregate(&iter->second, &record[groupOffset]);
+        }
+        accumulate(&iter->second, record, aggOffset, aggType);
+    }
+
+    if (overflow)
+    {
+        groups.clear();
+        return sortAggregate(srcRel, func, aggOffset, aggType, groupAttr, groupType, attr, op, strVal,
+                             resultTypes, &writer, rowCount);
+    }
+
+    if (!grouped)
+    {
+        // an empty input has a COUNT but no SUM/MIN/MAX/AVG
+        if (total.count > 0 || func == AGG_COUNT)
+        {
+            result = aggregateResult(&total, func);
+            writer.writeRow(&result, resultTypes, 1);
+            *rowCount = 1;
+        }
+        return SUCCESS;
+    }
+
+    // emit the groups in ascending order of the group attribute, the same
+    // order in which sortAggregate() produces them
+    vector<AggregateState *> sortedGroups;
+    for (auto &entry : groups)
+    {
+        sortedGroups.push_back(&entry.second);
+    }
+    sort(sortedGroups.begin(), sortedGroups.end(), [groupType](AggregateState *a, AggregateState *b)
+         { return compareAttrs(a->group, b->group, groupType) < 0; });
 
-                // close the target relation by calling OpenRelTable::closeRel()
-                // delete targetRelation (by calling Schema::deleteRel())
-                Schema::closeRel(targetRelation);
-                Schema::deleteRel(targetRelation);
-                return E_DISKFULL;
+    Attribute row[2];
+    for (AggregateState *state : sortedGroups)
+    {
+        row[0] = state->group;
+        row[1] = aggregateResult(state, func);
+        writer.writeRow(row, resultTypes, 2);
+        (*rowCount)++;
+    }
+
+    return SUCCESS;
+}
+
+/*
+    Reads every record of srcRel from each of numThreads threads at the same
+    time, walking the record blocks directly, and reports the number of records
+    read and the time it took. Used to measure how scans scale with the number
+    of threads sharing the buffer.
+*/
+int Algebra::benchmarkScan(char srcRel[ATTR_SIZE], int numThreads, long long *recordsRead, double *seconds)
+{
+    *recordsRead = 0;
+    *seconds = 0;
+
+    int srcRelId = OpenRelTable::getRelId(srcRel);
+    if (srcRelId == E_RELNOTOPEN)
+    {
+        return E_RELNOTOPEN;
+    }
+    if (numThreads < 1)
+    {
+        return E_INVALID;
+    }
+
+    RelCatEntry relCatEntry;
+    RelCacheTable::getRelCatEntry(srcRelId, &relCatEntry);
+    const int firstBlock = relCatEntry.firstBlk;
+    const int numAttrs = relCatEntry.numAttrs;
+    RecordLayout layout;
+    RelCacheTable::getRecordLayout(srcRelId, &layout);
+
+    vector<long long> counts(numThreads, 0);
+    auto scan = [&](int threadIndex)
+    {
+        Attribute record[numAttrs];
+        long long count = 0;
+        for (int block = firstBlock; block != -1;)
+        {
+            RecBuffer recBuffer(block, &layout);
+            HeadInfo head;
+            recBuffer.getHeader(&head);
+            SlotMap slotMap;
+            recBuffer.getSlotMap(&slotMap);
+
+            for (int slot = slotMap.nextOccupied(0); slot < head.numSlots; slot = slotMap.nextOccupied(slot + 1))
+            {
+                recBuffer.getRecord(record, slot);
+                count++;
             }
+            block = head.rblock;
         }
+        counts[threadIndex] = count;
+    };
+
+    // one task per thread, with enough workers for all of them to run at once
+    TaskScheduler::reserve(numThreads);
+    auto start = chrono::steady_clock::now();
+    TaskGroup group;
+    for (int i = 0; i < numThreads; i++)
+    {
+        group.run([&scan, i]()
+                  {
+                      scan(i);
+                      return SUCCESS;
+                  });
     }
+    group.wait();
+    *seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
-    // close the target relation by calling OpenRelTable::closeRel()
-    return Schema::closeRel(targetRelation);
-}
\ No newline at end of file
+    for (long long count : counts)
+    {
+        *recordsRead += count;
+    }
+    return SUCCESS;
+}
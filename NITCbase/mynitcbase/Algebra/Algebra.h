@@ -1,14 +1,40 @@
 #ifndef NITCBASE_ALGEBRA_H
 #define NITCBASE_ALGEBRA_H
 
+#include <string>
+#include <vector>
+
 #include "../Cache/OpenRelTable.h"
 #include "../Schema/Schema.h"
 #include "../define/constants.h"
 
+// an insert into relName whose relation and attribute types are looked up once,
+// and again only after a relation has been closed (see OpenRelTable::getGeneration())
+struct InsertPlan {
+  char relName[ATTR_SIZE];
+  int relId = -1;
+  unsigned int generation;
+  std::vector<int> attrTypes;
+  std::vector<int> attrFormats;
+};
+
+// what a bulk load of a csv file got through
+struct LoadStats {
+  long long rows = 0;       // rows inserted
+  long long bytes = 0;      // size of the file
+  double seconds = 0;
+  long long errorLine = 0;  // line of the row that could not be inserted, 0 if there was none
+  std::string error;        // what was wrong with that row, when FAILURE is returned
+};
+
 class Algebra {
  public:
   // Insert
   static int insert(char relName[ATTR_SIZE], int numberOfAttributes, char record[][ATTR_SIZE]);
+  static int insert(InsertPlan *plan, int numberOfAttributes, char record[][ATTR_SIZE]);
+
+  // Bulk load of the rows of a csv file
+  static int load(char relName[ATTR_SIZE], const char *filePath, LoadStats *stats);
 
   // Select
   static int select(char srcRel[ATTR_SIZE], char targetRel[ATTR_SIZE], char attr[ATTR_SIZE], int op, char strVal[ATTR_SIZE]);
@@ -22,6 +48,20 @@ class Algebra {
   // Join
   static int join(char srcRelOne[ATTR_SIZE], char srcRelTwo[ATTR_SIZE], char targetRel[ATTR_SIZE],
                   char attrOne[ATTR_SIZE], char attrTwo[ATTR_SIZE]);
+
+  // Select/Project streamed to stdout (outFile == nullptr) or a csv file, without a target relation
+  static int stream(char srcRel[ATTR_SIZE], int tar_nAttrs, char tar_Attrs[][ATTR_SIZE],
+                    char attr[ATTR_SIZE], int op, char strVal[ATTR_SIZE], const char *outFile, int *rowCount);
+
+  // Aggregate (COUNT/SUM/MIN/MAX/AVG), optionally grouped, streamed to stdout
+  static int aggregate(char srcRel[ATTR_SIZE], int func, char aggAttr[ATTR_SIZE], char groupAttr[ATTR_SIZE],
+                       char attr[ATTR_SIZE], int op, char strVal[ATTR_SIZE], int *rowCount);
+
+  // Number of threads full scans of select/project and hash joins are split across (0 for one per core)
+  static int setScanThreads(int numThreads);
+
+  // Read-only benchmark: numThreads threads each scan every record of srcRel
+  static int benchmarkScan(char srcRel[ATTR_SIZE], int numThreads, long long *recordsRead, double *seconds);
 };
 
 #endif  // NITCBASE_ALGEBRA_H
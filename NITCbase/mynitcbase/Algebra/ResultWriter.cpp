@@ -0,0 +1,91 @@
+#include "ResultWriter.h"
+
+#include <cmath>
+#include <cstring>
+
+ResultWriter::ResultWriter(FILE *file)
+{
+    this->file = file;
+    this->used = 0;
+}
+
+ResultWriter::~ResultWriter()
+{
+    flush();
+}
+
+void ResultWriter::flush()
+{
+    if (used > 0)
+    {
+        fwrite(buffer, 1, used, file);
+        used = 0;
+    }
+    fflush(file);
+}
+
+void ResultWriter::write(const char *data, int length)
+{
+    // hand the buffer over to the file only when it cannot take the data,
+    // so that a result set costs a handful of write calls
+    if (used + length > RESULT_BUFFER_SIZE)
+    {
+        fwrite(buffer, 1, used, file);
+        used = 0;
+    }
+    memcpy(buffer + used, data, length);
+    used += length;
+}
+
+void ResultWriter::writeAttr(Attribute *attr, int attrType)
+{
+    if (attrType == NUMBER)
+    {
+        // whole numbers (every value of an INT or BIGINT attribute) are
+        // printed exactly with %lld, anything else with %.15g; neither adds
+        // a trailing ".000000", so the output stays readable by
+        // INSERT INTO ... VALUES FROM
+        char number[32];
+        double value = attr->nVal;
+        int length = (value == floor(value) && fabs(value) <= MAX_EXACT_INTEGER)
+                         ? snprintf(number, sizeof(number), "%lld", (long long)value)
+                         : snprintf(number, sizeof(number), "%.15g", value);
+        write(number, length);
+    }
+    else if (isLongString(*attr))
+    {
+        std::string value;
+        getString(*attr, &value);
+        write(value.data(), value.size());
+    }
+    else
+    {
+        write(attr->sVal, strnlen(attr->sVal, ATTR_SIZE));
+    }
+}
+
+void ResultWriter::writeRow(Attribute record[], int attrTypes[], int nAttrs)
+{
+    for (int i = 0; i < nAttrs; i++)
+    {
+        if (i > 0)
+        {
+            write(",", 1);
+        }
+        writeAttr(&record[i], attrTypes[i]);
+    }
+    write("\n", 1);
+}
+
+void ResultWriter::writeRow(char values[][ATTR_SIZE], int nAttrs)
+{
+    for (int i = 0; i < nAttrs; i++)
+    {
+        if (i > 0)
+        {
+            write(",", 1);
+        }
+        write(values[i], strnlen(values[i], ATTR_SIZE));
+    }
+    write("\n", 1);
+}
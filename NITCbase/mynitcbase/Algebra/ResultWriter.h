@@ -0,0 +1,31 @@
+#ifndef NITCBASE_RESULTWRITER_H
+#define NITCBASE_RESULTWRITER_H
+
+#include <cstdio>
+
+#include "../Buffer/BlockBuffer.h"
+#include "../define/constants.h"
+
+/*
+  Buffered writer used to stream query results (as comma separated rows) to
+  stdout or to a file without going through the disk or the catalogs.
+*/
+class ResultWriter {
+ public:
+  ResultWriter(FILE *file);
+  ~ResultWriter();
+
+  void writeRow(Attribute record[], int attrTypes[], int nAttrs);
+  void writeRow(char values[][ATTR_SIZE], int nAttrs);
+  void flush();
+
+ private:
+  FILE *file;
+  int used;
+  char buffer[RESULT_BUFFER_SIZE];
+
+  void write(const char *data, int length);
+  void writeAttr(Attribute *attr, int attrType);
+};
+
+#endif  // NITCBASE_RESULTWRITER_H
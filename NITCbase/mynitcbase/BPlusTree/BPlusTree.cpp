@@ -1,16 +1,35 @@
 #include "BPlusTree.h"
-#include <iostream>
+#include "../Scheduler/TaskScheduler.h"
+#include <algorithm>
 #include <cstring>
+#include <iostream>
+#include <vector>
 
 using namespace std;
-RecId BPlusTree::bPlusSearch(int relId, char attrName[ATTR_SIZE], Attribute attrVal, int op)
+
+/* The key of attrVal as it is stored in a leaf: with the bytes a comparison
+   does not look at (those after the double of a NUMBER, or after the end of a
+   STRING that is not a long string) zeroed, so that the leaf can leave them
+   out (see IndLeaf) */
+static Attribute getLeafKey(Attribute attrVal, int attrType)
 {
-    // declare searchIndex which will be used to store search index for attrName.
-    IndexId searchIndex;
+    unsigned char *bytes = (unsigned char *)&attrVal;
+    if (attrType != STRING)
+    {
+        memset(bytes + sizeof(double), 0, ATTR_SIZE - sizeof(double));
+    }
+    else if (!isLongString(attrVal))
+    {
+        int length = strnlen(attrVal.sVal, ATTR_SIZE);
+        memset(bytes + length, 0, ATTR_SIZE - length);
+    }
+    return attrVal;
+}
 
-    /* get the search index corresponding to attribute with name attrName
-       using AttrCacheTable::getSearchIndex(). */
-    AttrCacheTable::getSearchIndex(relId, attrName, &searchIndex);
+RecId BPlusTree::bPlusSearch(int relId, char attrName[ATTR_SIZE], Attribute attrVal, int op, ScanCursor *cursor)
+{
+    // the leaf entry last returned by this scan is kept in the cursor
+    IndexId searchIndex = cursor->indexId;
 
     AttrCatEntry attrCatEntry;
     /* load the attribute cache entry into attrCatEntry using
@@ -73,7 +92,7 @@ RecId BPlusTree::bPlusSearch(int relId, char attrName[ATTR_SIZE], Attribute attr
              of attrVal and the operator op                             ******/
 
     /* (This section is only needed when
-        - search restarts from the root block (when searchIndex is reset by caller)
+        - search restarts from the root block (for a new or reset cursor)
         - root is not a leaf
         If there was a valid search index, then we are already at a leaf block
         and the test condition in the following loop will fail)
@@ -202,9 +221,8 @@ RecId BPlusTree::bPlusSearch(int relId, char attrName[ATTR_SIZE], Attribute attr
             {
                 // (entry satisfying the condition found)
 
-                // set search index to {block, index}
-                searchIndex = IndexId{block, index};
-                AttrCacheTable::setSearchIndex(relId, attrName, &searchIndex);
+                // move the cursor to {block, index}
+                cursor->indexId = IndexId{block, index};
 
                 // return the recId {leafEntry.block, leafEntry.slot}.
                 return RecId{leafEntry.block, leafEntry.slot};
@@ -241,6 +259,19 @@ RecId BPlusTree::bPlusSearch(int relId, char attrName[ATTR_SIZE], Attribute attr
 }
 
 int BPlusTree::bPlusCreate(int relId, char attrName[ATTR_SIZE])
+{
+    char attrNames[1][ATTR_SIZE];
+    strcpy(attrNames[0], attrName);
+    return bPlusCreate(relId, 1, attrNames);
+}
+
+/* Builds a B+ tree on each of the attributes in attrNames (attributes that
+   already have one are skipped). The relation is scanned once and the
+   (key, rec-id) pairs of every attribute are collected; then each tree is
+   sorted and built bottom-up as a task of its own (see bulkLoad()), so that
+   indexing several attributes costs little more than indexing one. The first
+   tree that runs out of disk cancels the ones not built yet. */
+int BPlusTree::bPlusCreate(int relId, int numAttrs, char attrNames[][ATTR_SIZE])
 {
     // if relId is either RELCAT_RELID or ATTRCAT_RELID:
     //     return E_NOTPERMITTED;
@@ -249,116 +280,266 @@ int BPlusTree::bPlusCreate(int relId, char attrName[ATTR_SIZE])
         return E_NOTPERMITTED;
     }
 
-    // get the attribute catalog entry of attribute `attrName`
-    // using AttrCacheTable::getAttrCatEntry()
-    AttrCatEntry attrCatEntry;
-    int ret = AttrCacheTable::getAttrCatEntry(relId, attrName, &attrCatEntry);
+    // get the attribute catalog entries of the attributes to index; if
+    // getAttrCatEntry fails return its error code before anything is built
+    vector<AttrCatEntry> attrCatEntries;
+    for (int i = 0; i < numAttrs; i++)
+    {
+        AttrCatEntry attrCatEntry;
+        int ret = AttrCacheTable::getAttrCatEntry(relId, attrNames[i], &attrCatEntry);
+        if (ret != SUCCESS)
+        {
+            return ret;
+        }
 
+        // (a B+ tree already exists for the attribute, or it is listed twice)
+        bool listed = false;
+        for (AttrCatEntry &entry : attrCatEntries)
+        {
+            listed = listed || entry.offset == attrCatEntry.offset;
+        }
+        if (attrCatEntry.rootBlock == -1 && !listed)
+        {
+            attrCatEntries.push_back(attrCatEntry);
+        }
+    }
+    if (attrCatEntries.empty())
+    {
+        return SUCCESS;
+    }
+
+    RelCatEntry relCatEntry;
+
+    // load the relation catalog entry into relCatEntry
+    // using RelCacheTable::getRelCatEntry().
+    int ret = RelCacheTable::getRelCatEntry(relId, &relCatEntry);
     if (ret != SUCCESS)
     {
         return ret;
     }
 
-    // if getAttrCatEntry fails
-    //     return the error code from getAttrCatEntry
-
-    if (attrCatEntry.rootBlock != -1)
+    /***** Traverse all the blocks in the relation once and collect the
+           entries of every B+ Tree *****/
+    vector<vector<Index>> entries(attrCatEntries.size());
+    for (vector<Index> &attrEntries : entries)
     {
-        // (B+ Tree already exists for the attribute)
-        return SUCCESS;
+        attrEntries.reserve(relCatEntry.numRecs);
     }
 
-    /******Creating a new B+ Tree ******/
+    RecordLayout layout;
+    RelCacheTable::getRecordLayout(relId, &layout);
 
-    // get a free leaf block using constructor 1 to allocate a new block
-    IndLeaf rootBlockBuf;
+    Attribute record[relCatEntry.numAttrs];
+    int block = relCatEntry.firstBlk;
+    while (block != -1)
+    {
+        RecBuffer recBuf(block, &layout);
 
-    // (if the block could not be allocated, the appropriate error code
-    //  will be stored in the blockNum member field of the object)
+        HeadInfo headInfo;
+        recBuf.getHeader(&headInfo);
+        SlotMap slotMap;
+        recBuf.getSlotMap(&slotMap);
 
-    // declare rootBlock to store the blockNumber of the new leaf block
-    int rootBlock = rootBlockBuf.getBlockNum();
+        for (int slot = slotMap.nextOccupied(0); slot < headInfo.numSlots; slot = slotMap.nextOccupied(slot + 1))
+        {
+            recBuf.getRecord(record, slot);
 
-    // if there is no more disk space for creating an index
-    if (rootBlock == E_DISKFULL)
-    {
-        return E_DISKFULL;
+            for (size_t i = 0; i < attrCatEntries.size(); i++)
+            {
+                Index index;
+                index.attrVal = getLeafKey(record[attrCatEntries[i].offset], attrCatEntries[i].attrType);
+                index.block = block;
+                index.slot = slot;
+                entries[i].push_back(index);
+            }
+        }
+
+        // set block = rblock of current block (from the header)
+        block = headInfo.rblock;
     }
-    attrCatEntry.rootBlock = rootBlock;
-    AttrCacheTable::setAttrCatEntry(relId, attrName, &attrCatEntry);
 
-    RelCatEntry relCatEntry;
+    /***** Sort and build every B+ Tree as a task of its own *****/
+    // (the trees of a cancelled build are left with no result)
+    vector<int> results(attrCatEntries.size(), E_NOINDEX);
+    TaskGroup group(TASK_PRIORITY_LOW);
+    auto build = [&](int i)
+    {
+        const int attrType = attrCatEntries[i].attrType;
+        sort(entries[i].begin(), entries[i].end(), [attrType](const Index &a, const Index &b)
+             {
+                 int cmpVal = compareAttrs(a.attrVal, b.attrVal, attrType);
+                 if (cmpVal != 0)
+                 {
+                     return cmpVal < 0;
+                 }
+                 return a.block != b.block ? a.block < b.block : a.slot < b.slot;
+             });
+        if (!group.isCancelled())
+        {
+            results[i] = bulkLoad(entries[i]);
+        }
+        vector<Index>().swap(entries[i]);
+        return results[i] < 0 ? results[i] : SUCCESS;
+    };
 
-    // load the relation catalog entry into relCatEntry
-    // using RelCacheTable::getRelCatEntry().
-    ret = RelCacheTable::getRelCatEntry(relId, &relCatEntry);
-    if (ret != SUCCESS)
+    for (size_t i = 0; i < attrCatEntries.size(); i++)
     {
-        return ret;
+        group.run([&build, i]()
+                  { return build(i); });
     }
+    ret = group.wait();
 
-    int block = relCatEntry.firstBlk;
-    /***** Traverse all the blocks in the relation and insert them one
-           by one into the B+ Tree *****/
-    while (block != -1)
+    // update the root blocks in the attribute cache
+    // (the trees that could not be built have already been released)
+    for (size_t i = 0; i < attrCatEntries.size(); i++)
     {
+        if (results[i] < 0)
+        {
+            continue;
+        }
+        attrCatEntries[i].rootBlock = results[i];
+        AttrCacheTable::setAttrCatEntry(relId, attrCatEntries[i].attrName, &attrCatEntries[i]);
+    }
+    return ret;
+}
 
-        // declare a RecBuffer object for `block` (using appropriate constructor)
-        RecBuffer recBuf(block);
+/* Builds a B+ tree bottom-up from entries sorted on their attribute value and
+   returns its root block, or E_DISKFULL (after releasing the blocks taken so
+   far) if the disk runs out of blocks.
+
+   The leaves are filled in order and linked left to right; each level of
+   internal blocks is then built over the one below it, with the entry between
+   two children holding the largest value of the left one (as splitLeaf() and
+   splitInternal() leave it). Each leaf takes as many entries as fit in it (see
+   IndLeaf::getNumFitting()), the last two sharing what is left; the entries of
+   an internal level are spread evenly over its blocks. Either way no block is
+   left with too few. */
+int BPlusTree::bulkLoad(vector<Index> &entries)
+{
+    vector<int> allocated;
+    auto releaseAll = [&allocated]()
+    {
+        for (int blockNum : allocated)
+        {
+            BlockBuffer blockBuf(blockNum);
+            blockBuf.releaseBlock();
+        }
+        return E_DISKFULL;
+    };
 
-        unsigned char slotMap[relCatEntry.numSlotsPerBlk];
+    /***** Fill the leaves *****/
+    const int numEntries = entries.size();
 
-        // load the slot map into slotMap using RecBuffer::getSlotMap().
-        recBuf.getSlotMap(slotMap);
+    vector<int> level;          // blocks of the level being built
+    vector<Attribute> maxVals;  // largest attribute value under each of them
+    int next = 0;
+    while (next < numEntries || level.empty())
+    {
+        IndLeaf leaf;
+        int leafBlockNum = leaf.getBlockNum();
+        if (leafBlockNum == E_DISKFULL)
+        {
+            return releaseAll();
+        }
+        allocated.push_back(leafBlockNum);
 
-        // for every occupied slot of the block
-        for (int slot = 0; slot < relCatEntry.numSlotsPerBlk; slot++)
+        // (fewer of the entries always fit, so the leaf can give some of them
+        // to the next one)
+        int count = 0;
+        if (next < numEntries)
         {
-            if (slotMap[slot] == SLOT_UNOCCUPIED)
+            count = IndLeaf::getNumFitting(&entries[next], numEntries - next);
+            const int rest = numEntries - next - count;
+            if (rest > 0 && rest < count / 2)
             {
-                // (slot is empty)
-                continue;
+                count = (count + rest + 1) / 2;
             }
-            Attribute record[relCatEntry.numAttrs];
-            // load the record corresponding to the slot into `record`
-            // using RecBuffer::getRecord().
-            recBuf.getRecord(record, slot);
+        }
+
+        HeadInfo leafHeader;
+        leaf.getHeader(&leafHeader);
+        leafHeader.numEntries = count;
+        leafHeader.lblock = level.empty() ? -1 : level.back();
+        leaf.setHeader(&leafHeader);
+
+        leaf.setEntries(entries.data() + next, count);
+
+        // link the previous leaf to this one
+        if (!level.empty())
+        {
+            IndLeaf prevLeaf(level.back());
+            HeadInfo prevHeader;
+            prevLeaf.getHeader(&prevHeader);
+            prevHeader.rblock = leafBlockNum;
+            prevLeaf.setHeader(&prevHeader);
+        }
+
+        level.push_back(leafBlockNum);
+        maxVals.push_back(count > 0 ? entries[next + count - 1].attrVal : Attribute());
+        next += count;
+    }
+
+    /***** Build the internal levels up to the root *****/
+    const int maxChildren = IndInternal::getMaxKeys() + 1;
+    while (level.size() > 1)
+    {
+        const int numChildren = level.size();
+        const int numNodes = (numChildren + maxChildren - 1) / maxChildren;
 
-            // declare recId and store the rec-id of this record in it
-            // RecId recId{block, slot};
-            RecId recId{block, slot};
-
-            // insert the attribute value corresponding to attrName from the record
-            // into the B+ tree using bPlusInsert.
-            // (note that bPlusInsert will destroy any existing bplus tree if
-            // insert fails i.e when disk is full)
-            // retVal = bPlusInsert(relId, attrName, attribute value, recId);
-            int retVal = bPlusInsert(relId, attrName, record[attrCatEntry.offset], recId);
-
-            // if (retVal == E_DISKFULL) {
-            //     // (unable to get enough blocks to build the B+ Tree.)
-            //     return E_DISKFULL;
-            // }
-            if (retVal == E_DISKFULL)
+        vector<int> parentLevel;
+        vector<Attribute> parentMaxVals;
+        int first = 0;
+        for (int nodeIndex = 0; nodeIndex < numNodes; nodeIndex++)
+        {
+            IndInternal node;
+            int nodeBlockNum = node.getBlockNum();
+            if (nodeBlockNum == E_DISKFULL)
             {
-                return E_DISKFULL;
+                return releaseAll();
             }
-        }
+            allocated.push_back(nodeBlockNum);
 
-        // get the header of the block using BlockBuffer::getHeader()
-        HeadInfo headInfo;
-        recBuf.getHeader(&headInfo);
+            const int count = numChildren / numNodes + (nodeIndex < numChildren % numNodes ? 1 : 0);
 
-        // set block = rblock of current block (from the header)
-        block = headInfo.rblock;
+            HeadInfo nodeHeader;
+            node.getHeader(&nodeHeader);
+            nodeHeader.numEntries = count - 1;
+            node.setHeader(&nodeHeader);
+
+            for (int i = 0; i < count - 1; i++)
+            {
+                InternalEntry entry;
+                entry.lChild = level[first + i];
+                entry.attrVal = maxVals[first + i];
+                entry.rChild = level[first + i + 1];
+                node.setEntry(&entry, i);
+            }
+
+            // the children get the new block as their parent
+            for (int i = 0; i < count; i++)
+            {
+                BlockBuffer child(level[first + i]);
+                HeadInfo childHeader;
+                child.getHeader(&childHeader);
+                childHeader.pblock = nodeBlockNum;
+                child.setHeader(&childHeader);
+            }
+
+            parentLevel.push_back(nodeBlockNum);
+            parentMaxVals.push_back(maxVals[first + count - 1]);
+            first += count;
+        }
+
+        level.swap(parentLevel);
+        maxVals.swap(parentMaxVals);
     }
 
-    return SUCCESS;
+    return level[0];
 }
 
 int BPlusTree::bPlusDestroy(int rootBlockNum)
 {
-    if (rootBlockNum < 0 || rootBlockNum >= DISK_BLOCKS)
+    if (rootBlockNum < 0 || rootBlockNum >= Disk::getNumBlocks())
     {
         return E_OUTOFBOUND;
     }
@@ -460,7 +641,7 @@ int BPlusTree::bPlusInsert(int relId, char attrName[ATTR_SIZE], Attribute attrVa
     //       required internal nodes by calling the required helper functions
     //       like insertIntoInternal() or createNewRoot()
     Index entry;
-    entry.attrVal = attrVal;
+    entry.attrVal = getLeafKey(attrVal, attrCatEntry.attrType);
     entry.block = recId.block;
     entry.slot = recId.slot;
 
@@ -555,25 +736,27 @@ int BPlusTree::insertIntoLeaf(int relId, char attrName[ATTR_SIZE], int blockNum,
     for (int i = targetIndex; i < numEntries; i++)
         leafBlock.getEntry(&indices[i + 1], i);
 
-    if (numEntries != MAX_KEYS_LEAF)
+    // (the leaf is full once the entries no longer fit in it together)
+    if (IndLeaf::getNumFitting(indices, numEntries + 1) == numEntries + 1)
     {
         leafHeader.numEntries++;
         leafBlock.setHeader(&leafHeader);
 
-        for (int i = 0; i < leafHeader.numEntries; i++)
-            leafBlock.setEntry(&indices[i], i);
+        leafBlock.setEntries(indices, leafHeader.numEntries);
 
         return SUCCESS;
     }
 
-    int newRightBlock = splitLeaf(blockNum, indices);
+    int newRightBlock = splitLeaf(blockNum, indices, numEntries + 1);
     if (newRightBlock == E_DISKFULL)
         return newRightBlock;
 
+    // the largest key of the left half goes up
+    const int leftKeys = (numEntries + 2) / 2;
     if (leafHeader.pblock != -1)
     {
         InternalEntry intEntry;
-        intEntry.attrVal = indices[MIDDLE_INDEX_LEAF].attrVal;
+        intEntry.attrVal = indices[leftKeys - 1].attrVal;
         intEntry.lChild = blockNum;
         intEntry.rChild = newRightBlock;
 
@@ -581,13 +764,18 @@ int BPlusTree::insertIntoLeaf(int relId, char attrName[ATTR_SIZE], int blockNum,
     }
     else
     {
-        return createNewRoot(relId, attrName, indices[MIDDLE_INDEX_LEAF].attrVal, blockNum, newRightBlock);
+        return createNewRoot(relId, attrName, indices[leftKeys - 1].attrVal, blockNum, newRightBlock);
     }
 
     return SUCCESS;
 }
 
-int BPlusTree::splitLeaf(int leafBlockNum, Index indices[])
+/* Splits the leaf leafBlockNum, whose numKeys entries (at most
+   IndLeaf::getMaxKeys()+1) are in indices, into itself and a new leaf to its
+   right, and returns the block of the new leaf. The left leaf keeps the first
+   half of the entries, and one more if numKeys is odd; either half fits
+   whatever its keys are. */
+int BPlusTree::splitLeaf(int leafBlockNum, Index indices[], int numKeys)
 {
     // declare rightBlk, an instance of IndLeaf using constructor 1 to obtain new
     // leaf index block that will be used as the right block in the splitting
@@ -611,38 +799,36 @@ int BPlusTree::splitLeaf(int leafBlockNum, Index indices[])
     leftBlk.getHeader(&leftBlkHeader);
     rightBlk.getHeader(&rightBlkHeader);
 
+    // a full leaf (IndLeaf::getMaxKeys()+1 entries) is split into halves of the
+    // same size (91 entries for 2048 byte blocks)
+    const int leftKeys = (numKeys + 1) / 2;
+    const int rightKeys = numKeys - leftKeys;
+
     // set rightBlkHeader with the following values
-    // - number of entries = (MAX_KEYS_LEAF+1)/2 = 32,
+    // - number of entries = rightKeys,
     // - pblock = pblock of leftBlk
     // - lblock = leftBlkNum
     // - rblock = rblock of leftBlk
     // and update the header of rightBlk using BlockBuffer::setHeader()
-    rightBlkHeader.numEntries = (MAX_KEYS_LEAF + 1) / 2;
+    rightBlkHeader.numEntries = rightKeys;
     rightBlkHeader.pblock = leftBlkHeader.pblock;
     rightBlkHeader.lblock = leftBlkNum;
     rightBlkHeader.rblock = leftBlkHeader.rblock;
     rightBlk.setHeader(&rightBlkHeader);
 
     // set leftBlkHeader with the following values
-    // - number of entries = (MAX_KEYS_LEAF+1)/2 = 32
+    // - number of entries = leftKeys
     // - rblock = rightBlkNum
     // and update the header of leftBlk using BlockBuffer::setHeader() */
-    leftBlkHeader.numEntries = (MAX_KEYS_LEAF + 1) / 2;
+    leftBlkHeader.numEntries = leftKeys;
     leftBlkHeader.rblock = rightBlkNum;
     leftBlk.setHeader(&leftBlkHeader);
 
-    // set the first 32 entries of leftBlk = the first 32 entries of indices array
-    // and set the first 32 entries of newRightBlk = the next 32 entries of
-    // indices array using IndLeaf::setEntry().
-    for (int i = 0; i < 32; i++)
-    {
-        leftBlk.setEntry(&indices[i], i);
-    }
-
-    for (int i = 32; i < 64; i++)
-    {
-        rightBlk.setEntry(&indices[i], i - 32);
-    }
+    // set the entries of leftBlk = the first leftKeys entries of indices array
+    // and the entries of newRightBlk = the rest of the indices array
+    // using IndLeaf::setEntries().
+    leftBlk.setEntries(indices, leftKeys);
+    rightBlk.setEntries(indices + leftKeys, rightKeys);
 
     return rightBlkNum;
 }
@@ -694,7 +880,8 @@ int BPlusTree::insertIntoInternal(int relId, char attrName[ATTR_SIZE], int intBl
         intEntries[targetIndex + 1].lChild = intEntries[targetIndex].rChild;
     }
 
-    if (intHeader.numEntries != MAX_KEYS_INTERNAL)
+    const int maxKeys = IndInternal::getMaxKeys();
+    if (intHeader.numEntries != maxKeys)
     {
         intHeader.numEntries++;
         intBlock.setHeader(&intHeader);
@@ -716,7 +903,7 @@ int BPlusTree::insertIntoInternal(int relId, char attrName[ATTR_SIZE], int intBl
     if (intHeader.pblock != -1)
     {
         InternalEntry entryInParent;
-        entryInParent.attrVal = intEntries[MIDDLE_INDEX_INTERNAL].attrVal;
+        entryInParent.attrVal = intEntries[maxKeys / 2].attrVal;
         entryInParent.lChild = intBlockNum;
         entryInParent.rChild = newRightBlock;
 
@@ -724,7 +911,7 @@ int BPlusTree::insertIntoInternal(int relId, char attrName[ATTR_SIZE], int intBl
     }
     else
     {
-        return createNewRoot(relId, attrName, intEntries[MIDDLE_INDEX_INTERNAL].attrVal, intBlockNum, newRightBlock);
+        return createNewRoot(relId, attrName, intEntries[maxKeys / 2].attrVal, intBlockNum, newRightBlock);
     }
 
     return SUCCESS;
@@ -747,21 +934,25 @@ int BPlusTree::splitInternal(int intBlockNum, InternalEntry internalEntries[])
     leftBlock.getHeader(&leftBlockHeader);
     rightBlock.getHeader(&rightBlockHeader);
 
-    rightBlockHeader.numEntries = (MAX_KEYS_INTERNAL / 2);
+    // the middle entry moves up to the parent, the halves on either side of it are split
+    const int maxKeys = IndInternal::getMaxKeys();
+    const int middleIndex = maxKeys / 2;
+
+    rightBlockHeader.numEntries = (maxKeys / 2);
     rightBlockHeader.pblock = leftBlockHeader.pblock;
     rightBlock.setHeader(&rightBlockHeader);
 
-    leftBlockHeader.numEntries = (MAX_KEYS_INTERNAL / 2);
+    leftBlockHeader.numEntries = (maxKeys / 2);
     leftBlock.setHeader(&leftBlockHeader);
 
-    for (int i = 0; i < MIDDLE_INDEX_INTERNAL; i++)
+    for (int i = 0; i < middleIndex; i++)
     {
         leftBlock.setEntry(&internalEntries[i], i);
     }
 
-    for (int i = MIDDLE_INDEX_INTERNAL + 1; i <= 100; i++)
+    for (int i = middleIndex + 1; i <= maxKeys; i++)
     {
-        rightBlock.setEntry(&internalEntries[i], i - MIDDLE_INDEX_INTERNAL - 1);
+        rightBlock.setEntry(&internalEntries[i], i - middleIndex - 1);
     }
 
     InternalEntry entryBuffer;
@@ -848,3 +1039,94 @@ int BPlusTree::createNewRoot(int relId, char attrName[ATTR_SIZE], Attribute attr
     AttrCacheTable::setAttrCatEntry(relId, attrName, &attrCatEntry);
     return SUCCESS;
 }
+
+/*
+    The smallest key of a B+ tree is the first entry of its left-most leaf, so
+    it is found by following the first lChild from the root down to the leaf.
+    No record block is read.
+*/
+int BPlusTree::bPlusMin(int relId, char attrName[ATTR_SIZE], Attribute *attrVal)
+{
+    AttrCatEntry attrCatEntry;
+    int ret = AttrCacheTable::getAttrCatEntry(relId, attrName, &attrCatEntry);
+    if (ret != SUCCESS)
+    {
+        return ret;
+    }
+
+    int block = attrCatEntry.rootBlock;
+    if (block == -1)
+    {
+        return E_NOINDEX;
+    }
+
+    while (StaticBuffer::getStaticBlockType(block) == IND_INTERNAL)
+    {
+        IndInternal internalBlk(block);
+        InternalEntry intEntry;
+        internalBlk.getEntry(&intEntry, 0);
+        block = intEntry.lChild;
+    }
+
+    IndLeaf leafBlk(block);
+    HeadInfo leafHead;
+    leafBlk.getHeader(&leafHead);
+
+    // only the root leaf of an index on an empty relation has no entries
+    if (leafHead.numEntries == 0)
+    {
+        return E_NOTFOUND;
+    }
+
+    Index leafEntry;
+    leafBlk.getEntry(&leafEntry, 0);
+    *attrVal = leafEntry.attrVal;
+
+    return SUCCESS;
+}
+
+/*
+    The largest key of a B+ tree is the last entry of its right-most leaf, so
+    it is found by following the last rChild from the root down to the leaf.
+*/
+int BPlusTree::bPlusMax(int relId, char attrName[ATTR_SIZE], Attribute *attrVal)
+{
+    AttrCatEntry attrCatEntry;
+    int ret = AttrCacheTable::getAttrCatEntry(relId, attrName, &attrCatEntry);
+    if (ret != SUCCESS)
+    {
+        return ret;
+    }
+
+    int block = attrCatEntry.rootBlock;
+    if (block == -1)
+    {
+        return E_NOINDEX;
+    }
+
+    while (StaticBuffer::getStaticBlockType(block) == IND_INTERNAL)
+    {
+        IndInternal internalBlk(block);
+        HeadInfo intHead;
+        internalBlk.getHeader(&intHead);
+
+        InternalEntry intEntry;
+        internalBlk.getEntry(&intEntry, intHead.numEntries - 1);
+        block = intEntry.rChild;
+    }
+
+    IndLeaf leafBlk(block);
+    HeadInfo leafHead;
+    leafBlk.getHeader(&leafHead);
+
+    if (leafHead.numEntries == 0)
+    {
+        return E_NOTFOUND;
+    }
+
+    Index leafEntry;
+    leafBlk.getEntry(&leafEntry, leafHead.numEntries - 1);
+    *attrVal = leafEntry.attrVal;
+
+    return SUCCESS;
+}
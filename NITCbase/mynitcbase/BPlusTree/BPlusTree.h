@@ -1,6 +1,8 @@
 #ifndef NITCBASE_BPLUSTREE_H
 #define NITCBASE_BPLUSTREE_H
 
+#include <vector>
+
 #include "../Buffer/BlockBuffer.h"
 #include "../Buffer/StaticBuffer.h"
 #include "../Cache/OpenRelTable.h"
@@ -11,16 +13,20 @@ class BPlusTree {
  private:
   static int findLeafToInsert(int rootBlock, Attribute attrVal, int attrType);
   static int insertIntoLeaf(int relId, char attrName[ATTR_SIZE], int blockNum, Index entry);
-  static int splitLeaf(int leafBlockNum, Index indices[]);
+  static int splitLeaf(int leafBlockNum, Index indices[], int numKeys);
   static int insertIntoInternal(int relId, char attrName[ATTR_SIZE], int intBlockNum, InternalEntry entry);
   static int splitInternal(int intBlockNum, InternalEntry internalEntries[]);
   static int createNewRoot(int relId, char attrName[ATTR_SIZE], Attribute attrVal, int lChild, int rChild);
+  static int bulkLoad(std::vector<Index> &entries);
 
  public:
   static int bPlusCreate(int relId, char attrName[ATTR_SIZE]);
+  static int bPlusCreate(int relId, int numAttrs, char attrNames[][ATTR_SIZE]);
   static int bPlusInsert(int relId, char attrName[ATTR_SIZE], union Attribute attrVal, RecId recordId);
-  static RecId bPlusSearch(int relId, char attrName[ATTR_SIZE], union Attribute attrVal, int op);
+  static RecId bPlusSearch(int relId, char attrName[ATTR_SIZE], union Attribute attrVal, int op, ScanCursor *cursor);
   static int bPlusDestroy(int rootBlockNum);
+  static int bPlusMin(int relId, char attrName[ATTR_SIZE], Attribute *attrVal);
+  static int bPlusMax(int relId, char attrName[ATTR_SIZE], Attribute *attrVal);
 };
 
 #endif  // NITCBASE_BPLUSTREE_H
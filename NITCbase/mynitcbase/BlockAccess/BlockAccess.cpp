@@ -1,20 +1,24 @@
 #include "BlockAccess.h"
 #include "../Buffer/BlockBuffer.h"
+#include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <vector>
 using namespace std;
 
-RecId BlockAccess::linearSearch(int relId, char attrName[ATTR_SIZE], union Attribute attrVal, int op)
+RecId BlockAccess::linearSearch(int relId, char attrName[ATTR_SIZE], union Attribute attrVal, int op,
+                                ScanCursor *cursor)
 {
     // TODO: No error handling is done in this function. Should add error handling code.
-    // get the previous search index of the relation relId from the relation cache
-    // (use RelCacheTable::getSearchIndex() function)
-    RecId prevRecId;
-    RelCacheTable::getSearchIndex(relId, &prevRecId);
+    // get the previous hit of this scan from the cursor
+    RecId prevRecId = cursor->recId;
 
     int block, slot;
 
-    // if the current search index record is invalid(i.e. both block and slot = -1)
+    RecordLayout layout;
+    RelCacheTable::getRecordLayout(relId, &layout);
+
+    // if the cursor's record is invalid(i.e. both block and slot = -1)
     if (prevRecId.block == -1 && prevRecId.slot == -1)
     {
         // (no hits from previous search; search should start from the
@@ -34,35 +38,39 @@ RecId BlockAccess::linearSearch(int relId, char attrName[ATTR_SIZE], union Attri
     else
     {
         // (there is a hit from previous search; search should start from
-        // the record next to the search index record)
+        // the record next to the cursor's record)
 
         // TODO: What if the previous hit is the last record of the relation?
         // How exactly should I move the block and slot pointers in that case?
-        // block = search index's block
-        // slot = search index's slot + 1
+        // block = cursor's block
+        // slot = cursor's slot + 1
         block = prevRecId.block;
         slot = prevRecId.slot + 1;
     }
 
+    /*
+        firstly get the attribute offset for the attrName attribute
+        from the attribute cache entry of the relation using
+        AttrCacheTable::getAttrCatEntry()
+    */
+    AttrCatEntry attrCatEntry;
+    AttrCacheTable::getAttrCatEntry(relId, attrName, &attrCatEntry);
+
     /* The following code searches for the next record in the relation
        that satisfies the given condition
        We start from the record id (block, slot) and iterate over the remaining
        records of the relation
     */
+    vector<Attribute> values;
     while (block != -1)
     {
         /* create a RecBuffer object for block (use RecBuffer Constructor for
            existing block) */
-        RecBuffer recBuffer(block);
+        RecBuffer recBuffer(block, &layout);
 
-        // get the record with id (block, slot) using RecBuffer::getRecord()
+        // get header of the block using RecBuffer::getHeader() function
         HeadInfo head;
         recBuffer.getHeader(&head);
-        unsigned char slotMap[head.numSlots];
-        recBuffer.getSlotMap(slotMap);
-
-        // get header of the block using RecBuffer::getHeader() function
-        // get slot map of the block using RecBuffer::getSlotMap() function
 
         // If slot >= the number of slots per block(i.e. no more slots in this block)
         if (slot >= head.numSlots)
@@ -75,59 +83,40 @@ RecId BlockAccess::linearSearch(int relId, char attrName[ATTR_SIZE], union Attri
             continue; // continue to the beginning of this while loop
         }
 
-        int numAttrs = head.numAttrs;
+        // get slot map of the block using RecBuffer::getSlotMap() function
+        SlotMap slotMap;
+        recBuffer.getSlotMap(&slotMap);
 
-        // if slot is free skip the loop
-        // (i.e. check if slot'th entry in slot map of block contains SLOT_UNOCCUPIED)
-        Attribute record[numAttrs];
-        recBuffer.getRecord(record, slot);
+        // only the attribute compared is read from the block, for every slot
+        // at once (of a columnar block, just its minipage)
+        values.resize(head.numSlots);
+        recBuffer.getColumn(values.data(), attrCatEntry.offset);
 
-        if (slotMap[slot] == SLOT_UNOCCUPIED)
+        // the free slots are skipped
+        for (slot = slotMap.nextOccupied(slot); slot < head.numSlots; slot = slotMap.nextOccupied(slot + 1))
         {
-            // increment slot and continue to the next record slot
-            slot++;
-            continue;
-        }
-        // compare record's attribute value to the the given attrVal as below:
-        /*
-            firstly get the attribute offset for the attrName attribute
-            from the attribute cache entry of the relation using
-            AttrCacheTable::getAttrCatEntry()
-        */
-        AttrCatEntry attrCatEntry;
-        AttrCacheTable::getAttrCatEntry(relId, attrName, &attrCatEntry);
-        /* use the attribute offset to get the value of the attribute from
-           current record */
-        Attribute recordAttrVal = record[attrCatEntry.offset];
-        int cmpVal; // will store the difference between the attributes
-        // set cmpVal using compareAttrs()
-        cmpVal = compareAttrs(recordAttrVal, attrVal, attrCatEntry.attrType);
-
-        /* Next task is to check whether this record satisfies the given condition.
-           It is determined based on the output of previous comparison and
-           the op value received.
-           The following code sets the cond variable if the condition is satisfied.
-        */
-        if (
-            (op == NE && cmpVal != 0) || // if op is "not equal to"
-            (op == LT && cmpVal < 0) ||  // if op is "less than"
-            (op == LE && cmpVal <= 0) || // if op is "less than or equal to"
-            (op == EQ && cmpVal == 0) || // if op is "equal to"
-            (op == GT && cmpVal > 0) ||  // if op is "greater than"
-            (op == GE && cmpVal >= 0)    // if op is "greater than or equal to"
-        )
-        {
-            /*
-            set the search index in the relation cache as
-            the record id of the record that satisfies the given condition
-            (use RelCacheTable::setSearchIndex function)
+            // compare record's attribute value to the the given attrVal
+            int cmpVal = compareAttrs(values[slot], attrVal, attrCatEntry.attrType);
+
+            /* Next task is to check whether this record satisfies the given condition.
+               It is determined based on the output of previous comparison and
+               the op value received.
+               The following code sets the cond variable if the condition is satisfied.
             */
-            prevRecId = RecId{block, slot};
-            RelCacheTable::setSearchIndex(relId, &prevRecId);
-            return RecId{block, slot};
+            if (
+                (op == NE && cmpVal != 0) || // if op is "not equal to"
+                (op == LT && cmpVal < 0) ||  // if op is "less than"
+                (op == LE && cmpVal <= 0) || // if op is "less than or equal to"
+                (op == EQ && cmpVal == 0) || // if op is "equal to"
+                (op == GT && cmpVal > 0) ||  // if op is "greater than"
+                (op == GE && cmpVal >= 0)    // if op is "greater than or equal to"
+            )
+            {
+                // move the cursor to the record that satisfies the given condition
+                cursor->recId = RecId{block, slot};
+                return RecId{block, slot};
+            }
         }
-
-        slot++;
     }
 
     // no record in the relation with Id relid satisfies the given condition
@@ -136,16 +125,15 @@ RecId BlockAccess::linearSearch(int relId, char attrName[ATTR_SIZE], union Attri
 
 int BlockAccess::renameRelation(char oldName[ATTR_SIZE], char newName[ATTR_SIZE])
 {
-    /* reset the searchIndex of the relation catalog using
-       RelCacheTable::resetSearchIndex() */
-    RelCacheTable::resetSearchIndex(RELCAT_RELID);
+    // start a new scan of the relation catalog
+    ScanCursor relCatCursor;
 
     Attribute newRelationName; // set newRelationName with newName
     strcpy(newRelationName.sVal, newName);
 
     // search the relation catalog for an entry with "RelName" = newRelationName
     // TODO : Get this dynamically
-    RecId recId = linearSearch(RELCAT_RELID, (char *)RELCAT_ATTR_RELNAME, newRelationName, EQ);
+    RecId recId = linearSearch(RELCAT_RELID, (char *)RELCAT_ATTR_RELNAME, newRelationName, EQ, &relCatCursor);
 
     // If relation with name newName already exists (result of linearSearch
     //                                               is not {-1, -1})
@@ -156,15 +144,14 @@ int BlockAccess::renameRelation(char oldName[ATTR_SIZE], char newName[ATTR_SIZE]
         return E_RELEXIST;
     }
 
-    /* reset the searchIndex of the relation catalog using
-       RelCacheTable::resetSearchIndex() */
-    RelCacheTable::resetSearchIndex(RELCAT_RELID);
+    // start a new scan of the relation catalog
+    relCatCursor = ScanCursor();
 
     Attribute oldRelationName; // set oldRelationName with oldName
 
     strcpy(oldRelationName.sVal, oldName);
     // search the relation catalog for an entry with "RelName" = oldRelationName
-    recId = linearSearch(RELCAT_RELID, (char *)RELCAT_ATTR_RELNAME, oldRelationName, EQ);
+    recId = linearSearch(RELCAT_RELID, (char *)RELCAT_ATTR_RELNAME, oldRelationName, EQ, &relCatCursor);
 
     // If relation with name oldName does not exist (result of linearSearch is {-1, -1})
     //    return E_RELNOTEXIST;
@@ -193,9 +180,8 @@ int BlockAccess::renameRelation(char oldName[ATTR_SIZE], char newName[ATTR_SIZE]
     to the relation with relation name oldName to the relation name newName
     */
 
-    /* reset the searchIndex of the attribute catalog using
-       RelCacheTable::resetSearchIndex() */
-    RelCacheTable::resetSearchIndex(ATTRCAT_RELID);
+    // start a new scan of the attribute catalog
+    ScanCursor attrCatCursor;
 
     // for i = 0 to numberOfAttributes :
     //     linearSearch on the attribute catalog for relName = oldRelationName
@@ -207,7 +193,7 @@ int BlockAccess::renameRelation(char oldName[ATTR_SIZE], char newName[ATTR_SIZE]
     int numAttrs = record[RELCAT_NO_ATTRIBUTES_INDEX].nVal;
     for (int i = 0; i < numAttrs; i++)
     {
-        recId = linearSearch(ATTRCAT_RELID, (char *)ATTRCAT_ATTR_RELNAME, oldRelationName, EQ);
+        recId = linearSearch(ATTRCAT_RELID, (char *)ATTRCAT_ATTR_RELNAME, oldRelationName, EQ, &attrCatCursor);
         RecBuffer recBuffer(recId.block);
         recBuffer.getRecord(record, recId.slot);
         strcpy(record[ATTRCAT_REL_NAME_INDEX].sVal, newName);
@@ -220,9 +206,8 @@ int BlockAccess::renameRelation(char oldName[ATTR_SIZE], char newName[ATTR_SIZE]
 int BlockAccess::renameAttribute(char relName[ATTR_SIZE], char oldName[ATTR_SIZE], char newName[ATTR_SIZE])
 {
 
-    /* reset the searchIndex of the relation catalog using
-       RelCacheTable::resetSearchIndex() */
-    RelCacheTable::resetSearchIndex(RELCAT_RELID);
+    // start a new scan of the relation catalog
+    ScanCursor relCatCursor;
 
     Attribute relNameAttr; // set relNameAttr to relName
     strcpy(relNameAttr.sVal, relName);
@@ -230,16 +215,15 @@ int BlockAccess::renameAttribute(char relName[ATTR_SIZE], char oldName[ATTR_SIZE
     // Search for the relation with name relName in relation catalog using linearSearch()
     // If relation with name relName does not exist (search returns {-1,-1})
     //    return E_RELNOTEXIST;
-    RecId recId = linearSearch(RELCAT_RELID, (char *)RELCAT_ATTR_RELNAME, relNameAttr, EQ);
+    RecId recId = linearSearch(RELCAT_RELID, (char *)RELCAT_ATTR_RELNAME, relNameAttr, EQ, &relCatCursor);
 
     if (recId.block == -1 && recId.slot == -1)
     {
         return E_RELNOTEXIST;
     }
 
-    /* reset the searchIndex of the attribute catalog using
-       RelCacheTable::resetSearchIndex() */
-    RelCacheTable::resetSearchIndex(ATTRCAT_RELID);
+    // start a new scan of the attribute catalog
+    ScanCursor attrCatCursor;
 
     /* declare variable attrToRenameRecId used to store the attr-cat recId
     of the attribute to rename */
@@ -254,7 +238,7 @@ int BlockAccess::renameAttribute(char relName[ATTR_SIZE], char oldName[ATTR_SIZE
         // get the record using RecBuffer.getRecord
         // if the attribute name is oldName, set attrToRenameRecId to block and slot of this record
 
-        RecId recId = linearSearch(ATTRCAT_RELID, (char *)ATTRCAT_ATTR_RELNAME, relNameAttr, EQ);
+        RecId recId = linearSearch(ATTRCAT_RELID, (char *)ATTRCAT_ATTR_RELNAME, relNameAttr, EQ, &attrCatCursor);
 
         // if there are no more attributes left to check (linearSearch returned {-1,-1})
         //     break;
@@ -305,6 +289,104 @@ int BlockAccess::renameAttribute(char relName[ATTR_SIZE], char oldName[ATTR_SIZE
 
 int BlockAccess::insert(int relId, Attribute *record)
 {
+    return insertRecord(relId, record, false);
+}
+
+/* Inserts the record after the last record of the relation. Unlike insert(),
+   free slots before the last block are not looked for, so a relation that is
+   only ever appended to (such as the target of an operator) is filled in time
+   proportional to its size rather than to its square. */
+int BlockAccess::append(int relId, Attribute *record)
+{
+    return insertRecord(relId, record, true);
+}
+
+/* Adds a record block to the relation after its last block prevBlockNum (-1
+   if it has none yet), and sets the first and last blocks of relCatBuf to
+   match. Returns the number of the block, or E_DISKFULL. */
+static int addRecordBlock(RelCatEntry *relCatBuf, const RecordLayout *layout, int prevBlockNum)
+{
+    RecBuffer newBlock(layout);
+    int newBlockNum = newBlock.getBlockNum();
+    if (newBlockNum == E_DISKFULL)
+    {
+        return E_DISKFULL;
+    }
+
+    HeadInfo newBlockHeader;
+    newBlock.getHeader(&newBlockHeader);
+    newBlockHeader.lblock = prevBlockNum;
+    newBlockHeader.numAttrs = relCatBuf->numAttrs;
+    newBlockHeader.numSlots = relCatBuf->numSlotsPerBlk;
+    newBlock.setHeader(&newBlockHeader);
+
+    SlotMap newBlockSlotMap;
+    newBlockSlotMap.clear(relCatBuf->numSlotsPerBlk);
+    newBlock.setSlotMap(newBlockSlotMap);
+
+    if (prevBlockNum != -1)
+    {
+        RecBuffer prevBlock(prevBlockNum);
+
+        HeadInfo prevBlockHeader;
+        prevBlock.getHeader(&prevBlockHeader);
+        prevBlockHeader.rblock = newBlockNum;
+        prevBlock.setHeader(&prevBlockHeader);
+    }
+    else
+    {
+        relCatBuf->firstBlk = newBlockNum;
+    }
+    relCatBuf->lastBlk = newBlockNum;
+
+    return newBlockNum;
+}
+
+/* Writes count records (stored one after the other in records, their long
+   strings already stored by the block) to the free slots from firstSlot of
+   the block, or as many of the first of them as the block still compresses
+   into one block with if the relation is compressed, found by a binary
+   search. Returns the number of records written. */
+static int setRecordsThatFit(RecBuffer *block, Attribute *records, int firstSlot, int count)
+{
+    block->setRecords(records, firstSlot, count);
+    if (block->fitsOnDisk())
+    {
+        return count;
+    }
+
+    // fits stays a count that fits, and tooMany one that does not
+    int fits = 0, tooMany = count;
+    while (tooMany - fits > 1)
+    {
+        int mid = (fits + tooMany) / 2;
+        block->clearRecords(firstSlot, count);
+        block->setRecords(records, firstSlot, mid);
+        if (block->fitsOnDisk())
+        {
+            fits = mid;
+        }
+        else
+        {
+            tooMany = mid;
+        }
+    }
+
+    block->clearRecords(firstSlot, count);
+    block->setRecords(records, firstSlot, fits);
+    return fits;
+}
+
+int BlockAccess::insertRecord(int relId, Attribute *record, bool atEnd)
+{
+    if (relId < 0 || relId >= MAX_OPEN)
+    {
+        return E_OUTOFBOUND;
+    }
+
+    // threads inserting into the same relation would hand out the same free slot
+    std::lock_guard<std::mutex> guard(RelCacheTable::getRelationLock(relId));
+
     RelCatEntry relCatBuf;
     int ret = RelCacheTable::getRelCatEntry(relId, &relCatBuf);
 
@@ -313,7 +395,17 @@ int BlockAccess::insert(int relId, Attribute *record)
         return ret;
     }
 
-    int blockNum = relCatBuf.firstBlk;
+    RecordLayout layout;
+    RelCacheTable::getRecordLayout(relId, &layout);
+    ret = checkRecord(&layout, record);
+    if (ret != SUCCESS)
+    {
+        return ret;
+    }
+
+    // (the blocks of a compressed relation before its last one are taken to
+    //  be as full as they compress)
+    int blockNum = atEnd || layout.compressed ? relCatBuf.lastBlk : relCatBuf.firstBlk;
 
     RecId recId = {-1, -1};
 
@@ -329,20 +421,11 @@ int BlockAccess::insert(int relId, Attribute *record)
         HeadInfo currentHeader;
         currentBlock.getHeader(&currentHeader);
 
-        unsigned char slotMap[numSlots];
-        currentBlock.getSlotMap(slotMap);
+        SlotMap slotMap;
+        currentBlock.getSlotMap(&slotMap);
 
-        int freeSlot = -1;
-        for (int i = 0; i < numSlots; i++)
-        {
-            if (slotMap[i] == SLOT_UNOCCUPIED)
-            {
-                freeSlot = i;
-                break;
-            }
-        }
-
-        if (freeSlot != -1)
+        int freeSlot = slotMap.nextFree(0);
+        if (freeSlot < numSlots)
         {
             recId.block = blockNum;
             recId.slot = freeSlot;
@@ -353,67 +436,54 @@ int BlockAccess::insert(int relId, Attribute *record)
         blockNum = currentHeader.rblock;
     }
 
-    if (recId.block == -1 || recId.slot == -1)
+    while (true)
     {
-        if (relId == RELCAT_RELID)
+        if (recId.block == -1 || recId.slot == -1)
         {
-            return E_MAXRELATIONS;
-        }
+            if (relId == RELCAT_RELID)
+            {
+                return E_MAXRELATIONS;
+            }
 
-        RecBuffer newBlock;
+            int newBlockNum = addRecordBlock(&relCatBuf, &layout, prevBlockNum);
+            if (newBlockNum == E_DISKFULL)
+            {
+                RelCacheTable::setRelCatEntry(relId, &relCatBuf);
+                return E_DISKFULL;
+            }
+            RelCacheTable::setRelCatEntry(relId, &relCatBuf);
 
-        int newBlockNum = newBlock.getBlockNum();
+            recId.block = newBlockNum;
+            recId.slot = 0;
+        }
 
-        if (newBlockNum == E_DISKFULL)
+        RecBuffer blockToInsert(recId.block, &layout);
+        ret = blockToInsert.storeLongStrings(record, 1);
+        if (ret != SUCCESS)
         {
-            return E_DISKFULL;
+            RelCacheTable::setRelCatEntry(relId, &relCatBuf);
+            return ret;
         }
+        blockToInsert.setRecord(record, recId.slot);
 
-        recId.block = newBlockNum;
-        recId.slot = 0;
-
-        HeadInfo newBlockHeader;
-        newBlock.getHeader(&newBlockHeader);
-        newBlockHeader.lblock = prevBlockNum;
-        newBlockHeader.numAttrs = numAttrs;
-        newBlockHeader.numSlots = numSlots;
-        newBlock.setHeader(&newBlockHeader);
+        blockToInsert.setSlot(recId.slot, true);
 
-        unsigned char newBlockSlotMap[numSlots];
-        newBlock.getSlotMap(newBlockSlotMap);
-        for (int i = 0; i < numSlots; i++)
-            newBlockSlotMap[i] = SLOT_UNOCCUPIED;
-        newBlock.setSlotMap(newBlockSlotMap);
+        HeadInfo headerToInsert;
+        blockToInsert.getHeader(&headerToInsert);
+        headerToInsert.numEntries++;
+        blockToInsert.setHeader(&headerToInsert);
 
-        if (prevBlockNum != -1)
+        if (blockToInsert.fitsOnDisk())
         {
-            RecBuffer prevBlock(prevBlockNum);
-
-            HeadInfo prevBlockHeader;
-            prevBlock.getHeader(&prevBlockHeader);
-            prevBlockHeader.rblock = recId.block;
-            prevBlock.setHeader(&prevBlockHeader);
-        }
-        else
-        {
-            relCatBuf.firstBlk = recId.block;
-            RelCacheTable::setRelCatEntry(relId, &relCatBuf);
+            break;
         }
-        relCatBuf.lastBlk = recId.block;
-    }
-
-    RecBuffer blockToInsert(recId.block);
-    blockToInsert.setRecord(record, recId.slot);
-
-    unsigned char slotMapToInsert[numSlots];
-    blockToInsert.getSlotMap(slotMapToInsert);
-    slotMapToInsert[recId.slot] = SLOT_OCCUPIED;
-    blockToInsert.setSlotMap(slotMapToInsert);
 
-    HeadInfo headerToInsert;
-    blockToInsert.getHeader(&headerToInsert);
-    headerToInsert.numEntries++;
-    blockToInsert.setHeader(&headerToInsert);
+        // the block of a compressed relation would no longer compress into a
+        // block: the record goes to a new block instead
+        blockToInsert.clearRecords(recId.slot, 1);
+        prevBlockNum = recId.block;
+        recId = {-1, -1};
+    }
 
     relCatBuf.numRecs++;
     RelCacheTable::setRelCatEntry(relId, &relCatBuf);
@@ -439,12 +509,149 @@ int BlockAccess::insert(int relId, Attribute *record)
     return flag;
 }
 
+/* Appends numRecords records (stored one after the other in records) after the
+   last record of the relation. The free slots at the end of the last block are
+   filled first, and then every new block is filled with one setRecords() call
+   instead of going through the slot map one record at a time. The relation
+   catalog entry is updated once, and the indexes of the relation after all the
+   records are in place (a block of a compressed relation takes as many of
+   them as it compresses with). The number of records appended is returned in
+   numAppended (fewer than numRecords only if the disk is full, or if a record
+   does not fit the formats of the attributes, when E_ATTRTYPEMISMATCH is
+   returned). */
+int BlockAccess::bulkAppend(int relId, Attribute *records, int numRecords, int *numAppended)
+{
+    *numAppended = 0;
+    if (relId < 0 || relId >= MAX_OPEN)
+    {
+        return E_OUTOFBOUND;
+    }
+    if (relId == RELCAT_RELID || relId == ATTRCAT_RELID)
+    {
+        return E_NOTPERMITTED;
+    }
+
+    std::lock_guard<std::mutex> guard(RelCacheTable::getRelationLock(relId));
+
+    RelCatEntry relCatBuf;
+    int ret = RelCacheTable::getRelCatEntry(relId, &relCatBuf);
+    if (ret != SUCCESS)
+    {
+        return ret;
+    }
+
+    const int numSlots = relCatBuf.numSlotsPerBlk;
+    const int numAttrs = relCatBuf.numAttrs;
+
+    // only the records before the first one that does not fit the layout are appended
+    RecordLayout layout;
+    RelCacheTable::getRecordLayout(relId, &layout);
+    int checkRet = SUCCESS;
+    for (int i = 0; i < numRecords && checkRet == SUCCESS; i++)
+    {
+        checkRet = checkRecord(&layout, records + (size_t)i * numAttrs);
+        if (checkRet != SUCCESS)
+        {
+            numRecords = i;
+        }
+    }
+
+    std::vector<RecId> recIds;
+    recIds.reserve(numRecords);
+    ret = SUCCESS;
+
+    // the slots after the last occupied slot of the last block
+    if (relCatBuf.lastBlk != -1)
+    {
+        RecBuffer lastBlock(relCatBuf.lastBlk, &layout);
+        SlotMap slotMap;
+        lastBlock.getSlotMap(&slotMap);
+
+        int firstFree = slotMap.lastOccupied() + 1;
+        int count = std::min(numSlots - firstFree, numRecords);
+        if (count > 0 && lastBlock.storeLongStrings(records, count) != SUCCESS)
+        {
+            count = 0;
+            numRecords = 0;
+            ret = E_DISKFULL;
+        }
+        if (count > 0)
+        {
+            count = setRecordsThatFit(&lastBlock, records, firstFree, count);
+            for (int i = 0; i < count; i++)
+            {
+                recIds.push_back({relCatBuf.lastBlk, firstFree + i});
+            }
+        }
+    }
+
+    while ((int)recIds.size() < numRecords)
+    {
+        int newBlockNum = addRecordBlock(&relCatBuf, &layout, relCatBuf.lastBlk);
+        if (newBlockNum == E_DISKFULL)
+        {
+            ret = E_DISKFULL;
+            break;
+        }
+        RecBuffer newBlock(newBlockNum, &layout);
+
+        int done = recIds.size();
+        int count = std::min(numSlots, numRecords - done);
+        if (newBlock.storeLongStrings(records + (size_t)done * numAttrs, count) != SUCCESS)
+        {
+            ret = E_DISKFULL;
+            break;
+        }
+        count = setRecordsThatFit(&newBlock, records + (size_t)done * numAttrs, 0, count);
+        for (int i = 0; i < count; i++)
+        {
+            recIds.push_back({newBlockNum, i});
+        }
+    }
+
+    relCatBuf.numRecs += recIds.size();
+    RelCacheTable::setRelCatEntry(relId, &relCatBuf);
+    *numAppended = recIds.size();
+
+    for (int attrOffset = 0; attrOffset < numAttrs; attrOffset++)
+    {
+        AttrCatEntry attrCatBuf;
+        AttrCacheTable::getAttrCatEntry(relId, attrOffset, &attrCatBuf);
+        if (attrCatBuf.rootBlock == -1)
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i < recIds.size(); i++)
+        {
+            int insertRet = BPlusTree::bPlusInsert(relId, attrCatBuf.attrName, records[i * numAttrs + attrOffset],
+                                                   recIds[i]);
+            if (insertRet == E_DISKFULL)
+            {
+                // (bPlusInsert() has destroyed the index)
+                if (ret == SUCCESS)
+                {
+                    ret = E_INDEX_BLOCKS_RELEASED;
+                }
+                break;
+            }
+        }
+    }
+
+    if (checkRet != SUCCESS && ret != E_DISKFULL)
+    {
+        ret = checkRet;
+    }
+    return ret;
+}
+
 /*
 NOTE: This function will copy the result of the search to the `record` argument.
       The caller should ensure that space is allocated for `record` array
       based on the number of attributes in the relation.
 */
-int BlockAccess::search(int relId, Attribute *record, char attrName[ATTR_SIZE], Attribute attrVal, int op)
+int BlockAccess::search(int relId, Attribute *record, char attrName[ATTR_SIZE], Attribute attrVal, int op,
+                        ScanCursor *cursor)
 {
     // Declare a variable called recid to store the searched record
     RecId recId;
@@ -470,8 +677,7 @@ int BlockAccess::search(int relId, Attribute *record, char attrName[ATTR_SIZE],
            attribute name attrName, with value attrval and satisfying the
            condition op using linearSearch()
         */
-        recId = linearSearch(relId, attrName, attrVal, op);
-        // resetting the search index will be handled by linear search
+        recId = linearSearch(relId, attrName, attrVal, op, cursor);
     }
 
     /* else */
@@ -482,7 +688,7 @@ int BlockAccess::search(int relId, Attribute *record, char attrName[ATTR_SIZE],
         /* search for the record id (recid) correspoding to the attribute with
         attribute name attrName and with value attrval and satisfying the
         condition op using BPlusTree::bPlusSearch() */
-        recId = BPlusTree::bPlusSearch(relId, attrName, attrVal, op);
+        recId = BPlusTree::bPlusSearch(relId, attrName, attrVal, op, cursor);
     }
 
     // if there's no record satisfying the given condition (recId = {-1, -1})
@@ -496,7 +702,9 @@ int BlockAccess::search(int relId, Attribute *record, char attrName[ATTR_SIZE],
        For this, instantiate a RecBuffer class object by passing the recId and
        call the appropriate method to fetch the record
     */
-    RecBuffer recBuffer(recId.block);
+    RecordLayout layout;
+    RelCacheTable::getRecordLayout(relId, &layout);
+    RecBuffer recBuffer(recId.block, &layout);
     recBuffer.getRecord(record, recId.slot);
 
     return SUCCESS;
@@ -511,12 +719,12 @@ int BlockAccess::deleteRelation(char relName[ATTR_SIZE])
         return E_NOTPERMITTED;
     }
 
-    RelCacheTable::resetSearchIndex(RELCAT_RELID);
+    ScanCursor relCatCursor;
 
     Attribute relNameAttribute;
     strcpy(relNameAttribute.sVal, relName);
 
-    RecId recId = linearSearch(RELCAT_RELID, (char *)RELCAT_ATTR_RELNAME, relNameAttribute, EQ);
+    RecId recId = linearSearch(RELCAT_RELID, (char *)RELCAT_ATTR_RELNAME, relNameAttribute, EQ, &relCatCursor);
 
     if (recId.block == -1 || recId.slot == -1)
     {
@@ -538,15 +746,26 @@ int BlockAccess::deleteRelation(char relName[ATTR_SIZE])
 
         int nextBlock = currentBlockHeader.rblock;
 
+        // the overflow blocks holding the long strings of its records
+        int overflowBlock = currentBlockHeader.pblock;
+        while (overflowBlock != -1)
+        {
+            OverflowBuffer overflowBuffer(overflowBlock);
+            HeadInfo overflowHeader;
+            overflowBuffer.getHeader(&overflowHeader);
+            overflowBuffer.releaseBlock();
+            overflowBlock = overflowHeader.rblock;
+        }
+
         currentBlockBuffer.releaseBlock();
         currentBlock = nextBlock;
     }
 
     int numAttrsDeleted = 0;
-    RelCacheTable::resetSearchIndex(ATTRCAT_RELID);
+    ScanCursor attrCatCursor;
     while (true)
     {
-        RecId attrCatRecId = linearSearch(ATTRCAT_RELID, (char *)ATTRCAT_ATTR_RELNAME, relNameAttribute, EQ);
+        RecId attrCatRecId = linearSearch(ATTRCAT_RELID, (char *)ATTRCAT_ATTR_RELNAME, relNameAttribute, EQ, &attrCatCursor);
 
         if (attrCatRecId.slot == -1 || attrCatRecId.block == -1)
         {
@@ -565,11 +784,7 @@ int BlockAccess::deleteRelation(char relName[ATTR_SIZE])
 
         int rootBlock = record[ATTRCAT_ROOT_BLOCK_INDEX].nVal;
 
-        unsigned char slotMap[currentBlockHeader.numSlots];
-
-        currentBlock.getSlotMap(slotMap);
-        slotMap[attrCatRecId.slot] = SLOT_UNOCCUPIED;
-        currentBlock.setSlotMap(slotMap);
+        currentBlock.setSlot(attrCatRecId.slot, false);
 
         currentBlockHeader.numEntries--;
         currentBlock.setHeader(&currentBlockHeader);
@@ -612,11 +827,7 @@ int BlockAccess::deleteRelation(char relName[ATTR_SIZE])
     HeadInfo relCatHeader;
     recBuffer.getHeader(&relCatHeader);
 
-    unsigned char recSlotMap[relCatHeader.numSlots];
-
-    recBuffer.getSlotMap(recSlotMap);
-    recSlotMap[recId.slot] = SLOT_UNOCCUPIED;
-    recBuffer.setSlotMap(recSlotMap);
+    recBuffer.setSlot(recId.slot, false);
 
     relCatHeader.numEntries--;
     recBuffer.setHeader(&relCatHeader);
@@ -639,19 +850,17 @@ NOTE: the caller is expected to allocate space for the argument `record` based
       on the size of the relation. This function will only copy the result of
       the projection onto the array pointed to by the argument.
 */
-int BlockAccess::project(int relId, Attribute *record)
+int BlockAccess::project(int relId, Attribute *record, ScanCursor *cursor)
 {
-    // get the previous search index of the relation relId from the relation
-    // cache (use RelCacheTable::getSearchIndex() function)
-    RecId prevRecId;
-    RelCacheTable::getSearchIndex(relId, &prevRecId);
+    // get the record last returned by this scan from the cursor
+    RecId prevRecId = cursor->recId;
 
     // declare block and slot which will be used to store the record id of the
     // slot we need to check.
     int block, slot;
 
-    /* if the current search index record is invalid(i.e. = {-1, -1})
-       (this only happens when the caller reset the search index)
+    /* if the cursor's record is invalid(i.e. = {-1, -1})
+       (this only happens for a new or reset cursor)
     */
     if (prevRecId.block == -1 && prevRecId.slot == -1)
     {
@@ -671,8 +880,8 @@ int BlockAccess::project(int relId, Attribute *record)
     {
         // (a project/search operation is already in progress)
 
-        // block = previous search index's block
-        // slot = previous search index's slot + 1
+        // block = cursor's block
+        // slot = cursor's slot + 1
         block = prevRecId.block;
         slot = prevRecId.slot + 1;
     }
@@ -689,9 +898,11 @@ int BlockAccess::project(int relId, Attribute *record)
         // get slot map of the block using RecBuffer::getSlotMap() function
         struct HeadInfo header;
         recBlock.getHeader(&header);
-        unsigned char slotMap[header.numSlots];
-        recBlock.getSlotMap(slotMap);
+        SlotMap slotMap;
+        recBlock.getSlotMap(&slotMap);
 
+        // skip to the next occupied slot
+        slot = slotMap.nextOccupied(slot);
         if (slot >= header.numSlots)
         {
             // (no more slots in this block)
@@ -703,13 +914,6 @@ int BlockAccess::project(int relId, Attribute *record)
             slot = 0;
             continue; // continue to the beginning of this while loop
         }
-        else if (slotMap[slot] == SLOT_UNOCCUPIED)
-        {
-            // (slot is free)
-            // increment slot and continue to the next record slot
-            slot++;
-            continue;
-        }
         else
         {
             // (the next occupied slot / record has been found)
@@ -727,14 +931,16 @@ int BlockAccess::project(int relId, Attribute *record)
     // declare nextRecId to store the RecId of the record found
     RecId nextRecId{block, slot};
 
-    // set the search index to nextRecId using RelCacheTable::setSearchIndex
-    RelCacheTable::setSearchIndex(relId, &nextRecId);
+    // move the cursor to nextRecId
+    cursor->recId = nextRecId;
 
     /* Copy the record with record id (nextRecId) to the record buffer (record)
        For this Instantiate a RecBuffer class object by passing the recId and
        call the appropriate method to fetch the record
     */
-    RecBuffer recBuffer(nextRecId.block);
+    RecordLayout layout;
+    RelCacheTable::getRecordLayout(relId, &layout);
+    RecBuffer recBuffer(nextRecId.block, &layout);
     recBuffer.getRecord(record, nextRecId.slot);
 
     return SUCCESS;
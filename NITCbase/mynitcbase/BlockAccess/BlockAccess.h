@@ -9,20 +9,27 @@
 #include "../define/id.h"
 
 class BlockAccess {
+ private:
+  static int insertRecord(int relId, union Attribute *record, bool atEnd);
+
  public:
-  static int search(int relId, Attribute *record, char *attrName, Attribute attrVal, int op);
+  static int search(int relId, Attribute *record, char *attrName, Attribute attrVal, int op, ScanCursor *cursor);
 
   static int insert(int relId, union Attribute *record);
 
+  static int append(int relId, union Attribute *record);
+
+  static int bulkAppend(int relId, union Attribute *records, int numRecords, int *numAppended);
+
   static int renameRelation(char *oldName, char *newName);
 
   static int renameAttribute(char *relName, char *oldName, char *newName);
 
   static int deleteRelation(char *relName);
 
-  static RecId linearSearch(int relId, char *attrName, Attribute attrVal, int op);
+  static RecId linearSearch(int relId, char *attrName, Attribute attrVal, int op, ScanCursor *cursor);
 
-  static int project(int relId, Attribute *record);
+  static int project(int relId, Attribute *record, ScanCursor *cursor);
 };
 
 #endif  // NITCBASE_BLOCKACCESS_H
\ No newline at end of file
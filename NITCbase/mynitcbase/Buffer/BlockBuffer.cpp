@@ -1,8 +1,13 @@
 #include "BlockBuffer.h"
 
+#include "BlockCompression.h"
+
+#include <cmath>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <mutex>
+#include <vector>
 using namespace std;
 
 // the declarations for these functions can be found in "BlockBuffer.h"
@@ -28,6 +33,10 @@ BlockBuffer::BlockBuffer(char blockType)
     {
         blockTypeNum = IND_LEAF;
     }
+    else if (blockType == 'O')
+    {
+        blockTypeNum = OVERFLOW_BLK;
+    }
     else
     {
         blockTypeNum = UNUSED_BLK;
@@ -35,16 +44,25 @@ BlockBuffer::BlockBuffer(char blockType)
     int blockNum = getFreeBlock(blockTypeNum);
 
     this->blockNum = blockNum;
-    if (blockNum < 0 || blockNum >= DISK_BLOCKS)
+    if (blockNum < 0 || blockNum >= Disk::getNumBlocks())
         return;
 }
 
 // calls the parent class constructor
-RecBuffer::RecBuffer(int blockNum) : BlockBuffer::BlockBuffer(blockNum)
+RecBuffer::RecBuffer(int blockNum, const RecordLayout *layout) : BlockBuffer::BlockBuffer(blockNum), layout(layout)
 {
 }
-RecBuffer::RecBuffer() : BlockBuffer('R') {}
 // call parent non-default constructor with 'R' denoting record block.
+RecBuffer::RecBuffer(const RecordLayout *layout) : BlockBuffer('R'), layout(layout)
+{
+    if (layout == nullptr || !layout->compressed || blockNum < 0)
+    {
+        return;
+    }
+
+    // the new block is buffered in a whole frame, and written compressed
+    setCompressed();
+}
 
 // call the corresponding parent constructor
 IndBuffer::IndBuffer(char blockType) : BlockBuffer(blockType) {}
@@ -59,12 +77,93 @@ IndInternal::IndInternal() : IndBuffer('I') {}
 IndInternal::IndInternal(int blockNum) : IndBuffer(blockNum) {}
 // call the corresponding parent constructor
 
+/* Number of keys that fit in an internal index block of the current block size.
+   Entries share their child pointers, so a block holds one leading lChild
+   followed by (attrVal, rChild) pairs. The count is kept even so that a split
+   of a full node (getMaxKeys()+1 keys) leaves both halves the same size. */
+int IndInternal::getMaxKeys()
+{
+    int maxKeys = (Disk::getBlockSize() - HEADER_SIZE - LCHILD_SIZE) / (ATTR_SIZE + RCHILD_SIZE);
+    return maxKeys & ~1;
+}
+
+/* Number of keys a leaf index block of the current block size holds at most:
+   one less than twice as many as fit when their keys share no bytes, so that
+   a split of a full leaf (getMaxKeys()+1 keys) leaves two halves of the same
+   size that fit whatever their keys are. On a disk before PREFIX_LEAF_VERSION,
+   the LEAF_ENTRY_SIZE entries that fit, which is odd for every supported
+   block size. */
+int IndLeaf::getMaxKeys()
+{
+    if (Disk::getFormatVersion() < PREFIX_LEAF_VERSION)
+    {
+        return (Disk::getBlockSize() - HEADER_SIZE) / LEAF_ENTRY_SIZE;
+    }
+
+    int minKeys = (Disk::getBlockSize() - HEADER_SIZE - LEAF_PREFIX_INFO_SIZE) / (ATTR_SIZE + LEAF_RECID_SIZE);
+    return 2 * minKeys - 1;
+}
+
+// number of bytes of the key up to its last byte that is not zero
+static int getKeyLength(const Attribute &key)
+{
+    const unsigned char *bytes = (const unsigned char *)&key;
+    int length = ATTR_SIZE;
+    while (length > 0 && bytes[length - 1] == 0)
+    {
+        length--;
+    }
+    return length;
+}
+
+// number of leading bytes, at most length, that two keys share
+static int getSharedLength(const Attribute &key1, const Attribute &key2, int length)
+{
+    const unsigned char *bytes1 = (const unsigned char *)&key1;
+    const unsigned char *bytes2 = (const unsigned char *)&key2;
+    int shared = 0;
+    while (shared < length && bytes1[shared] == bytes2[shared])
+    {
+        shared++;
+    }
+    return shared;
+}
+
+/* Number of the first of count entries that fit in a leaf together */
+int IndLeaf::getNumFitting(const Index entries[], int count)
+{
+    count = min(count, getMaxKeys());
+    if (Disk::getFormatVersion() < PREFIX_LEAF_VERSION)
+    {
+        return count;
+    }
+
+    const int space = Disk::getBlockSize() - HEADER_SIZE - LEAF_PREFIX_INFO_SIZE;
+    int sharedLength = ATTR_SIZE, keyLength = 0;
+    for (int i = 0; i < count; i++)
+    {
+        sharedLength = getSharedLength(entries[0].attrVal, entries[i].attrVal, sharedLength);
+        keyLength = max(keyLength, getKeyLength(entries[i].attrVal));
+        int prefixLength = min(sharedLength, keyLength);
+        if (prefixLength + (i + 1) * (keyLength - prefixLength + LEAF_RECID_SIZE) > space)
+        {
+            return i;
+        }
+    }
+    return count;
+}
+
 IndLeaf::IndLeaf() : IndBuffer('L') {} // this is the way to call parent non-default constructor.
                                        // 'L' used to denote IndLeaf.
 
 // this is the way to call parent non-default constructor.
 IndLeaf::IndLeaf(int blockNum) : IndBuffer(blockNum) {}
 
+// 'O' used to denote OverflowBuffer.
+OverflowBuffer::OverflowBuffer() : BlockBuffer('O') {}
+
+OverflowBuffer::OverflowBuffer(int blockNum) : BlockBuffer(blockNum) {}
+
 int BlockBuffer::getBlockNum()
 {
     // return corresponding block number.
@@ -77,10 +176,10 @@ int BlockBuffer::getHeader(struct HeadInfo *head)
 
     unsigned char *bufferPtr;
 
-    int ret = loadBlockAndGetBufferPtr(&bufferPtr);
-    if (ret != SUCCESS)
+    int bufferNum = loadBlockAndGetBufferPtr(&bufferPtr, false);
+    if (bufferNum < 0)
     {
-        return ret; // return any errors that might have occured in the process
+        return bufferNum; // return any errors that might have occured in the process
     }
 
     HeadInfo *header = (HeadInfo *)bufferPtr;
@@ -92,16 +191,17 @@ int BlockBuffer::getHeader(struct HeadInfo *head)
     head->rblock = header->rblock;
     head->pblock = header->pblock;
 
+    releaseBufferPtr(bufferNum, false);
     return SUCCESS;
 }
 
 int BlockBuffer::setHeader(struct HeadInfo *head)
 {
     unsigned char *bufferPtr;
-    int ret = loadBlockAndGetBufferPtr(&bufferPtr);
+    int bufferNum = loadBlockAndGetBufferPtr(&bufferPtr, true);
 
-    if (ret != SUCCESS)
-        return ret;
+    if (bufferNum < 0)
+        return bufferNum;
 
     HeadInfo *header = (HeadInfo *)bufferPtr;
 
@@ -112,45 +212,225 @@ int BlockBuffer::setHeader(struct HeadInfo *head)
     header->rblock = head->rblock;
     header->pblock = head->pblock;
 
-    return StaticBuffer::setDirtyBit(this->blockNum);
+    StaticBuffer::markDirty(bufferNum);
+    releaseBufferPtr(bufferNum, true);
+    return SUCCESS;
 }
 
-// load the record at slotNum into the argument pointer
-int RecBuffer::getRecord(union Attribute *rec, int slotNum)
+/* Number of bytes an attribute of the given format takes in a record */
+int getFormatSize(int format)
+{
+    switch (format)
+    {
+    case FORMAT_DOUBLE:
+    case FORMAT_INT64:
+        return 8;
+    case FORMAT_INT32:
+        return 4;
+    case FORMAT_DEFAULT:
+    case FORMAT_VARCHAR:
+        return ATTR_SIZE;
+    default:
+        // FORMAT_CHAR + the declared length
+        return format - FORMAT_CHAR;
+    }
+}
+
+/* Sets up the layout of the records of a relation whose attributes have the
+   given formats (all FORMAT_DEFAULT if formats is nullptr), stored in columnar
+   record blocks if columnar is set, and in compressed ones if compressed is */
+void initRecordLayout(RecordLayout *layout, int numAttrs, const int formats[], bool columnar, bool compressed)
+{
+    layout->numAttrs = numAttrs;
+    // (the values of a minipage are always converted one at a time)
+    layout->packed = columnar;
+    layout->columnar = columnar;
+    layout->compressed = compressed;
+
+    int offset = 0;
+    for (int i = 0; i < numAttrs; i++)
+    {
+        int format = formats == nullptr ? FORMAT_DEFAULT : formats[i];
+        layout->formats[i] = format;
+        layout->offsets[i] = offset;
+        offset += getFormatSize(format);
+        if (format != FORMAT_DEFAULT)
+        {
+            layout->packed = true;
+        }
+    }
+    layout->recordSize = offset;
+}
+
+/* Checks that every attribute of record can be stored in its format: numbers
+   of an integer format have to be whole and in range (at most
+   MAX_EXACT_INTEGER in magnitude for FORMAT_INT64), strings of a declared
+   length no longer than it, and only strings of a VARCHAR attribute long
+   strings. Returns E_ATTRTYPEMISMATCH otherwise. */
+int checkRecord(const RecordLayout *layout, const Attribute *record)
+{
+    if (!layout->packed)
+    {
+        return SUCCESS;
+    }
+
+    for (int i = 0; i < layout->numAttrs; i++)
+    {
+        int format = layout->formats[i];
+        double value = record[i].nVal;
+        if (format == FORMAT_INT32 &&
+            (value != floor(value) || value < INT32_MIN || value > INT32_MAX))
+        {
+            return E_ATTRTYPEMISMATCH;
+        }
+        // (a larger value may already have been rounded on its way to a double)
+        if (format == FORMAT_INT64 && (value != floor(value) || fabs(value) > MAX_EXACT_INTEGER))
+        {
+            return E_ATTRTYPEMISMATCH;
+        }
+        if (format > FORMAT_CHAR &&
+            (isLongString(record[i]) || strnlen(record[i].sVal, ATTR_SIZE) > (size_t)(format - FORMAT_CHAR)))
+        {
+            return E_ATTRTYPEMISMATCH;
+        }
+    }
+    return SUCCESS;
+}
+
+// copies attr to attrPtr in the given format
+static void packAttr(int format, const Attribute &attr, unsigned char *attrPtr)
 {
-    struct HeadInfo head;
-    this->getHeader(&head);
-    // get the header using this.getHeader() function
+    if (format == FORMAT_DOUBLE)
+    {
+        memcpy(attrPtr, &attr.nVal, sizeof(double));
+    }
+    else if (format == FORMAT_INT32)
+    {
+        int32_t value = (int32_t)attr.nVal;
+        memcpy(attrPtr, &value, sizeof(int32_t));
+    }
+    else if (format == FORMAT_INT64)
+    {
+        int64_t value = (int64_t)attr.nVal;
+        memcpy(attrPtr, &value, sizeof(int64_t));
+    }
+    else if (format == FORMAT_DEFAULT || format == FORMAT_VARCHAR)
+    {
+        memcpy(attrPtr, &attr, ATTR_SIZE);
+    }
+    else
+    {
+        // (a string of the declared length is not terminated)
+        strncpy((char *)attrPtr, attr.sVal, format - FORMAT_CHAR);
+    }
+}
 
-    int attrCount = head.numAttrs;
-    int slotCount = head.numSlots;
+// copies the value at attrPtr, stored in the given format, to attr
+static void unpackAttr(int format, const unsigned char *attrPtr, Attribute *attr)
+{
+    if (format == FORMAT_DOUBLE)
+    {
+        memcpy(&attr->nVal, attrPtr, sizeof(double));
+    }
+    else if (format == FORMAT_INT32)
+    {
+        int32_t value;
+        memcpy(&value, attrPtr, sizeof(int32_t));
+        attr->nVal = value;
+    }
+    else if (format == FORMAT_INT64)
+    {
+        int64_t value;
+        memcpy(&value, attrPtr, sizeof(int64_t));
+        attr->nVal = value;
+    }
+    else if (format == FORMAT_DEFAULT || format == FORMAT_VARCHAR)
+    {
+        memcpy(attr, attrPtr, ATTR_SIZE);
+    }
+    else
+    {
+        int length = format - FORMAT_CHAR;
+        memcpy(attr->sVal, attrPtr, length);
+        memset(attr->sVal + length, 0, ATTR_SIZE - length);
+    }
+}
+
+/* Offset in a block of numSlots slots of the attribute attrOffset of the
+   record in slot, for a relation with a packed layout */
+static int attrPosition(const RecordLayout *layout, int numSlots, int slot, int attrOffset)
+{
+    if (layout->columnar)
+    {
+        return HEADER_SIZE + getSlotMapSize(numSlots) + numSlots * layout->offsets[attrOffset] +
+               slot * getFormatSize(layout->formats[attrOffset]);
+    }
+    return HEADER_SIZE + getSlotMapSize(numSlots) + slot * layout->recordSize + layout->offsets[attrOffset];
+}
+
+// copies rec into the slot of a block of numSlots slots in the packed layout
+static void packRecord(const RecordLayout *layout, const Attribute *rec, unsigned char *bufferPtr, int numSlots,
+                       int slot)
+{
+    for (int i = 0; i < layout->numAttrs; i++)
+    {
+        packAttr(layout->formats[i], rec[i], bufferPtr + attrPosition(layout, numSlots, slot, i));
+    }
+}
+
+// copies the record in the slot of a block of numSlots slots, stored in the
+// packed layout, to rec
+static void unpackRecord(const RecordLayout *layout, const unsigned char *bufferPtr, int numSlots, int slot,
+                         Attribute *rec)
+{
+    for (int i = 0; i < layout->numAttrs; i++)
+    {
+        unpackAttr(layout->formats[i], bufferPtr + attrPosition(layout, numSlots, slot, i), &rec[i]);
+    }
+}
 
+// load the record at slotNum into the argument pointer
+int RecBuffer::getRecord(union Attribute *rec, int slotNum)
+{
     unsigned char *bufferPtr;
 
-    int ret = loadBlockAndGetBufferPtr(&bufferPtr);
-    if (ret != SUCCESS)
+    int bufferNum = loadBlockAndGetBufferPtr(&bufferPtr, false);
+    if (bufferNum < 0)
     {
-        return ret;
+        return bufferNum;
     }
 
+    // get the header from the latched buffer
+    // (calling getHeader() here would latch the buffer a second time)
+    HeadInfo *head = (HeadInfo *)bufferPtr;
+    int attrCount = head->numAttrs;
+    int slotCount = head->numSlots;
+
     /* record at slotNum will be at offset HEADER_SIZE + slotMapSize + (recordSize * slotNum)
-       - each record will have size attrCount * ATTR_SIZE
-       - slotMap will be of size slotCount
+       - each record will have size attrCount * ATTR_SIZE, or the size of the
+         layout of the relation
+       - slotMap will be of size getSlotMapSize(slotCount)
     */
 
-    int recordSize = attrCount * ATTR_SIZE;
+    int recordSize = layout == nullptr ? attrCount * ATTR_SIZE : layout->recordSize;
 
-    int offset = HEADER_SIZE + slotCount + (recordSize * slotNum);
+    int offset = HEADER_SIZE + getSlotMapSize(slotCount) + (recordSize * slotNum);
     // proof that each record block only contain records specific to a single relation
     // SlotMap is generated dynamically based on the number of attributes so, here when we are acessing records based on this calculation.
     // This calculation is based on the assumption that the slotMap is at the beginning of the block and the records are stored after the slotMap
     // so slot map must be constant and also number of attributes. So we cannot keep records of different relations in the same block.
 
-    // unsigned char *slotPointer = &buffer/* calculate buffer + offset */;
-
     // load the record into the rec data structure
-    memcpy(rec, bufferPtr + offset, recordSize);
+    if (layout != nullptr && layout->packed)
+    {
+        unpackRecord(layout, bufferPtr, slotCount, slotNum, rec);
+    }
+    else
+    {
+        memcpy(rec, bufferPtr + offset, recordSize);
+    }
 
+    releaseBufferPtr(bufferNum, false);
     return SUCCESS;
 }
 
@@ -159,53 +439,364 @@ int RecBuffer::setRecord(union Attribute *rec, int slotNum)
     unsigned char *bufferPtr;
     /* get the starting address of the buffer containing the block
        using loadBlockAndGetBufferPtr(&bufferPtr). */
-    int ret = loadBlockAndGetBufferPtr(&bufferPtr);
+    int bufferNum = loadBlockAndGetBufferPtr(&bufferPtr, true);
 
-    // if loadBlockAndGetBufferPtr(&bufferPtr) != SUCCESS
+    // if loadBlockAndGetBufferPtr(&bufferPtr) failed
     // return the value returned by the call.
-    if (ret != SUCCESS)
+    if (bufferNum < 0)
     {
-        return ret;
+        return bufferNum;
     }
 
-    /* get the header of the block using the getHeader() function */
-    struct HeadInfo head;
-    this->getHeader(&head);
+    /* get the header of the block from the latched buffer */
+    HeadInfo *head = (HeadInfo *)bufferPtr;
 
     // get number of attributes in the block.
-    int numAttrs = head.numAttrs;
+    int numAttrs = head->numAttrs;
 
     // get the number of slots in the block.
-    int numSlots = head.numSlots;
+    int numSlots = head->numSlots;
 
     // if input slotNum is not in the permitted range return E_OUTOFBOUND.
     if (slotNum >= numSlots || slotNum < 0)
     {
+        releaseBufferPtr(bufferNum, true);
         return E_OUTOFBOUND;
     }
 
     /* offset bufferPtr to point to the beginning of the record at required
        slot. the block contains the header, the slotmap, followed by all
        the records. so, for example,
-       record at slot x will be at bufferPtr + HEADER_SIZE + (x*recordSize)
+       record at slot x will be at bufferPtr + HEADER_SIZE + slotMapSize + (x*recordSize)
        copy the record from `rec` to buffer using memcpy
-       (hint: a record will be of size ATTR_SIZE * numAttrs)
+       (hint: a record will be of size ATTR_SIZE * numAttrs, unless the
+       relation has a packed layout)
     */
-    int recordSize = numAttrs * ATTR_SIZE;
-    int offset = HEADER_SIZE + numSlots + (recordSize * slotNum);
-    memcpy(bufferPtr + offset, rec, recordSize);
-
-    // update dirty bit using setDirtyBit()
-    StaticBuffer::setDirtyBit(this->blockNum);
+    int recordSize = layout == nullptr ? numAttrs * ATTR_SIZE : layout->recordSize;
+    int offset = HEADER_SIZE + getSlotMapSize(numSlots) + (recordSize * slotNum);
+    if (layout != nullptr && layout->packed)
+    {
+        packRecord(layout, rec, bufferPtr, numSlots, slotNum);
+    }
+    else
+    {
+        memcpy(bufferPtr + offset, rec, recordSize);
+    }
 
-    /* (the above function call should not fail since the block is already
-       in buffer and the blockNum is valid. If the call does fail, there
-       exists some other issue in the code) */
+    // mark the buffer dirty (the latched buffer number saves a lookup)
+    StaticBuffer::markDirty(bufferNum);
 
+    releaseBufferPtr(bufferNum, true);
     // return SUCCESS
     return SUCCESS;
 }
 
+/* Writes count records, stored one after the other in recs, to the slots
+   firstSlot .. firstSlot+count-1 and marks those slots occupied, with the
+   buffer latched only once (used to fill whole blocks by a bulk load). */
+int RecBuffer::setRecords(union Attribute *recs, int firstSlot, int count)
+{
+    unsigned char *bufferPtr;
+    int bufferNum = loadBlockAndGetBufferPtr(&bufferPtr, true);
+    if (bufferNum < 0)
+    {
+        return bufferNum;
+    }
+
+    HeadInfo *head = (HeadInfo *)bufferPtr;
+    int numSlots = head->numSlots;
+    if (firstSlot < 0 || count < 0 || firstSlot + count > numSlots)
+    {
+        releaseBufferPtr(bufferNum, true);
+        return E_OUTOFBOUND;
+    }
+
+    if (layout != nullptr && layout->packed)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            packRecord(layout, recs + (size_t)i * layout->numAttrs, bufferPtr, numSlots, firstSlot + i);
+        }
+    }
+    else
+    {
+        int recordSize = head->numAttrs * ATTR_SIZE;
+        memcpy(bufferPtr + HEADER_SIZE + getSlotMapSize(numSlots) + recordSize * firstSlot, recs, recordSize * count);
+    }
+    unsigned char *slotMapInBuffer = bufferPtr + HEADER_SIZE;
+    if (Disk::getFormatVersion() < BITMAP_SLOT_MAP_VERSION)
+    {
+        memset(slotMapInBuffer + firstSlot, SLOT_OCCUPIED, count);
+    }
+    else
+    {
+        for (int slot = firstSlot; slot < firstSlot + count; slot++)
+        {
+            slotMapInBuffer[slot >> 3] |= 1 << (slot & 7);
+        }
+    }
+    head->numEntries += count;
+
+    StaticBuffer::markDirty(bufferNum);
+    releaseBufferPtr(bufferNum, true);
+    return SUCCESS;
+}
+
+/* Zeroes the records in the slots firstSlot .. firstSlot+count-1, which are
+   the last ones written to the block, and marks those slots free again (used
+   to take back records that made a block of a compressed relation too large
+   to compress into a block). */
+int RecBuffer::clearRecords(int firstSlot, int count)
+{
+    unsigned char *bufferPtr;
+    int bufferNum = loadBlockAndGetBufferPtr(&bufferPtr, true);
+    if (bufferNum < 0)
+    {
+        return bufferNum;
+    }
+
+    HeadInfo *head = (HeadInfo *)bufferPtr;
+    int numSlots = head->numSlots;
+    if (firstSlot < 0 || count < 0 || firstSlot + count > numSlots)
+    {
+        releaseBufferPtr(bufferNum, true);
+        return E_OUTOFBOUND;
+    }
+
+    unsigned char *slotMapInBuffer = bufferPtr + HEADER_SIZE;
+    int occupied = 0;
+    for (int slot = firstSlot; slot < firstSlot + count; slot++)
+    {
+        if (Disk::getFormatVersion() < BITMAP_SLOT_MAP_VERSION)
+        {
+            occupied += slotMapInBuffer[slot] == SLOT_OCCUPIED;
+            slotMapInBuffer[slot] = SLOT_UNOCCUPIED;
+        }
+        else
+        {
+            occupied += (slotMapInBuffer[slot >> 3] >> (slot & 7)) & 1;
+            slotMapInBuffer[slot >> 3] &= ~(1 << (slot & 7));
+        }
+    }
+    head->numEntries -= occupied;
+
+    if (layout != nullptr && layout->columnar)
+    {
+        for (int i = 0; i < layout->numAttrs; i++)
+        {
+            memset(bufferPtr + attrPosition(layout, numSlots, firstSlot, i), 0,
+                   count * getFormatSize(layout->formats[i]));
+        }
+    }
+    else
+    {
+        int recordSize = layout == nullptr ? head->numAttrs * ATTR_SIZE : layout->recordSize;
+        memset(bufferPtr + HEADER_SIZE + getSlotMapSize(numSlots) + recordSize * firstSlot, 0, recordSize * count);
+    }
+
+    StaticBuffer::markDirty(bufferNum);
+    releaseBufferPtr(bufferNum, true);
+    return SUCCESS;
+}
+
+/* Whether the block can be written to the disk as it is buffered: always,
+   unless it is a record block of a compressed relation whose frame no longer
+   compresses into a block */
+bool RecBuffer::fitsOnDisk()
+{
+    if (layout == nullptr || !layout->compressed)
+    {
+        return true;
+    }
+
+    unsigned char *bufferPtr;
+    int bufferNum = loadBlockAndGetBufferPtr(&bufferPtr, false);
+    if (bufferNum < 0)
+    {
+        return false;
+    }
+
+    vector<unsigned char> block(Disk::getBlockSize());
+    bool fits = compressBlock(bufferPtr, block.data()) == SUCCESS;
+
+    releaseBufferPtr(bufferNum, false);
+    return fits;
+}
+
+/* Copies the attribute attrOffset of the record in every slot of the block
+   (occupied or not) to values[0..numSlots-1], with the buffer latched only
+   once. Of a columnar block, only the minipage of the attribute is read. */
+int RecBuffer::getColumn(union Attribute *values, int attrOffset)
+{
+    unsigned char *bufferPtr;
+    int bufferNum = loadBlockAndGetBufferPtr(&bufferPtr, false);
+    if (bufferNum < 0)
+    {
+        return bufferNum;
+    }
+
+    HeadInfo *head = (HeadInfo *)bufferPtr;
+    int numSlots = head->numSlots;
+    if (attrOffset < 0 || attrOffset >= head->numAttrs)
+    {
+        releaseBufferPtr(bufferNum, false);
+        return E_OUTOFBOUND;
+    }
+
+    if (layout != nullptr && layout->packed)
+    {
+        int format = layout->formats[attrOffset];
+        const unsigned char *attrPtr = bufferPtr + attrPosition(layout, numSlots, 0, attrOffset);
+        int stride = layout->columnar ? getFormatSize(format) : layout->recordSize;
+        for (int slot = 0; slot < numSlots; slot++)
+        {
+            unpackAttr(format, attrPtr, &values[slot]);
+            attrPtr += stride;
+        }
+    }
+    else
+    {
+        int recordSize = head->numAttrs * ATTR_SIZE;
+        const unsigned char *attrPtr = bufferPtr + HEADER_SIZE + getSlotMapSize(numSlots) + attrOffset * ATTR_SIZE;
+        for (int slot = 0; slot < numSlots; slot++)
+        {
+            memcpy(&values[slot], attrPtr, ATTR_SIZE);
+            attrPtr += recordSize;
+        }
+    }
+
+    releaseBufferPtr(bufferNum, false);
+    return SUCCESS;
+}
+
+/* Moves the long strings of the VARCHAR attributes of count records (stored
+   one after the other in recs, which are about to be written to this block)
+   to the overflow blocks of this block, and points the records at them. A
+   long string already stored elsewhere (in a record of another relation, say)
+   is copied, so the strings of a block live as long as the block. */
+int RecBuffer::storeLongStrings(union Attribute *recs, int count)
+{
+    if (layout == nullptr || !layout->packed)
+    {
+        return SUCCESS;
+    }
+
+    HeadInfo head;
+    int ret = getHeader(&head);
+    if (ret != SUCCESS)
+    {
+        return ret;
+    }
+
+    int overflowBlock = head.pblock;
+    for (int i = 0; i < count * layout->numAttrs; i++)
+    {
+        Attribute &attr = recs[i];
+        if (layout->formats[i % layout->numAttrs] != FORMAT_VARCHAR || !isLongString(attr))
+        {
+            continue;
+        }
+
+        string value;
+        ret = getString(attr, &value);
+        if (ret != SUCCESS)
+        {
+            break;
+        }
+
+        int offset;
+        ret = overflowBlock == -1 ? E_OUTOFBOUND : OverflowBuffer(overflowBlock).addValue(value, &offset);
+        if (ret == E_OUTOFBOUND)
+        {
+            // the newest overflow block is full: start another in front of it
+            OverflowBuffer newBlock;
+            int newBlockNum = newBlock.getBlockNum();
+            if (newBlockNum < 0)
+            {
+                ret = newBlockNum;
+                break;
+            }
+            HeadInfo newHead;
+            newBlock.getHeader(&newHead);
+            newHead.rblock = overflowBlock;
+            newBlock.setHeader(&newHead);
+            overflowBlock = newBlockNum;
+            ret = newBlock.addValue(value, &offset);
+        }
+        if (ret != SUCCESS)
+        {
+            break;
+        }
+
+        LongString longString;
+        memcpy(&longString, &attr, sizeof(LongString));
+        longString.offset = offset;
+        longString.block = overflowBlock;
+        memcpy(&attr, &longString, sizeof(LongString));
+    }
+
+    if (overflowBlock != head.pblock)
+    {
+        head.pblock = overflowBlock;
+        setHeader(&head);
+    }
+    return ret;
+}
+
+// copies the long string stored at offset of this block to value
+int OverflowBuffer::getValue(int offset, std::string *value)
+{
+    unsigned char *bufferPtr;
+    int bufferNum = loadBlockAndGetBufferPtr(&bufferPtr, false);
+    if (bufferNum < 0)
+    {
+        return bufferNum;
+    }
+
+    HeadInfo *head = (HeadInfo *)bufferPtr;
+    uint16_t length;
+    if (offset < HEADER_SIZE || offset + 2 > HEADER_SIZE + head->numEntries)
+    {
+        releaseBufferPtr(bufferNum, false);
+        return E_OUTOFBOUND;
+    }
+    memcpy(&length, bufferPtr + offset, 2);
+    value->assign((const char *)bufferPtr + offset + 2, length);
+
+    releaseBufferPtr(bufferNum, false);
+    return SUCCESS;
+}
+
+/* Stores value after the strings already in this block and returns where in
+   offset, or returns E_OUTOFBOUND if the block has no room left for it */
+int OverflowBuffer::addValue(const std::string &value, int *offset)
+{
+    unsigned char *bufferPtr;
+    int bufferNum = loadBlockAndGetBufferPtr(&bufferPtr, true);
+    if (bufferNum < 0)
+    {
+        return bufferNum;
+    }
+
+    HeadInfo *head = (HeadInfo *)bufferPtr;
+    int used = HEADER_SIZE + head->numEntries;
+    if (used + 2 + (int)value.size() > Disk::getBlockSize())
+    {
+        releaseBufferPtr(bufferNum, true);
+        return E_OUTOFBOUND;
+    }
+
+    uint16_t length = value.size();
+    memcpy(bufferPtr + used, &length, 2);
+    memcpy(bufferPtr + used + 2, value.data(), length);
+    head->numEntries += 2 + length;
+    *offset = used;
+
+    StaticBuffer::markDirty(bufferNum);
+    releaseBufferPtr(bufferNum, true);
+    return SUCCESS;
+}
+
 /*
 Used to load a block to the buffer and get a pointer to it.
 NOTE: this function expects the caller to allocate memory for the argument
@@ -218,160 +809,427 @@ NOTE: this function expects the caller to allocate memory for the argument
    update is done. This is because the block might not be present in the
    buffer due to LRU buffer replacement. So, it will need to be bought back
    to the buffer before any operations can be done.
+   The buffer is returned latched (exclusively if the block is going to be
+   modified) and stays in place until releaseBufferPtr() is called with the
+   returned buffer number. Returns the buffer number, or an error code.
  */
-int BlockBuffer::loadBlockAndGetBufferPtr(unsigned char **bufferPtr)
+int BlockBuffer::loadBlockAndGetBufferPtr(unsigned char **bufferPtr, bool exclusive)
 {
-    int bufferNum = StaticBuffer::getBufferNum(this->blockNum);
+    int bufferNum = StaticBuffer::latchBlock(this->blockNum, exclusive, true);
 
-    if (bufferNum == E_BLOCKNOTINBUFFER)
-    {
-        bufferNum = StaticBuffer::getFreeBuffer(this->blockNum);
+    if (bufferNum < 0)
+        return bufferNum;
 
-        if (bufferNum == E_OUTOFBOUND)
-            return E_OUTOFBOUND;
+    *bufferPtr = StaticBuffer::blocks[bufferNum];
 
-        Disk::readBlock(StaticBuffer::blocks[bufferNum], this->blockNum);
+    return bufferNum;
+}
+
+void BlockBuffer::releaseBufferPtr(int bufferNum, bool exclusive)
+{
+    StaticBuffer::unlatchBlock(bufferNum, exclusive);
+}
+
+void SlotMap::clear(int numSlots)
+{
+    this->numSlots = numSlots;
+    memset(words, 0, numWords() * sizeof(uint64_t));
+}
+
+void SlotMap::setOccupied(int slot, bool occupied)
+{
+    if (occupied)
+    {
+        words[slot >> 6] |= 1ULL << (slot & 63);
     }
     else
     {
-        for (int i = 0; i < BUFFER_CAPACITY; i++)
+        words[slot >> 6] &= ~(1ULL << (slot & 63));
+    }
+}
+
+// number of occupied slots
+int SlotMap::count() const
+{
+    int count = 0;
+    for (int i = 0; i < numWords(); i++)
+    {
+        count += __builtin_popcountll(words[i]);
+    }
+    return count;
+}
+
+// the first occupied slot from slot on, or size() if there is none
+int SlotMap::nextOccupied(int slot) const
+{
+    if (slot >= numSlots)
+    {
+        return numSlots;
+    }
+    int word = slot >> 6;
+    uint64_t bits = words[word] & (~0ULL << (slot & 63));
+    while (bits == 0)
+    {
+        if (++word == numWords())
+        {
+            return numSlots;
+        }
+        bits = words[word];
+    }
+    // (the bits past the last slot are never set)
+    return (word << 6) + __builtin_ctzll(bits);
+}
+
+// the first free slot from slot on, or size() if there is none
+int SlotMap::nextFree(int slot) const
+{
+    if (slot >= numSlots)
+    {
+        return numSlots;
+    }
+    int word = slot >> 6;
+    uint64_t bits = ~words[word] & (~0ULL << (slot & 63));
+    while (bits == 0)
+    {
+        if (++word == numWords())
         {
-            if (!StaticBuffer::metainfo[i].free)
-                StaticBuffer::metainfo[i].timeStamp++;
+            return numSlots;
         }
+        bits = ~words[word];
+    }
+    return min((word << 6) + __builtin_ctzll(bits), numSlots);
+}
 
-        StaticBuffer::metainfo[bufferNum].timeStamp = 0;
+// the last occupied slot, or -1 if every slot is free
+int SlotMap::lastOccupied() const
+{
+    for (int word = numWords() - 1; word >= 0; word--)
+    {
+        if (words[word] != 0)
+        {
+            return (word << 6) + 63 - __builtin_clzll(words[word]);
+        }
     }
+    return -1;
+}
 
-    *bufferPtr = StaticBuffer::blocks[bufferNum];
+/* Number of bytes the slot map of a record block of numSlots slots takes */
+int getSlotMapSize(int numSlots)
+{
+    if (Disk::getFormatVersion() < BITMAP_SLOT_MAP_VERSION)
+    {
+        return numSlots;
+    }
+    return (numSlots + 7) / 8;
+}
 
-    return SUCCESS;
+/* Number of slots of the record blocks of a relation whose records take
+   recordSize bytes: as many as fit in a block with their slot map, or in the
+   frame of a block of a compressed relation (whose blocks then hold as many
+   of them as compress into a block) */
+int getSlotsPerBlock(int recordSize, bool compressed)
+{
+    int space = (compressed ? getFrameSize() : Disk::getBlockSize()) - HEADER_SIZE;
+    if (Disk::getFormatVersion() < BITMAP_SLOT_MAP_VERSION)
+    {
+        return space / (recordSize + 1);
+    }
+
+    // each slot takes recordSize bytes and a bit, and the map whole bytes
+    int numSlots = (long long)space * 8 / (recordSize * 8 + 1);
+    while (getSlotMapSize(numSlots) + numSlots * recordSize > space)
+    {
+        numSlots--;
+    }
+    // (the slot map of a frame has room for no more than a block's bytes)
+    return min(numSlots, MAX_BLOCK_SIZE);
 }
-/* used to get the slotmap from a record block
-NOTE: this function expects the caller to allocate memory for `*slotMap`
-*/
-int RecBuffer::getSlotMap(unsigned char *slotMap)
+
+/* Reads the slot map of the record block into slotMap */
+int RecBuffer::getSlotMap(SlotMap *slotMap)
 {
     unsigned char *bufferPtr;
 
     // get the starting address of the buffer containing the block using loadBlockAndGetBufferPtr().
-    int ret = loadBlockAndGetBufferPtr(&bufferPtr);
-    if (ret != SUCCESS)
+    int bufferNum = loadBlockAndGetBufferPtr(&bufferPtr, false);
+    if (bufferNum < 0)
     {
-        return ret;
+        return bufferNum;
     }
 
-    struct HeadInfo head;
-    // get the header of the block using getHeader() function
-    ret = BlockBuffer::getHeader(&head);
-
-    int slotCount = head.numSlots;
+    // get the header of the block from the latched buffer
+    int slotCount = ((HeadInfo *)bufferPtr)->numSlots;
 
     // get a pointer to the beginning of the slotmap in memory by offsetting HEADER_SIZE
     unsigned char *slotMapInBuffer = bufferPtr + HEADER_SIZE;
 
-    // copy the values from `slotMapInBuffer` to `slotMap` (size is `slotCount`)
-    memcpy(slotMap, slotMapInBuffer, slotCount);
+    slotMap->clear(slotCount);
+    if (Disk::getFormatVersion() < BITMAP_SLOT_MAP_VERSION)
+    {
+        for (int slot = 0; slot < slotCount; slot++)
+        {
+            if (slotMapInBuffer[slot] == SLOT_OCCUPIED)
+            {
+                slotMap->setOccupied(slot, true);
+            }
+        }
+    }
+    else
+    {
+        // (the words are little endian, as every integer on the disk)
+        memcpy(slotMap->words, slotMapInBuffer, getSlotMapSize(slotCount));
+    }
 
+    releaseBufferPtr(bufferNum, false);
     return SUCCESS;
 }
 
-int RecBuffer::setSlotMap(unsigned char *slotMap)
+/* Replaces the slot map of the record block by slotMap */
+int RecBuffer::setSlotMap(const SlotMap &slotMap)
 {
     unsigned char *bufferPtr;
     /* get the starting address of the buffer containing the block using
        loadBlockAndGetBufferPtr(&bufferPtr). */
-    int ret = loadBlockAndGetBufferPtr(&bufferPtr);
+    int bufferNum = loadBlockAndGetBufferPtr(&bufferPtr, true);
 
-    // if loadBlockAndGetBufferPtr(&bufferPtr) != SUCCESS
+    // if loadBlockAndGetBufferPtr(&bufferPtr) failed
     // return the value returned by the call.
-    if (ret != SUCCESS)
+    if (bufferNum < 0)
     {
-        return ret;
+        return bufferNum;
     }
 
-    // get the header of the block using the getHeader() function
-    struct HeadInfo head;
-    this->getHeader(&head);
-
-    int numSlots = head.numSlots;
+    // get the header of the block from the latched buffer
+    int numSlots = ((HeadInfo *)bufferPtr)->numSlots;
+    if (slotMap.size() != numSlots)
+    {
+        releaseBufferPtr(bufferNum, true);
+        return E_OUTOFBOUND;
+    }
 
-    // the slotmap starts at bufferPtr + HEADER_SIZE. Copy the contents of the
-    // argument `slotMap` to the buffer replacing the existing slotmap.
-    // Note that size of slotmap is `numSlots`
+    // the slotmap starts at bufferPtr + HEADER_SIZE
     unsigned char *slotMapInBuffer = bufferPtr + HEADER_SIZE;
-    memcpy(slotMapInBuffer, slotMap, numSlots);
+    if (Disk::getFormatVersion() < BITMAP_SLOT_MAP_VERSION)
+    {
+        for (int slot = 0; slot < numSlots; slot++)
+        {
+            slotMapInBuffer[slot] = slotMap.isOccupied(slot) ? SLOT_OCCUPIED : SLOT_UNOCCUPIED;
+        }
+    }
+    else
+    {
+        memcpy(slotMapInBuffer, slotMap.words, getSlotMapSize(numSlots));
+    }
 
-    // update dirty bit using StaticBuffer::setDirtyBit
-    // if setDirtyBit failed, return the value returned by the call
-    return StaticBuffer::setDirtyBit(this->blockNum);
+    // mark the buffer dirty (the latched buffer number saves a lookup)
+    StaticBuffer::markDirty(bufferNum);
+    releaseBufferPtr(bufferNum, true);
+    return SUCCESS;
 }
 
-int BlockBuffer::getFreeBlock(int blockType)
+/* Marks one slot of the record block occupied or free, without going through
+   the whole slot map */
+int RecBuffer::setSlot(int slotNum, bool occupied)
 {
-    int freeBlock = -1;
-    for (int i = 0; i < DISK_BLOCKS; i++)
+    unsigned char *bufferPtr;
+    int bufferNum = loadBlockAndGetBufferPtr(&bufferPtr, true);
+    if (bufferNum < 0)
     {
-        if (StaticBuffer::blockAllocMap[i] == UNUSED_BLK)
-        {
-            freeBlock = i;
-            break;
-        }
+        return bufferNum;
     }
 
-    if (freeBlock == -1)
+    int numSlots = ((HeadInfo *)bufferPtr)->numSlots;
+    if (slotNum < 0 || slotNum >= numSlots)
+    {
+        releaseBufferPtr(bufferNum, true);
+        return E_OUTOFBOUND;
+    }
+
+    unsigned char *slotMapInBuffer = bufferPtr + HEADER_SIZE;
+    if (Disk::getFormatVersion() < BITMAP_SLOT_MAP_VERSION)
+    {
+        slotMapInBuffer[slotNum] = occupied ? SLOT_OCCUPIED : SLOT_UNOCCUPIED;
+    }
+    else if (occupied)
+    {
+        slotMapInBuffer[slotNum >> 3] |= 1 << (slotNum & 7);
+    }
+    else
+    {
+        slotMapInBuffer[slotNum >> 3] &= ~(1 << (slotNum & 7));
+    }
+
+    StaticBuffer::markDirty(bufferNum);
+    releaseBufferPtr(bufferNum, true);
+    return SUCCESS;
+}
+
+int BlockBuffer::getFreeBlock(int blockType)
+{
+    // the disk grows when it runs out of unused blocks,
+    // so this only fails once it cannot grow any further
+    int freeBlock = StaticBuffer::getFreeBlockNum();
+
+    if (freeBlock == E_DISKFULL)
     {
         return E_DISKFULL;
     }
 
     this->blockNum = freeBlock;
 
-    int freeBuffer = StaticBuffer::getFreeBuffer(freeBlock);
+    // the block is initialised here, so there is no need to read it from the disk
+    int bufferNum = StaticBuffer::latchBlock(freeBlock, true, false);
+    if (bufferNum < 0)
+    {
+        return bufferNum;
+    }
 
-    HeadInfo header;
-    header.pblock = -1;
-    header.lblock = -1;
-    header.rblock = -1;
-    header.numEntries = 0;
-    header.numAttrs = 0;
-    header.numSlots = 0;
+    unsigned char *bufferPtr = StaticBuffer::blocks[bufferNum];
+    memset(bufferPtr, 0, getFrameSize());
 
-    this->setHeader(&header);
-    this->setBlockType(blockType);
+    HeadInfo *header = (HeadInfo *)bufferPtr;
+    header->blockType = blockType;
+    header->pblock = -1;
+    header->lblock = -1;
+    header->rblock = -1;
+    header->numEntries = 0;
+    header->numAttrs = 0;
+    header->numSlots = 0;
+
+    StaticBuffer::markDirty(bufferNum);
+    releaseBufferPtr(bufferNum, true);
+
+    StaticBuffer::setStaticBlockType(freeBlock, blockType);
 
     return freeBlock;
 }
 
+/* Marks the (newly allocated) block as a record block of a compressed
+   relation, to be written to the disk compressed */
+int BlockBuffer::setCompressed()
+{
+    int bufferNum = StaticBuffer::latchBlock(blockNum, true, true);
+    if (bufferNum < 0)
+    {
+        return bufferNum;
+    }
+
+    // (the buffer may have been replaced and read back since the block was
+    // allocated, which only reads the first block of the frame)
+    if (!StaticBuffer::metainfo[bufferNum].compressed)
+    {
+        memset(StaticBuffer::blocks[bufferNum] + Disk::getBlockSize(), 0, getFrameSize() - Disk::getBlockSize());
+    }
+    StaticBuffer::metainfo[bufferNum].compressed = true;
+    StaticBuffer::markDirty(bufferNum);
+    releaseBufferPtr(bufferNum, true);
+    return SUCCESS;
+}
+
 void BlockBuffer::releaseBlock()
 {
 
-    if (blockNum < 0 || blockNum >= DISK_BLOCKS || StaticBuffer::blockAllocMap[blockNum] == UNUSED_BLK)
+    if (blockNum < 0 || blockNum >= Disk::getNumBlocks() || StaticBuffer::getStaticBlockType(blockNum) == UNUSED_BLK)
     {
         return;
     }
 
-    int bufferNum = StaticBuffer::getBufferNum(blockNum);
+    // free the buffer holding the block, if it is loaded
+    StaticBuffer::freeBuffer(blockNum);
+
+    StaticBuffer::setStaticBlockType(blockNum, UNUSED_BLK);
+
+    this->blockNum = INVALID_BLOCKNUM;
+}
 
-    if (bufferNum == E_BLOCKNOTINBUFFER)
+// the long strings of the statement being run that are not in a relation yet
+static vector<string> transientStrings;
+static mutex transientLock;
+
+/* Sets attr to the string of length bytes at value: in sVal, if it fits, or
+   else as a long string (see LongString) held with the transient strings
+   until the statement is over. */
+void setString(Attribute *attr, const char *value, int length)
+{
+    if (length < ATTR_SIZE &&
+        (length <= LONG_STRING_PREFIX || (unsigned char)value[LONG_STRING_PREFIX] != LONG_STRING_MARKER))
     {
+        memset(attr->sVal, 0, ATTR_SIZE);
+        memcpy(attr->sVal, value, length);
         return;
     }
 
-    StaticBuffer::metainfo[bufferNum].free = true;
+    LongString longString;
+    memcpy(longString.prefix, value, LONG_STRING_PREFIX);
+    longString.marker = LONG_STRING_MARKER;
+    longString.unused = 0;
+    longString.offset = 0;
+    {
+        lock_guard<mutex> guard(transientLock);
+        transientStrings.emplace_back(value, length);
+        longString.block = -(int)transientStrings.size();
+    }
+    memcpy(attr, &longString, sizeof(LongString));
+}
 
-    StaticBuffer::blockAllocMap[blockNum] = UNUSED_BLK;
+// copies the whole string of attr, long or not, to value
+int getString(const Attribute &attr, string *value)
+{
+    if (!isLongString(attr))
+    {
+        value->assign(attr.sVal, strnlen(attr.sVal, ATTR_SIZE));
+        return SUCCESS;
+    }
 
-    this->blockNum = INVALID_BLOCKNUM;
+    LongString longString;
+    memcpy(&longString, &attr, sizeof(LongString));
+    if (longString.block < 0)
+    {
+        lock_guard<mutex> guard(transientLock);
+        size_t index = -1 - longString.block;
+        if (index >= transientStrings.size())
+        {
+            return E_OUTOFBOUND;
+        }
+        *value = transientStrings[index];
+        return SUCCESS;
+    }
+
+    OverflowBuffer overflowBlock(longString.block);
+    return overflowBlock.getValue(longString.offset, value);
+}
+
+// drops the transient strings, once no attribute of the statement refers to them
+void clearTransientStrings()
+{
+    lock_guard<mutex> guard(transientLock);
+    vector<string>().swap(transientStrings);
 }
 
 int compareAttrs(union Attribute attr1, union Attribute attr2, int attrType)
 {
 
     double diff;
-    if (attrType == STRING)
+    if (attrType != STRING)
+    {
+        diff = attr1.nVal - attr2.nVal;
+    }
+    else if (!isLongString(attr1) && !isLongString(attr2))
+    {
         diff = strcmp(attr1.sVal, attr2.sVal);
+    }
     else
-        diff = attr1.nVal - attr2.nVal;
+    {
+        // the prefix kept inline decides, unless both strings start the same
+        diff = strncmp(attr1.sVal, attr2.sVal, LONG_STRING_PREFIX);
+        if (diff == 0)
+        {
+            string value1, value2;
+            getString(attr1, &value1);
+            getString(attr2, &value2);
+            diff = value1.compare(value2);
+        }
+    }
 
     if (diff > 0)
         return 1;
@@ -383,9 +1241,9 @@ int compareAttrs(union Attribute attr1, union Attribute attr2, int attrType)
 
 int IndInternal::getEntry(void *ptr, int indexNum)
 {
-    // if the indexNum is not in the valid range of [0, MAX_KEYS_INTERNAL-1]
+    // if the indexNum is not in the valid range of [0, getMaxKeys()-1]
     //     return E_OUTOFBOUND.
-    if (indexNum < 0 || indexNum >= MAX_KEYS_INTERNAL)
+    if (indexNum < 0 || indexNum >= IndInternal::getMaxKeys())
     {
         return E_OUTOFBOUND;
     }
@@ -393,13 +1251,13 @@ int IndInternal::getEntry(void *ptr, int indexNum)
     unsigned char *bufferPtr;
     /* get the starting address of the buffer containing the block
        using loadBlockAndGetBufferPtr(&bufferPtr). */
-    int ret = loadBlockAndGetBufferPtr(&bufferPtr);
+    int bufferNum = loadBlockAndGetBufferPtr(&bufferPtr, false);
 
-    // if loadBlockAndGetBufferPtr(&bufferPtr) != SUCCESS
+    // if loadBlockAndGetBufferPtr(&bufferPtr) failed
     //     return the value returned by the call.
-    if (ret != SUCCESS)
+    if (bufferNum < 0)
     {
-        return ret;
+        return bufferNum;
     }
 
     // typecast the void pointer to an internal entry pointer
@@ -421,6 +1279,7 @@ int IndInternal::getEntry(void *ptr, int indexNum)
     memcpy(&(internalEntry->lChild), entryPtr, sizeof(int32_t));
     memcpy(&(internalEntry->attrVal), entryPtr + 4, sizeof(Attribute));
     memcpy(&(internalEntry->rChild), entryPtr + 20, sizeof(int32_t));
+    releaseBufferPtr(bufferNum, false);
 
     // return SUCCESS.
     return SUCCESS;
@@ -429,9 +1288,9 @@ int IndInternal::getEntry(void *ptr, int indexNum)
 int IndLeaf::getEntry(void *ptr, int indexNum)
 {
 
-    // if the indexNum is not in the valid range of [0, MAX_KEYS_LEAF-1]
+    // if the indexNum is not in the valid range of [0, getMaxKeys()-1]
     //     return E_OUTOFBOUND.
-    if (indexNum < 0 || indexNum >= MAX_KEYS_LEAF)
+    if (indexNum < 0 || indexNum >= IndLeaf::getMaxKeys())
     {
         return E_OUTOFBOUND;
     }
@@ -439,25 +1298,53 @@ int IndLeaf::getEntry(void *ptr, int indexNum)
     unsigned char *bufferPtr;
     /* get the starting address of the buffer containing the block
        using loadBlockAndGetBufferPtr(&bufferPtr). */
-    int ret = loadBlockAndGetBufferPtr(&bufferPtr);
+    int bufferNum = loadBlockAndGetBufferPtr(&bufferPtr, false);
 
-    // if loadBlockAndGetBufferPtr(&bufferPtr) != SUCCESS
+    // if loadBlockAndGetBufferPtr(&bufferPtr) failed
     //     return the value returned by the call.
-    if (ret != SUCCESS)
+    if (bufferNum < 0)
     {
-        return ret;
+        return bufferNum;
     }
 
-    // copy the indexNum'th Index entry in buffer to memory ptr using memcpy
-
-    /* the indexNum'th entry will begin at an offset of
-       HEADER_SIZE + (indexNum * LEAF_ENTRY_SIZE)  from bufferPtr */
-    unsigned char *entryPtr = bufferPtr + HEADER_SIZE + (indexNum * LEAF_ENTRY_SIZE);
-    // memcpy((struct Index *)ptr, entryPtr, LEAF_ENTRY_SIZE);
+    // copy the indexNum'th Index entry in buffer to memory ptr
     struct Index *index = (struct Index *)ptr;
-    memcpy(&(index->attrVal), entryPtr, sizeof(Attribute));
-    memcpy(&(index->block), entryPtr + 16, 4);
-    memcpy(&(index->slot), entryPtr + 20, 4);
+    if (Disk::getFormatVersion() < PREFIX_LEAF_VERSION)
+    {
+        /* the indexNum'th entry will begin at an offset of
+           HEADER_SIZE + (indexNum * LEAF_ENTRY_SIZE)  from bufferPtr */
+        unsigned char *entryPtr = bufferPtr + HEADER_SIZE + (indexNum * LEAF_ENTRY_SIZE);
+        memcpy(&(index->attrVal), entryPtr, sizeof(Attribute));
+        memcpy(&(index->block), entryPtr + 16, 4);
+        memcpy(&(index->slot), entryPtr + 20, 4);
+        releaseBufferPtr(bufferNum, false);
+        return SUCCESS;
+    }
+
+    // (past the entries of the leaf there may be no room for another one)
+    if (indexNum >= ((HeadInfo *)bufferPtr)->numEntries)
+    {
+        releaseBufferPtr(bufferNum, false);
+        return E_OUTOFBOUND;
+    }
+
+    // the key is the shared prefix, the indexNum'th entry's part of it and zeroes
+    const unsigned char *prefixPtr = bufferPtr + HEADER_SIZE + LEAF_PREFIX_INFO_SIZE;
+    int prefixLength = bufferPtr[HEADER_SIZE];
+    int keyWidth = bufferPtr[HEADER_SIZE + 1];
+    const unsigned char *entryPtr = prefixPtr + prefixLength + indexNum * (keyWidth + LEAF_RECID_SIZE);
+
+    unsigned char *key = (unsigned char *)&(index->attrVal);
+    memcpy(key, prefixPtr, prefixLength);
+    memcpy(key + prefixLength, entryPtr, keyWidth);
+    memset(key + prefixLength + keyWidth, 0, ATTR_SIZE - prefixLength - keyWidth);
+
+    uint16_t slot;
+    memcpy(&(index->block), entryPtr + keyWidth, sizeof(int32_t));
+    memcpy(&slot, entryPtr + keyWidth + sizeof(int32_t), sizeof(uint16_t));
+    index->slot = slot;
+
+    releaseBufferPtr(bufferNum, false);
 
     // return SUCCESS
     return SUCCESS;
@@ -465,9 +1352,9 @@ int IndLeaf::getEntry(void *ptr, int indexNum)
 
 int IndInternal::setEntry(void *ptr, int indexNum)
 {
-    // if the indexNum is not in the valid range of [0, MAX_KEYS_INTERNAL-1]
+    // if the indexNum is not in the valid range of [0, getMaxKeys()-1]
     //     return E_OUTOFBOUND.
-    if (indexNum < 0 || indexNum >= MAX_KEYS_INTERNAL)
+    if (indexNum < 0 || indexNum >= IndInternal::getMaxKeys())
     {
         return E_OUTOFBOUND;
     }
@@ -475,13 +1362,13 @@ int IndInternal::setEntry(void *ptr, int indexNum)
     unsigned char *bufferPtr;
     /* get the starting address of the buffer containing the block
        using loadBlockAndGetBufferPtr(&bufferPtr). */
-    int ret = loadBlockAndGetBufferPtr(&bufferPtr);
+    int bufferNum = loadBlockAndGetBufferPtr(&bufferPtr, true);
 
-    // if loadBlockAndGetBufferPtr(&bufferPtr) != SUCCESS
+    // if loadBlockAndGetBufferPtr(&bufferPtr) failed
     //     return the value returned by the call.
-    if (ret != SUCCESS)
+    if (bufferNum < 0)
     {
-        return ret;
+        return bufferNum;
     }
 
     // typecast the void pointer to an internal entry pointer
@@ -505,27 +1392,49 @@ int IndInternal::setEntry(void *ptr, int indexNum)
     memcpy(entryPtr + 4, &(internalEntry->attrVal), ATTR_SIZE);
     memcpy(entryPtr + 20, &(internalEntry->rChild), 4);
 
-    // update dirty bit using setDirtyBit()
-    // if setDirtyBit failed, return the value returned by the call
-    return StaticBuffer::setDirtyBit(this->blockNum);
+    // mark the buffer dirty (the latched buffer number saves a lookup)
+    StaticBuffer::markDirty(bufferNum);
+    releaseBufferPtr(bufferNum, true);
+    return SUCCESS;
 }
+/* Writes the entry at ptr to the indexNum'th entry of the leaf. Of a prefix
+   compressed leaf, the entry has to be one of the numEntries of the leaf, and
+   they are all written again (see setEntries()). */
 int IndLeaf::setEntry(void *ptr, int indexNum)
 {
-    // if the indexNum is not in the valid range of [0, MAX_KEYS_LEAF-1]
+    // if the indexNum is not in the valid range of [0, getMaxKeys()-1]
     //     return E_OUTOFBOUND.
-    if (indexNum < 0 || indexNum >= MAX_KEYS_LEAF)
+    if (indexNum < 0 || indexNum >= IndLeaf::getMaxKeys())
         return E_OUTOFBOUND;
 
+    if (Disk::getFormatVersion() >= PREFIX_LEAF_VERSION)
+    {
+        HeadInfo head;
+        getHeader(&head);
+        if (indexNum >= head.numEntries)
+        {
+            return E_OUTOFBOUND;
+        }
+
+        vector<Index> entries(head.numEntries);
+        for (int i = 0; i < head.numEntries; i++)
+        {
+            getEntry(&entries[i], i);
+        }
+        entries[indexNum] = *(struct Index *)ptr;
+        return setEntries(entries.data(), head.numEntries);
+    }
+
     unsigned char *bufferPtr;
     /* get the starting address of the buffer containing the block
        using loadBlockAndGetBufferPtr(&bufferPtr). */
-    int ret = loadBlockAndGetBufferPtr(&bufferPtr);
+    int bufferNum = loadBlockAndGetBufferPtr(&bufferPtr, true);
 
-    // if loadBlockAndGetBufferPtr(&bufferPtr) != SUCCESS
+    // if loadBlockAndGetBufferPtr(&bufferPtr) failed
     //     return the value returned by the call.
-    if (ret != SUCCESS)
+    if (bufferNum < 0)
     {
-        return ret;
+        return bufferNum;
     }
 
     // copy the Index at ptr to indexNum'th entry in the buffer using memcpy
@@ -538,9 +1447,68 @@ int IndLeaf::setEntry(void *ptr, int indexNum)
     memcpy(entryPtr + 16, &(index->block), sizeof(int));
     memcpy(entryPtr + 20, &(index->slot), sizeof(int));
 
-    // update dirty bit using setDirtyBit()
-    return StaticBuffer::setDirtyBit(this->blockNum);
-    // if setDirtyBit failed, return the value returned by the call
+    // mark the buffer dirty (the latched buffer number saves a lookup)
+    StaticBuffer::markDirty(bufferNum);
+    releaseBufferPtr(bufferNum, true);
+    return SUCCESS;
+}
+
+/* Writes count entries, in order, as the entries of the leaf (its numEntries
+   is set by the caller). Returns E_OUTOFBOUND if they do not fit in a leaf
+   together (see getNumFitting()). */
+int IndLeaf::setEntries(const Index entries[], int count)
+{
+    if (count < 0 || getNumFitting(entries, count) < count)
+    {
+        return E_OUTOFBOUND;
+    }
+    if (Disk::getFormatVersion() < PREFIX_LEAF_VERSION)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            setEntry((void *)&entries[i], i);
+        }
+        return SUCCESS;
+    }
+
+    unsigned char *bufferPtr;
+    int bufferNum = loadBlockAndGetBufferPtr(&bufferPtr, true);
+    if (bufferNum < 0)
+    {
+        return bufferNum;
+    }
+
+    // the bytes every key shares (no more than the longest key has)
+    int sharedLength = ATTR_SIZE, keyLength = 0;
+    for (int i = 0; i < count; i++)
+    {
+        sharedLength = getSharedLength(entries[0].attrVal, entries[i].attrVal, sharedLength);
+        keyLength = max(keyLength, getKeyLength(entries[i].attrVal));
+    }
+    int prefixLength = min(sharedLength, keyLength);
+    int keyWidth = keyLength - prefixLength;
+
+    bufferPtr[HEADER_SIZE] = prefixLength;
+    bufferPtr[HEADER_SIZE + 1] = keyWidth;
+    unsigned char *entryPtr = bufferPtr + HEADER_SIZE + LEAF_PREFIX_INFO_SIZE;
+    if (count > 0)
+    {
+        memcpy(entryPtr, &entries[0].attrVal, prefixLength);
+    }
+    entryPtr += prefixLength;
+
+    for (int i = 0; i < count; i++)
+    {
+        uint16_t slot = entries[i].slot;
+        memcpy(entryPtr, (const unsigned char *)&entries[i].attrVal + prefixLength, keyWidth);
+        memcpy(entryPtr + keyWidth, &entries[i].block, sizeof(int32_t));
+        memcpy(entryPtr + keyWidth + sizeof(int32_t), &slot, sizeof(uint16_t));
+        entryPtr += keyWidth + LEAF_RECID_SIZE;
+    }
+
+    StaticBuffer::markDirty(bufferNum);
+    releaseBufferPtr(bufferNum, true);
+    return SUCCESS;
 }
 
 int BlockBuffer::setBlockType(int blockType)
@@ -549,24 +1517,24 @@ int BlockBuffer::setBlockType(int blockType)
     unsigned char *bufferPtr;
     /* get the starting address of the buffer containing the block
        using loadBlockAndGetBufferPtr(&bufferPtr). */
-    int ret = loadBlockAndGetBufferPtr(&bufferPtr);
+    int bufferNum = loadBlockAndGetBufferPtr(&bufferPtr, true);
 
-    // if loadBlockAndGetBufferPtr(&bufferPtr) != SUCCESS
+    // if loadBlockAndGetBufferPtr(&bufferPtr) failed
     // return the value returned by the call.
-    if (ret != SUCCESS)
-        return ret;
+    if (bufferNum < 0)
+        return bufferNum;
 
     // store the input block type in the first 4 bytes of the buffer.
     // (hint: cast bufferPtr to int32_t* and then assign it)
     // *((int32_t *)bufferPtr) = blockType;
     *((int32_t *)bufferPtr) = blockType;
 
-    // update the StaticBuffer::blockAllocMap entry corresponding to the
+    // update the block allocation map entry corresponding to the
     // object's block number to `blockType`.
-    StaticBuffer::blockAllocMap[this->blockNum] = blockType;
+    StaticBuffer::setStaticBlockType(this->blockNum, blockType);
 
-    // update dirty bit by calling StaticBuffer::setDirtyBit()
-    // if setDirtyBit() failed
-    // return the returned value from the call
-    return StaticBuffer::setDirtyBit(this->blockNum);
-}
\ No newline at end of file
+    // mark the buffer dirty (the latched buffer number saves a lookup)
+    StaticBuffer::markDirty(bufferNum);
+    releaseBufferPtr(bufferNum, true);
+    return SUCCESS;
+}
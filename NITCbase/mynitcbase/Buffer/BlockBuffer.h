@@ -2,6 +2,8 @@
 #define NITCBASE_BLOCKBUFFER_H
 
 #include <cstdint>
+#include <cstring>
+#include <string>
 
 #include "../Disk_Class/Disk.h"
 #include "../define/constants.h"
@@ -26,8 +28,67 @@ typedef union Attribute
   char sVal[ATTR_SIZE];
 } Attribute;
 
+/* A string of a VARCHAR attribute that does not fit in sVal (one of
+   ATTR_SIZE bytes or more) keeps its first LONG_STRING_PREFIX bytes there,
+   followed by LONG_STRING_MARKER and where the whole string is: at offset in
+   overflow block block, or, for a string that has not been stored in a
+   relation yet (a value typed in a command or read from a csv file), in the
+   transient strings of the statement as string number -1 - block. */
+struct LongString
+{
+  char prefix[LONG_STRING_PREFIX];
+  unsigned char marker;
+  unsigned char unused;
+  uint16_t offset;
+  int32_t block;
+};
+
+inline bool isLongString(const Attribute &attr)
+{
+  return (unsigned char)attr.sVal[LONG_STRING_PREFIX] == LONG_STRING_MARKER &&
+         memchr(attr.sVal, '\0', LONG_STRING_PREFIX) == nullptr;
+}
+
+void setString(Attribute *attr, const char *value, int length);
+int getString(const Attribute &attr, std::string *value);
+void clearTransientStrings();
+
 int compareAttrs(Attribute attr1, Attribute attr2, int attrType);
 
+/* Where the attributes of a record of a relation are stored within its slot.
+   The records of a relation whose attributes all have FORMAT_DEFAULT are
+   arrays of union Attribute, which are copied to and from the block as they
+   are; the attributes of any other relation are packed one after the other
+   at the size of their format (see getFormatSize()).
+
+   The record blocks of a columnar relation are PAX blocks: the slots of a
+   block are split by attribute instead, each attribute having a minipage of
+   numSlots values after the slot map (attribute i starting numSlots *
+   offsets[i] bytes into the records). A scan that needs a few attributes
+   only reads their minipages (see RecBuffer::getColumn()).
+
+   The record blocks of a compressed relation are buffered in frames of
+   COMPRESSED_FRAME_BLOCKS blocks and written compressed into one block (see
+   BlockCompression.h); a record is only added to a block while the block
+   still compresses into one. */
+struct RecordLayout
+{
+  int numAttrs;
+  int recordSize;
+  bool packed;
+  bool columnar;
+  bool compressed;
+  int16_t offsets[MAX_ATTRS];
+  int8_t formats[MAX_ATTRS];
+};
+
+int getFormatSize(int format);
+int getSlotMapSize(int numSlots);
+int getSlotsPerBlock(int recordSize, bool compressed = false);
+void initRecordLayout(RecordLayout *layout, int numAttrs, const int formats[], bool columnar = false,
+                      bool compressed = false);
+int checkRecord(const RecordLayout *layout, const Attribute *record);
+
 struct InternalEntry
 {
   int32_t lChild;
@@ -40,7 +101,34 @@ struct Index
   union Attribute attrVal;
   int32_t block;
   int32_t slot;
-  unsigned char unused[8];
+};
+
+/* The slot map of a record block, with bit s set if slot s is occupied. It is
+   stored as it is after the header of the block (bit s in byte s / 8, from
+   the least significant bit); the blocks of a disk before
+   BITMAP_SLOT_MAP_VERSION have one SLOT_OCCUPIED or SLOT_UNOCCUPIED byte per
+   slot instead, which RecBuffer converts. The occupied slots are visited with
+   nextOccupied(), and a free one found with nextFree(), a word of 64 slots at
+   a time. */
+class SlotMap
+{
+public:
+  SlotMap() : numSlots(0) {}
+  int size() const { return numSlots; }
+  void clear(int numSlots);
+  bool isOccupied(int slot) const { return (words[slot >> 6] >> (slot & 63)) & 1; }
+  void setOccupied(int slot, bool occupied);
+  int count() const;
+  int nextOccupied(int slot) const;
+  int nextFree(int slot) const;
+  int lastOccupied() const;
+
+private:
+  friend class RecBuffer;
+  int numWords() const { return (numSlots + 63) >> 6; }
+
+  int numSlots;
+  uint64_t words[MAX_BLOCK_SIZE / 64];  // (a block never has more slots than a block has bytes)
 };
 
 class BlockBuffer
@@ -49,9 +137,11 @@ protected:
   // field
   int blockNum;
   // methods
-  int loadBlockAndGetBufferPtr(unsigned char **buffPtr);
+  int loadBlockAndGetBufferPtr(unsigned char **buffPtr, bool exclusive);
+  void releaseBufferPtr(int bufferNum, bool exclusive);
   int getFreeBlock(int blockType);
   int setBlockType(int blockType);
+  int setCompressed();
 
 public:
   // methods
@@ -63,16 +153,42 @@ public:
   void releaseBlock();
 };
 
+/* A record block. Records are converted to and from the layout passed to the
+   constructor; without one, they are taken to be arrays of union Attribute
+   (as the records of the catalogs are). */
 class RecBuffer : public BlockBuffer
 {
+private:
+  const RecordLayout *layout;
+
 public:
   // methods
-  RecBuffer();
-  RecBuffer(int blockNum);
-  int getSlotMap(unsigned char *slotMap);
-  int setSlotMap(unsigned char *slotMap);
+  RecBuffer(const RecordLayout *layout = nullptr);
+  RecBuffer(int blockNum, const RecordLayout *layout = nullptr);
+  int getSlotMap(SlotMap *slotMap);
+  int setSlotMap(const SlotMap &slotMap);
+  int setSlot(int slotNum, bool occupied);
   int getRecord(union Attribute *rec, int slotNum);
   int setRecord(union Attribute *rec, int slotNum);
+  int setRecords(union Attribute *recs, int firstSlot, int count);
+  int clearRecords(int firstSlot, int count);
+  bool fitsOnDisk();
+  int getColumn(union Attribute *values, int attrOffset);
+  int storeLongStrings(union Attribute *recs, int count);
+};
+
+/* An overflow block, holding the long strings of the records of one record
+   block (the block's pblock is the first of its overflow blocks, and each one
+   links to the next through rblock). The strings follow the header one after
+   the other, each as a 2 byte length and its bytes; numEntries is the number
+   of bytes they take. */
+class OverflowBuffer : public BlockBuffer
+{
+public:
+  OverflowBuffer();
+  OverflowBuffer(int blockNum);
+  int getValue(int offset, std::string *value);
+  int addValue(const std::string &value, int *offset);
 };
 
 class IndBuffer : public BlockBuffer
@@ -91,8 +207,21 @@ public:
   IndInternal(int blockNum);
   int getEntry(void *ptr, int indexNum);
   int setEntry(void *ptr, int indexNum);
+  static int getMaxKeys();
 };
 
+/* A leaf index block. The entries of a leaf are prefix compressed: after the
+   header, the number of leading bytes all their keys share and the width of
+   the rest of a key (up to the last byte that is not zero of any key of the
+   leaf), then the shared bytes, and then the entries, each its key less the
+   shared bytes in the key width and its rec-id in LEAF_RECID_SIZE bytes. Keys
+   that share a prefix, and short STRING keys (whose unused bytes the tree
+   zeroes), take a few bytes each, so that a leaf holds up to getMaxKeys()
+   entries; any half of that many fit whatever their keys are.
+
+   Since an entry can make the others wider, the entries of a leaf are written
+   all at once (see setEntries()); a leaf of a disk before PREFIX_LEAF_VERSION
+   has LEAF_ENTRY_SIZE entries instead. */
 class IndLeaf : public IndBuffer
 {
 public:
@@ -100,6 +229,9 @@ public:
   IndLeaf(int blockNum);
   int getEntry(void *ptr, int indexNum);
   int setEntry(void *ptr, int indexNum);
+  int setEntries(const Index entries[], int count);
+  static int getMaxKeys();
+  static int getNumFitting(const Index entries[], int count);
 };
 
 #endif // NITCBASE_BLOCKBUFFER_H
\ No newline at end of file
@@ -0,0 +1,235 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "../Disk_Class/Disk.h"
+
+#define LZ_MIN_MATCH 4      // shortest repeated string that is coded as a match
+#define LZ_HASH_BITS 12     // the last position of each hash of 4 bytes is kept in 2^LZ_HASH_BITS entries
+#define LZ_MAX_OFFSET 65535 // a match is at most this many bytes back (the offset takes 2 bytes)
+
+/* The compressed data is a run of sequences, each a token byte, literals that
+   are copied as they are and a match: a string of at least LZ_MIN_MATCH bytes
+   that is copied from offset bytes back in the output. The high 4 bits of the
+   token are the number of literals and the low 4 bits the length of the match
+   less LZ_MIN_MATCH; either of them at 15 is continued in the bytes that follow
+   (255 adding 255 and the first byte below it ending the length). The offset
+   of the match is 2 bytes after the literals. The last sequence ends with its
+   literals, and has no match. */
+
+static inline uint32_t read32(const unsigned char *ptr)
+{
+    uint32_t value;
+    memcpy(&value, ptr, sizeof(uint32_t));
+    return value;
+}
+
+static unsigned char *writeLength(unsigned char *out, int length)
+{
+    for (; length >= 255; length -= 255)
+    {
+        *out++ = 255;
+    }
+    *out++ = (unsigned char)length;
+    return out;
+}
+
+static int readLength(const unsigned char **in, const unsigned char *end, int *length)
+{
+    int byte;
+    do
+    {
+        if (*in == end)
+        {
+            return FAILURE;
+        }
+        byte = *(*in)++;
+        *length += byte;
+    } while (byte == 255);
+    return SUCCESS;
+}
+
+/* Writes a sequence of literalLength literals and a match of matchLength bytes
+   at offset (none if matchLength is 0) at out, and returns where it ends, or
+   nullptr if it does not fit before end */
+static unsigned char *writeSequence(unsigned char *out, unsigned char *end, const unsigned char *literals,
+                                    int literalLength, int offset, int matchLength)
+{
+    // (a bound on the bytes the sequence takes)
+    if (end - out < 6 + literalLength + literalLength / 255 + matchLength / 255)
+    {
+        return nullptr;
+    }
+
+    int matchCode = matchLength == 0 ? 0 : matchLength - LZ_MIN_MATCH;
+    *out++ = (unsigned char)((std::min(literalLength, 15) << 4) | std::min(matchCode, 15));
+    if (literalLength >= 15)
+    {
+        out = writeLength(out, literalLength - 15);
+    }
+    memcpy(out, literals, literalLength);
+    out += literalLength;
+
+    if (matchLength != 0)
+    {
+        *out++ = (unsigned char)(offset & 0xFF);
+        *out++ = (unsigned char)(offset >> 8);
+        if (matchCode >= 15)
+        {
+            out = writeLength(out, matchCode - 15);
+        }
+    }
+    return out;
+}
+
+/* Compresses the size bytes at src to at most capacity bytes at dst. Returns
+   the number of bytes written, or FAILURE if they do not fit. */
+static int lzCompress(const unsigned char *src, int size, unsigned char *dst, int capacity)
+{
+    int lastPosition[1 << LZ_HASH_BITS];
+    std::fill(lastPosition, lastPosition + (1 << LZ_HASH_BITS), -1);
+
+    unsigned char *out = dst;
+    unsigned char *end = dst + capacity;
+    int anchor = 0;
+    int pos = 0;
+    while (pos + LZ_MIN_MATCH <= size)
+    {
+        uint32_t bytes = read32(src + pos);
+        uint32_t hash = (bytes * 2654435761u) >> (32 - LZ_HASH_BITS);
+        int candidate = lastPosition[hash];
+        lastPosition[hash] = pos;
+        if (candidate < 0 || pos - candidate > LZ_MAX_OFFSET || read32(src + candidate) != bytes)
+        {
+            pos++;
+            continue;
+        }
+
+        int matchLength = LZ_MIN_MATCH;
+        while (pos + matchLength < size && src[candidate + matchLength] == src[pos + matchLength])
+        {
+            matchLength++;
+        }
+        out = writeSequence(out, end, src + anchor, pos - anchor, pos - candidate, matchLength);
+        if (out == nullptr)
+        {
+            return FAILURE;
+        }
+        pos += matchLength;
+        anchor = pos;
+    }
+
+    if (anchor < size)
+    {
+        out = writeSequence(out, end, src + anchor, size - anchor, 0, 0);
+        if (out == nullptr)
+        {
+            return FAILURE;
+        }
+    }
+    return out - dst;
+}
+
+/* Expands the size bytes of compressed data at src into exactly expandedSize
+   bytes at dst. Returns FAILURE if the data is corrupt. */
+static int lzExpand(const unsigned char *src, int size, unsigned char *dst, int expandedSize)
+{
+    const unsigned char *in = src;
+    const unsigned char *inEnd = src + size;
+    unsigned char *out = dst;
+    unsigned char *outEnd = dst + expandedSize;
+
+    while (in < inEnd)
+    {
+        int token = *in++;
+        int literalLength = token >> 4;
+        if (literalLength == 15 && readLength(&in, inEnd, &literalLength) != SUCCESS)
+        {
+            return FAILURE;
+        }
+        if (literalLength > inEnd - in || literalLength > outEnd - out)
+        {
+            return FAILURE;
+        }
+        memcpy(out, in, literalLength);
+        in += literalLength;
+        out += literalLength;
+        if (in == inEnd)
+        {
+            break;
+        }
+
+        if (inEnd - in < 2)
+        {
+            return FAILURE;
+        }
+        int offset = in[0] | (in[1] << 8);
+        in += 2;
+        int matchLength = token & 15;
+        if (matchLength == 15 && readLength(&in, inEnd, &matchLength) != SUCCESS)
+        {
+            return FAILURE;
+        }
+        matchLength += LZ_MIN_MATCH;
+        if (offset == 0 || offset > out - dst || matchLength > outEnd - out)
+        {
+            return FAILURE;
+        }
+
+        // byte by byte, as the match may overlap the bytes it produces
+        const unsigned char *match = out - offset;
+        for (int i = 0; i < matchLength; i++)
+        {
+            out[i] = match[i];
+        }
+        out += matchLength;
+    }
+
+    return out == outEnd ? SUCCESS : FAILURE;
+}
+
+/* Size in bytes of the buffer frame of a record block of a compressed relation */
+int getFrameSize()
+{
+    return Disk::getBlockSize() * COMPRESSED_FRAME_BLOCKS;
+}
+
+/* Compresses the record block buffered in frame (getFrameSize() bytes) into a
+   block to be written to the disk. Returns FAILURE if the records do not
+   compress into a block. */
+int compressBlock(const unsigned char *frame, unsigned char *block)
+{
+    const int blockSize = Disk::getBlockSize();
+    int dataSize = lzCompress(frame + HEADER_SIZE, getFrameSize() - HEADER_SIZE, block + COMPRESSED_HEADER_SIZE,
+                              blockSize - COMPRESSED_HEADER_SIZE);
+    if (dataSize < 0)
+    {
+        return FAILURE;
+    }
+
+    int32_t blockType = COMPRESSED_REC;
+    memcpy(block, frame, HEADER_SIZE);
+    memcpy(block, &blockType, sizeof(int32_t));
+    CompressedHeader header = {dataSize};
+    memcpy(block + HEADER_SIZE, &header, sizeof(CompressedHeader));
+    memset(block + COMPRESSED_HEADER_SIZE + dataSize, 0, blockSize - COMPRESSED_HEADER_SIZE - dataSize);
+    return SUCCESS;
+}
+
+/* Expands a compressed record block read from the disk into frame. Returns
+   FAILURE if the block is corrupt. */
+int expandBlock(const unsigned char *block, unsigned char *frame)
+{
+    CompressedHeader header;
+    memcpy(&header, block + HEADER_SIZE, sizeof(CompressedHeader));
+    if (header.dataSize < 0 || header.dataSize > Disk::getBlockSize() - COMPRESSED_HEADER_SIZE)
+    {
+        return FAILURE;
+    }
+
+    int32_t blockType = REC;
+    memcpy(frame, block, HEADER_SIZE);
+    memcpy(frame, &blockType, sizeof(int32_t));
+    return lzExpand(block + COMPRESSED_HEADER_SIZE, header.dataSize, frame + HEADER_SIZE, getFrameSize() - HEADER_SIZE);
+}
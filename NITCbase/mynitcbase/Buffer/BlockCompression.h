@@ -0,0 +1,30 @@
+#ifndef NITCBASE_BLOCKCOMPRESSION_H
+#define NITCBASE_BLOCKCOMPRESSION_H
+
+#include <cstdint>
+
+#include "../define/constants.h"
+
+/* A record block of a compressed relation is buffered in a frame of
+   COMPRESSED_FRAME_BLOCKS blocks, and stored on the disk as a single block:
+   the header of the frame (with blockType COMPRESSED_REC instead of REC, and
+   the page LSN where it always is), then the number of bytes of compressed
+   data and the rest of the frame compressed with an LZ77 coder in the manner
+   of LZ4. The runs of equal bytes and repeated strings of the records of an
+   archival relation (padded STRING attributes, the same values in many
+   records) take a few bytes each.
+
+   A frame is only ever changed so that it still compresses into a block (see
+   RecBuffer::fitsOnDisk()), so writing it back cannot fail. */
+struct CompressedHeader
+{
+    int32_t dataSize;  // bytes of compressed data following the header
+};
+
+#define COMPRESSED_HEADER_SIZE (HEADER_SIZE + (int)sizeof(CompressedHeader))
+
+int getFrameSize();
+int compressBlock(const unsigned char *frame, unsigned char *block);
+int expandBlock(const unsigned char *block, unsigned char *frame);
+
+#endif // NITCBASE_BLOCKCOMPRESSION_H
@@ -1,22 +1,45 @@
 #include "StaticBuffer.h"
 #include <string.h>
 #include <stdio.h>
+#include <climits>
 #include <iostream>
+#include <thread>
+
+#include "../Disk_Class/WriteAheadLog.h"
+#include "BlockCompression.h"
 using namespace std;
 
-unsigned char StaticBuffer::blocks[BUFFER_CAPACITY][BLOCK_SIZE];
+unsigned char *StaticBuffer::blocks[BUFFER_CAPACITY];
 struct BufferMetaInfo StaticBuffer::metainfo[BUFFER_CAPACITY];
-unsigned char StaticBuffer::blockAllocMap[DISK_BLOCKS];
+std::shared_mutex StaticBuffer::latches[BUFFER_CAPACITY];
+BufferPartition StaticBuffer::partitions[BUFFER_PARTITIONS];
+std::mutex StaticBuffer::replacementLock;
+std::mutex StaticBuffer::commitLock;
+std::atomic<unsigned long long> StaticBuffer::accessClock(0);
+std::vector<unsigned char *> StaticBuffer::allocMapPages;
+std::vector<bool> StaticBuffer::allocMapDirty;
+std::vector<bool> StaticBuffer::allocMapUnlogged;
+int StaticBuffer::allocMapFreeHint = 0;
+std::recursive_mutex StaticBuffer::allocMapLock;
 
 StaticBuffer::StaticBuffer()
 {
-    // copy blockAllocMap blocks from disk to buffer (using readblock() of disk)
-    // blocks 0 to 3
-    unsigned char block[BLOCK_SIZE];
-    for (int blockNum = 0; blockNum < 4; blockNum++)
+    // allocate the buffer blocks
+    for (int bufferIndex = 0; bufferIndex < BUFFER_CAPACITY; bufferIndex++)
+    {
+        blocks[bufferIndex] = new unsigned char[getFrameSize()];
+    }
+
+    // the block allocation map pages are read from the disk on first use
+    // (see getAllocMapPage())
+    allocMapPages.assign(Disk::getNumMapBlocks(), nullptr);
+    allocMapDirty.assign(Disk::getNumMapBlocks(), false);
+    allocMapUnlogged.assign(Disk::getNumMapBlocks(), false);
+    allocMapFreeHint = 0;
+
+    for (int partitionIndex = 0; partitionIndex < BUFFER_PARTITIONS; partitionIndex++)
     {
-        Disk::readBlock(block, blockNum);
-        memcpy(blockAllocMap + blockNum * BLOCK_SIZE, block, BLOCK_SIZE);
+        partitions[partitionIndex].count = 0;
     }
 
     // initialise all blocks as free
@@ -24,8 +47,12 @@ StaticBuffer::StaticBuffer()
     {
         metainfo[bufferIndex].free = true;
         metainfo[bufferIndex].dirty = false;
+        metainfo[bufferIndex].unlogged = false;
+        metainfo[bufferIndex].compressed = false;
+        metainfo[bufferIndex].lsn = 0;
         metainfo[bufferIndex].blockNum = -1;
-        metainfo[bufferIndex].timeStamp = -1;
+        metainfo[bufferIndex].pinCount = 0;
+        metainfo[bufferIndex].lastAccess = 0;
     }
 }
 
@@ -34,94 +61,296 @@ StaticBuffer::StaticBuffer()
 */
 int StaticBuffer::getBufferNum(int blockNum)
 {
-    // Check if blockNum is valid (between zero and DISK_BLOCKS)
+    // Check if blockNum is valid (between zero and the number of disk blocks)
     // and return E_OUTOFBOUND if not valid.
-    if (blockNum < 0 || blockNum > DISK_BLOCKS)
+    if (blockNum < 0 || blockNum >= Disk::getNumBlocks())
     {
         return E_OUTOFBOUND;
     }
 
-    // find and return the bufferIndex which corresponds to blockNum (check metainfo)
-    for (int bufferIndex = 0; bufferIndex < BUFFER_CAPACITY; bufferIndex++)
+    // look the block up in its partition of the mapping table
+    BufferPartition &partition = partitions[blockNum % BUFFER_PARTITIONS];
+    lock_guard<mutex> guard(partition.lock);
+    int index = findMapping(partition, blockNum);
+    if (index != E_BLOCKNOTINBUFFER)
     {
-        if (metainfo[bufferIndex].blockNum == blockNum)
-        {
-            return bufferIndex;
-        }
+        return partition.bufferNums[index];
     }
 
     // if block is not in the buffer
     return E_BLOCKNOTINBUFFER;
 }
 
-int StaticBuffer::getFreeBuffer(int blockNum)
+/* Returns the position of the block in the partition, or E_BLOCKNOTINBUFFER.
+   The caller must hold the lock of the partition. */
+int StaticBuffer::findMapping(BufferPartition &partition, int blockNum)
 {
-    // Check if blockNum is valid (non zero and less than DISK_BLOCKS)
-    // and return E_OUTOFBOUND if not valid.
-    if (blockNum < 0 || blockNum >= DISK_BLOCKS)
+    for (int index = 0; index < partition.count; index++)
+    {
+        if (partition.blockNums[index] == blockNum)
+        {
+            return index;
+        }
+    }
+    return E_BLOCKNOTINBUFFER;
+}
+
+/* Pins the buffer holding the block, if there is one, and returns its index.
+   Pins are only taken under the partition lock, so a buffer found unpinned
+   under that lock can safely be replaced. */
+int StaticBuffer::pinIfBuffered(int blockNum)
+{
+    BufferPartition &partition = partitions[blockNum % BUFFER_PARTITIONS];
+    lock_guard<mutex> guard(partition.lock);
+    int index = findMapping(partition, blockNum);
+    if (index == E_BLOCKNOTINBUFFER)
+    {
+        return E_BLOCKNOTINBUFFER;
+    }
+    int bufferNum = partition.bufferNums[index];
+    metainfo[bufferNum].pinCount.fetch_add(1, memory_order_relaxed);
+    return bufferNum;
+}
+
+/* Returns the index of the buffer holding the block, pinned and latched in the
+   requested mode, after reading the block from the disk if it is not buffered
+   (unless `load` is false, for a block that is about to be initialised).
+   Every latchBlock() must be matched by an unlatchBlock(). */
+int StaticBuffer::latchBlock(int blockNum, bool exclusive, bool load)
+{
+    if (blockNum < 0 || blockNum >= Disk::getNumBlocks())
     {
         return E_OUTOFBOUND;
     }
 
-    // increase the timeStamp in metaInfo of all occupied buffers.
-    for (int bufferIndex = 0; bufferIndex < BUFFER_CAPACITY; bufferIndex++)
+    int bufferNum = pinIfBuffered(blockNum);
+    while (bufferNum == E_BLOCKNOTINBUFFER)
     {
-        if (!metainfo[bufferIndex].free)
+        unique_lock<mutex> replacement(replacementLock);
+
+        // another thread may have loaded the block while this one waited
+        bufferNum = pinIfBuffered(blockNum);
+        if (bufferNum != E_BLOCKNOTINBUFFER)
+        {
+            break;
+        }
+
+        // the new buffer comes back pinned and exclusively latched, so threads
+        // that find it in the mapping table wait until the block is read
+        bufferNum = getFreeBuffer(blockNum);
+        replacement.unlock();
+
+        if (bufferNum == E_BLOCKNOTINBUFFER)
+        {
+            // every buffer is pinned; wait for one to be unpinned
+            this_thread::yield();
+            continue;
+        }
+
+        if (load)
+        {
+            readBuffer(bufferNum, blockNum);
+        }
+        if (!exclusive)
         {
-            metainfo[bufferIndex].timeStamp++;
+            latches[bufferNum].unlock();
+            latches[bufferNum].lock_shared();
         }
+        metainfo[bufferNum].lastAccess.store(accessClock.fetch_add(1, memory_order_relaxed), memory_order_relaxed);
+        return bufferNum;
+    }
+
+    if (exclusive)
+    {
+        latches[bufferNum].lock();
+    }
+    else
+    {
+        latches[bufferNum].lock_shared();
+    }
+    metainfo[bufferNum].lastAccess.store(accessClock.fetch_add(1, memory_order_relaxed), memory_order_relaxed);
+    return bufferNum;
+}
+
+void StaticBuffer::unlatchBlock(int bufferNum, bool exclusive)
+{
+    // unlatch before unpinning: an unpinned buffer is never latched
+    if (exclusive)
+    {
+        latches[bufferNum].unlock();
     }
+    else
+    {
+        latches[bufferNum].unlock_shared();
+    }
+    metainfo[bufferNum].pinCount.fetch_sub(1, memory_order_release);
+}
 
+/* Takes a buffer for blockNum: a free buffer if there is one, otherwise the
+   least recently used buffer that is not pinned, which is written back to the
+   disk first if it is dirty. Returns the buffer pinned, exclusively latched and
+   entered in the mapping table, or E_BLOCKNOTINBUFFER if every buffer is pinned.
+   The caller must hold replacementLock. */
+int StaticBuffer::getFreeBuffer(int blockNum)
+{
     // let bufferNum be used to store the buffer number of the free/freed buffer.
-    int bufferNum;
-    bool bufferFound = false;
+    int bufferNum = -1;
     // iterate through metainfo and check if there is any buffer free
     for (int bufferIndex = 0; bufferIndex < BUFFER_CAPACITY; bufferIndex++)
     {
         if (metainfo[bufferIndex].free)
         {
             bufferNum = bufferIndex;
-            bufferFound = true;
             break;
         }
     }
 
-    // if a free buffer is available, set bufferNum = index of that free buffer.
-
     // if a free buffer is not available,
-    //     find the buffer with the largest timestamp
+    //     find the unpinned buffer that was used the longest time ago
     //     IF IT IS DIRTY, write back to the disk using Disk::writeBlock()
-    //     set bufferNum = index of this buffer
-
-    if (!bufferFound)
+    while (bufferNum == -1)
     {
-        int maxTimeStamp = -1;
+        unsigned long long oldestAccess = ULLONG_MAX;
         for (int bufferIndex = 0; bufferIndex < BUFFER_CAPACITY; bufferIndex++)
         {
-            if (metainfo[bufferIndex].timeStamp > maxTimeStamp)
+            if (metainfo[bufferIndex].pinCount.load(memory_order_relaxed) != 0)
             {
-                maxTimeStamp = metainfo[bufferIndex].timeStamp;
+                continue;
+            }
+            unsigned long long lastAccess = metainfo[bufferIndex].lastAccess.load(memory_order_relaxed);
+            if (lastAccess < oldestAccess)
+            {
+                oldestAccess = lastAccess;
                 bufferNum = bufferIndex;
             }
         }
-        if (metainfo[bufferNum].dirty)
+        if (bufferNum == -1)
         {
-            Disk::writeBlock(blocks[bufferNum], metainfo[bufferNum].blockNum);
+            return E_BLOCKNOTINBUFFER;
         }
+
+        // take the block out of the mapping table, unless it was pinned meanwhile
+        BufferPartition &partition = partitions[metainfo[bufferNum].blockNum % BUFFER_PARTITIONS];
+        lock_guard<mutex> guard(partition.lock);
+        if (metainfo[bufferNum].pinCount != 0)
+        {
+            bufferNum = -1;
+            continue;
+        }
+        int index = findMapping(partition, metainfo[bufferNum].blockNum);
+        partition.count--;
+        partition.blockNums[index] = partition.blockNums[partition.count];
+        partition.bufferNums[index] = partition.bufferNums[partition.count];
+    }
+
+    latches[bufferNum].lock();
+    metainfo[bufferNum].pinCount = 1;
+
+    if (!metainfo[bufferNum].free && metainfo[bufferNum].dirty)
+    {
+        // the log must hold the block before the disk does: log every modified
+        // block at once so that later evictions rarely need a log flush of their own
+        if (metainfo[bufferNum].unlogged)
+        {
+            logBuffer(bufferNum);
+            logModifiedBlocks(false);
+        }
+
+        // changes the command has not committed yet can be taken back after a
+        // crash (see WriteAheadLog::appendUndo())
+        int lsn = metainfo[bufferNum].lsn;
+        if (lsn > WriteAheadLog::getCommittedLsn())
+        {
+            lsn = max(lsn, WriteAheadLog::appendUndo(metainfo[bufferNum].blockNum));
+        }
+        if (lsn > WriteAheadLog::getFlushedLsn())
+        {
+            WriteAheadLog::flush();
+        }
+        writeBuffer(bufferNum);
     }
 
     // update the metaInfo entry corresponding to bufferNum with
-    // free:false, dirty:false, blockNum:the input block number, timeStamp:0.
+    // free:false, dirty:false, blockNum:the input block number
     metainfo[bufferNum].free = false;
     metainfo[bufferNum].dirty = false;
+    metainfo[bufferNum].unlogged = false;
+    metainfo[bufferNum].compressed = false;
+    metainfo[bufferNum].lsn = 0;
     metainfo[bufferNum].blockNum = blockNum;
-    metainfo[bufferNum].timeStamp = 0; // or -1
 
-    return bufferNum;
+    BufferPartition &partition = partitions[blockNum % BUFFER_PARTITIONS];
+    lock_guard<mutex> guard(partition.lock);
+    partition.blockNums[partition.count] = blockNum;
+    partition.bufferNums[partition.count] = bufferNum;
+    partition.count++;
 
     // return the bufferNum.
+    return bufferNum;
+}
+
+/* Drops the buffer holding a block that was released, without writing it back.
+   A buffer still pinned by another thread is left as it is. */
+void StaticBuffer::freeBuffer(int blockNum)
+{
+    lock_guard<mutex> replacement(replacementLock);
+
+    BufferPartition &partition = partitions[blockNum % BUFFER_PARTITIONS];
+    lock_guard<mutex> guard(partition.lock);
+    int index = findMapping(partition, blockNum);
+    if (index == E_BLOCKNOTINBUFFER || metainfo[partition.bufferNums[index]].pinCount != 0)
+    {
+        return;
+    }
+
+    int bufferNum = partition.bufferNums[index];
+    metainfo[bufferNum].free = true;
+    metainfo[bufferNum].dirty = false;
+    metainfo[bufferNum].unlogged = false;
+    metainfo[bufferNum].compressed = false;
+    partition.count--;
+    partition.blockNums[index] = partition.blockNums[partition.count];
+    partition.bufferNums[index] = partition.bufferNums[partition.count];
+}
+
+/* Reads the block into the buffer, expanding it into the frame of a record
+   block of a compressed relation if it is stored compressed. The caller holds
+   the exclusive latch of the buffer. */
+void StaticBuffer::readBuffer(int bufferNum, int blockNum)
+{
+    Disk::readBlock(blocks[bufferNum], blockNum);
+    if (*(int32_t *)blocks[bufferNum] != COMPRESSED_REC)
+    {
+        return;
+    }
+
+    vector<unsigned char> block(blocks[bufferNum], blocks[bufferNum] + Disk::getBlockSize());
+    metainfo[bufferNum].compressed = true;
+    if (expandBlock(block.data(), blocks[bufferNum]) != SUCCESS)
+    {
+        cout << "Compressed block " << blockNum << " is corrupt, reading it as an empty block\n";
+        memset(blocks[bufferNum] + HEADER_SIZE, 0, getFrameSize() - HEADER_SIZE);
+    }
 }
 
+/* Writes the buffered block back to the disk, compressing it first if it is a
+   record block of a compressed relation. The caller holds the exclusive latch
+   of the buffer. */
+void StaticBuffer::writeBuffer(int bufferNum)
+{
+    if (!metainfo[bufferNum].compressed)
+    {
+        Disk::writeBlock(blocks[bufferNum], metainfo[bufferNum].blockNum);
+        return;
+    }
+
+    vector<unsigned char> block(Disk::getBlockSize());
+    compressBlock(blocks[bufferNum], block.data());
+    Disk::writeBlock(block.data(), metainfo[bufferNum].blockNum);
+}
+
+/* Marks a buffered block as modified. The caller holds the exclusive latch of
+   the buffer (see BlockBuffer). */
 int StaticBuffer::setDirtyBit(int blockNum)
 {
     // find the buffer index corresponding to the block using getBufferNum().
@@ -146,47 +375,343 @@ int StaticBuffer::setDirtyBit(int blockNum)
     //     (the bufferNum is valid)
     //     set the dirty bit of that buffer to true in metainfo
     metainfo[bufferNum].dirty = true;
+    metainfo[bufferNum].unlogged = true;
     // return SUCCESS
     return SUCCESS;
 }
 
+/* Marks a buffer as modified; used by BlockBuffer, which already holds the
+   exclusive latch and knows the buffer number. */
+void StaticBuffer::markDirty(int bufferNum)
+{
+    metainfo[bufferNum].dirty = true;
+    metainfo[bufferNum].unlogged = true;
+}
+
 int StaticBuffer::getStaticBlockType(int blockNum)
 {
     // Check if blockNum is valid (non zero and less than number of disk blocks)
     // and return E_OUTOFBOUND if not valid.
-    if (blockNum < 0 || blockNum >= DISK_BLOCKS)
+    if (blockNum < 0 || blockNum >= Disk::getNumBlocks())
     {
         return E_OUTOFBOUND;
     }
 
     // Access the entry in block allocation map corresponding to the blockNum argument
     // and return the block type after type casting to integer.
-    return (int)blockAllocMap[blockNum];
+    lock_guard<recursive_mutex> guard(allocMapLock);
+    const int blockSize = Disk::getBlockSize();
+    return (int)getAllocMapPage(blockNum / blockSize)[blockNum % blockSize];
 }
 
-/*
-At this stage, we are not writing back from the buffer to the disk since we are
-not modifying the buffer. So, we will define an empty destructor for now. In
-subsequent stages, we will implement the write-back functionality here.
-*/
-// write back all modified blocks on system exit
-StaticBuffer::~StaticBuffer()
+int StaticBuffer::setStaticBlockType(int blockNum, int blockType)
+{
+    if (blockNum < 0 || blockNum >= Disk::getNumBlocks())
+    {
+        return E_OUTOFBOUND;
+    }
+
+    lock_guard<recursive_mutex> guard(allocMapLock);
+    const int blockSize = Disk::getBlockSize();
+    const int mapIndex = blockNum / blockSize;
+    getAllocMapPage(mapIndex)[blockNum % blockSize] = (unsigned char)blockType;
+    allocMapDirty[mapIndex] = true;
+    allocMapUnlogged[mapIndex] = true;
+
+    if (blockType == UNUSED_BLK && blockNum < allocMapFreeHint)
+    {
+        allocMapFreeHint = blockNum;
+    }
+
+    return SUCCESS;
+}
+
+/* Returns the first unused block of the disk, growing the disk when every
+   block is in use, or E_DISKFULL if the disk cannot grow any further.
+   The block is marked as used (as a record block) so that no other thread
+   is handed the same block; its real type is set by the caller. */
+int StaticBuffer::getFreeBlockNum()
+{
+    lock_guard<recursive_mutex> guard(allocMapLock);
+    const int blockSize = Disk::getBlockSize();
+
+    while (true)
+    {
+        // scan the map a page at a time, starting from the page holding the hint
+        for (int mapIndex = allocMapFreeHint / blockSize; mapIndex < Disk::getNumMapBlocks(); mapIndex++)
+        {
+            int start = (mapIndex == allocMapFreeHint / blockSize) ? allocMapFreeHint % blockSize : 0;
+            int end = min(blockSize, Disk::getNumBlocks() - mapIndex * blockSize);
+            if (start >= end)
+            {
+                continue;
+            }
+
+            unsigned char *page = getAllocMapPage(mapIndex);
+            unsigned char *freeEntry = (unsigned char *)memchr(page + start, UNUSED_BLK, end - start);
+            if (freeEntry != nullptr)
+            {
+                int blockNum = mapIndex * blockSize + (freeEntry - page);
+                setStaticBlockType(blockNum, REC);
+                allocMapFreeHint = blockNum + 1;
+                return blockNum;
+            }
+        }
+
+        allocMapFreeHint = Disk::getNumBlocks();
+        int ret = growAllocMap();
+        if (ret != SUCCESS)
+        {
+            return ret;
+        }
+    }
+}
+
+/* Returns the mapIndex'th page of the block allocation map, reading it from
+   the disk the first time it is used. The caller must hold allocMapLock. */
+unsigned char *StaticBuffer::getAllocMapPage(int mapIndex)
+{
+    if (allocMapPages[mapIndex] == nullptr)
+    {
+        allocMapPages[mapIndex] = new unsigned char[Disk::getBlockSize()];
+        Disk::readBlock(allocMapPages[mapIndex], Disk::getMapBlock(mapIndex));
+    }
+    return allocMapPages[mapIndex];
+}
+
+/* Grows the disk by a chunk and extends the block allocation map to cover it:
+   the new blocks are marked unused, except the blocks the disk took for new
+   map pages. The caller must hold allocMapLock. */
+int StaticBuffer::growAllocMap()
+{
+    const int oldNumBlocks = Disk::getNumBlocks();
+    const int oldNumMapBlocks = Disk::getNumMapBlocks();
+
+    int ret = Disk::growDisk();
+    if (ret != SUCCESS)
+    {
+        return ret;
+    }
+
+    const int blockSize = Disk::getBlockSize();
+    for (int mapIndex = oldNumMapBlocks; mapIndex < Disk::getNumMapBlocks(); mapIndex++)
+    {
+        // entries past the end of the disk are never handed out
+        unsigned char *page = new unsigned char[blockSize];
+        memset(page, BMAP, blockSize);
+        allocMapPages.push_back(page);
+        allocMapDirty.push_back(true);
+        allocMapUnlogged.push_back(true);
+    }
+
+    for (int blockNum = oldNumBlocks; blockNum < Disk::getNumBlocks(); blockNum++)
+    {
+        setStaticBlockType(blockNum, UNUSED_BLK);
+    }
+    for (int mapIndex = oldNumMapBlocks; mapIndex < Disk::getNumMapBlocks(); mapIndex++)
+    {
+        setStaticBlockType(Disk::getMapBlock(mapIndex), BMAP);
+    }
+
+    // the map pages covering the new blocks must be on the disk before the
+    // superblock makes the new blocks part of it. The last old page may hold
+    // allocations that are not committed yet (see WriteAheadLog::appendUndo()).
+    logAllocMap();
+    if (oldNumMapBlocks > 0)
+    {
+        WriteAheadLog::appendUndo(Disk::getMapBlock(oldNumMapBlocks - 1));
+    }
+    WriteAheadLog::flush();
+    for (int mapIndex = max(oldNumMapBlocks - 1, 0); mapIndex < Disk::getNumMapBlocks(); mapIndex++)
+    {
+        Disk::writeBlock(getAllocMapPage(mapIndex), Disk::getMapBlock(mapIndex));
+    }
+    Disk::sync();
+
+    return Disk::writeSuperBlock();
+}
+
+/* Appends the after-image of a buffered block to the write-ahead log. The
+   caller holds the exclusive latch of the buffer. */
+int StaticBuffer::logBuffer(int bufferNum)
 {
-    // copy blockAllocMap blocks from buffer to disk(using writeblock() of disk)
-    // blocks 0 to 3
-    for (int blockNum = 0; blockNum < 4; blockNum++)
+    // record and index blocks carry their page LSN in the header
+    int32_t blockType = *(int32_t *)blocks[bufferNum];
+    bool hasPageLsn = blockType == REC || blockType == IND_INTERNAL || blockType == IND_LEAF;
+
+    if (metainfo[bufferNum].compressed)
     {
-        Disk::writeBlock(blockAllocMap + blockNum * BLOCK_SIZE, blockNum);
+        // the log holds the block as it is written to the disk
+        vector<unsigned char> block(Disk::getBlockSize());
+        compressBlock(blocks[bufferNum], block.data());
+        metainfo[bufferNum].lsn = WriteAheadLog::appendPage(metainfo[bufferNum].blockNum, block.data(), true);
+        memcpy(blocks[bufferNum] + PAGE_LSN_OFFSET, &metainfo[bufferNum].lsn, sizeof(int32_t));
     }
-    /*iterate through all the buffer blocks,
-      write back blocks with metainfo as free=false,dirty=true
-      using Disk::writeBlock()
-      */
+    else
+    {
+        metainfo[bufferNum].lsn = WriteAheadLog::appendPage(metainfo[bufferNum].blockNum, blocks[bufferNum], hasPageLsn);
+    }
+    metainfo[bufferNum].unlogged = false;
+    return metainfo[bufferNum].lsn;
+}
+
+/* Appends the after-image of every buffered block modified since it was last
+   logged to the write-ahead log and returns the number of blocks logged.
+   Unless `wait` is set, blocks latched by other threads are skipped; they are
+   logged by a later call. The caller must hold replacementLock. */
+int StaticBuffer::logModifiedBlocks(bool wait)
+{
+    int logged = 0;
+
     for (int bufferIndex = 0; bufferIndex < BUFFER_CAPACITY; bufferIndex++)
     {
-        if (!metainfo[bufferIndex].free && metainfo[bufferIndex].dirty)
+        if (metainfo[bufferIndex].free || !metainfo[bufferIndex].unlogged)
+        {
+            continue;
+        }
+
+        if (wait)
+        {
+            latches[bufferIndex].lock();
+        }
+        else if (!latches[bufferIndex].try_lock())
+        {
+            continue;
+        }
+
+        if (metainfo[bufferIndex].unlogged)
+        {
+            logBuffer(bufferIndex);
+            logged++;
+        }
+        latches[bufferIndex].unlock();
+    }
+
+    return logged;
+}
+
+/* Appends the block allocation map pages modified since they were last logged
+   to the write-ahead log and returns the number of pages logged */
+int StaticBuffer::logAllocMap()
+{
+    lock_guard<recursive_mutex> guard(allocMapLock);
+    int logged = 0;
+
+    for (int mapIndex = 0; mapIndex < (int)allocMapPages.size(); mapIndex++)
+    {
+        if (allocMapUnlogged[mapIndex])
         {
-            Disk::writeBlock(blocks[bufferIndex], metainfo[bufferIndex].blockNum);
+            WriteAheadLog::appendPage(Disk::getMapBlock(mapIndex), allocMapPages[mapIndex], false);
+            allocMapUnlogged[mapIndex] = false;
+            logged++;
         }
     }
-}
\ No newline at end of file
+
+    return logged;
+}
+
+/* Makes the changes of the command that just finished durable: every block it
+   modified is appended to the write-ahead log followed by a commit record, and
+   the log is flushed - right away if `force` is set, otherwise possibly together
+   with the commits of the next commands (group commit). The blocks themselves
+   reach the disk later, on eviction or at a checkpoint, so the cost depends on
+   the size of the change only.
+   Checkpoints once the log grows past WAL_CHECKPOINT_SIZE. */
+int StaticBuffer::commit(bool force)
+{
+    {
+        lock_guard<mutex> guard(commitLock);
+        {
+            lock_guard<mutex> replacement(replacementLock);
+            logModifiedBlocks(true);
+        }
+        logAllocMap();
+
+        // commands that modified nothing add nothing to the log
+        int ret = WriteAheadLog::commit(force);
+        if (ret != SUCCESS)
+        {
+            return ret;
+        }
+    }
+
+    if (WriteAheadLog::getSize() > WAL_CHECKPOINT_SIZE)
+    {
+        return checkpoint();
+    }
+    return SUCCESS;
+}
+
+/* Writes every modified block to the disk and empties the write-ahead log */
+int StaticBuffer::checkpoint()
+{
+    lock_guard<mutex> guard(commitLock);
+
+    // no buffer may be replaced or modified until the log is emptied
+    lock_guard<mutex> replacement(replacementLock);
+    for (int bufferIndex = 0; bufferIndex < BUFFER_CAPACITY; bufferIndex++)
+    {
+        latches[bufferIndex].lock();
+    }
+    lock_guard<recursive_mutex> allocMap(allocMapLock);
+
+    for (int bufferIndex = 0; bufferIndex < BUFFER_CAPACITY; bufferIndex++)
+    {
+        if (!metainfo[bufferIndex].free && metainfo[bufferIndex].unlogged)
+        {
+            logBuffer(bufferIndex);
+        }
+    }
+    logAllocMap();
+    WriteAheadLog::appendCommit();
+    int ret = WriteAheadLog::flush();
+
+    if (ret == SUCCESS)
+    {
+        for (int bufferIndex = 0; bufferIndex < BUFFER_CAPACITY; bufferIndex++)
+        {
+            if (!metainfo[bufferIndex].free && metainfo[bufferIndex].dirty)
+            {
+                writeBuffer(bufferIndex);
+                metainfo[bufferIndex].dirty = false;
+            }
+        }
+
+        for (int mapIndex = 0; mapIndex < (int)allocMapPages.size(); mapIndex++)
+        {
+            if (allocMapDirty[mapIndex])
+            {
+                Disk::writeBlock(allocMapPages[mapIndex], Disk::getMapBlock(mapIndex));
+                allocMapDirty[mapIndex] = false;
+            }
+        }
+
+        // the log can only be emptied once the blocks are durable on the disk
+        ret = Disk::sync();
+        if (ret == SUCCESS)
+        {
+            ret = WriteAheadLog::truncate();
+        }
+    }
+
+    for (int bufferIndex = 0; bufferIndex < BUFFER_CAPACITY; bufferIndex++)
+    {
+        latches[bufferIndex].unlock();
+    }
+    return ret;
+}
+
+// checkpoint all modified blocks on system exit
+StaticBuffer::~StaticBuffer()
+{
+    checkpoint();
+
+    for (int mapIndex = 0; mapIndex < (int)allocMapPages.size(); mapIndex++)
+    {
+        delete[] allocMapPages[mapIndex];
+    }
+    for (int bufferIndex = 0; bufferIndex < BUFFER_CAPACITY; bufferIndex++)
+    {
+        delete[] blocks[bufferIndex];
+    }
+}
@@ -1,33 +1,93 @@
 #ifndef NITCBASE_STATICBUFFER_H
 #define NITCBASE_STATICBUFFER_H
 
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
 #include "../Disk_Class/Disk.h"
 #include "../define/constants.h"
 
 struct BufferMetaInfo {
   bool free;
-  bool dirty;
+  bool dirty;     // modified since it was last written to the disk
+  bool unlogged;  // modified since it was last written to the write-ahead log
+  bool compressed;  // a record block of a compressed relation (see BlockCompression.h)
+  int lsn;        // LSN of the last log record of the block
   int blockNum;
-  int timeStamp;
+  std::atomic<int> pinCount;                   // number of threads using the buffer, a pinned buffer is never replaced
+  std::atomic<unsigned long long> lastAccess;  // value of the access clock when the buffer was last used
+};
+
+// one partition of the table mapping block numbers to the buffers holding them;
+// with a few dozen buffers a short array is searched faster than a hash table
+struct BufferPartition {
+  std::mutex lock;
+  int count;
+  int blockNums[BUFFER_CAPACITY];
+  int bufferNums[BUFFER_CAPACITY];
 };
 
+/*
+ * The buffer may be used by several threads at once. Each buffer has a
+ * reader/writer latch that is held while a block is read or modified, and a pin
+ * count that keeps it from being replaced meanwhile (see latchBlock()). Looking
+ * up a block only locks the partition of the mapping table the block hashes to;
+ * replacing a buffer on a miss is serialised by replacementLock.
+ *
+ * Lock order: commitLock, replacementLock, buffer latches, allocMapLock, then the
+ * lock of the write-ahead log. A thread holds at most one buffer latch at a time
+ * outside of commit() and checkpoint().
+ */
 class StaticBuffer {
   friend class BlockBuffer;
 
  private:
   // fields
-  static unsigned char blocks[BUFFER_CAPACITY][BLOCK_SIZE];
+  // blocks are sized from the disk geometry at startup, each large enough for
+  // the frame of a compressed record block
+  static unsigned char *blocks[BUFFER_CAPACITY];
   static struct BufferMetaInfo metainfo[BUFFER_CAPACITY];
-  static unsigned char blockAllocMap[DISK_BLOCKS];
+  static std::shared_mutex latches[BUFFER_CAPACITY];
+  static BufferPartition partitions[BUFFER_PARTITIONS];
+  static std::mutex replacementLock;
+  static std::mutex commitLock;
+  static std::atomic<unsigned long long> accessClock;
+
+  // the block allocation map is kept one map block (page) at a time; a page is
+  // read from the disk the first time it is used and written back if dirty
+  static std::vector<unsigned char *> allocMapPages;
+  static std::vector<bool> allocMapDirty;
+  static std::vector<bool> allocMapUnlogged;
+  static int allocMapFreeHint;  // no block below this one is unused
+  static std::recursive_mutex allocMapLock;
 
   // methods
+  static int latchBlock(int blockNum, bool exclusive, bool load);
+  static void unlatchBlock(int bufferNum, bool exclusive);
+  static int pinIfBuffered(int blockNum);
+  static int findMapping(BufferPartition &partition, int blockNum);
   static int getFreeBuffer(int blockNum);
   static int getBufferNum(int blockNum);
+  static void freeBuffer(int blockNum);
+  static void readBuffer(int bufferNum, int blockNum);
+  static void writeBuffer(int bufferNum);
+  static unsigned char *getAllocMapPage(int mapIndex);
+  static int growAllocMap();
+  static int logBuffer(int bufferNum);
+  static int logModifiedBlocks(bool wait);
+  static int logAllocMap();
 
  public:
   // methods
   static int getStaticBlockType(int blockNum);
+  static int setStaticBlockType(int blockNum, int blockType);
+  static int getFreeBlockNum();
   static int setDirtyBit(int blockNum);
+  static void markDirty(int bufferNum);
+  static int commit(bool force);
+  static int checkpoint();
   StaticBuffer();
   ~StaticBuffer();
 };
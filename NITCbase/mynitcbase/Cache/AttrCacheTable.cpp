@@ -1,14 +1,18 @@
 #include "AttrCacheTable.h"
 
+#include <algorithm>
 #include <cstring>
 
 AttrCacheEntry *AttrCacheTable::attrCache[MAX_OPEN];
+std::shared_mutex AttrCacheTable::cacheLock;
 
 /* returns the attrOffset-th attribute for the relation corresponding to relId
 NOTE: this function expects the caller to allocate memory for `*attrCatBuf`
 */
 int AttrCacheTable::getAttrCatEntry(int relId, int attrOffset, AttrCatEntry *attrCatBuf)
 {
+    std::shared_lock<std::shared_mutex> guard(cacheLock);
+
     // check if 0 <= relId < MAX_OPEN and return E_OUTOFBOUND otherwise
     if (relId < 0 || relId >= MAX_OPEN)
     {
@@ -43,6 +47,8 @@ NOTE: this function expects the caller to allocate memory for `*attrCatBuf`
 */
 int AttrCacheTable::getAttrCatEntry(int relId, char attrName[ATTR_SIZE], AttrCatEntry *attrCatBuf)
 {
+    std::shared_lock<std::shared_mutex> guard(cacheLock);
+
 
     // check that relId is valid and corresponds to an open relation
     if (relId < 0 || relId >= MAX_OPEN)
@@ -70,6 +76,8 @@ int AttrCacheTable::getAttrCatEntry(int relId, char attrName[ATTR_SIZE], AttrCat
 }
 int AttrCacheTable::setAttrCatEntry(int relId, char attrName[ATTR_SIZE], AttrCatEntry *attrCatBuf)
 {
+    std::unique_lock<std::shared_mutex> guard(cacheLock);
+
 
     if (relId < 0 || relId >= MAX_OPEN)
     {
@@ -102,6 +110,8 @@ int AttrCacheTable::setAttrCatEntry(int relId, char attrName[ATTR_SIZE], AttrCat
 
 int AttrCacheTable::setAttrCatEntry(int relId, int attrOffset, AttrCatEntry *attrCatBuf)
 {
+    std::unique_lock<std::shared_mutex> guard(cacheLock);
+
 
     if (relId < 0 || relId >= MAX_OPEN)
     {
@@ -137,133 +147,28 @@ int AttrCacheTable::setAttrCatEntry(int relId, int attrOffset, AttrCatEntry *att
     This function will convert that to a struct AttrCatEntry type.
 */
 
-int AttrCacheTable::getSearchIndex(int relId, char attrName[ATTR_SIZE], IndexId *searchIndex)
-{
-
-    if (relId < 0 || relId >= MAX_OPEN)
-    {
-        return E_OUTOFBOUND;
-    }
-
-    if (attrCache[relId] == nullptr)
-    {
-        return E_RELNOTOPEN;
-    }
-
-    for (AttrCacheEntry *entry = attrCache[relId]; entry != nullptr; entry = entry->next)
-    {
-        if (strcmp(entry->attrCatEntry.attrName, attrName) == 0)
-        {
-            *searchIndex = entry->searchIndex;
-            return SUCCESS;
-        }
-    }
-
-    return E_ATTRNOTEXIST;
-}
-
-int AttrCacheTable::getSearchIndex(int relId, int attrOffset, IndexId *searchIndex)
-{
-
-    if (relId < 0 || relId >= MAX_OPEN)
-    {
-        return E_OUTOFBOUND;
-    }
-
-    if (attrCache[relId] == nullptr)
-    {
-        return E_RELNOTOPEN;
-    }
-
-    for (AttrCacheEntry *entry = attrCache[relId]; entry != nullptr; entry = entry->next)
-    {
-        if (entry->attrCatEntry.offset == attrOffset)
-        {
-            *searchIndex = entry->searchIndex;
-            return SUCCESS;
-        }
-    }
-
-    return E_ATTRNOTEXIST;
-}
-
-int AttrCacheTable::setSearchIndex(int relId, char attrName[ATTR_SIZE], IndexId *searchIndex)
-{
-
-    if (relId < 0 || relId >= MAX_OPEN)
-    {
-        return E_OUTOFBOUND;
-    }
-
-    if (attrCache[relId] == nullptr)
-    {
-        return E_RELNOTOPEN;
-    }
-
-    for (AttrCacheEntry *entry = attrCache[relId]; entry != nullptr; entry = entry->next)
-    {
-        if (strcmp(entry->attrCatEntry.attrName, attrName) == 0)
-        {
-            entry->searchIndex = *searchIndex;
-            return SUCCESS;
-        }
-    }
-
-    return E_ATTRNOTEXIST;
-}
-
-int AttrCacheTable::setSearchIndex(int relId, int attrOffset, IndexId *searchIndex)
+void AttrCacheTable::recordToAttrCatEntry(union Attribute record[ATTRCAT_NO_ATTRS],
+                                          AttrCatEntry *attrCatEntry)
 {
-
-    if (relId < 0 || relId >= MAX_OPEN)
+    strcpy(attrCatEntry->relName, record[ATTRCAT_REL_NAME_INDEX].sVal);
+    strcpy(attrCatEntry->attrName, record[ATTRCAT_ATTR_NAME_INDEX].sVal);
+    attrCatEntry->attrType = (int)record[ATTRCAT_ATTR_TYPE_INDEX].nVal;
+    // (the flag of an older disk, -1 or 1, is the default format)
+    attrCatEntry->format = (int)record[ATTRCAT_PRIMARY_FLAG_INDEX].nVal;
+    attrCatEntry->compressed = attrCatEntry->format >= FORMAT_COMPRESSED;
+    if (attrCatEntry->compressed)
     {
-        return E_OUTOFBOUND;
+        attrCatEntry->format -= FORMAT_COMPRESSED;
     }
-
-    if (attrCache[relId] == nullptr)
+    attrCatEntry->columnar = attrCatEntry->format >= FORMAT_COLUMNAR;
+    if (attrCatEntry->columnar)
     {
-        return E_RELNOTOPEN;
+        attrCatEntry->format -= FORMAT_COLUMNAR;
     }
-
-    for (AttrCacheEntry *entry = attrCache[relId]; entry != nullptr; entry = entry->next)
+    if (attrCatEntry->format < FORMAT_DOUBLE)
     {
-        if (entry->attrCatEntry.offset == attrOffset)
-        {
-            entry->searchIndex = *searchIndex;
-            return SUCCESS;
-        }
+        attrCatEntry->format = FORMAT_DEFAULT;
     }
-
-    return E_ATTRNOTEXIST;
-}
-
-int AttrCacheTable::resetSearchIndex(int relId, char attrName[ATTR_SIZE])
-{
-
-    // declare an IndexId having value {-1, -1}
-    // set the search index to {-1, -1} using AttrCacheTable::setSearchIndex
-    // return the value returned by setSearchIndex
-    IndexId searchIndex = {-1, -1};
-    return setSearchIndex(relId, attrName, &searchIndex);
-}
-
-int AttrCacheTable::resetSearchIndex(int relId, int attrOffset)
-{
-
-    // declare an IndexId having value {-1, -1}
-    // set the search index to {-1, -1} using AttrCacheTable::setSearchIndex
-    // return the value returned by setSearchIndex
-    IndexId searchIndex = {-1, -1};
-    return setSearchIndex(relId, attrOffset, &searchIndex);
-}
-
-void AttrCacheTable::recordToAttrCatEntry(union Attribute record[ATTRCAT_NO_ATTRS],
-                                          AttrCatEntry *attrCatEntry)
-{
-    strcpy(attrCatEntry->relName, record[ATTRCAT_REL_NAME_INDEX].sVal);
-    strcpy(attrCatEntry->attrName, record[ATTRCAT_ATTR_NAME_INDEX].sVal);
-    attrCatEntry->attrType = (int)record[ATTRCAT_ATTR_TYPE_INDEX].nVal;
-    attrCatEntry->primaryFlag = (bool)record[ATTRCAT_PRIMARY_FLAG_INDEX].nVal;
     attrCatEntry->rootBlock = (int)record[ATTRCAT_ROOT_BLOCK_INDEX].nVal;
     attrCatEntry->offset = (int)record[ATTRCAT_OFFSET_INDEX].nVal;
 
@@ -275,7 +180,14 @@ void AttrCacheTable::attrCatEntryToRecord(AttrCatEntry *attrCatEntry, union Attr
     strcpy(record[ATTRCAT_REL_NAME_INDEX].sVal, attrCatEntry->relName);
     strcpy(record[ATTRCAT_ATTR_NAME_INDEX].sVal, attrCatEntry->attrName);
     record[ATTRCAT_ATTR_TYPE_INDEX].nVal = (double)attrCatEntry->attrType;
-    record[ATTRCAT_PRIMARY_FLAG_INDEX].nVal = (double)attrCatEntry->primaryFlag;
+    record[ATTRCAT_PRIMARY_FLAG_INDEX].nVal = (double)attrCatEntry->format;
+    if (attrCatEntry->columnar || attrCatEntry->compressed)
+    {
+        // (FORMAT_DEFAULT is stored as 0, so that it stays below FORMAT_DOUBLE)
+        record[ATTRCAT_PRIMARY_FLAG_INDEX].nVal = std::max(attrCatEntry->format, 0) +
+                                                  (attrCatEntry->columnar ? FORMAT_COLUMNAR : 0) +
+                                                  (attrCatEntry->compressed ? FORMAT_COMPRESSED : 0);
+    }
     record[ATTRCAT_ROOT_BLOCK_INDEX].nVal = (double)attrCatEntry->rootBlock;
     record[ATTRCAT_OFFSET_INDEX].nVal = (double)attrCatEntry->offset;
 
@@ -1,6 +1,8 @@
 #ifndef NITCBASE_ATTRCACHETABLE_H
 #define NITCBASE_ATTRCACHETABLE_H
 
+#include <shared_mutex>
+
 #include "../Buffer/BlockBuffer.h"
 #include "../define/constants.h"
 #include "../define/id.h"
@@ -9,7 +11,9 @@ typedef struct AttrCatEntry {
   char relName[ATTR_SIZE];
   char attrName[ATTR_SIZE];
   int attrType;
-  bool primaryFlag;
+  int format;     // the AttributeFormat, stored as the primary flag
+  bool columnar;    // the relation has columnar record blocks (stored with the format)
+  bool compressed;  // the relation has compressed record blocks (stored with the format)
   int rootBlock;
   int offset;
 
@@ -19,7 +23,6 @@ typedef struct AttrCacheEntry {
   AttrCatEntry attrCatEntry;
   bool dirty;
   RecId recId;
-  IndexId searchIndex;
   struct AttrCacheEntry *next;
 
 } AttrCacheEntry;
@@ -33,16 +36,11 @@ class AttrCacheTable {
   static int getAttrCatEntry(int relId, int attrOffset, AttrCatEntry *attrCatBuf);
   static int setAttrCatEntry(int relId, char attrName[ATTR_SIZE], AttrCatEntry *attrCatBuf);
   static int setAttrCatEntry(int relId, int attrOffset, AttrCatEntry *attrCatBuf);
-  static int getSearchIndex(int relId, char attrName[ATTR_SIZE], IndexId *searchIndex);
-  static int getSearchIndex(int relId, int attrOffset, IndexId *searchIndex);
-  static int setSearchIndex(int relId, char attrName[ATTR_SIZE], IndexId *searchIndex);
-  static int setSearchIndex(int relId, int attrOffset, IndexId *searchIndex);
-  static int resetSearchIndex(int relId, char attrName[ATTR_SIZE]);
-  static int resetSearchIndex(int relId, int attrOffset);
 
  private:
   // field
   static AttrCacheEntry *attrCache[MAX_OPEN];
+  static std::shared_mutex cacheLock;  // guards attrCache, entries are read and written under it
 
   // methods
   static void recordToAttrCatEntry(union Attribute record[ATTRCAT_NO_ATTRS], AttrCatEntry *attrCatEntry);
@@ -2,16 +2,21 @@
 #include <stdlib.h>
 #include <cstring>
 #include <stdio.h>
+#include <algorithm>
+#include <vector>
 
 OpenRelTableMetaInfo OpenRelTable::tableMetaInfo[MAX_OPEN];
+std::recursive_mutex OpenRelTable::openRelLock;
+unsigned int OpenRelTable::generation = 0;
 
 AttrCacheEntry *createLinkedList(int length)
 {
-    AttrCacheEntry *head = (AttrCacheEntry *)malloc(sizeof(AttrCacheEntry));
+    // entries start out zeroed, i.e. not dirty
+    AttrCacheEntry *head = (AttrCacheEntry *)calloc(1, sizeof(AttrCacheEntry));
     AttrCacheEntry *tail = head;
     for (int i = 1; i < length; i++)
     {
-        tail->next = (AttrCacheEntry *)malloc(sizeof(AttrCacheEntry));
+        tail->next = (AttrCacheEntry *)calloc(1, sizeof(AttrCacheEntry));
         tail = tail->next;
     }
     tail->next = nullptr;
@@ -44,8 +49,10 @@ OpenRelTable::OpenRelTable()
 
         struct RelCacheEntry relCacheEntry;
         RelCacheTable::recordToRelCatEntry(relCatRecord, &relCacheEntry.relCatEntry);
+        relCacheEntry.dirty = false;
         relCacheEntry.recId.block = RELCAT_BLOCK;
         relCacheEntry.recId.slot = i;
+        initRecordLayout(&relCacheEntry.layout, relCacheEntry.relCatEntry.numAttrs, nullptr);
 
         RelCacheTable::relCache[i] = (struct RelCacheEntry *)malloc(sizeof(RelCacheEntry));
         *(RelCacheTable::relCache[i]) = relCacheEntry;
@@ -86,6 +93,7 @@ OpenRelTable::OpenRelTable()
 
 int OpenRelTable::getRelId(char relName[ATTR_SIZE])
 {
+    std::lock_guard<std::recursive_mutex> guard(openRelLock);
     for (int i = 0; i < MAX_OPEN; i++)
     {
         if (!tableMetaInfo[i].free && strcmp(relName, tableMetaInfo[i].relName) == 0)
@@ -108,6 +116,8 @@ int OpenRelTable::getFreeOpenRelTableEntry()
 
 int OpenRelTable::openRel(char relName[ATTR_SIZE])
 {
+    std::lock_guard<std::recursive_mutex> guard(openRelLock);
+
     int exist = OpenRelTable::getRelId(relName);
 
     if (exist >= 0)
@@ -124,8 +134,8 @@ int OpenRelTable::openRel(char relName[ATTR_SIZE])
 
     Attribute relNameAttribute;
     memcpy(relNameAttribute.sVal, relName, ATTR_SIZE);
-    RelCacheTable::resetSearchIndex(RELCAT_RELID);
-    RecId relcatRecId = BlockAccess::linearSearch(RELCAT_RELID, (char *)RELCAT_ATTR_RELNAME, relNameAttribute, EQ);
+    ScanCursor relCatCursor;
+    RecId relcatRecId = BlockAccess::linearSearch(RELCAT_RELID, (char *)RELCAT_ATTR_RELNAME, relNameAttribute, EQ, &relCatCursor);
 
     if (relcatRecId.block == -1 && relcatRecId.slot == -1)
     {
@@ -140,19 +150,24 @@ int OpenRelTable::openRel(char relName[ATTR_SIZE])
 
     RelCacheTable::recordToRelCatEntry(record, &relCatEntry);
 
-    RelCacheTable::relCache[freeSlot] = (RelCacheEntry *)malloc(sizeof(RelCacheEntry));
+    RelCacheEntry *relCacheEntry = (RelCacheEntry *)malloc(sizeof(RelCacheEntry));
 
-    RelCacheTable::relCache[freeSlot]->recId = relcatRecId;
-    RelCacheTable::relCache[freeSlot]->relCatEntry = relCatEntry;
+    relCacheEntry->recId = relcatRecId;
+    relCacheEntry->relCatEntry = relCatEntry;
+    relCacheEntry->dirty = false;
 
     int numAttrs = relCatEntry.numAttrs;
     AttrCacheEntry *listHead = createLinkedList(numAttrs);
     AttrCacheEntry *node = listHead;
+    int formats[numAttrs];
+    std::fill(formats, formats + numAttrs, (int)FORMAT_DEFAULT);
+    bool columnar = false;
+    bool compressed = false;
 
-    RelCacheTable::resetSearchIndex(ATTRCAT_RELID);
+    ScanCursor attrCatCursor;
     while (true)
     {
-        RecId searchRes = BlockAccess::linearSearch(ATTRCAT_RELID, (char *)ATTRCAT_ATTR_RELNAME, relNameAttribute, EQ);
+        RecId searchRes = BlockAccess::linearSearch(ATTRCAT_RELID, (char *)ATTRCAT_ATTR_RELNAME, relNameAttribute, EQ, &attrCatCursor);
 
         if (searchRes.block != -1 && searchRes.slot != -1)
         {
@@ -167,13 +182,26 @@ int OpenRelTable::openRel(char relName[ATTR_SIZE])
 
             node->recId = searchRes;
             node->attrCatEntry = attrCatEntry;
+            formats[attrCatEntry.offset] = attrCatEntry.format;
+            columnar = attrCatEntry.columnar;
+            compressed = attrCatEntry.compressed;
             node = node->next;
         }
         else
             break;
     }
 
-    AttrCacheTable::attrCache[freeSlot] = listHead;
+    initRecordLayout(&relCacheEntry->layout, numAttrs, formats, columnar, compressed);
+
+    // the entries are only made visible to other threads once they are complete
+    {
+        std::unique_lock<std::shared_mutex> relCacheGuard(RelCacheTable::cacheLock);
+        RelCacheTable::relCache[freeSlot] = relCacheEntry;
+    }
+    {
+        std::unique_lock<std::shared_mutex> attrCacheGuard(AttrCacheTable::cacheLock);
+        AttrCacheTable::attrCache[freeSlot] = listHead;
+    }
 
     OpenRelTable::tableMetaInfo[freeSlot].free = false;
     memcpy(OpenRelTable::tableMetaInfo[freeSlot].relName, relCatEntry.relName, ATTR_SIZE);
@@ -189,46 +217,111 @@ int OpenRelTable::closeRel(int relId)
     if (relId < 0 || relId >= MAX_OPEN)
         return E_OUTOFBOUND;
 
+    std::lock_guard<std::recursive_mutex> guard(openRelLock);
+
     if (tableMetaInfo[relId].free == true)
         return E_RELNOTOPEN;
 
-    RelCacheEntry *relCacheEntry = RelCacheTable::relCache[relId];
+    // write the modified entries back and take them out of the caches
+    writeBack(relId);
 
-    if (relCacheEntry && relCacheEntry->dirty == true)
+    RelCacheEntry *relCacheEntry;
+    AttrCacheEntry *attrCacheHead;
+    {
+        std::unique_lock<std::shared_mutex> relCacheGuard(RelCacheTable::cacheLock);
+        relCacheEntry = RelCacheTable::relCache[relId];
+        RelCacheTable::relCache[relId] = nullptr;
+    }
     {
-        RecBuffer relCatBlock((relCacheEntry->recId).block);
+        std::unique_lock<std::shared_mutex> attrCacheGuard(AttrCacheTable::cacheLock);
+        attrCacheHead = AttrCacheTable::attrCache[relId];
+        AttrCacheTable::attrCache[relId] = nullptr;
+    }
 
-        RelCatEntry relCatEntry = relCacheEntry->relCatEntry;
-        Attribute record[RELCAT_NO_ATTRS];
+    free(relCacheEntry);
+    freeLinkedList(attrCacheHead);
 
-        RelCacheTable::relCatEntryToRecord(&relCatEntry, record);
+    tableMetaInfo[relId].free = true;
+    generation++;
+    return SUCCESS;
+}
 
-        relCatBlock.setRecord(record, (relCacheEntry->recId).slot);
-    }
+/* Changes whenever a relation is closed. A rel-id (and what was read from the
+   caches for it) stays valid for as long as the generation is unchanged, as a
+   relation can only be renamed, altered or deleted, and its rel-id reused,
+   after it is closed. */
+unsigned int OpenRelTable::getGeneration()
+{
+    std::lock_guard<std::recursive_mutex> guard(openRelLock);
+    return generation;
+}
 
-    free(relCacheEntry);
-    RelCacheTable::relCache[relId] = nullptr;
+/* Writes the modified catalog entries of every open relation (including the
+   catalogs themselves) back to the buffer, leaving the relations open. Called
+   before a commit so that the catalogs in the log match the data. */
+void OpenRelTable::writeBack()
+{
+    std::lock_guard<std::recursive_mutex> guard(openRelLock);
 
-    for (auto attrCacheEntry = AttrCacheTable::attrCache[relId]; attrCacheEntry != nullptr; attrCacheEntry = attrCacheEntry->next)
+    for (int relId = 0; relId < MAX_OPEN; relId++)
     {
-        if (attrCacheEntry && attrCacheEntry->dirty == true)
+        if (!tableMetaInfo[relId].free)
+            writeBack(relId);
+    }
+}
+
+/* Writes the modified catalog entries of the open relation relId back to the
+   buffer. The entries are copied out under the cache locks, so the blocks are
+   written without holding them. */
+void OpenRelTable::writeBack(int relId)
+{
+    bool relCatDirty = false;
+    RelCatEntry relCatEntry;
+    RecId relCatRecId;
+    {
+        std::unique_lock<std::shared_mutex> relCacheGuard(RelCacheTable::cacheLock);
+        RelCacheEntry *relCacheEntry = RelCacheTable::relCache[relId];
+        if (relCacheEntry && relCacheEntry->dirty == true)
         {
-            RecBuffer attrCatBlock((attrCacheEntry->recId).block);
+            relCatDirty = true;
+            relCatEntry = relCacheEntry->relCatEntry;
+            relCatRecId = relCacheEntry->recId;
+            relCacheEntry->dirty = false;
+        }
+    }
+
+    if (relCatDirty)
+    {
+        RecBuffer relCatBlock(relCatRecId.block);
 
-            AttrCatEntry attrCatEntry = attrCacheEntry->attrCatEntry;
-            Attribute record[ATTRCAT_NO_ATTRS];
+        Attribute record[RELCAT_NO_ATTRS];
+        RelCacheTable::relCatEntryToRecord(&relCatEntry, record);
 
-            AttrCacheTable::attrCatEntryToRecord(&attrCatEntry, record);
+        relCatBlock.setRecord(record, relCatRecId.slot);
+    }
 
-            attrCatBlock.setRecord(record, (attrCacheEntry->recId).slot);
+    std::vector<AttrCacheEntry> dirtyAttrs;
+    {
+        std::unique_lock<std::shared_mutex> attrCacheGuard(AttrCacheTable::cacheLock);
+        for (auto attrCacheEntry = AttrCacheTable::attrCache[relId]; attrCacheEntry != nullptr; attrCacheEntry = attrCacheEntry->next)
+        {
+            if (attrCacheEntry->dirty == true)
+            {
+                dirtyAttrs.push_back(*attrCacheEntry);
+                attrCacheEntry->dirty = false;
+            }
         }
     }
 
-    freeLinkedList(AttrCacheTable::attrCache[relId]);
-    AttrCacheTable::attrCache[relId] = nullptr;
+    for (AttrCacheEntry &attrCacheEntry : dirtyAttrs)
+    {
+        RecBuffer attrCatBlock((attrCacheEntry.recId).block);
 
-    tableMetaInfo[relId].free = true;
-    return SUCCESS;
+        Attribute record[ATTRCAT_NO_ATTRS];
+        AttrCacheTable::attrCatEntryToRecord(&attrCacheEntry.attrCatEntry, record);
+
+        attrCatBlock.setRecord(record, (attrCacheEntry.recId).slot);
+    }
 }
 
 OpenRelTable::~OpenRelTable()
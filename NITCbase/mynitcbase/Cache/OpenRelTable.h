@@ -1,6 +1,8 @@
 #ifndef NITCBASE_OPENRELTABLE_H
 #define NITCBASE_OPENRELTABLE_H
 
+#include <mutex>
+
 #include "../BlockAccess/BlockAccess.h"
 #include "../Buffer/BlockBuffer.h"
 #include "../define/constants.h"
@@ -21,13 +23,18 @@ class OpenRelTable {
   static int getRelId(char relName[ATTR_SIZE]);
   static int openRel(char relName[ATTR_SIZE]);
   static int closeRel(int relId);
+  static void writeBack();
+  static unsigned int getGeneration();
 
  private:
   // field
   static OpenRelTableMetaInfo tableMetaInfo[MAX_OPEN];
+  static std::recursive_mutex openRelLock;  // serialises opening, closing and writing back relations
+  static unsigned int generation;           // number of relations closed so far, see getGeneration()
 
   // method
   static int getFreeOpenRelTableEntry();
+  static void writeBack(int relId);
 };
 
 #endif  // NITCBASE_OPENRELTABLE_H
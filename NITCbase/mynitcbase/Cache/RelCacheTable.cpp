@@ -3,6 +3,8 @@
 #include <cstring>
 
 RelCacheEntry *RelCacheTable::relCache[MAX_OPEN];
+std::shared_mutex RelCacheTable::cacheLock;
+std::mutex RelCacheTable::relationLocks[MAX_OPEN];
 
 /*
 Get the relation catalog entry for the relation with rel-id `relId` from the cache
@@ -10,6 +12,8 @@ NOTE: this function expects the caller to allocate memory for `*relCatBuf`
 */
 int RelCacheTable::getRelCatEntry(int relId, RelCatEntry *relCatBuf)
 {
+    std::shared_lock<std::shared_mutex> guard(cacheLock);
+
     if (relId < 0 || relId >= MAX_OPEN)
     {
         return E_OUTOFBOUND;
@@ -29,6 +33,8 @@ int RelCacheTable::getRelCatEntry(int relId, RelCatEntry *relCatBuf)
 
 int RelCacheTable::setRelCatEntry(int relId, RelCatEntry *relCatBuf)
 {
+    std::unique_lock<std::shared_mutex> guard(cacheLock);
+
 
     if (relId < 0 || relId >= MAX_OPEN)
     {
@@ -51,6 +57,29 @@ int RelCacheTable::setRelCatEntry(int relId, RelCatEntry *relCatBuf)
     return SUCCESS;
 }
 
+/*
+Get the layout of the records of the relation with rel-id `relId`
+NOTE: this function expects the caller to allocate memory for `*layout`
+*/
+int RelCacheTable::getRecordLayout(int relId, RecordLayout *layout)
+{
+    std::shared_lock<std::shared_mutex> guard(cacheLock);
+
+    if (relId < 0 || relId >= MAX_OPEN)
+    {
+        return E_OUTOFBOUND;
+    }
+
+    if (relCache[relId] == nullptr)
+    {
+        return E_RELNOTOPEN;
+    }
+
+    *layout = relCache[relId]->layout;
+
+    return SUCCESS;
+}
+
 /* Converts a relation catalog record to RelCatEntry struct
     We get the record as Attribute[] from the BlockBuffer.getRecord() function.
     This function will convert that to a struct RelCatEntry type.
@@ -85,56 +114,9 @@ void RelCacheTable::relCatEntryToRecord(RelCatEntry *relCatEntry,
     record[RELCAT_NO_SLOTS_PER_BLOCK_INDEX].nVal = relCatEntry->numSlotsPerBlk;
 }
 
-/* will return the searchIndex for the relation corresponding to `relId
-NOTE: this function expects the caller to allocate memory for `*searchIndex`
-*/
-int RelCacheTable::getSearchIndex(int relId, RecId *searchIndex)
-{
-    // check if 0 <= relId < MAX_OPEN and return E_OUTOFBOUND otherwise
-    if (relId < 0 || relId >= MAX_OPEN)
-    {
-        return E_OUTOFBOUND;
-    }
-
-    // check if relCache[relId] == nullptr and return E_RELNOTOPEN if true
-    if (relCache[relId] == nullptr)
-    {
-        return E_RELNOTOPEN;
-    }
-
-    // copy the searchIndex field of the Relation Cache entry corresponding
-    //   to input relId to the searchIndex variable.
-    *searchIndex = relCache[relId]->searchIndex;
-    return SUCCESS;
-}
-
-// sets the searchIndex for the relation corresponding to relId
-int RelCacheTable::setSearchIndex(int relId, RecId *searchIndex)
-{
-
-    // check if 0 <= relId < MAX_OPEN and return E_OUTOFBOUND otherwise
-    if (relId < 0 || relId >= MAX_OPEN)
-    {
-        return E_OUTOFBOUND;
-    }
-
-    // check if relCache[relId] == nullptr and return E_RELNOTOPEN if true
-    if (relCache[relId] == nullptr)
-    {
-        return E_RELNOTOPEN;
-    }
-
-    // update the searchIndex value in the relCache for the relId to the searchIndex argument
-    relCache[relId]->searchIndex = *searchIndex;
-
-    return SUCCESS;
-}
-
-int RelCacheTable::resetSearchIndex(int relId)
+/* Returns the lock that serialises the threads modifying the relation with
+   rel-id `relId` (see BlockAccess::insert()). Readers do not take it. */
+std::mutex &RelCacheTable::getRelationLock(int relId)
 {
-    // use setSearchIndex to set the search index to {-1, -1}
-    RecId searchIndex;
-    searchIndex.block = -1;
-    searchIndex.slot = -1;
-    return RelCacheTable::setSearchIndex(relId, &searchIndex);
+    return relationLocks[relId];
 }
@@ -1,6 +1,9 @@
 #ifndef NITCBASE_RELCACHETABLE_H
 #define NITCBASE_RELCACHETABLE_H
 
+#include <mutex>
+#include <shared_mutex>
+
 #include "../Buffer/BlockBuffer.h"
 #include "../define/constants.h"
 #include "../define/id.h"
@@ -19,7 +22,7 @@ typedef struct RelCacheEntry {
   RelCatEntry relCatEntry;
   bool dirty;
   RecId recId;
-  RecId searchIndex;
+  RecordLayout layout;  // of the records, set when the relation is opened
 
 } RelCacheEntry;
 
@@ -30,13 +33,14 @@ class RelCacheTable {
   // methods
   static int getRelCatEntry(int relId, RelCatEntry *relCatBuf);
   static int setRelCatEntry(int relId, RelCatEntry *relCatBuf);
-  static int getSearchIndex(int relId, RecId *searchIndex);
-  static int setSearchIndex(int relId, RecId *searchIndex);
-  static int resetSearchIndex(int relId);
+  static int getRecordLayout(int relId, RecordLayout *layout);
+  static std::mutex &getRelationLock(int relId);
 
  private:
   // field
   static RelCacheEntry *relCache[MAX_OPEN];
+  static std::shared_mutex cacheLock;  // guards relCache, entries are read and written under it
+  static std::mutex relationLocks[MAX_OPEN];
 
   // methods
   static void recordToRelCatEntry(union Attribute record[RELCAT_NO_ATTRS], RelCatEntry *relCatEntry);
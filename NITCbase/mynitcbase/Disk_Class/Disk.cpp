@@ -1,39 +1,205 @@
 #include "Disk.h"
 
-#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 #include "../define/constants.h"
+#include "WriteAheadLog.h"
+
+int Disk::diskFd = -1;
+int Disk::blockSize = LEGACY_BLOCK_SIZE;
+std::atomic<int> Disk::numBlocks(LEGACY_DISK_BLOCKS);
+int Disk::formatVersion = 1;
+int Disk::diskId = 0;
+int Disk::checkpointLsn = 0;
+std::vector<int> Disk::mapBlocks;
 
 /*
- * Used to make a temporary copy of the disk contents before the starting of a new session.
- * This ensures that if the system has a forced shutdown during the course of the session,
- * the previous state of the disk is not lost.
+ * Opens the disk for the session and brings it up to date by replaying the
+ * write-ahead log left behind by an earlier session that did not shut down
+ * cleanly. Changes are written to the disk in place from here on; the log
+ * keeps them durable (see WriteAheadLog).
+ * A disk the XFS interface was upgrading when it was interrupted is half
+ * converted and is not opened; the interface puts the old disk back.
  */
 Disk::Disk() {
-  /* An efficient method to copy files */
-  /* Copy Disk to Disk Run Copy */
-  std::ifstream src(DISK_PATH, std::ios::binary);
-  std::ofstream dst(DISK_RUN_COPY_PATH, std::ios::binary);
-
-  dst << src.rdbuf();
-  src.close();
-  dst.close();
+  if (access(DISK_BACKUP_PATH, F_OK) == 0) {
+    std::cout << "An upgrade of the disk was interrupted: start the XFS interface to put the old disk back\n";
+    exit(1);
+  }
+
+  diskFd = open(DISK_PATH, O_RDWR);
+  if (diskFd < 0) {
+    std::cout << "Could not open the disk at " << DISK_PATH << "\n";
+    exit(1);
+  }
+
+  loadSuperBlock();
+  WriteAheadLog::open();
 }
 
 /*
- * Used to update the changes made to the disk on graceful termination of the latest session.
- * This ensures that these changes are visible in future sessions.
+ * Closes the disk and the log. The buffer has already checkpointed every
+ * change to the disk by the time this runs.
  */
 Disk::~Disk() {
-  /* An efficient method to copy files */
-  /* Copy Disk Run Copy to Disk */
-  std::ifstream src(DISK_RUN_COPY_PATH, std::ios::binary);
-  std::ofstream dst(DISK_PATH, std::ios::binary);
-
-  dst << src.rdbuf();
-  src.close();
-  dst.close();
+  WriteAheadLog::close();
+  close(diskFd);
+  diskFd = -1;
+}
+
+/*
+ * Reads the geometry of the disk (block size, number of blocks and the blocks
+ * holding the block allocation map) from the superblock. Disks formatted
+ * before the superblock was introduced have no magic string and are read
+ * with the legacy geometry.
+ */
+void Disk::loadSuperBlock() {
+  blockSize = LEGACY_BLOCK_SIZE;
+  numBlocks = LEGACY_DISK_BLOCKS;
+  formatVersion = 1;
+  diskId = 0;
+  checkpointLsn = 0;
+  mapBlocks.clear();
+
+  SuperBlock superBlock;
+  bool found = pread(diskFd, &superBlock, sizeof(SuperBlock), 0) == sizeof(SuperBlock) &&
+               memcmp(superBlock.magic, DISK_MAGIC, sizeof(superBlock.magic)) == 0;
+
+  if (found && superBlock.formatVersion <= DISK_FORMAT_VERSION && superBlock.blockSize >= MIN_BLOCK_SIZE &&
+      superBlock.blockSize <= MAX_BLOCK_SIZE) {
+    blockSize = superBlock.blockSize;
+    numBlocks = superBlock.numBlocks;
+    formatVersion = superBlock.formatVersion;
+    diskId = superBlock.diskId;
+    checkpointLsn = superBlock.checkpointLsn;
+
+    std::vector<int32_t> mapBlockNums(superBlock.numMapBlocks);
+    pread(diskFd, mapBlockNums.data(), superBlock.numMapBlocks * sizeof(int32_t),
+          (off_t)SUPERBLOCK * blockSize + HEADER_SIZE);
+    mapBlocks.assign(mapBlockNums.begin(), mapBlockNums.end());
+  } else {
+    if (found) {
+      std::cout << "Unsupported disk format version " << superBlock.formatVersion
+                << ", reading it as a legacy disk\n";
+    }
+    for (int i = 0; i < LEGACY_BLOCK_ALLOCATION_MAP_SIZE; i++) {
+      mapBlocks.push_back(i);
+    }
+  }
+}
+
+int Disk::getBlockSize() {
+  return blockSize;
+}
+
+int Disk::getNumBlocks() {
+  return numBlocks;
+}
+
+int Disk::getFormatVersion() {
+  return formatVersion;
+}
+
+int Disk::getNumMapBlocks() {
+  return mapBlocks.size();
+}
+
+// block number of the mapBlockIndex'th block of the block allocation map
+int Disk::getMapBlock(int mapBlockIndex) {
+  return mapBlocks[mapBlockIndex];
+}
+
+int Disk::getDiskId() {
+  return diskId;
+}
+
+int Disk::getCheckpointLsn() {
+  return checkpointLsn;
+}
+
+// the superblock keeps the old LSN until writeSuperBlock() is called
+void Disk::setCheckpointLsn(int lsn) {
+  checkpointLsn = lsn;
+}
+
+/*
+ * Extends the disk by DISK_GROW_SIZE bytes (at least one block). Blocks needed for
+ * the block allocation map entries of the new blocks are taken from the start of the
+ * new region; they are the blocks getMapBlock() returns for the map indices past the
+ * old getNumMapBlocks(). The new blocks read as zeros.
+ * The new size is only recorded on the disk by writeSuperBlock(), which the caller
+ * does once the new map blocks are written. Legacy disks have no superblock to
+ * record the new size in and cannot grow.
+ * Returns SUCCESS, or E_DISKFULL if the disk cannot grow any further.
+ */
+int Disk::growDisk() {
+  if (formatVersion < 2) {
+    return E_DISKFULL;
+  }
+
+  // the superblock holds at most (blockSize - HEADER_SIZE) / 4 map block numbers
+  long long maxBlocks = (long long)(blockSize - HEADER_SIZE) / sizeof(int32_t) * blockSize;
+  if (maxBlocks > INT32_MAX) {
+    maxBlocks = INT32_MAX;
+  }
+  long long newNumBlocks = numBlocks + std::max(DISK_GROW_SIZE / blockSize, 1);
+  if (newNumBlocks > maxBlocks) {
+    newNumBlocks = maxBlocks;
+  }
+  if (newNumBlocks <= numBlocks) {
+    return E_DISKFULL;
+  }
+
+  if (ftruncate(diskFd, (off_t)newNumBlocks * blockSize) != 0) {
+    return E_DISKFULL;
+  }
+
+  const int numMapBlocks = (newNumBlocks + blockSize - 1) / blockSize;
+  for (int blockNum = numBlocks; (int)mapBlocks.size() < numMapBlocks; blockNum++) {
+    mapBlocks.push_back(blockNum);
+  }
+  numBlocks = newNumBlocks;
+
+  return SUCCESS;
+}
+
+/*
+ * Writes the current geometry of the disk to the superblock and syncs the disk
+ */
+int Disk::writeSuperBlock() {
+  SuperBlock superBlock;
+  memset(&superBlock, 0, sizeof(SuperBlock));
+  memcpy(superBlock.magic, DISK_MAGIC, sizeof(superBlock.magic));
+  superBlock.formatVersion = formatVersion;
+  superBlock.blockSize = blockSize;
+  superBlock.numBlocks = numBlocks;
+  superBlock.numMapBlocks = mapBlocks.size();
+  superBlock.diskId = diskId;
+  superBlock.checkpointLsn = checkpointLsn;
+
+  std::vector<int32_t> mapBlockNums(mapBlocks.begin(), mapBlocks.end());
+  pwrite(diskFd, &superBlock, sizeof(SuperBlock), (off_t)SUPERBLOCK * blockSize);
+  pwrite(diskFd, mapBlockNums.data(), mapBlockNums.size() * sizeof(int32_t),
+         (off_t)SUPERBLOCK * blockSize + HEADER_SIZE);
+
+  return sync();
+}
+
+/*
+ * Makes every block written so far durable
+ */
+int Disk::sync() {
+  if (fdatasync(diskFd) != 0) {
+    return FAILURE;
+  }
+  return SUCCESS;
 }
 
 /*
@@ -43,14 +209,11 @@ Disk::~Disk() {
  * blockNum - Block number of the disk block to be read.
  */
 int Disk::readBlock(unsigned char *block, int blockNum) {
-  FILE *disk = fopen(DISK_RUN_COPY_PATH, "rb");
-  if (blockNum < 0 || blockNum > DISK_BLOCKS - 1) {
+  if (blockNum < 0 || blockNum > numBlocks - 1) {
     return E_OUTOFBOUND;
   }
-  const int offset = blockNum * BLOCK_SIZE;
-  fseek(disk, offset, SEEK_SET);
-  fread(block, BLOCK_SIZE, 1, disk);
-  fclose(disk);
+  const off_t offset = (off_t)blockNum * blockSize;
+  pread(diskFd, block, blockSize, offset);
   return SUCCESS;
 }
 
@@ -61,13 +224,10 @@ int Disk::readBlock(unsigned char *block, int blockNum) {
  * blockNum - Block number of the disk block to be written into.
  */
 int Disk::writeBlock(unsigned char *block, int blockNum) {
-  FILE *disk = fopen(DISK_RUN_COPY_PATH, "rb+");
-  if (blockNum < 0 || blockNum > DISK_BLOCKS - 1) {
+  if (blockNum < 0 || blockNum > numBlocks - 1) {
     return E_OUTOFBOUND;
   }
-  const int offset = blockNum * BLOCK_SIZE;
-  fseek(disk, offset, SEEK_SET);
-  fwrite(block, BLOCK_SIZE, 1, disk);
-  fclose(disk);
+  const off_t offset = (off_t)blockNum * blockSize;
+  pwrite(diskFd, block, blockSize, offset);
   return SUCCESS;
 }
\ No newline at end of file
@@ -1,10 +1,59 @@
 #ifndef NITCBASE_H
 #define NITCBASE_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Layout of the superblock (block SUPERBLOCK of a disk of format version 2
+ * onwards). It is followed, at offset HEADER_SIZE, by numMapBlocks int32_t
+ * block numbers of the blocks holding the block allocation map, in order.
+ * A disk without the magic string is a legacy (version 1) disk.
+ *
+ * diskId is a random number FDISK gives every disk it formats; the write-ahead
+ * log carries it too, so that a log is never replayed onto another disk.
+ * checkpointLsn is the last LSN the write-ahead log had handed out at the last
+ * checkpoint, so that the LSN sequence continues past the page LSNs on the disk
+ * even if the log is lost. Both are 0 on a disk formatted before they existed.
+ */
+struct SuperBlock {
+  char magic[8];
+  int32_t formatVersion;
+  int32_t blockSize;
+  int32_t numBlocks;
+  int32_t numMapBlocks;
+  int32_t diskId;
+  int32_t checkpointLsn;
+};
+
 class Disk {
  public:
   Disk();
   ~Disk();
   static int readBlock(unsigned char *block, int blockNum);
   static int writeBlock(unsigned char *block, int blockNum);
+  static int sync();
+  static int getBlockSize();
+  static int getNumBlocks();
+  static int getFormatVersion();
+  static int getNumMapBlocks();
+  static int getMapBlock(int mapBlockIndex);
+  static int getDiskId();
+  static int getCheckpointLsn();
+  static void setCheckpointLsn(int lsn);
+  static int growDisk();
+  static int writeSuperBlock();
+
+ private:
+  static int diskFd;
+  static int blockSize;
+  static std::atomic<int> numBlocks;  // read by every thread, changed when the disk grows
+  static int formatVersion;
+  static int diskId;
+  static int checkpointLsn;
+  static std::vector<int> mapBlocks;
+
+  static void loadSuperBlock();
 };
-#endif  // NITCBASE_H
\ No newline at end of file
+#endif  // NITCBASE_H
@@ -0,0 +1,381 @@
+#include "WriteAheadLog.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "../define/constants.h"
+#include "Disk.h"
+
+int WriteAheadLog::logFd = -1;
+int WriteAheadLog::nextLsn = 1;
+int WriteAheadLog::flushedLsn = 0;
+int WriteAheadLog::committedLsn = 0;
+bool WriteAheadLog::uncommitted = false;
+std::unordered_set<int> WriteAheadLog::undoLogged;
+long long WriteAheadLog::size = 0;
+std::vector<unsigned char> WriteAheadLog::pending;
+std::recursive_mutex WriteAheadLog::logLock;
+int WriteAheadLog::commitDelay = COMMIT_DELAY;
+int WriteAheadLog::commitBatch = COMMIT_BATCH_SIZE;
+int WriteAheadLog::waitingCommits = 0;
+std::chrono::steady_clock::time_point WriteAheadLog::firstWaiting;
+long long WriteAheadLog::commitCount = 0;
+long long WriteAheadLog::fsyncCount = 0;
+std::chrono::steady_clock::time_point WriteAheadLog::firstCommit, WriteAheadLog::lastCommit;
+
+/*
+ * Opens the log, replays the records a previous session left behind onto the
+ * disk and starts an empty log. Must be called after the disk geometry is known.
+ * A log of another disk (one formatted again since) or of another block size is
+ * not replayed. The LSNs handed out from here on are greater than any a page of
+ * the disk may carry: the log, or else the superblock, has the last one used.
+ */
+int WriteAheadLog::open() {
+  logFd = ::open(DISK_WAL_PATH, O_RDWR | O_CREAT, 0644);
+  if (logFd < 0) {
+    std::cout << "Could not open the write-ahead log at " << DISK_WAL_PATH << "\n";
+    return FAILURE;
+  }
+
+  LogFileHeader header;
+  bool found = pread(logFd, &header, sizeof(LogFileHeader), 0) == sizeof(LogFileHeader) &&
+               memcmp(header.magic, WAL_MAGIC, sizeof(header.magic)) == 0;
+
+  nextLsn = 1;
+  if (found && header.diskId != Disk::getDiskId()) {
+    std::cout << "Ignoring a write-ahead log written for another disk\n";
+  } else if (found && header.blockSize != Disk::getBlockSize()) {
+    std::cout << "Ignoring a write-ahead log written for a block size of " << header.blockSize << "\n";
+  } else if (found) {
+    nextLsn = header.startLsn;
+    int replayed = replay();
+    if (replayed > 0) {
+      Disk::sync();
+      std::cout << "Recovered " << replayed << " block(s) from the write-ahead log\n";
+    }
+  }
+  nextLsn = std::max(nextLsn, Disk::getCheckpointLsn() + 1);
+
+  return truncate();
+}
+
+void WriteAheadLog::close() {
+  std::lock_guard<std::recursive_mutex> guard(logLock);
+  if (logFd >= 0) {
+    flush();
+    ::close(logFd);
+    logFd = -1;
+  }
+}
+
+/*
+ * Brings the disk to the state of the last commit record in the log and returns
+ * the number of blocks written. The log ends at the first torn or corrupt record,
+ * which is where the previous session stopped writing.
+ *
+ * The before-images logged after the last commit record are written back first,
+ * in reverse order so that the earliest image of a block is the one left. That
+ * takes back whatever the commands that did not commit wrote to the disk. The
+ * after-images up to the last commit record are then applied in order; a block
+ * is skipped if its page LSN shows the disk already holds this or a later image
+ * of it.
+ */
+int WriteAheadLog::replay() {
+  const int blockSize = Disk::getBlockSize();
+  std::vector<unsigned char> image(blockSize), onDisk(blockSize);
+  off_t offset = sizeof(LogFileHeader);
+  int replayed = 0;
+
+  // the complete records with their offsets, and how many of them the last
+  // commit record ends
+  std::vector<std::pair<LogRecordHeader, off_t>> records;
+  size_t numCommitted = 0;
+
+  LogRecordHeader record;
+  while (pread(logFd, &record, sizeof(LogRecordHeader), offset) == sizeof(LogRecordHeader)) {
+    if (record.lsn != nextLsn || record.length < 0 || record.length > blockSize) {
+      break;
+    }
+    if (pread(logFd, image.data(), record.length, offset + sizeof(LogRecordHeader)) != record.length) {
+      break;
+    }
+
+    uint32_t expected = record.checksum;
+    record.checksum = 0;
+    uint32_t hash = checksum((unsigned char *)&record, sizeof(LogRecordHeader), 2166136261u);
+    if (checksum(image.data(), record.length, hash) != expected) {
+      break;
+    }
+
+    records.push_back(std::make_pair(record, offset));
+    if (record.type == LOG_COMMIT) {
+      numCommitted = records.size();
+    }
+    nextLsn = record.lsn + 1;
+    offset += sizeof(LogRecordHeader) + record.length;
+  }
+
+  for (size_t i = records.size(); i > numCommitted; i--) {
+    const LogRecordHeader &undo = records[i - 1].first;
+    if (undo.type == LOG_UNDO && undo.length == blockSize && undo.blockNum < Disk::getNumBlocks()) {
+      pread(logFd, image.data(), blockSize, records[i - 1].second + sizeof(LogRecordHeader));
+      Disk::writeBlock(image.data(), undo.blockNum);
+      replayed++;
+    }
+  }
+
+  for (size_t i = 0; i < numCommitted; i++) {
+    const LogRecordHeader &page = records[i].first;
+    if (page.type != LOG_PAGE || page.length != blockSize || page.blockNum >= Disk::getNumBlocks()) {
+      continue;
+    }
+
+    int32_t diskLsn = 0;
+    if (page.hasPageLsn) {
+      Disk::readBlock(onDisk.data(), page.blockNum);
+      memcpy(&diskLsn, onDisk.data() + PAGE_LSN_OFFSET, sizeof(int32_t));
+    }
+    if (!page.hasPageLsn || diskLsn < page.lsn) {
+      pread(logFd, image.data(), blockSize, records[i].second + sizeof(LogRecordHeader));
+      Disk::writeBlock(image.data(), page.blockNum);
+      replayed++;
+    }
+  }
+
+  return replayed;
+}
+
+/*
+ * Queues the after-image of a block and returns the LSN given to it. For record
+ * and index blocks (hasPageLsn) the LSN is also stored in the block itself.
+ */
+int WriteAheadLog::appendPage(int blockNum, unsigned char *block, bool hasPageLsn) {
+  std::lock_guard<std::recursive_mutex> guard(logLock);
+  LogRecordHeader record;
+  record.type = LOG_PAGE;
+  record.lsn = nextLsn;
+  record.blockNum = blockNum;
+  record.length = Disk::getBlockSize();
+  record.hasPageLsn = hasPageLsn;
+
+  if (hasPageLsn) {
+    memcpy(block + PAGE_LSN_OFFSET, &record.lsn, sizeof(int32_t));
+  }
+
+  uncommitted = true;
+  return append(&record, block);
+}
+
+/*
+ * Queues the before-image of a block the buffer is about to write to the disk
+ * with changes that are not committed yet, and returns its LSN. The image is
+ * read from the disk, so this is called before the block is written. A block
+ * only needs the image it had at the last commit record: returns 0, queueing
+ * nothing, if it has one since.
+ */
+int WriteAheadLog::appendUndo(int blockNum) {
+  std::lock_guard<std::recursive_mutex> guard(logLock);
+  if (!undoLogged.insert(blockNum).second) {
+    return 0;
+  }
+
+  std::vector<unsigned char> image(Disk::getBlockSize());
+  Disk::readBlock(image.data(), blockNum);
+
+  LogRecordHeader record;
+  record.type = LOG_UNDO;
+  record.lsn = nextLsn;
+  record.blockNum = blockNum;
+  record.length = Disk::getBlockSize();
+  record.hasPageLsn = false;
+
+  uncommitted = true;
+  return append(&record, image.data());
+}
+
+/*
+ * Queues a commit record marking the end of a command's changes, unless no page
+ * was logged since the last one
+ */
+int WriteAheadLog::appendCommit() {
+  std::lock_guard<std::recursive_mutex> guard(logLock);
+  if (!uncommitted) {
+    return nextLsn - 1;
+  }
+  uncommitted = false;
+
+  LogRecordHeader record;
+  record.type = LOG_COMMIT;
+  record.lsn = nextLsn;
+  record.blockNum = INVALID_BLOCKNUM;
+  record.length = 0;
+  record.hasPageLsn = false;
+
+  committedLsn = record.lsn;
+  undoLogged.clear();
+  return append(&record, nullptr);
+}
+
+/*
+ * Ends the current command with a commit record and decides whether to make it
+ * durable now. Unless `force` is set, the fdatasync is put off until enough
+ * commits are waiting or the oldest one has waited long enough; any later
+ * forced commit, eviction or checkpoint flushes the waiting commits too.
+ */
+int WriteAheadLog::commit(bool force) {
+  std::lock_guard<std::recursive_mutex> guard(logLock);
+  if (uncommitted) {
+    appendCommit();
+
+    auto now = std::chrono::steady_clock::now();
+    if (commitCount == 0) {
+      firstCommit = now;
+    }
+    lastCommit = now;
+    commitCount++;
+
+    if (waitingCommits == 0) {
+      firstWaiting = now;
+    }
+    waitingCommits++;
+  }
+
+  if (pending.empty()) {
+    return SUCCESS;
+  }
+
+  if (!force && waitingCommits < commitBatch) {
+    auto waited = std::chrono::steady_clock::now() - firstWaiting;
+    if (std::chrono::duration_cast<std::chrono::microseconds>(waited).count() < commitDelay) {
+      return SUCCESS;
+    }
+  }
+
+  return flush();
+}
+
+int WriteAheadLog::append(LogRecordHeader *record, unsigned char *data) {
+  record->checksum = 0;
+  uint32_t hash = checksum((unsigned char *)record, sizeof(LogRecordHeader), 2166136261u);
+  record->checksum = checksum(data, record->length, hash);
+
+  pending.insert(pending.end(), (unsigned char *)record, (unsigned char *)record + sizeof(LogRecordHeader));
+  if (record->length > 0) {
+    pending.insert(pending.end(), data, data + record->length);
+  }
+
+  return nextLsn++;
+}
+
+/*
+ * Writes the queued records to the log and makes them durable with one fdatasync
+ */
+int WriteAheadLog::flush() {
+  std::lock_guard<std::recursive_mutex> guard(logLock);
+  if (pending.empty()) {
+    return SUCCESS;
+  }
+
+  if (pwrite(logFd, pending.data(), pending.size(), size) != (ssize_t)pending.size() || fdatasync(logFd) != 0) {
+    return FAILURE;
+  }
+
+  size += pending.size();
+  pending.clear();
+  flushedLsn = nextLsn - 1;
+  waitingCommits = 0;
+  fsyncCount++;
+  return SUCCESS;
+}
+
+/*
+ * Empties the log once every change in it has reached the disk (a checkpoint).
+ * The LSN sequence continues from where it was: the superblock records the last
+ * LSN handed out before the log that holds it is emptied (a legacy disk has no
+ * superblock to record it in).
+ */
+int WriteAheadLog::truncate() {
+  std::lock_guard<std::recursive_mutex> guard(logLock);
+  if (Disk::getFormatVersion() >= 2) {
+    Disk::setCheckpointLsn(nextLsn - 1);
+    if (Disk::writeSuperBlock() != SUCCESS) {
+      return FAILURE;
+    }
+  }
+
+  LogFileHeader header;
+  memset(&header, 0, sizeof(LogFileHeader));
+  memcpy(header.magic, WAL_MAGIC, sizeof(header.magic));
+  header.blockSize = Disk::getBlockSize();
+  header.startLsn = nextLsn;
+  header.diskId = Disk::getDiskId();
+
+  pending.clear();
+  if (ftruncate(logFd, 0) != 0 || pwrite(logFd, &header, sizeof(LogFileHeader), 0) != sizeof(LogFileHeader) ||
+      fdatasync(logFd) != 0) {
+    return FAILURE;
+  }
+
+  size = sizeof(LogFileHeader);
+  flushedLsn = nextLsn - 1;
+  committedLsn = nextLsn - 1;
+  undoLogged.clear();
+  waitingCommits = 0;
+  return SUCCESS;
+}
+
+int WriteAheadLog::getFlushedLsn() {
+  std::lock_guard<std::recursive_mutex> guard(logLock);
+  return flushedLsn;
+}
+
+// a block logged at this LSN or before is committed
+int WriteAheadLog::getCommittedLsn() {
+  std::lock_guard<std::recursive_mutex> guard(logLock);
+  return committedLsn;
+}
+
+// size of the log in bytes, including the records not flushed yet
+long long WriteAheadLog::getSize() {
+  std::lock_guard<std::recursive_mutex> guard(logLock);
+  return size + pending.size();
+}
+
+// changing a group commit setting also restarts the statistics
+void WriteAheadLog::setCommitDelay(int delay) {
+  std::lock_guard<std::recursive_mutex> guard(logLock);
+  commitDelay = delay;
+  commitCount = fsyncCount = 0;
+}
+
+void WriteAheadLog::setCommitBatch(int batch) {
+  std::lock_guard<std::recursive_mutex> guard(logLock);
+  commitBatch = batch;
+  commitCount = fsyncCount = 0;
+}
+
+/*
+ * Number of commits and log fdatasyncs so far, and the time in seconds from the
+ * first commit to the last
+ */
+void WriteAheadLog::getCommitStats(long long *commits, long long *fsyncs, double *seconds) {
+  std::lock_guard<std::recursive_mutex> guard(logLock);
+  *commits = commitCount;
+  *fsyncs = fsyncCount;
+  *seconds = 0;
+  if (commitCount > 0) {
+    *seconds = std::chrono::duration<double>(lastCommit - firstCommit).count();
+  }
+}
+
+// 32-bit FNV-1a hash of `length` bytes, continuing from `hash`
+uint32_t WriteAheadLog::checksum(const unsigned char *data, int length, uint32_t hash) {
+  for (int i = 0; i < length; i++) {
+    hash = (hash ^ data[i]) * 16777619u;
+  }
+  return hash;
+}
@@ -0,0 +1,109 @@
+#ifndef NITCBASE_WRITEAHEADLOG_H
+#define NITCBASE_WRITEAHEADLOG_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+/*
+ * Layout of the header at the start of the write-ahead log. startLsn is the LSN
+ * of the first record in the log; it carries the LSN sequence across checkpoints.
+ * diskId is the id of the disk the log belongs to (see SuperBlock).
+ */
+struct LogFileHeader {
+  char magic[8];
+  int32_t blockSize;
+  int32_t startLsn;
+  int32_t diskId;
+  unsigned char reserved[12];
+};
+
+/*
+ * Layout of the header of every record in the log. A LOG_PAGE record is followed
+ * by `length` bytes holding the after-image of block `blockNum`, a LOG_UNDO record
+ * by its before-image. The checksum covers the header (with checksum = 0) and the
+ * image.
+ */
+struct LogRecordHeader {
+  int32_t type;
+  int32_t lsn;
+  int32_t blockNum;
+  int32_t length;
+  int32_t hasPageLsn;  // the image carries its LSN at PAGE_LSN_OFFSET
+  uint32_t checksum;
+};
+
+enum LogRecordType
+{
+  LOG_PAGE = 1,
+  LOG_COMMIT = 2,
+  LOG_UNDO = 3
+};
+
+/*
+ * Redo log of whole-block after-images. A block is logged when a command that
+ * modified it commits, or before the buffer evicts it, so the log always holds
+ * a block's latest contents before the disk does. Records are collected in
+ * memory and written with one fdatasync by flush().
+ *
+ * A block the buffer evicts before the command that modified it commits is
+ * written to the disk with changes that are not committed. Before the first
+ * such write of a block since the last commit, the block as the disk holds it
+ * is logged as a before-image (appendUndo()). Replay writes the before-images
+ * logged after the last commit back first, then redoes the committed records,
+ * so a command that did not commit leaves nothing behind.
+ *
+ * commit() implements group commit: a commit that is not forced may wait for
+ * later commits to share its fdatasync, until commitBatch commits are waiting
+ * or the oldest of them has waited commitDelay microseconds.
+ *
+ * All methods may be called from several threads; they are serialised by logLock.
+ */
+class WriteAheadLog {
+ public:
+  static int open();
+  static void close();
+  static int appendPage(int blockNum, unsigned char *block, bool hasPageLsn);
+  static int appendUndo(int blockNum);
+  static int appendCommit();
+  static int commit(bool force);
+  static int flush();
+  static int truncate();
+  static int getFlushedLsn();
+  static int getCommittedLsn();
+  static long long getSize();
+
+  static void setCommitDelay(int delay);
+  static void setCommitBatch(int batch);
+  static void getCommitStats(long long *commits, long long *fsyncs, double *seconds);
+
+ private:
+  static int logFd;
+  static int nextLsn;
+  static int flushedLsn;
+  static int committedLsn;  // LSN of the last commit record
+  static bool uncommitted;  // pages were logged since the last commit record
+  static std::unordered_set<int> undoLogged;  // blocks with a before-image since the last commit record
+  static long long size;
+  static std::vector<unsigned char> pending;
+  static std::recursive_mutex logLock;
+
+  // group commit
+  static int commitDelay;  // in microseconds
+  static int commitBatch;
+  static int waitingCommits;  // commit records written since the last fdatasync
+  static std::chrono::steady_clock::time_point firstWaiting;
+
+  // statistics since startup or since the group commit settings last changed
+  static long long commitCount;
+  static long long fsyncCount;
+  static std::chrono::steady_clock::time_point firstCommit, lastCommit;
+
+  static int append(LogRecordHeader *header, unsigned char *data);
+  static int replay();
+  static uint32_t checksum(const unsigned char *data, int length, uint32_t hash);
+};
+
+#endif  // NITCBASE_WRITEAHEADLOG_H
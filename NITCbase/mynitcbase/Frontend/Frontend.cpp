@@ -1,12 +1,14 @@
 #include "Frontend.h"
+#include "../Disk_Class/WriteAheadLog.h"
 #include <iostream>
 #include <cstring>
 #include <iostream>
 
 using namespace std;
-int Frontend::create_table(char relname[ATTR_SIZE], int no_attrs, char attributes[][ATTR_SIZE], int type_attrs[])
+int Frontend::create_table(char relname[ATTR_SIZE], int no_attrs, char attributes[][ATTR_SIZE], int type_attrs[],
+                           int format_attrs[], bool columnar, bool compressed)
 {
-  return Schema::createRel(relname, no_attrs, attributes, type_attrs);
+  return Schema::createRel(relname, no_attrs, attributes, type_attrs, format_attrs, columnar, compressed);
 }
 
 int Frontend::drop_table(char relname[ATTR_SIZE])
@@ -43,6 +45,11 @@ int Frontend::create_index(char relname[ATTR_SIZE], char attrname[ATTR_SIZE])
   return Schema::createIndex(relname, attrname);
 }
 
+int Frontend::create_index(char relname[ATTR_SIZE], int attr_count, char attr_names[][ATTR_SIZE])
+{
+  return Schema::createIndex(relname, attr_count, attr_names);
+}
+
 int Frontend::drop_index(char relname[ATTR_SIZE], char attrname[ATTR_SIZE])
 {
   return Schema::dropIndex(relname, attrname);
@@ -53,6 +60,16 @@ int Frontend::insert_into_table_values(char relname[ATTR_SIZE], int attr_count,
   return Algebra::insert(relname, attr_count, attr_values);
 }
 
+int Frontend::insert_into_table_values(InsertPlan *plan, int attr_count, char attr_values[][ATTR_SIZE])
+{
+  return Algebra::insert(plan, attr_count, attr_values);
+}
+
+int Frontend::insert_into_table_from_file(char relname[ATTR_SIZE], const char *file_path, LoadStats *stats)
+{
+  return Algebra::load(relname, file_path, stats);
+}
+
 int Frontend::select_from_table(char relname_source[ATTR_SIZE], char relname_target[ATTR_SIZE])
 {
 
@@ -144,6 +161,69 @@ int Frontend::select_attrlist_from_join_where(
   return ret;
 }
 
+int Frontend::select_to_output(char relname_source[ATTR_SIZE], int attr_count, char attr_list[][ATTR_SIZE],
+                               char attribute[ATTR_SIZE], int op, char value[ATTR_SIZE],
+                               const char *file_path, int *row_count)
+{
+  // Algebra::stream
+  return Algebra::stream(relname_source, attr_count, attr_list, attribute, op, value, file_path, row_count);
+}
+
+int Frontend::select_aggregate(char relname_source[ATTR_SIZE], int func, char agg_attr[ATTR_SIZE],
+                               char group_attr[ATTR_SIZE], char attribute[ATTR_SIZE], int op,
+                               char value[ATTR_SIZE], int *row_count)
+{
+  // Algebra::aggregate
+  return Algebra::aggregate(relname_source, func, agg_attr, group_attr, attribute, op, value, row_count);
+}
+
+int Frontend::benchmark_scan(char relname_source[ATTR_SIZE], int num_threads, long long *records_read, double *seconds)
+{
+  // Algebra::benchmarkScan
+  return Algebra::benchmarkScan(relname_source, num_threads, records_read, seconds);
+}
+
+int Frontend::commit(bool force)
+{
+  // write the cached catalog entries back to their blocks, then log every modified block
+  OpenRelTable::writeBack();
+  return StaticBuffer::commit(force);
+}
+
+int Frontend::set_commit_delay(int delay)
+{
+  WriteAheadLog::setCommitDelay(delay);
+  return SUCCESS;
+}
+
+int Frontend::set_commit_batch(int batch)
+{
+  if (batch < 1)
+  {
+    return E_INVALID;
+  }
+  WriteAheadLog::setCommitBatch(batch);
+  return SUCCESS;
+}
+
+int Frontend::commit_stats(long long *commits, long long *fsyncs, double *seconds)
+{
+  WriteAheadLog::getCommitStats(commits, fsyncs, seconds);
+  return SUCCESS;
+}
+
+int Frontend::set_scan_threads(int num_threads)
+{
+  // Algebra::setScanThreads
+  return Algebra::setScanThreads(num_threads);
+}
+
+int Frontend::scheduler_stats(std::vector<WorkerStats> *stats)
+{
+  TaskScheduler::getWorkerStats(stats);
+  return SUCCESS;
+}
+
 int Frontend::custom_function(int argc, char argv[][ATTR_SIZE])
 {
   // argc gives the size of the argv array
@@ -3,12 +3,14 @@
 
 #include "../Algebra/Algebra.h"
 #include "../Schema/Schema.h"
+#include "../Scheduler/TaskScheduler.h"
 #include "../define/constants.h"
 
 class Frontend {
  public:
   // DDL
-  static int create_table(char relname[ATTR_SIZE], int no_attrs, char attributes[][ATTR_SIZE], int type_attrs[]);
+  static int create_table(char relname[ATTR_SIZE], int no_attrs, char attributes[][ATTR_SIZE], int type_attrs[],
+                          int format_attrs[] = nullptr, bool columnar = false, bool compressed = false);
 
   static int drop_table(char relname[ATTR_SIZE]);
 
@@ -18,6 +20,8 @@ class Frontend {
 
   static int create_index(char relname[ATTR_SIZE], char attrname[ATTR_SIZE]);
 
+  static int create_index(char relname[ATTR_SIZE], int attr_count, char attr_names[][ATTR_SIZE]);
+
   static int drop_index(char relname[ATTR_SIZE], char attrname[ATTR_SIZE]);
 
   static int alter_table_rename(char relname_from[ATTR_SIZE], char relname_to[ATTR_SIZE]);
@@ -27,6 +31,10 @@ class Frontend {
   // DML
   static int insert_into_table_values(char relname[ATTR_SIZE], int attr_count, char attr_values[][ATTR_SIZE]);
 
+  static int insert_into_table_values(InsertPlan *plan, int attr_count, char attr_values[][ATTR_SIZE]);
+
+  static int insert_into_table_from_file(char relname[ATTR_SIZE], const char *file_path, LoadStats *stats);
+
   static int select_from_table(char relname_source[ATTR_SIZE], char relname_target[ATTR_SIZE]);
 
   static int select_attrlist_from_table(char relname_source[ATTR_SIZE], char relname_target[ATTR_SIZE],
@@ -48,7 +56,31 @@ class Frontend {
                                              char join_attr_one[ATTR_SIZE], char join_attr_two[ATTR_SIZE],
                                              int attr_count, char attr_list[][ATTR_SIZE]);
 
+  static int select_to_output(char relname_source[ATTR_SIZE], int attr_count, char attr_list[][ATTR_SIZE],
+                              char attribute[ATTR_SIZE], int op, char value[ATTR_SIZE],
+                              const char *file_path, int *row_count);
+
+  static int select_aggregate(char relname_source[ATTR_SIZE], int func, char agg_attr[ATTR_SIZE],
+                              char group_attr[ATTR_SIZE], char attribute[ATTR_SIZE], int op,
+                              char value[ATTR_SIZE], int *row_count);
+
   static int custom_function(int argc, char argv[][ATTR_SIZE]);
+
+  // Durability
+  static int commit(bool force);
+
+  static int set_commit_delay(int delay);
+
+  static int set_commit_batch(int batch);
+
+  static int commit_stats(long long *commits, long long *fsyncs, double *seconds);
+
+  // Parallel scans
+  static int benchmark_scan(char relname_source[ATTR_SIZE], int num_threads, long long *records_read, double *seconds);
+
+  static int set_scan_threads(int num_threads);
+
+  static int scheduler_stats(std::vector<WorkerStats> *stats);
 };
 
 #endif  // FRONTEND_INTERFACE_FRONTEND_H
@@ -1,6 +1,8 @@
 // clang-format off
+#include <chrono>
 #include <cstring>
 #include <fstream>
+#include <functional>
 #include <string>
 #include <iostream>
 #include <readline/history.h>
@@ -15,22 +17,13 @@
 
 using namespace std;
 
-int getOperator(string op_str);
-
 void attrToTruncatedArray(string nameString, char *nameArray);
+void valueToArray(const string &value, char *valueArray);
 
 void printErrorMsg(int error);
 
 void printHelp();
 
-// extract tokens delimited by whitespace and comma
-vector<string> RegexHandler::extractTokens(string input) {
-  regex re("\\s*,\\s*|\\s+");
-  sregex_token_iterator first(input.begin(), input.end(), re, -1), last;
-  vector<string> tokens(first, last);
-  return tokens;
-}
-
 // handler functions
 int RegexHandler::helpHandler() {
   printHelp();
@@ -42,13 +35,12 @@ int RegexHandler::exitHandler() {
 };
 
 int RegexHandler::echoHandler() {
-  string message = m[1];
-  cout << message << endl;
+  cout << stmt->text << endl;
   return SUCCESS;
 }
 
 int RegexHandler::runHandler() {
-  string fileName = m[1];
+  string fileName = stmt->file;
   const string filePath = BATCH_FILES_PATH;
   fstream commandsFile;
   commandsFile.open(filePath + fileName, ios::in);
@@ -59,6 +51,7 @@ int RegexHandler::runHandler() {
   }
 
   int lineNumber = 1;
+  runDepth++;
   while (getline(commandsFile, command)) {
     int ret = this->handle(command);
     if (ret == EXIT) {
@@ -70,15 +63,78 @@ int RegexHandler::runHandler() {
     }
     lineNumber++;
   }
+  runDepth--;
 
   commandsFile.close();
 
   return SUCCESS;  // error messages if any will be printed in recursive call to handle
 }
 
+int RegexHandler::setCommitHandler() {
+  string setting = stmt->text;
+  int value = stmt->number;
+
+  int ret;
+  if (toupper(setting[0]) == 'D') {
+    ret = Frontend::set_commit_delay(value);
+  } else {
+    ret = Frontend::set_commit_batch(value);
+  }
+  if (ret == SUCCESS) {
+    cout << "Commit " << setting << " set to " << value << "\n";
+  }
+  return ret;
+}
+
+int RegexHandler::showCommitStatsHandler() {
+  long long commits, fsyncs;
+  double seconds;
+  int ret = Frontend::commit_stats(&commits, &fsyncs, &seconds);
+  if (ret != SUCCESS) {
+    return ret;
+  }
+
+  cout << "Commits: " << commits << ", fsyncs: " << fsyncs;
+  if (fsyncs > 0) {
+    printf(" (%.1f commits per fsync)", (double)commits / fsyncs);
+  }
+  if (seconds > 0) {
+    printf(", %.0f commits/s", commits / seconds);
+  }
+  cout << endl;
+  return SUCCESS;
+}
+
+int RegexHandler::setScanThreadsHandler() {
+  int numThreads = stmt->number;
+  int ret = Frontend::set_scan_threads(numThreads);
+  if (ret == SUCCESS) {
+    if (numThreads == 0) {
+      cout << "Scans use one thread per core\n";
+    } else {
+      cout << "Scans use " << numThreads << " thread(s)\n";
+    }
+  }
+  return ret;
+}
+
+int RegexHandler::showSchedulerStatsHandler() {
+  std::vector<WorkerStats> stats;
+  int ret = Frontend::scheduler_stats(&stats);
+  if (ret != SUCCESS) {
+    return ret;
+  }
+
+  for (size_t i = 0; i < stats.size(); i++) {
+    printf("Thread %zu%s: %lld tasks, %lld stolen, busy %.3f s (%.1f%%)\n", i, i == 0 ? " (statement)" : "",
+           stats[i].tasks, stats[i].steals, stats[i].busySeconds, stats[i].utilization * 100);
+  }
+  return SUCCESS;
+}
+
 int RegexHandler::openHandler() {
   char relName[ATTR_SIZE];
-  attrToTruncatedArray(m[1], relName);
+  attrToTruncatedArray(stmt->relation, relName);
 
   int ret = Frontend::open_table(relName);
   if (ret == SUCCESS) {
@@ -89,7 +145,7 @@ int RegexHandler::openHandler() {
 
 int RegexHandler::closeHandler() {
   char relName[ATTR_SIZE];
-  attrToTruncatedArray(m[1], relName);
+  attrToTruncatedArray(stmt->relation, relName);
 
   int ret = Frontend::close_table(relName);
   if (ret == SUCCESS) {
@@ -101,28 +157,26 @@ int RegexHandler::closeHandler() {
 
 int RegexHandler::createTableHandler() {
   char relName[ATTR_SIZE];
-  attrToTruncatedArray(m[1], relName);
+  attrToTruncatedArray(stmt->relation, relName);
 
-  vector<string> words = extractTokens(m[2]);
+  int attrCount = stmt->attrs.size();
 
-  int attrCount = words.size() / 2;
-
-  if (attrCount > 125) {
+  if (attrCount > MAX_ATTRS) {
     return E_MAXATTRS;
   }
 
   char attrNames[attrCount][ATTR_SIZE];
   int attrTypes[attrCount];
+  int attrFormats[attrCount];
 
-  for (int i = 0, k = 0; i < attrCount; i++, k += 2) {
-    attrToTruncatedArray(words[k], attrNames[i]);
-    if (words[k + 1] == "STR")
-      attrTypes[i] = STRING;
-    else if (words[k + 1] == "NUM")
-      attrTypes[i] = NUMBER;
+  for (int i = 0; i < attrCount; i++) {
+    attrToTruncatedArray(stmt->attrs[i], attrNames[i]);
+    attrTypes[i] = stmt->attrTypes[i];
+    attrFormats[i] = stmt->attrFormats[i];
   }
 
-  int ret = Frontend::create_table(relName, attrCount, attrNames, attrTypes);
+  int ret = Frontend::create_table(relName, attrCount, attrNames, attrTypes, attrFormats, stmt->columnar,
+                                   stmt->compressed);
   if (ret == SUCCESS) {
     cout << "Relation " << relName << " created successfully" << endl;
   }
@@ -132,7 +186,7 @@ int RegexHandler::createTableHandler() {
 
 int RegexHandler::dropTableHandler() {
   char relName[ATTR_SIZE];
-  attrToTruncatedArray(m[1], relName);
+  attrToTruncatedArray(stmt->relation, relName);
 
   int ret = Frontend::drop_table(relName);
   if (ret == SUCCESS) {
@@ -144,8 +198,8 @@ int RegexHandler::dropTableHandler() {
 int RegexHandler::createIndexHandler() {
   char relName[ATTR_SIZE], attrName[ATTR_SIZE];
 
-  attrToTruncatedArray(m[1], relName);
-  attrToTruncatedArray(m[2], attrName);
+  attrToTruncatedArray(stmt->relation, relName);
+  attrToTruncatedArray(stmt->attribute, attrName);
 
   int ret = Frontend::create_index(relName, attrName);
   if (ret == SUCCESS) {
@@ -155,10 +209,28 @@ int RegexHandler::createIndexHandler() {
   return ret;
 }
 
+int RegexHandler::createMultiIndexHandler() {
+  char relName[ATTR_SIZE];
+  attrToTruncatedArray(stmt->relation, relName);
+
+  int attrCount = stmt->attrs.size();
+  char attrNames[attrCount][ATTR_SIZE];
+  for (int i = 0; i < attrCount; i++) {
+    attrToTruncatedArray(stmt->attrs[i], attrNames[i]);
+  }
+
+  int ret = Frontend::create_index(relName, attrCount, attrNames);
+  if (ret == SUCCESS) {
+    cout << "Indexes created successfully\n";
+  }
+
+  return ret;
+}
+
 int RegexHandler::dropIndexHandler() {
   char relName[ATTR_SIZE], attrName[ATTR_SIZE];
-  attrToTruncatedArray(m[1], relName);
-  attrToTruncatedArray(m[2], attrName);
+  attrToTruncatedArray(stmt->relation, relName);
+  attrToTruncatedArray(stmt->attribute, attrName);
 
   int ret = Frontend::drop_index(relName, attrName);
   if (ret == SUCCESS) {
@@ -171,8 +243,8 @@ int RegexHandler::dropIndexHandler() {
 int RegexHandler::renameTableHandler() {
   char oldRelName[ATTR_SIZE];
   char newRelName[ATTR_SIZE];
-  attrToTruncatedArray(m[1], oldRelName);
-  attrToTruncatedArray(m[2], newRelName);
+  attrToTruncatedArray(stmt->relation, oldRelName);
+  attrToTruncatedArray(stmt->target, newRelName);
 
   int ret = Frontend::alter_table_rename(oldRelName, newRelName);
   if (ret == SUCCESS) {
@@ -186,9 +258,9 @@ int RegexHandler::renameColumnHandler() {
   char relName[ATTR_SIZE];
   char oldColName[ATTR_SIZE];
   char newColName[ATTR_SIZE];
-  attrToTruncatedArray(m[1], relName);
-  attrToTruncatedArray(m[2], oldColName);
-  attrToTruncatedArray(m[3], newColName);
+  attrToTruncatedArray(stmt->relation, relName);
+  attrToTruncatedArray(stmt->attribute, oldColName);
+  attrToTruncatedArray(stmt->target, newColName);
 
   int ret = Frontend::alter_table_rename_column(relName, oldColName, newColName);
   if (ret == SUCCESS) {
@@ -200,14 +272,12 @@ int RegexHandler::renameColumnHandler() {
 
 int RegexHandler::insertSingleHandler() {
   char relName[ATTR_SIZE];
-  attrToTruncatedArray(m[1], relName);
-
-  vector<string> words = extractTokens(m[2]);
+  attrToTruncatedArray(stmt->relation, relName);
 
-  int attrCount = words.size();
+  int attrCount = stmt->values.size();
   char attrValues[attrCount][ATTR_SIZE];
   for (int i = 0; i < attrCount; ++i) {
-    attrToTruncatedArray(words[i], attrValues[i]);
+    valueToArray(stmt->values[i], attrValues[i]);
   }
 
   int ret = Frontend::insert_into_table_values(relName, attrCount, attrValues);
@@ -220,9 +290,9 @@ int RegexHandler::insertSingleHandler() {
 
 int RegexHandler::insertFromFileHandler() {
   char relName[ATTR_SIZE];
-  attrToTruncatedArray(m[1], relName);
+  attrToTruncatedArray(stmt->relation, relName);
 
-  string filePath = string(INPUT_FILES_PATH) + m[2].str();
+  string filePath = string(INPUT_FILES_PATH) + stmt->file;
   std::cout << "File path: " << filePath << endl;
 
   ifstream file(filePath);
@@ -230,64 +300,24 @@ int RegexHandler::insertFromFileHandler() {
     cout << "Invalid file path or file does not exist" << endl;
     return FAILURE;
   }
-
-  string errorMsg("");
-  string fileLine;
-
-  int retVal = SUCCESS;
-  int columnCount = -1, lineNumber = 1;
-  while (getline(file, fileLine)) {
-    vector<string> row;
-
-    stringstream lineStream(fileLine);
-
-    string item;
-    while (getline(lineStream, item, ',')) {
-      if (item.size() == 0) {
-        errorMsg += "Null values not allowed in attribute values\n";
-        retVal = FAILURE;
-        break;
-      }
-      row.push_back(item);
-    }
-    if (retVal == FAILURE) {
-      break;
-    }
-
-    if (columnCount == -1) {
-      columnCount = row.size();
-    } else if (columnCount != row.size()) {
-      errorMsg += "Mismatch in number of attributes\n";
-      retVal = FAILURE;
-      break;
-    }
-
-    char rowArray[columnCount][ATTR_SIZE];
-    for (int i = 0; i < columnCount; ++i) {
-      attrToTruncatedArray(row[i], rowArray[i]);
-    }
-
-    retVal = Frontend::insert_into_table_values(relName, columnCount, rowArray);
-
-    if (retVal != SUCCESS) {
-      break;
-    }
-
-    lineNumber++;
-  }
-
   file.close();
 
-  if (retVal == SUCCESS) {
-    cout << lineNumber - 1 << " rows inserted successfully" << endl;
-  } else {
-    if (lineNumber > 1) {
-      std::cout << "Rows till line " << lineNumber - 1 << " successfully inserted\n";
+  LoadStats stats;
+  int retVal = Frontend::insert_into_table_from_file(relName, filePath.c_str(), &stats);
+
+  if (retVal == SUCCESS || retVal == E_INDEX_BLOCKS_RELEASED) {
+    cout << stats.rows << " rows inserted successfully" << endl;
+    double megabytes = stats.bytes / (1024.0 * 1024.0);
+    printf("Loaded %.1f MB in %.3f s (%.1f MB/s, %.0f rows/s)\n", megabytes, stats.seconds,
+           stats.seconds > 0 ? megabytes / stats.seconds : 0, stats.seconds > 0 ? stats.rows / stats.seconds : 0);
+  } else if (stats.errorLine > 0) {
+    if (stats.errorLine > 1) {
+      std::cout << "Rows till line " << stats.errorLine - 1 << " successfully inserted\n";
     }
-    std::cout << "Insertion error at line " << lineNumber << " in file \n";
+    std::cout << "Insertion error at line " << stats.errorLine << " in file \n";
     std::cout << "Subsequent lines will be skipped\n";
     if (retVal == FAILURE) {
-      std::cout << "Error:" << errorMsg;
+      std::cout << "Error:" << stats.error << "\n";
     }
   }
 
@@ -297,8 +327,8 @@ int RegexHandler::insertFromFileHandler() {
 int RegexHandler::selectFromHandler() {
   char sourceRelName[ATTR_SIZE];
   char targetRelName[ATTR_SIZE];
-  attrToTruncatedArray(m[1], sourceRelName);
-  attrToTruncatedArray(m[2], targetRelName);
+  attrToTruncatedArray(stmt->relation, sourceRelName);
+  attrToTruncatedArray(stmt->target, targetRelName);
 
   int ret = Frontend::select_from_table(sourceRelName, targetRelName);
   if (ret == SUCCESS) {
@@ -313,11 +343,11 @@ int RegexHandler::selectFromWhereHandler() {
   char targetRelName[ATTR_SIZE];
   char attribute[ATTR_SIZE];
   char valueStr[ATTR_SIZE];
-  attrToTruncatedArray(m[1], sourceRelName);
-  attrToTruncatedArray(m[2], targetRelName);
-  attrToTruncatedArray(m[3], attribute);
-  int op = getOperator(m[4]);
-  attrToTruncatedArray(m[5], valueStr);
+  attrToTruncatedArray(stmt->relation, sourceRelName);
+  attrToTruncatedArray(stmt->target, targetRelName);
+  attrToTruncatedArray(stmt->condAttr, attribute);
+  int op = stmt->op;
+  valueToArray(stmt->condValue, valueStr);
 
   int ret = Frontend::select_from_table_where(sourceRelName, targetRelName, attribute, op, valueStr);
   if (ret == SUCCESS) {
@@ -330,15 +360,13 @@ int RegexHandler::selectFromWhereHandler() {
 int RegexHandler::selectAttrFromHandler() {
   char sourceRelName[ATTR_SIZE];
   char targetRelName[ATTR_SIZE];
-  attrToTruncatedArray(m[2], sourceRelName);
-  attrToTruncatedArray(m[3], targetRelName);
-
-  vector<string> words = extractTokens(m[1]);
+  attrToTruncatedArray(stmt->relation, sourceRelName);
+  attrToTruncatedArray(stmt->target, targetRelName);
 
-  int attrCount = words.size();
+  int attrCount = stmt->attrs.size();
   char attrNames[attrCount][ATTR_SIZE];
   for (int i = 0; i < attrCount; i++) {
-    attrToTruncatedArray(words[i], attrNames[i]);
+    attrToTruncatedArray(stmt->attrs[i], attrNames[i]);
   }
 
   int ret = Frontend::select_attrlist_from_table(sourceRelName, targetRelName, attrCount, attrNames);
@@ -355,18 +383,16 @@ int RegexHandler::selectAttrFromWhereHandler() {
   char attribute[ATTR_SIZE];
   char value[ATTR_SIZE];
 
-  attrToTruncatedArray(m[2], sourceRelName);
-  attrToTruncatedArray(m[3], targetRelName);
-  attrToTruncatedArray(m[4], attribute);
-  int op = getOperator(m[5]);
-  attrToTruncatedArray(m[6], value);
+  attrToTruncatedArray(stmt->relation, sourceRelName);
+  attrToTruncatedArray(stmt->target, targetRelName);
+  attrToTruncatedArray(stmt->condAttr, attribute);
+  int op = stmt->op;
+  valueToArray(stmt->condValue, value);
 
-  vector<string> attrTokens = extractTokens(m[1]);
-
-  int attrCount = attrTokens.size();
+  int attrCount = stmt->attrs.size();
   char attrNames[attrCount][ATTR_SIZE];
   for (int i = 0; i < attrCount; i++) {
-    attrToTruncatedArray(attrTokens[i], attrNames[i]);
+    attrToTruncatedArray(stmt->attrs[i], attrNames[i]);
   }
 
   int ret = Frontend::select_attrlist_from_table_where(sourceRelName, targetRelName, attrCount, attrNames,
@@ -378,6 +404,92 @@ int RegexHandler::selectAttrFromWhereHandler() {
   return ret;
 }
 
+int RegexHandler::selectToOutputHandler() {
+  char sourceRelName[ATTR_SIZE];
+  char attribute[ATTR_SIZE] = "";
+  char value[ATTR_SIZE] = "";
+  int op = EQ;
+  attrToTruncatedArray(stmt->relation, sourceRelName);
+
+  // the WHERE clause is optional
+  if (stmt->hasCondition) {
+    attrToTruncatedArray(stmt->condAttr, attribute);
+    op = stmt->op;
+    valueToArray(stmt->condValue, value);
+  }
+
+  // '*' selects every attribute, which is passed on as an empty attribute list
+  int attrCount = stmt->attrs.size();
+  char attrNames[attrCount + 1][ATTR_SIZE];
+  for (int i = 0; i < attrCount; i++) {
+    attrToTruncatedArray(stmt->attrs[i], attrNames[i]);
+  }
+
+  // rows go to stdout unless a csv file is given with TO
+  const bool toFile = !stmt->file.empty();
+  string filePath;
+  if (toFile) {
+    filePath = string(OUTPUT_FILES_PATH) + stmt->file;
+  }
+
+  int rowCount = 0;
+  auto start = chrono::steady_clock::now();
+  int ret = Frontend::select_to_output(sourceRelName, attrCount, attrNames, attribute, op, value,
+                                       toFile ? filePath.c_str() : nullptr, &rowCount);
+  auto end = chrono::steady_clock::now();
+
+  if (ret == SUCCESS) {
+    double elapsedMs = chrono::duration<double, milli>(end - start).count();
+    if (toFile) {
+      cout << "Written to " << filePath << endl;
+    }
+    cout << rowCount << " row(s) in " << elapsedMs << " ms" << endl;
+  }
+
+  return ret;
+}
+
+int RegexHandler::selectAggregateHandler() {
+  char sourceRelName[ATTR_SIZE];
+  char aggAttribute[ATTR_SIZE];
+  char groupAttribute[ATTR_SIZE] = "";
+  char attribute[ATTR_SIZE] = "";
+  char value[ATTR_SIZE] = "";
+  int op = EQ;
+
+  int func = stmt->aggFunc;
+  attrToTruncatedArray(stmt->aggAttr, aggAttribute);
+  attrToTruncatedArray(stmt->relation, sourceRelName);
+
+  if (stmt->hasCondition) {
+    attrToTruncatedArray(stmt->condAttr, attribute);
+    op = stmt->op;
+    valueToArray(stmt->condValue, value);
+  }
+
+  // an attribute listed before the aggregate is only allowed if it is the grouping attribute
+  if (!stmt->attrs.empty() && stmt->attrs[0] != stmt->groupAttr) {
+    cout << "Syntax Error: " << stmt->attrs[0] << " must appear in GROUP BY" << endl;
+    return FAILURE;
+  }
+  if (!stmt->groupAttr.empty()) {
+    attrToTruncatedArray(stmt->groupAttr, groupAttribute);
+  }
+
+  int rowCount = 0;
+  auto start = chrono::steady_clock::now();
+  int ret = Frontend::select_aggregate(sourceRelName, func, aggAttribute, groupAttribute, attribute, op, value,
+                                       &rowCount);
+  auto end = chrono::steady_clock::now();
+
+  if (ret == SUCCESS) {
+    double elapsedMs = chrono::duration<double, milli>(end - start).count();
+    cout << rowCount << " row(s) in " << elapsedMs << " ms" << endl;
+  }
+
+  return ret;
+}
+
 int RegexHandler::selectFromJoinHandler() {
   char sourceRelOneName[ATTR_SIZE];
   char sourceRelTwoName[ATTR_SIZE];
@@ -385,16 +497,16 @@ int RegexHandler::selectFromJoinHandler() {
   char joinAttributeOne[ATTR_SIZE];
   char joinAttributeTwo[ATTR_SIZE];
 
-  attrToTruncatedArray(m[1], sourceRelOneName);
-  attrToTruncatedArray(m[2], sourceRelTwoName);
-  attrToTruncatedArray(m[3], targetRelName);
+  attrToTruncatedArray(stmt->relation, sourceRelOneName);
+  attrToTruncatedArray(stmt->relation2, sourceRelTwoName);
+  attrToTruncatedArray(stmt->target, targetRelName);
 
-  if (m[1] == m[4] && m[2] == m[6]) {
-    attrToTruncatedArray(m[5], joinAttributeOne);
-    attrToTruncatedArray(m[7], joinAttributeTwo);
-  } else if (m[1] == m[6] && m[2] == m[4]) {
-    attrToTruncatedArray(m[7], joinAttributeOne);
-    attrToTruncatedArray(m[5], joinAttributeTwo);
+  if (stmt->relation == stmt->joinRel1 && stmt->relation2 == stmt->joinRel2) {
+    attrToTruncatedArray(stmt->joinAttr1, joinAttributeOne);
+    attrToTruncatedArray(stmt->joinAttr2, joinAttributeTwo);
+  } else if (stmt->relation == stmt->joinRel2 && stmt->relation2 == stmt->joinRel1) {
+    attrToTruncatedArray(stmt->joinAttr2, joinAttributeOne);
+    attrToTruncatedArray(stmt->joinAttr1, joinAttributeTwo);
 
   } else {
     cout << "Syntax Error: Relation names do not match" << endl;
@@ -417,29 +529,25 @@ int RegexHandler::selectAttrFromJoinHandler() {
   char joinAttributeOne[ATTR_SIZE];
   char joinAttributeTwo[ATTR_SIZE];
 
-  attrToTruncatedArray(m[2], sourceRelOneName);
-  attrToTruncatedArray(m[3], sourceRelTwoName);
-  attrToTruncatedArray(m[4], targetRelName);
+  attrToTruncatedArray(stmt->relation, sourceRelOneName);
+  attrToTruncatedArray(stmt->relation2, sourceRelTwoName);
+  attrToTruncatedArray(stmt->target, targetRelName);
 
-  if (m[2] == m[5] && m[3] == m[7]) {
-    attrToTruncatedArray(m[6], joinAttributeOne);
-    attrToTruncatedArray(m[8], joinAttributeTwo);
-  } else if (m[2] == m[7] && m[3] == m[5]) {
-    attrToTruncatedArray(m[8], joinAttributeOne);
-    attrToTruncatedArray(m[6], joinAttributeTwo);
+  if (stmt->relation == stmt->joinRel1 && stmt->relation2 == stmt->joinRel2) {
+    attrToTruncatedArray(stmt->joinAttr1, joinAttributeOne);
+    attrToTruncatedArray(stmt->joinAttr2, joinAttributeTwo);
+  } else if (stmt->relation == stmt->joinRel2 && stmt->relation2 == stmt->joinRel1) {
+    attrToTruncatedArray(stmt->joinAttr2, joinAttributeOne);
+    attrToTruncatedArray(stmt->joinAttr1, joinAttributeTwo);
   } else {
     cout << "Syntax Error: Relation names do not match" << endl;
     return FAILURE;
   }
 
-  attrToTruncatedArray(m[6], joinAttributeOne);
-  attrToTruncatedArray(m[8], joinAttributeTwo);
-
-  vector<string> attrTokens = extractTokens(m[1]);
-  int attrCount = attrTokens.size();
+  int attrCount = stmt->attrs.size();
   char attrNames[attrCount][ATTR_SIZE];
   for (int i = 0; i < attrCount; i++) {
-    attrToTruncatedArray(attrTokens[i], attrNames[i]);
+    attrToTruncatedArray(stmt->attrs[i], attrNames[i]);
   }
 
   int ret = Frontend::select_attrlist_from_join_where(sourceRelOneName, sourceRelTwoName, targetRelName,
@@ -452,8 +560,194 @@ int RegexHandler::selectAttrFromJoinHandler() {
   return ret;
 }
 
+int RegexHandler::benchmarkScanHandler() {
+  char relName[ATTR_SIZE];
+  attrToTruncatedArray(stmt->relation, relName);
+  int numThreads = stmt->number != -1 ? stmt->number : 1;
+
+  long long recordsRead;
+  double seconds;
+  int ret = Frontend::benchmark_scan(relName, numThreads, &recordsRead, &seconds);
+  if (ret == SUCCESS) {
+    printf("%lld record(s) read by %d thread(s) in %.3f s", recordsRead, numThreads, seconds);
+    if (seconds > 0) {
+      printf(" (%.0f records/s)", recordsRead / seconds);
+    }
+    printf("\n");
+  }
+  return ret;
+}
+
+/*
+ * Times three ways of turning the commands of a batch file into statements,
+ * without running them: matching them against the regular expressions the
+ * commands used to be dispatched with (copying each regex and searching it again
+ * on a match, as that dispatch did), parsing them with Parser, and preparing them
+ * through an empty StatementCache. Each way is repeated over the file for at
+ * least BENCHMARK_PARSE_SECONDS.
+ */
+int RegexHandler::benchmarkParseHandler() {
+  const string filePath = string(BATCH_FILES_PATH) + stmt->file;
+  ifstream commandsFile(filePath);
+  if (!commandsFile.is_open()) {
+    cout << "The file " << stmt->file << " does not exist\n";
+    return FAILURE;
+  }
+  vector<string> commands;
+  string command;
+  while (getline(commandsFile, command)) {
+    commands.push_back(command);
+  }
+  if (commands.empty()) {
+    cout << "The file " << stmt->file << " is empty\n";
+    return FAILURE;
+  }
+
+  static const vector<regex> regexes = {
+      REGEX(HELP_CMD), REGEX(EXIT_CMD), REGEX(ECHO_CMD), REGEX(RUN_CMD),
+      REGEX(SET_COMMIT_CMD), REGEX(SHOW_COMMIT_STATS_CMD), REGEX(SET_SCAN_THREADS_CMD),
+      REGEX(SHOW_SCHEDULER_STATS_CMD), REGEX(OPEN_TABLE_CMD), REGEX(CLOSE_TABLE_CMD),
+      REGEX(CREATE_TABLE_CMD), REGEX(DROP_TABLE_CMD), REGEX(CREATE_INDEX_CMD),
+      REGEX(CREATE_MULTI_INDEX_CMD), REGEX(DROP_INDEX_CMD), REGEX(RENAME_TABLE_CMD),
+      REGEX(RENAME_COLUMN_CMD), REGEX(INSERT_SINGLE_CMD), REGEX(INSERT_MULTIPLE_CMD),
+      REGEX(SELECT_FROM_CMD), REGEX(SELECT_FROM_WHERE_CMD), REGEX(SELECT_ATTR_FROM_CMD),
+      REGEX(SELECT_ATTR_FROM_WHERE_CMD), REGEX(SELECT_TO_OUTPUT_CMD), REGEX(SELECT_AGGREGATE_CMD),
+      REGEX(SELECT_FROM_JOIN_CMD), REGEX(SELECT_ATTR_FROM_JOIN_CMD), REGEX(BENCHMARK_SCAN_CMD),
+      REGEX(BENCHMARK_PARSE_CMD), REGEX(PREPARE_CMD), REGEX(EXECUTE_CMD), REGEX(DEALLOCATE_CMD),
+      REGEX(CUSTOM_CMD),
+  };
+
+  // runs parseOne over every command until BENCHMARK_PARSE_SECONDS have passed,
+  // and returns the number of commands parsed per second
+  auto measure = [&commands](const function<bool(const string &)> &parseOne, long long *failed) {
+    auto start = chrono::steady_clock::now();
+    long long parsed = 0;
+    double seconds;
+    *failed = 0;
+    do {
+      for (const string &command : commands) {
+        *failed += !parseOne(command);
+      }
+      parsed += commands.size();
+      seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    } while (seconds < BENCHMARK_PARSE_SECONDS);
+    *failed /= parsed / commands.size();
+    return parsed / seconds;
+  };
+
+  long long regexFailed, parserFailed, cacheFailed;
+  double regexRate = measure(
+      [](const string &command) {
+        smatch match;
+        for (auto iter = regexes.begin(); iter != regexes.end(); ++iter) {
+          regex testCommand = *iter;
+          if (regex_match(command, testCommand)) {
+            regex_search(command, match, testCommand);
+            return true;
+          }
+        }
+        return false;
+      },
+      &regexFailed);
+
+  vector<Token> tokens;
+  double parserRate = measure(
+      [&tokens](const string &command) {
+        Statement statement;
+        string error;
+        Parser::tokenize(command, &tokens);
+        return Parser::parse(command, tokens, &statement, &error) == SUCCESS;
+      },
+      &parserFailed);
+
+  StatementCache cache;
+  double cacheRate = measure(
+      [&cache](const string &command) {
+        shared_ptr<const Statement> statement;
+        string error;
+        return cache.prepare(command, &statement, &error) == SUCCESS;
+      },
+      &cacheFailed);
+
+  printf("%zu command(s), %lld rejected by the regexes and %lld by the parser\n", commands.size(), regexFailed,
+         parserFailed);
+  printf("regex: %.0f commands/s\n", regexRate);
+  printf("parser: %.0f commands/s (%.1fx)\n", parserRate, parserRate / regexRate);
+  printf("statement cache: %.0f commands/s (%.1fx, %.1f%% hits)\n", cacheRate, cacheRate / regexRate,
+         100.0 * cache.hits / (cache.hits + cache.misses));
+  return SUCCESS;
+}
+
+int RegexHandler::prepareHandler() {
+  PreparedStatement &prepared = preparedStatements[stmt->name];
+  prepared.statement = stmt->prepared;
+  prepared.insertPlan = InsertPlan();
+  attrToTruncatedArray(stmt->prepared->relation, prepared.insertPlan.relName);
+  cout << "Prepared " << stmt->name << " with " << stmt->prepared->params.size() << " parameter(s)" << endl;
+  return SUCCESS;
+}
+
+/*
+ * Runs a prepared statement with the arguments of EXECUTE bound to its
+ * placeholders. An INSERT goes straight to Algebra with the relation and types
+ * looked up by its first run; any other statement is run by its usual handler.
+ */
+int RegexHandler::executeHandler() {
+  auto found = preparedStatements.find(stmt->name);
+  if (found == preparedStatements.end()) {
+    cout << "Error: No prepared statement named " << stmt->name << endl;
+    return FAILURE;
+  }
+  PreparedStatement &prepared = found->second;
+  const Statement &statement = *prepared.statement;
+  if (stmt->values.size() != statement.params.size()) {
+    cout << "Error: " << stmt->name << " takes " << statement.params.size() << " parameter(s), "
+         << stmt->values.size() << " given" << endl;
+    return FAILURE;
+  }
+
+  if (statement.type == STMT_INSERT_SINGLE) {
+    int attrCount = statement.values.size();
+    char attrValues[attrCount][ATTR_SIZE];
+    for (int i = 0; i < attrCount; ++i) {
+      valueToArray(statement.values[i], attrValues[i]);
+    }
+    for (size_t i = 0; i < statement.params.size(); ++i) {
+      valueToArray(stmt->values[i], attrValues[statement.params[i]]);
+    }
+
+    int ret = Frontend::insert_into_table_values(&prepared.insertPlan, attrCount, attrValues);
+    if (ret == SUCCESS) {
+      cout << "Inserted successfully" << endl;
+    }
+    return ret;
+  }
+
+  shared_ptr<Statement> bound = make_shared<Statement>(statement);
+  for (size_t i = 0; i < statement.params.size(); ++i) {
+    if (statement.params[i] == -1) {
+      bound->condValue = stmt->values[i];
+    } else {
+      bound->values[statement.params[i]] = stmt->values[i];
+    }
+  }
+  bound->params.clear();
+
+  // (the EXECUTE statement is held by handle() while its handler runs)
+  stmt = bound;
+  return (this->*findHandler(bound->type))();
+}
+
+int RegexHandler::deallocateHandler() {
+  if (preparedStatements.erase(stmt->name) == 0) {
+    cout << "Error: No prepared statement named " << stmt->name << endl;
+    return FAILURE;
+  }
+  return SUCCESS;
+}
+
 int RegexHandler::customFunctionHandler() {
-  vector<string> tokens = extractTokens(m[1]);
+  const vector<string> &tokens = stmt->values;
 
   char tokensAsArray[tokens.size()][ATTR_SIZE];
   for (int i = 0; i < tokens.size(); ++i) {
@@ -465,21 +759,44 @@ int RegexHandler::customFunctionHandler() {
 }
 
 int RegexHandler::handle(const string command) {
+  // (kept here as well, as a RUN command replaces stmt with the statements of its file)
+  shared_ptr<const Statement> statement;
+  string error;
+  if (statementCache.prepare(command, &statement, &error) != SUCCESS) {
+    cout << "Syntax Error: " << error << endl;
+    return FAILURE;
+  }
+  stmt = statement;
+
+  handlerFunction handler = findHandler(statement->type);
+  if (handler == nullptr) {
+    cout << "Syntax Error" << endl;
+    return FAILURE;
+  }
+  int status = (this->*handler)();
+  clearTransientStrings();
+
+  // every command is durable once it returns, whether or not it succeeded;
+  // commands of a batch file may share an fsync until the whole batch returns
+  int commitStatus = Frontend::commit(runDepth == 0);
+  if (status == SUCCESS && commitStatus != SUCCESS) {
+    status = commitStatus;
+  }
+
+  if (status == SUCCESS || status == EXIT) {
+    return status;
+  }
+  printErrorMsg(status);
+  return FAILURE;
+}
+
+RegexHandler::handlerFunction RegexHandler::findHandler(StatementType type) {
   for (auto iter = handlers.begin(); iter != handlers.end(); ++iter) {
-    regex testCommand = iter->first;
-    handlerFunction handler = iter->second;
-    if (regex_match(command, testCommand)) {
-      regex_search(command, m, testCommand);
-      int status = (this->*handler)();
-      if (status == SUCCESS || status == EXIT) {
-        return status;
-      }
-      printErrorMsg(status);
-      return FAILURE;
+    if (iter->first == type) {
+      return iter->second;
     }
   }
-  cout << "Syntax Error" << endl;
-  return FAILURE;
+  return nullptr;
 }
 
 RegexHandler FrontendInterface::regexHandler;
@@ -508,24 +825,6 @@ int FrontendInterface::handleFrontend(int argc, char *argv[]) {
   return 0;
 }
 
-// get the operator constant corresponding to the string
-int getOperator(string opStr) {
-  int op = 0;
-  if (opStr == "=")
-    op = EQ;
-  else if (opStr == "<")
-    op = LT;
-  else if (opStr == "<=")
-    op = LE;
-  else if (opStr == ">")
-    op = GT;
-  else if (opStr == ">=")
-    op = GE;
-  else if (opStr == "!=")
-    op = NE;
-  return op;
-}
-
 // truncates a given name string to ATTR_NAME sized char array
 void attrToTruncatedArray(string nameString, char *nameArray) {
   string truncated = nameString.substr(0, ATTR_SIZE - 1);
@@ -536,6 +835,17 @@ void attrToTruncatedArray(string nameString, char *nameArray) {
   }
 }
 
+/*
+ * Stores an attribute value in an ATTR_SIZE array. A value of ATTR_SIZE
+ * characters or more is passed on whole, as a long string (see setString()),
+ * and Algebra cuts it short unless its attribute is a VARCHAR.
+ */
+void valueToArray(const string &value, char *valueArray) {
+  Attribute attr;
+  setString(&attr, value.data(), value.size());
+  memcpy(valueArray, &attr, ATTR_SIZE);
+}
+
 void printErrorMsg(int error) {
   if (error == FAILURE)
     cout << "Error: Command Failed" << endl;
@@ -584,11 +894,12 @@ void printErrorMsg(int error) {
 }
 
 void printHelp() {
-  printf("CREATE TABLE tablename(attr1_name attr1_type ,attr2_name attr2_type....); \n\t -create a relation with given attribute names\n \n");
+  printf("CREATE TABLE tablename(attr1_name attr1_type ,attr2_name attr2_type....) [COLUMNAR] [COMPRESSED]; \n\t -create a relation with given attribute names\n\t  types: STR, NUM (stored in 16 bytes), STR(n) (at most n < 16 characters, stored in n bytes),\n\t  VARCHAR (up to 1024 characters, those of 16 or more in overflow blocks),\n\t  DOUBLE (a number stored in 8 bytes), BIGINT, INT (whole numbers stored in 8 and 4 bytes)\n\t  COLUMNAR stores the values of each attribute together within a block, for scans of few attributes\n\t  COMPRESSED stores the record blocks compressed, for archival relations of repetitive records\n \n");
   printf("DROP TABLE tablename;\n\t-delete the relation\n  \n");
   printf("OPEN TABLE tablename;\n\t-open the relation \n\n");
   printf("CLOSE TABLE tablename;\n\t-close the relation \n \n");
   printf("CREATE INDEX ON tablename.attributename;\n\t-create an index on a given attribute. \n\n");
+  printf("CREATE INDEX ON tablename(attribute1, attribute2, ...);\n\t-create indexes on several attributes with one scan of the relation. \n\n");
   printf("DROP INDEX ON tablename.attributename; \n\t-delete the index. \n\n");
   printf("ALTER TABLE RENAME tablename TO new_tablename;\n\t-rename an existing relation to a given new name. \n\n");
   printf("ALTER TABLE RENAME tablename COLUMN column_name TO new_column_name;\n\t-rename an attribute of an existing relation.\n\n");
@@ -598,9 +909,20 @@ void printHelp() {
   printf("SELECT Attribute1,Attribute2,....FROM source_relation INTO target_relation; \n\t-creates a relation with attributes specified and all records\n\n");
   printf("SELECT * FROM source_relation INTO target_relation WHERE attrname OP value; \n\t-retrieve records based on a condition and insert them into a target relation\n\n");
   printf("SELECT Attribute1,Attribute2,....FROM source_relation INTO target_relation;\n\t-creates a relation with the attributes specified and inserts those records which satisfy the given condition.\n\n");
+  printf("SELECT * | Attribute1,Attribute2,... FROM source_relation [WHERE attrname OP value] [TO filename.csv]; \n\t-print the selected records, or write them to a csv file in Output_Files, without creating a relation\n\n");
+  printf("SELECT [group_attr,] COUNT|SUM|MIN|MAX|AVG(attrname | *) FROM source_relation [WHERE attrname OP value] [GROUP BY group_attr]; \n\t-print an aggregate of the records, one row per group\n\n");
   printf("SELECT * FROM source_relation1 JOIN source_relation2 INTO target_relation WHERE source_relation1.attribute1 = source_relation2.attribute2; \n\t-creates a new relation with by equi-join of both the source relations\n\n");
   printf("SELECT Attribute1,Attribute2,.. FROM source_relation1 JOIN source_relation2 INTO target_relation WHERE source_relation1.attribute1 = source_relation2.attribute2; \n\t-creates a new relation by equi-join of both the source relations with the attributes specified \n\n");
+  printf("BENCHMARK SCAN tablename [THREADS n]; \n\t-read every record of an open relation from n threads at once and print the scan throughput\n\n");
+  printf("BENCHMARK PARSE filename; \n\t-time parsing the commands of a batch file with the regular expressions, the parser and the statement cache, without running them\n\n");
+  printf("PREPARE name AS INSERT INTO tablename VALUES (...) | PREPARE name AS SELECT ...; \n\t-keep a statement whose values may be ? placeholders, to be run by EXECUTE\n\n");
+  printf("EXECUTE name [(value1, value2, ...)]; \n\t-run a prepared statement with the given values in place of its placeholders\n\n");
+  printf("DEALLOCATE name; \n\t-forget a prepared statement\n\n");
   printf("echo <any message> \n\t  -echo back the given string. \n\n");
   printf("run <filename> \n\t  -run commands from an input file in sequence. \n\n");
+  printf("SET COMMIT DELAY microseconds | SET COMMIT BATCH count; \n\t  -tune how long and for how many commits the commands of a batch file may wait to share an fsync\n\n");
+  printf("SHOW COMMIT STATS; \n\t  -print the number of commits and fsyncs and the commit rate\n\n");
+  printf("SET SCAN THREADS count; \n\t  -split the full scans of SELECT ... INTO and the hash joins across count threads (0 for one per core)\n\n");
+  printf("SHOW SCHEDULER STATS; \n\t  -print the tasks run, tasks stolen and utilization of every thread of the task scheduler\n\n");
   printf("exit \n\t-Exit the interface\n");
 }
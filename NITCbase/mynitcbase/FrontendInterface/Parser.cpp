@@ -0,0 +1,759 @@
+#include "Parser.h"
+
+#include <strings.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#include "../define/constants.h"
+
+static bool isWordChar(char c) {
+  return isalnum((unsigned char)c) || c == '_' || c == '#' || c == '-';
+}
+
+/*
+ * Splits command into words (runs of letters, digits, '_', '#' and '-', with a
+ * decimal number such as 3.14 kept as one word) and symbols (the two character
+ * operators <=, >= and != or any other single character). The last token is
+ * always a TOKEN_END.
+ */
+void Parser::tokenize(const std::string &command, std::vector<Token> *tokens) {
+  tokens->clear();
+  const int length = command.size();
+  int i = 0;
+  while (true) {
+    while (i < length && isspace((unsigned char)command[i])) {
+      i++;
+    }
+    if (i == length) {
+      tokens->push_back({TOKEN_END, length, 0});
+      return;
+    }
+
+    int start = i;
+    if (isWordChar(command[i])) {
+      bool digits = true;
+      while (i < length && isWordChar(command[i])) {
+        digits = digits && isdigit((unsigned char)command[i]);
+        i++;
+      }
+      if (digits && i + 1 < length && command[i] == '.' && isdigit((unsigned char)command[i + 1])) {
+        i++;
+        while (i < length && isdigit((unsigned char)command[i])) {
+          i++;
+        }
+      }
+      tokens->push_back({TOKEN_WORD, start, i - start});
+    } else {
+      i++;
+      if (i < length && command[i] == '=' && strchr("<>!", command[start]) != nullptr) {
+        i++;
+      }
+      tokens->push_back({TOKEN_SYMBOL, start, i - start});
+    }
+  }
+}
+
+// command with its runs of spaces made single spaces and its trailing ';' dropped
+std::string Parser::normalize(const std::string &command, const std::vector<Token> &tokens) {
+  int count = tokens.size() - 1;  // (the TOKEN_END)
+  if (count > 0 && tokens[count - 1].type == TOKEN_SYMBOL && command[tokens[count - 1].start] == ';') {
+    count--;
+  }
+
+  std::string normalized;
+  normalized.reserve(command.size());
+  for (int i = 0; i < count; i++) {
+    if (i > 0 && tokens[i].start > tokens[i - 1].start + tokens[i - 1].length) {
+      normalized += ' ';
+    }
+    normalized.append(command, tokens[i].start, tokens[i].length);
+  }
+  return normalized;
+}
+
+/*
+ * Whether the statement of command may be kept by the StatementCache. Commands
+ * that keep raw text (ECHO, RUN, FUNCTION, BENCHMARK PARSE) depend on more than
+ * their normalized text, and INSERT and EXECUTE commands carry their values, so
+ * they are seldom repeated and would only push the other statements out of the cache.
+ */
+bool Parser::isCacheable(const std::string &command, const std::vector<Token> &tokens) {
+  static const char *uncached[] = {"ECHO", "RUN", "FUNCTION", "BENCHMARK", "INSERT", "EXECUTE"};
+  const Token &first = tokens[0];
+  for (const char *keyword : uncached) {
+    if (first.type == TOKEN_WORD && (int)strlen(keyword) == first.length &&
+        strncasecmp(command.data() + first.start, keyword, first.length) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+namespace {
+
+/*
+ * One parse of a command. Every rule returns false (after setting error) as
+ * soon as the command does not match it.
+ */
+class CommandParser {
+ public:
+  CommandParser(const std::string &command, const std::vector<Token> &tokens, Statement *statement)
+      : command(command), tokens(tokens), s(statement) {}
+
+  bool parseCommand();
+
+  std::string error;
+
+ private:
+  const std::string &command;
+  const std::vector<Token> &tokens;
+  Statement *s;
+  size_t pos = 0;
+  bool allowParams = false;  // within PREPARE, where values may be '?'
+
+  const Token &peek(size_t ahead = 0) {
+    return tokens[std::min(pos + ahead, tokens.size() - 1)];
+  }
+
+  std::string text(const Token &token) {
+    return command.substr(token.start, token.length);
+  }
+
+  bool isKeyword(const Token &token, const char *keyword) {
+    return token.type == TOKEN_WORD && (int)strlen(keyword) == token.length &&
+           strncasecmp(command.data() + token.start, keyword, token.length) == 0;
+  }
+
+  bool isSymbol(const Token &token, const char *symbol) {
+    return token.type == TOKEN_SYMBOL && (int)strlen(symbol) == token.length &&
+           strncmp(command.data() + token.start, symbol, token.length) == 0;
+  }
+
+  bool fail(const std::string &expected) {
+    const Token &token = peek();
+    if (token.type == TOKEN_END) {
+      error = "expected " + expected + " at the end of the command";
+    } else {
+      error = "expected " + expected + " near '" + text(token) + "'";
+    }
+    return false;
+  }
+
+  bool acceptKeyword(const char *keyword) {
+    if (!isKeyword(peek(), keyword)) {
+      return false;
+    }
+    pos++;
+    return true;
+  }
+
+  bool expectKeyword(const char *keyword) {
+    return acceptKeyword(keyword) || fail(keyword);
+  }
+
+  bool acceptSymbol(const char *symbol) {
+    if (!isSymbol(peek(), symbol)) {
+      return false;
+    }
+    pos++;
+    return true;
+  }
+
+  bool expectSymbol(const char *symbol) {
+    return acceptSymbol(symbol) || fail(std::string("'") + symbol + "'");
+  }
+
+  // a relation name, or an attribute name (which may also hold '#')
+  bool expectName(std::string *name, bool attribute) {
+    const Token &token = peek();
+    if (token.type != TOKEN_WORD) {
+      return fail(attribute ? "an attribute name" : "a relation name");
+    }
+    for (int i = token.start; i < token.start + token.length; i++) {
+      if (command[i] == '.' || (command[i] == '#' && !attribute)) {
+        return fail(attribute ? "an attribute name" : "a relation name");
+      }
+    }
+    *name = text(token);
+    pos++;
+    return true;
+  }
+
+  // a value compared against or inserted: a word without '#', or a decimal number;
+  // in a prepared statement also a '?', recorded as the placeholder of param
+  bool expectValue(std::string *value, int param) {
+    const Token &token = peek();
+    if (allowParams && isSymbol(token, "?")) {
+      *value = "?";
+      s->params.push_back(param);
+      pos++;
+      return true;
+    }
+    if (token.type != TOKEN_WORD || memchr(command.data() + token.start, '#', token.length) != nullptr) {
+      return fail("a value");
+    }
+    *value = text(token);
+    pos++;
+    return true;
+  }
+
+  bool expectNumber(long *number, int maxDigits) {
+    const Token &token = peek();
+    bool digits = token.type == TOKEN_WORD && token.length <= maxDigits;
+    for (int i = token.start; digits && i < token.start + token.length; i++) {
+      digits = isdigit((unsigned char)command[i]);
+    }
+    if (!digits) {
+      return fail("a number of at most " + std::to_string(maxDigits) + " digits");
+    }
+    *number = strtol(command.c_str() + token.start, nullptr, 10);
+    pos++;
+    return true;
+  }
+
+  // name.csv, written without spaces
+  bool expectCsvFile(std::string *file) {
+    const Token &name = peek(), &dot = peek(1), &extension = peek(2);
+    if (name.type != TOKEN_WORD || memchr(command.data() + name.start, '#', name.length) != nullptr ||
+        memchr(command.data() + name.start, '.', name.length) != nullptr || !isSymbol(dot, ".") ||
+        !isKeyword(extension, "csv") || dot.start != name.start + name.length ||
+        extension.start != dot.start + 1) {
+      return fail("a file name.csv");
+    }
+    *file = command.substr(name.start, extension.start + extension.length - name.start);
+    pos += 3;
+    return true;
+  }
+
+  bool expectEnd() {
+    acceptSymbol(";");
+    return peek().type == TOKEN_END || fail("the end of the command");
+  }
+
+  bool expectOperator(int *op) {
+    static const char *symbols[] = {"=", "<", "<=", ">", ">=", "!="};
+    static const int ops[] = {EQ, LT, LE, GT, GE, NE};
+    for (int i = 0; i < 6; i++) {
+      if (acceptSymbol(symbols[i])) {
+        *op = ops[i];
+        return true;
+      }
+    }
+    return fail("a comparison operator");
+  }
+
+  // attr op value
+  bool parseCondition() {
+    s->hasCondition = true;
+    return expectName(&s->condAttr, true) && expectOperator(&s->op) && expectValue(&s->condValue, -1);
+  }
+
+  // name {, name}
+  bool parseNameList(std::vector<std::string> *names) {
+    do {
+      names->emplace_back();
+      if (!expectName(&names->back(), true)) {
+        return false;
+      }
+    } while (acceptSymbol(","));
+    return true;
+  }
+
+  int aggregateFunction(const Token &token) {
+    static const char *names[] = {"COUNT", "SUM", "MIN", "MAX", "AVG"};
+    static const int funcs[] = {AGG_COUNT, AGG_SUM, AGG_MIN, AGG_MAX, AGG_AVG};
+    for (int i = 0; i < 5; i++) {
+      if (isKeyword(token, names[i])) {
+        return funcs[i];
+      }
+    }
+    return -1;
+  }
+
+  // the rest of the command after the current token, with a trailing ';' dropped;
+  // every character must be in allowed
+  bool rawText(const char *allowed, bool needSpace, std::string *rest) {
+    size_t begin = peek().start;
+    size_t end = command.size();
+    if (pos > 0) {
+      begin = tokens[pos - 1].start + tokens[pos - 1].length;
+    }
+    if (needSpace && (begin == end || !isspace((unsigned char)command[begin]))) {
+      return fail("a space");
+    }
+    while (begin < end && isspace((unsigned char)command[begin])) {
+      begin++;
+    }
+    while (end > begin && isspace((unsigned char)command[end - 1])) {
+      end--;
+    }
+    if (end > begin && command[end - 1] == ';') {
+      end--;
+      while (end > begin && isspace((unsigned char)command[end - 1])) {
+        end--;
+      }
+    }
+    for (size_t i = begin; i < end; i++) {
+      if (strchr(allowed, command[i]) == nullptr) {
+        error = std::string("unexpected '") + command[i] + "'";
+        return false;
+      }
+    }
+    *rest = command.substr(begin, end - begin);
+    pos = tokens.size() - 1;
+    return true;
+  }
+
+  bool parseSet();
+  bool parseShow();
+  bool parseCreate();
+  bool parseAttrType();
+  bool parseDrop();
+  bool parseAlter();
+  bool parseInsert();
+  bool parseSelect();
+  bool parseAggregate();
+  bool parseBenchmark();
+  bool parseFunction();
+  bool parsePrepare();
+  bool parseExecute();
+};
+
+#define NAME_CHARS "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-"
+#define ECHO_CHARS NAME_CHARS " ,()'?:+*."
+#define PATH_CHARS NAME_CHARS "/."
+#define FUNCTION_CHARS NAME_CHARS ",#() \t"
+
+bool CommandParser::parseCommand() {
+  if (acceptKeyword("HELP")) {
+    s->type = STMT_HELP;
+    return expectEnd();
+  }
+  if (acceptKeyword("EXIT")) {
+    s->type = STMT_EXIT;
+    return expectEnd();
+  }
+  if (acceptKeyword("ECHO")) {
+    s->type = STMT_ECHO;
+    return rawText(ECHO_CHARS, false, &s->text);
+  }
+  if (acceptKeyword("RUN")) {
+    s->type = STMT_RUN;
+    return rawText(PATH_CHARS, true, &s->file) && (!s->file.empty() || fail("a file name"));
+  }
+  if (acceptKeyword("SET")) {
+    return parseSet();
+  }
+  if (acceptKeyword("SHOW")) {
+    return parseShow();
+  }
+  if (acceptKeyword("OPEN") || acceptKeyword("CLOSE")) {
+    s->type = isKeyword(tokens[pos - 1], "OPEN") ? STMT_OPEN_TABLE : STMT_CLOSE_TABLE;
+    return expectKeyword("TABLE") && expectName(&s->relation, false) && expectEnd();
+  }
+  if (acceptKeyword("CREATE")) {
+    return parseCreate();
+  }
+  if (acceptKeyword("DROP")) {
+    return parseDrop();
+  }
+  if (acceptKeyword("ALTER")) {
+    return parseAlter();
+  }
+  if (acceptKeyword("INSERT")) {
+    return parseInsert();
+  }
+  if (acceptKeyword("SELECT")) {
+    return parseSelect();
+  }
+  if (acceptKeyword("BENCHMARK")) {
+    return parseBenchmark();
+  }
+  if (acceptKeyword("FUNCTION")) {
+    return parseFunction();
+  }
+  if (acceptKeyword("PREPARE")) {
+    return parsePrepare();
+  }
+  if (acceptKeyword("EXECUTE")) {
+    return parseExecute();
+  }
+  if (acceptKeyword("DEALLOCATE")) {
+    s->type = STMT_DEALLOCATE;
+    return expectName(&s->name, false) && expectEnd();
+  }
+  return fail("a command");
+}
+
+// SET COMMIT (DELAY | BATCH) n | SET SCAN THREADS n
+bool CommandParser::parseSet() {
+  if (acceptKeyword("COMMIT")) {
+    s->type = STMT_SET_COMMIT;
+    if (!acceptKeyword("DELAY") && !acceptKeyword("BATCH")) {
+      return fail("DELAY or BATCH");
+    }
+    s->text = text(tokens[pos - 1]);
+    return expectNumber(&s->number, 9) && expectEnd();
+  }
+  s->type = STMT_SET_SCAN_THREADS;
+  return expectKeyword("SCAN") && expectKeyword("THREADS") && expectNumber(&s->number, 3) && expectEnd();
+}
+
+// SHOW COMMIT STATS | SHOW SCHEDULER STATS
+bool CommandParser::parseShow() {
+  if (acceptKeyword("COMMIT")) {
+    s->type = STMT_SHOW_COMMIT_STATS;
+  } else if (acceptKeyword("SCHEDULER")) {
+    s->type = STMT_SHOW_SCHEDULER_STATS;
+  } else {
+    return fail("COMMIT or SCHEDULER");
+  }
+  return expectKeyword("STATS") && expectEnd();
+}
+
+// CREATE TABLE rel(attr type, ...) [COLUMNAR] [COMPRESSED] | CREATE INDEX ON rel.attr | CREATE INDEX ON rel(attr, ...)
+// where type is STR, STR(length), VARCHAR, NUM, DOUBLE, INT or BIGINT
+bool CommandParser::parseCreate() {
+  if (acceptKeyword("TABLE")) {
+    s->type = STMT_CREATE_TABLE;
+    if (!expectName(&s->relation, false) || !expectSymbol("(")) {
+      return false;
+    }
+    do {
+      s->attrs.emplace_back();
+      if (!expectName(&s->attrs.back(), true)) {
+        return false;
+      }
+      if (!parseAttrType()) {
+        return false;
+      }
+    } while (acceptSymbol(","));
+    if (!expectSymbol(")")) {
+      return false;
+    }
+    s->columnar = acceptKeyword("COLUMNAR");
+    s->compressed = acceptKeyword("COMPRESSED");
+    return expectEnd();
+  }
+
+  if (!expectKeyword("INDEX") || !expectKeyword("ON") || !expectName(&s->relation, false)) {
+    return false;
+  }
+  if (acceptSymbol("(")) {
+    s->type = STMT_CREATE_MULTI_INDEX;
+    return parseNameList(&s->attrs) && expectSymbol(")") && expectEnd();
+  }
+  s->type = STMT_CREATE_INDEX;
+  return expectSymbol(".") && expectName(&s->attribute, true) && expectEnd();
+}
+
+// the type of an attribute of CREATE TABLE, and the format it is stored in
+bool CommandParser::parseAttrType() {
+  int type = NUMBER, format = FORMAT_DEFAULT;
+  if (acceptKeyword("STR")) {
+    type = STRING;
+    if (acceptSymbol("(")) {
+      long length;
+      if (!expectNumber(&length, 2)) {
+        return false;
+      }
+      if (length < 1 || length >= ATTR_SIZE) {
+        pos--;
+        return fail("a length of 1 to " + std::to_string(ATTR_SIZE - 1));
+      }
+      if (!expectSymbol(")")) {
+        return false;
+      }
+      format = FORMAT_CHAR + length;
+    }
+  } else if (acceptKeyword("NUM")) {
+    format = FORMAT_DEFAULT;
+  } else if (acceptKeyword("DOUBLE")) {
+    format = FORMAT_DOUBLE;
+  } else if (acceptKeyword("INT")) {
+    format = FORMAT_INT32;
+  } else if (acceptKeyword("BIGINT")) {
+    format = FORMAT_INT64;
+  } else if (acceptKeyword("VARCHAR")) {
+    type = STRING;
+    format = FORMAT_VARCHAR;
+  } else {
+    return fail("STR, VARCHAR, NUM, DOUBLE, INT or BIGINT");
+  }
+  s->attrTypes.push_back(type);
+  s->attrFormats.push_back(format);
+  return true;
+}
+
+// DROP TABLE rel | DROP INDEX ON rel.attr
+bool CommandParser::parseDrop() {
+  if (acceptKeyword("TABLE")) {
+    s->type = STMT_DROP_TABLE;
+    return expectName(&s->relation, false) && expectEnd();
+  }
+  s->type = STMT_DROP_INDEX;
+  return expectKeyword("INDEX") && expectKeyword("ON") && expectName(&s->relation, false) && expectSymbol(".") &&
+         expectName(&s->attribute, true) && expectEnd();
+}
+
+// ALTER TABLE RENAME rel TO new | ALTER TABLE RENAME rel COLUMN attr TO new
+bool CommandParser::parseAlter() {
+  if (!expectKeyword("TABLE") || !expectKeyword("RENAME") || !expectName(&s->relation, false)) {
+    return false;
+  }
+  if (acceptKeyword("COLUMN")) {
+    s->type = STMT_RENAME_COLUMN;
+    return expectName(&s->attribute, true) && expectKeyword("TO") && expectName(&s->target, true) && expectEnd();
+  }
+  s->type = STMT_RENAME_TABLE;
+  return expectKeyword("TO") && expectName(&s->target, false) && expectEnd();
+}
+
+// INSERT INTO rel VALUES (value, ...) | INSERT INTO rel VALUES FROM file.csv
+bool CommandParser::parseInsert() {
+  if (!expectKeyword("INTO") || !expectName(&s->relation, false) || !expectKeyword("VALUES")) {
+    return false;
+  }
+  if (acceptKeyword("FROM")) {
+    s->type = STMT_INSERT_FROM_FILE;
+    return expectCsvFile(&s->file) && expectEnd();
+  }
+
+  s->type = STMT_INSERT_SINGLE;
+  if (!expectSymbol("(")) {
+    return false;
+  }
+  do {
+    s->values.emplace_back();
+    if (!expectValue(&s->values.back(), s->values.size() - 1)) {
+      return false;
+    }
+  } while (acceptSymbol(","));
+  return expectSymbol(")") && expectEnd();
+}
+
+/*
+ * SELECT * | attr, ... FROM rel INTO target [WHERE attr op value]
+ * SELECT * | attr, ... FROM rel [WHERE attr op value] [TO file.csv]
+ * SELECT * | attr, ... FROM rel JOIN rel2 INTO target WHERE rel.attr = rel2.attr
+ * SELECT [attr,] func(* | attr) FROM rel [WHERE attr op value] [GROUP BY attr]
+ */
+bool CommandParser::parseSelect() {
+  if (aggregateFunction(peek()) != -1 && isSymbol(peek(1), "(")) {
+    return parseAggregate();
+  }
+  if (peek().type == TOKEN_WORD && isSymbol(peek(1), ",") && aggregateFunction(peek(2)) != -1 &&
+      isSymbol(peek(3), "(")) {
+    s->attrs.push_back(text(peek()));
+    pos += 2;
+    return parseAggregate();
+  }
+
+  bool star = acceptSymbol("*");
+  if (!star && !parseNameList(&s->attrs)) {
+    return false;
+  }
+  if (!expectKeyword("FROM") || !expectName(&s->relation, false)) {
+    return false;
+  }
+
+  if (acceptKeyword("JOIN")) {
+    s->type = star ? STMT_SELECT_FROM_JOIN : STMT_SELECT_ATTR_FROM_JOIN;
+    return expectName(&s->relation2, false) && expectKeyword("INTO") && expectName(&s->target, false) &&
+           expectKeyword("WHERE") && expectName(&s->joinRel1, false) && expectSymbol(".") &&
+           expectName(&s->joinAttr1, true) && expectSymbol("=") && expectName(&s->joinRel2, false) &&
+           expectSymbol(".") && expectName(&s->joinAttr2, true) && expectEnd();
+  }
+
+  if (acceptKeyword("INTO")) {
+    if (!expectName(&s->target, false)) {
+      return false;
+    }
+    if (acceptKeyword("WHERE")) {
+      s->type = star ? STMT_SELECT_FROM_WHERE : STMT_SELECT_ATTR_FROM_WHERE;
+      return parseCondition() && expectEnd();
+    }
+    s->type = star ? STMT_SELECT_FROM : STMT_SELECT_ATTR_FROM;
+    return expectEnd();
+  }
+
+  s->type = STMT_SELECT_TO_OUTPUT;
+  if (acceptKeyword("WHERE") && !parseCondition()) {
+    return false;
+  }
+  if (acceptKeyword("TO") && !expectCsvFile(&s->file)) {
+    return false;
+  }
+  return expectEnd();
+}
+
+bool CommandParser::parseAggregate() {
+  s->type = STMT_SELECT_AGGREGATE;
+  s->aggFunc = aggregateFunction(peek());
+  pos += 2;  // (the function and '(')
+
+  if (acceptSymbol("*")) {
+    s->aggAttr = "*";
+  } else if (!expectName(&s->aggAttr, true)) {
+    return false;
+  }
+  if (!expectSymbol(")") || !expectKeyword("FROM") || !expectName(&s->relation, false)) {
+    return false;
+  }
+  if (acceptKeyword("WHERE") && !parseCondition()) {
+    return false;
+  }
+  if (acceptKeyword("GROUP") && !(expectKeyword("BY") && expectName(&s->groupAttr, true))) {
+    return false;
+  }
+  return expectEnd();
+}
+
+// BENCHMARK SCAN rel [THREADS n] | BENCHMARK PARSE file
+bool CommandParser::parseBenchmark() {
+  if (acceptKeyword("PARSE")) {
+    s->type = STMT_BENCHMARK_PARSE;
+    return rawText(PATH_CHARS, true, &s->file) && (!s->file.empty() || fail("a file name"));
+  }
+  s->type = STMT_BENCHMARK_SCAN;
+  if (!expectKeyword("SCAN") || !expectName(&s->relation, false)) {
+    return false;
+  }
+  if (acceptKeyword("THREADS") && !expectNumber(&s->number, 3)) {
+    return false;
+  }
+  return expectEnd();
+}
+
+// FUNCTION args, the arguments being delimited by spaces and commas
+bool CommandParser::parseFunction() {
+  s->type = STMT_CUSTOM;
+  std::string args;
+  if (!rawText(FUNCTION_CHARS, true, &args)) {
+    return false;
+  }
+  size_t i = 0;
+  while (i < args.size()) {
+    size_t end = args.find_first_of(", \t", i);
+    if (end == std::string::npos) {
+      end = args.size();
+    }
+    if (end > i) {
+      s->values.push_back(args.substr(i, end - i));
+    }
+    i = end + 1;
+  }
+  return !s->values.empty() || fail("the arguments");
+}
+
+// PREPARE name AS command, the command being an INSERT INTO ... VALUES (...) or a SELECT
+bool CommandParser::parsePrepare() {
+  s->type = STMT_PREPARE;
+  if (!expectName(&s->name, false) || !expectKeyword("AS")) {
+    return false;
+  }
+  if (!isKeyword(peek(), "INSERT") && !isKeyword(peek(), "SELECT")) {
+    return fail("INSERT or SELECT");
+  }
+
+  std::shared_ptr<Statement> prepared = std::make_shared<Statement>();
+  Statement *outer = s;
+  s = prepared.get();
+  allowParams = true;
+  bool parsed = parseCommand();
+  allowParams = false;
+  s = outer;
+  if (!parsed) {
+    return false;
+  }
+  if (prepared->type == STMT_INSERT_FROM_FILE) {
+    error = "only INSERT INTO ... VALUES (...) can be prepared";
+    return false;
+  }
+  s->prepared = prepared;
+  return true;
+}
+
+// EXECUTE name [(value, ...)]
+bool CommandParser::parseExecute() {
+  s->type = STMT_EXECUTE;
+  if (!expectName(&s->name, false)) {
+    return false;
+  }
+  if (acceptSymbol("(")) {
+    do {
+      s->values.emplace_back();
+      if (!expectValue(&s->values.back(), s->values.size() - 1)) {
+        return false;
+      }
+    } while (acceptSymbol(","));
+    if (!expectSymbol(")")) {
+      return false;
+    }
+  }
+  return expectEnd();
+}
+
+}  // namespace
+
+/*
+ * Parses command (split into tokens by tokenize()) into statement. Returns
+ * SUCCESS, or FAILURE with a description of the syntax error in error.
+ */
+int Parser::parse(const std::string &command, const std::vector<Token> &tokens, Statement *statement,
+                  std::string *error) {
+  CommandParser parser(command, tokens, statement);
+  if (!parser.parseCommand()) {
+    *error = parser.error;
+    return FAILURE;
+  }
+  return SUCCESS;
+}
+
+/*
+ * Returns the statement of command, from the cache if a command with the same
+ * normalized text was parsed before.
+ */
+int StatementCache::prepare(const std::string &command, std::shared_ptr<const Statement> *statement,
+                            std::string *error) {
+  Parser::tokenize(command, &tokens);
+  if (!Parser::isCacheable(command, tokens)) {
+    std::shared_ptr<Statement> parsed = std::make_shared<Statement>();
+    int ret = Parser::parse(command, tokens, parsed.get(), error);
+    *statement = parsed;
+    return ret;
+  }
+  std::string key = Parser::normalize(command, tokens);
+
+  auto found = index.find(key);
+  if (found != index.end()) {
+    hits++;
+    entries.splice(entries.begin(), entries, found->second);
+    *statement = found->second->second;
+    return SUCCESS;
+  }
+
+  misses++;
+  std::shared_ptr<Statement> parsed = std::make_shared<Statement>();
+  int ret = Parser::parse(command, tokens, parsed.get(), error);
+  if (ret != SUCCESS) {
+    return ret;
+  }
+  *statement = parsed;
+
+  if ((int)entries.size() >= STATEMENT_CACHE_SIZE) {
+    index.erase(entries.back().first);
+    entries.pop_back();
+  }
+  entries.emplace_front(std::move(key), parsed);
+  index[entries.front().first] = entries.begin();
+  return SUCCESS;
+}
+
+void StatementCache::clear() {
+  entries.clear();
+  index.clear();
+}
@@ -0,0 +1,142 @@
+#ifndef FRONTEND_INTERFACE_PARSER_H
+#define FRONTEND_INTERFACE_PARSER_H
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum StatementType {
+  STMT_HELP,
+  STMT_EXIT,
+  STMT_ECHO,
+  STMT_RUN,
+  STMT_SET_COMMIT,
+  STMT_SHOW_COMMIT_STATS,
+  STMT_SET_SCAN_THREADS,
+  STMT_SHOW_SCHEDULER_STATS,
+  STMT_OPEN_TABLE,
+  STMT_CLOSE_TABLE,
+  STMT_CREATE_TABLE,
+  STMT_DROP_TABLE,
+  STMT_CREATE_INDEX,
+  STMT_CREATE_MULTI_INDEX,
+  STMT_DROP_INDEX,
+  STMT_RENAME_TABLE,
+  STMT_RENAME_COLUMN,
+  STMT_INSERT_SINGLE,
+  STMT_INSERT_FROM_FILE,
+  STMT_SELECT_FROM,
+  STMT_SELECT_FROM_WHERE,
+  STMT_SELECT_ATTR_FROM,
+  STMT_SELECT_ATTR_FROM_WHERE,
+  STMT_SELECT_TO_OUTPUT,
+  STMT_SELECT_AGGREGATE,
+  STMT_SELECT_FROM_JOIN,
+  STMT_SELECT_ATTR_FROM_JOIN,
+  STMT_BENCHMARK_SCAN,
+  STMT_BENCHMARK_PARSE,
+  STMT_PREPARE,
+  STMT_EXECUTE,
+  STMT_DEALLOCATE,
+  STMT_CUSTOM
+};
+
+/*
+ * A parsed command. Only the fields used by its type are set:
+ *   relation   the relation the command works on (the first one of a join)
+ *   relation2  the second relation of a join
+ *   target     the relation a SELECT creates, or the new name of ALTER TABLE RENAME
+ *   attribute  the attribute of CREATE/DROP INDEX, the old name of RENAME COLUMN
+ *   attrs      the attribute list of SELECT and CREATE INDEX ON rel(...), the attribute
+ *              names of CREATE TABLE, or the attribute before the aggregate of a
+ *              grouped SELECT
+ *   values     the values of INSERT, the arguments of FUNCTION
+ *   file       the csv file of INSERT ... FROM and SELECT ... TO, or the batch file of
+ *              RUN and BENCHMARK PARSE
+ *   text       the message of ECHO, or DELAY/BATCH of SET COMMIT
+ *   name       the prepared statement of PREPARE, EXECUTE and DEALLOCATE
+ *   prepared   the statement of PREPARE, whose values may be '?' placeholders
+ *   params     the placeholders of a prepared statement in order, each the index of
+ *              its value in values, or -1 for the value of the WHERE condition
+ *
+ * The values of EXECUTE are its arguments, bound to the placeholders in order.
+ */
+struct Statement {
+  StatementType type;
+  std::string relation, relation2, target, attribute;
+  std::vector<std::string> attrs;
+  std::vector<int> attrTypes;    // of CREATE TABLE
+  std::vector<int> attrFormats;  // of CREATE TABLE
+  bool columnar = false;         // of CREATE TABLE
+  bool compressed = false;       // of CREATE TABLE
+  std::vector<std::string> values;
+  std::string file;
+  std::string text;
+  std::string name;
+  std::shared_ptr<const Statement> prepared;
+  std::vector<int> params;
+  long number = -1;  // the value of SET, the threads of BENCHMARK SCAN (-1 if not given)
+
+  // WHERE attr op value
+  bool hasCondition = false;
+  std::string condAttr, condValue;
+  int op;
+
+  // WHERE joinRel1.joinAttr1 = joinRel2.joinAttr2
+  std::string joinRel1, joinAttr1, joinRel2, joinAttr2;
+
+  // SELECT func(aggAttr) ... GROUP BY groupAttr
+  int aggFunc;
+  std::string aggAttr, groupAttr;
+};
+
+enum TokenType {
+  TOKEN_WORD,    // a name, keyword or number
+  TOKEN_SYMBOL,  // punctuation or an operator
+  TOKEN_END
+};
+
+struct Token {
+  TokenType type;
+  int start;
+  int length;
+};
+
+/*
+ * Hand-written tokenizer and recursive-descent parser of the commands. A command
+ * is split into tokens in one pass; the parser then looks at the leading keywords
+ * to pick the rule of the command and fills in a Statement. Keywords are case
+ * insensitive; names and values are kept as they were typed.
+ */
+class Parser {
+ public:
+  static void tokenize(const std::string &command, std::vector<Token> *tokens);
+  static std::string normalize(const std::string &command, const std::vector<Token> &tokens);
+  static bool isCacheable(const std::string &command, const std::vector<Token> &tokens);
+  static int parse(const std::string &command, const std::vector<Token> &tokens, Statement *statement,
+                   std::string *error);
+};
+
+/*
+ * The statements parsed most recently, keyed by their normalized text (see
+ * Parser::normalize()), so that a command repeated in a batch file is only
+ * parsed once. The least recently used statement is dropped once
+ * STATEMENT_CACHE_SIZE are kept.
+ */
+class StatementCache {
+ public:
+  int prepare(const std::string &command, std::shared_ptr<const Statement> *statement, std::string *error);
+  void clear();
+
+  long long hits = 0, misses = 0;
+
+ private:
+  typedef std::pair<std::string, std::shared_ptr<const Statement>> Entry;
+  std::list<Entry> entries;  // most recently used first
+  std::unordered_map<std::string, std::list<Entry>::iterator> index;
+  std::vector<Token> tokens;
+};
+
+#endif  // FRONTEND_INTERFACE_PARSER_H
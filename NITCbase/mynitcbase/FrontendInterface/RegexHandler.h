@@ -1,15 +1,29 @@
 #ifndef REGEX_HANDLER_H
 #define REGEX_HANDLER_H
 
+#include <memory>
 #include <regex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "../Algebra/Algebra.h"
+#include "Parser.h"
+
+/*
+ * The regular expressions the commands were matched against before they were
+ * parsed by Parser, kept as the baseline of BENCHMARK PARSE.
+ */
+
 /* External File System Commands */
 #define HELP_CMD "\\s*HELP\\s*;?"
 #define EXIT_CMD "\\s*EXIT\\s*;?"
 #define RUN_CMD "\\s*RUN\\s+([a-zA-Z0-9_/.-]+)\\s*;?"
 #define ECHO_CMD "\\s*ECHO\\s*([a-zA-Z0-9 _,()'?:+*.-]*)\\s*;?"
+#define SET_COMMIT_CMD "\\s*SET\\s+COMMIT\\s+(DELAY|BATCH)\\s+([0-9]{1,9})\\s*;?"
+#define SHOW_COMMIT_STATS_CMD "\\s*SHOW\\s+COMMIT\\s+STATS\\s*;?"
+#define SET_SCAN_THREADS_CMD "\\s*SET\\s+SCAN\\s+THREADS\\s+([0-9]{1,3})\\s*;?"
+#define SHOW_SCHEDULER_STATS_CMD "\\s*SHOW\\s+SCHEDULER\\s+STATS\\s*;?"
 
 /* DDL Commands*/
 #define CREATE_TABLE_CMD "\\s*CREATE\\s+TABLE\\s+([A-Za-z0-9_-]+)\\s*\\(\\s*((?:[#A-Za-z0-9_-]+\\s+(?:STR|NUM)\\s*,\\s*)*(?:[#A-Za-z0-9_-]+\\s+(?:STR|NUM)))\\s*\\)\\s*;?"
@@ -17,6 +31,7 @@
 #define OPEN_TABLE_CMD "\\s*OPEN\\s+TABLE\\s+([A-Za-z0-9_-]+)\\s*;?"
 #define CLOSE_TABLE_CMD "\\s*CLOSE\\s+TABLE\\s+([A-Za-z0-9_-]+)\\s*;?"
 #define CREATE_INDEX_CMD "\\s*CREATE\\s+INDEX\\s+ON\\s+([A-Za-z0-9_-]+)\\s*\\.\\s*([#A-Za-z0-9_-]+)\\s*;?"
+#define CREATE_MULTI_INDEX_CMD "\\s*CREATE\\s+INDEX\\s+ON\\s+([A-Za-z0-9_-]+)\\s*\\(\\s*((?:[#A-Za-z0-9_-]+\\s*,\\s*)*(?:[#A-Za-z0-9_-]+))\\s*\\)\\s*;?"
 #define DROP_INDEX_CMD "\\s*DROP\\s+INDEX\\s+ON\\s+([A-Za-z0-9_-]+)\\s*\\.\\s*([#A-Za-z0-9_-]+)\\s*;?"
 #define RENAME_TABLE_CMD "\\s*ALTER\\s+TABLE\\s+RENAME\\s+([a-zA-Z0-9_-]+)\\s+TO\\s+([a-zA-Z0-9_-]+)\\s*;?"
 #define RENAME_COLUMN_CMD "\\s*ALTER\\s+TABLE\\s+RENAME\\s+([a-zA-Z0-9_-]+)\\s+COLUMN\\s+([#a-zA-Z0-9_-]+)\\s+TO\\s+([#a-zA-Z0-9_-]+)\\s*;?"
@@ -26,57 +41,93 @@
 #define SELECT_ATTR_FROM_CMD "\\s*SELECT\\s+((?:[#A-Za-z0-9_-]+\\s*,\\s*)*(?:[#A-Za-z0-9_-]+))\\s+FROM\\s+([A-Za-z0-9_-]+)\\s+INTO\\s+([A-Za-z0-9_-]+)\\s*;?"
 #define SELECT_FROM_WHERE_CMD "\\s*SELECT\\s+\\*\\s+FROM\\s+([A-Za-z0-9_-]+)\\s+INTO\\s+([A-Za-z0-9_-]+)\\s+WHERE\\s+([#A-Za-z0-9_-]+)\\s*(<|<=|>|>=|=|!=)\\s*([A-Za-z0-9_-]+|([0-9]+(\\.)[0-9]+))\\s*;?"
 #define SELECT_ATTR_FROM_WHERE_CMD "\\s*SELECT\\s+((?:[#A-Za-z0-9_-]+\\s*,\\s*)*(?:[#A-Za-z0-9_-]+))\\s+FROM\\s+([A-Za-z0-9_-]+)\\s+INTO\\s+([A-Za-z0-9_-]+)\\s+WHERE\\s+([#A-Za-z0-9_-]+)\\s*(<|<=|>|>=|=|!=)\\s*([A-Za-z0-9_-]+|([0-9]+(\\.)[0-9]+))\\s*;?"
+#define SELECT_TO_OUTPUT_CMD "\\s*SELECT\\s+(\\*|(?:[#A-Za-z0-9_-]+\\s*,\\s*)*(?:[#A-Za-z0-9_-]+))\\s+FROM\\s+([A-Za-z0-9_-]+)(?:\\s+WHERE\\s+([#A-Za-z0-9_-]+)\\s*(<|<=|>|>=|=|!=)\\s*([A-Za-z0-9_-]+|[0-9]+\\.[0-9]+))?(?:\\s+TO\\s+([a-zA-Z0-9_-]+\\.csv))?\\s*;?"
+#define SELECT_AGGREGATE_CMD "\\s*SELECT\\s+(?:([#A-Za-z0-9_-]+)\\s*,\\s*)?(COUNT|SUM|MIN|MAX|AVG)\\s*\\(\\s*(\\*|[#A-Za-z0-9_-]+)\\s*\\)\\s+FROM\\s+([A-Za-z0-9_-]+)(?:\\s+WHERE\\s+([#A-Za-z0-9_-]+)\\s*(<|<=|>|>=|=|!=)\\s*([A-Za-z0-9_-]+|[0-9]+\\.[0-9]+))?(?:\\s+GROUP\\s+BY\\s+([#A-Za-z0-9_-]+))?\\s*;?"
 #define SELECT_FROM_JOIN_CMD "\\s*SELECT\\s+\\*\\s+FROM\\s+([A-Za-z0-9_-]+)\\s+JOIN\\s+([A-Za-z0-9_-]+)\\s+INTO\\s+([A-Za-z0-9_-]+)\\s+WHERE\\s+([A-Za-z0-9_-]+)\\s*\\.([#A-Za-z0-9_-]+)\\s*\\=\\s*([A-Za-z0-9_-]+)\\s*\\.([#A-Za-z0-9_-]+)\\s*;?"
 #define SELECT_ATTR_FROM_JOIN_CMD "\\s*SELECT\\s+((?:[#A-Za-z0-9_-]+\\s*,\\s*)*(?:[#A-Za-z0-9_-]+))\\s+FROM\\s+([A-Za-z0-9_-]+)\\s+JOIN\\s+([A-Za-z0-9_-]+)\\s+INTO\\s+([A-Za-z0-9_-]+)\\s+WHERE\\s+([A-Za-z0-9_-]+)\\s*\\.([#A-Za-z0-9_-]+)\\s*\\=\\s*([A-Za-z0-9_-]+)\\s*\\.([#A-Za-z0-9_-]+)\\s*;?"
 #define INSERT_SINGLE_CMD "\\s*INSERT\\s+INTO\\s+([A-Za-z0-9_-]+)\\s+VALUES\\s*\\(\\s*((?:(?:[A-Za-z0-9_-]+|[0-9]+\\.[0-9]+)\\s*,\\s*)*(?:[A-Za-z0-9_-]+|[0-9]+\\.[0-9]+))\\s*\\)\\s*;?"
 #define INSERT_MULTIPLE_CMD "\\s*INSERT\\s+INTO\\s+([A-Za-z0-9_-]+)\\s+VALUES\\s+FROM\\s+([a-zA-Z0-9_-]+\\.csv)\\s*;?"
+#define BENCHMARK_SCAN_CMD "\\s*BENCHMARK\\s+SCAN\\s+([A-Za-z0-9_-]+)(?:\\s+THREADS\\s+([0-9]{1,3}))?\\s*;?"
+#define BENCHMARK_PARSE_CMD "\\s*BENCHMARK\\s+PARSE\\s+([a-zA-Z0-9_/.-]+)\\s*;?"
+#define PREPARE_CMD "\\s*PREPARE\\s+([A-Za-z0-9_-]+)\\s+AS\\s+((?:INSERT|SELECT)\\s.*)"
+#define EXECUTE_CMD "\\s*EXECUTE\\s+([A-Za-z0-9_-]+)\\s*(?:\\(\\s*((?:(?:[A-Za-z0-9_-]+|[0-9]+\\.[0-9]+)\\s*,\\s*)*(?:[A-Za-z0-9_-]+|[0-9]+\\.[0-9]+))\\s*\\))?\\s*;?"
+#define DEALLOCATE_CMD "\\s*DEALLOCATE\\s+([A-Za-z0-9_-]+)\\s*;?"
 #define CUSTOM_CMD "\\s*FUNCTION\\s+([A-Za-z,#0-9\\s()_-]+)\\s*;?"
 
 #define REGEX(c) std::regex(c, std::regex_constants::icase)
 
+// a statement of PREPARE; an INSERT keeps the rel-id and attribute types it found
+struct PreparedStatement {
+  std::shared_ptr<const Statement> statement;
+  InsertPlan insertPlan;
+};
+
 class RegexHandler {
   typedef int (RegexHandler::*handlerFunction)(void);  // function pointer type
 
  private:
-  // command to handler mappings
-  const std::vector<std::pair<std::regex, handlerFunction>> handlers = {
-      {REGEX(HELP_CMD), &RegexHandler::helpHandler},
-      {REGEX(EXIT_CMD), &RegexHandler::exitHandler},
-      {REGEX(ECHO_CMD), &RegexHandler::echoHandler},
-      {REGEX(RUN_CMD), &RegexHandler::runHandler},
-      {REGEX(OPEN_TABLE_CMD), &RegexHandler::openHandler},
-      {REGEX(CLOSE_TABLE_CMD), &RegexHandler::closeHandler},
-      {REGEX(CREATE_TABLE_CMD), &RegexHandler::createTableHandler},
-      {REGEX(DROP_TABLE_CMD), &RegexHandler::dropTableHandler},
-      {REGEX(CREATE_INDEX_CMD), &RegexHandler::createIndexHandler},
-      {REGEX(DROP_INDEX_CMD), &RegexHandler::dropIndexHandler},
-      {REGEX(RENAME_TABLE_CMD), &RegexHandler::renameTableHandler},
-      {REGEX(RENAME_COLUMN_CMD), &RegexHandler::renameColumnHandler},
-      {REGEX(INSERT_SINGLE_CMD), &RegexHandler::insertSingleHandler},
-      {REGEX(INSERT_MULTIPLE_CMD), &RegexHandler::insertFromFileHandler},
-      {REGEX(SELECT_FROM_CMD), &RegexHandler::selectFromHandler},
-      {REGEX(SELECT_FROM_WHERE_CMD), &RegexHandler::selectFromWhereHandler},
-      {REGEX(SELECT_ATTR_FROM_CMD), &RegexHandler::selectAttrFromHandler},
-      {REGEX(SELECT_ATTR_FROM_WHERE_CMD), &RegexHandler::selectAttrFromWhereHandler},
-      {REGEX(SELECT_FROM_JOIN_CMD), &RegexHandler::selectFromJoinHandler},
-      {REGEX(SELECT_ATTR_FROM_JOIN_CMD), &RegexHandler::selectAttrFromJoinHandler},
-      {REGEX(CUSTOM_CMD), &RegexHandler::customFunctionHandler},
+  // statement to handler mappings
+  const std::vector<std::pair<StatementType, handlerFunction>> handlers = {
+      {STMT_HELP, &RegexHandler::helpHandler},
+      {STMT_EXIT, &RegexHandler::exitHandler},
+      {STMT_ECHO, &RegexHandler::echoHandler},
+      {STMT_RUN, &RegexHandler::runHandler},
+      {STMT_SET_COMMIT, &RegexHandler::setCommitHandler},
+      {STMT_SHOW_COMMIT_STATS, &RegexHandler::showCommitStatsHandler},
+      {STMT_SET_SCAN_THREADS, &RegexHandler::setScanThreadsHandler},
+      {STMT_SHOW_SCHEDULER_STATS, &RegexHandler::showSchedulerStatsHandler},
+      {STMT_OPEN_TABLE, &RegexHandler::openHandler},
+      {STMT_CLOSE_TABLE, &RegexHandler::closeHandler},
+      {STMT_CREATE_TABLE, &RegexHandler::createTableHandler},
+      {STMT_DROP_TABLE, &RegexHandler::dropTableHandler},
+      {STMT_CREATE_INDEX, &RegexHandler::createIndexHandler},
+      {STMT_CREATE_MULTI_INDEX, &RegexHandler::createMultiIndexHandler},
+      {STMT_DROP_INDEX, &RegexHandler::dropIndexHandler},
+      {STMT_RENAME_TABLE, &RegexHandler::renameTableHandler},
+      {STMT_RENAME_COLUMN, &RegexHandler::renameColumnHandler},
+      {STMT_INSERT_SINGLE, &RegexHandler::insertSingleHandler},
+      {STMT_INSERT_FROM_FILE, &RegexHandler::insertFromFileHandler},
+      {STMT_SELECT_FROM, &RegexHandler::selectFromHandler},
+      {STMT_SELECT_FROM_WHERE, &RegexHandler::selectFromWhereHandler},
+      {STMT_SELECT_ATTR_FROM, &RegexHandler::selectAttrFromHandler},
+      {STMT_SELECT_ATTR_FROM_WHERE, &RegexHandler::selectAttrFromWhereHandler},
+      {STMT_SELECT_TO_OUTPUT, &RegexHandler::selectToOutputHandler},
+      {STMT_SELECT_AGGREGATE, &RegexHandler::selectAggregateHandler},
+      {STMT_SELECT_FROM_JOIN, &RegexHandler::selectFromJoinHandler},
+      {STMT_SELECT_ATTR_FROM_JOIN, &RegexHandler::selectAttrFromJoinHandler},
+      {STMT_BENCHMARK_SCAN, &RegexHandler::benchmarkScanHandler},
+      {STMT_BENCHMARK_PARSE, &RegexHandler::benchmarkParseHandler},
+      {STMT_PREPARE, &RegexHandler::prepareHandler},
+      {STMT_EXECUTE, &RegexHandler::executeHandler},
+      {STMT_DEALLOCATE, &RegexHandler::deallocateHandler},
+      {STMT_CUSTOM, &RegexHandler::customFunctionHandler},
   };
 
-  // extract tokens delimited by whitespace and comma
-  std::vector<std::string> extractTokens(std::string input);
+  handlerFunction findHandler(StatementType type);
+
+  // statements parsed before, keyed by their normalized text
+  StatementCache statementCache;
+
+  // statements of PREPARE, by name
+  std::unordered_map<std::string, PreparedStatement> preparedStatements;
 
   // handler functions
-  std::smatch m;  // to store matches while parsing the regex
+  std::shared_ptr<const Statement> stmt;  // the statement being run
+  int runDepth = 0;  // number of batch files being run, commits inside them may share an fsync
   int helpHandler();
   int exitHandler();
   int echoHandler();
   int runHandler();
+  int setCommitHandler();
+  int showCommitStatsHandler();
+  int setScanThreadsHandler();
+  int showSchedulerStatsHandler();
   int openHandler();
   int closeHandler();
   int createTableHandler();
   int dropTableHandler();
   int createIndexHandler();
+  int createMultiIndexHandler();
   int dropIndexHandler();
   int renameTableHandler();
   int renameColumnHandler();
@@ -86,8 +137,15 @@ class RegexHandler {
   int selectFromWhereHandler();
   int selectAttrFromHandler();
   int selectAttrFromWhereHandler();
+  int selectToOutputHandler();
+  int selectAggregateHandler();
   int selectFromJoinHandler();
   int selectAttrFromJoinHandler();
+  int benchmarkScanHandler();
+  int benchmarkParseHandler();
+  int prepareHandler();
+  int executeHandler();
+  int deallocateHandler();
   int customFunctionHandler();
 
  public:
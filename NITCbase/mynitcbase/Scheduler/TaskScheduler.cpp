@@ -0,0 +1,218 @@
+#include "TaskScheduler.h"
+
+#include <algorithm>
+
+TaskQueue TaskScheduler::queues[MAX_SCAN_THREADS];
+WorkerCounters TaskScheduler::counters[MAX_SCAN_THREADS];
+std::vector<std::thread> TaskScheduler::workers;
+std::atomic<int> TaskScheduler::numWorkers(0);
+std::atomic<int> TaskScheduler::queuedTasks(0);
+std::mutex TaskScheduler::startLock;
+std::mutex TaskScheduler::sleepLock;
+std::condition_variable TaskScheduler::wakeup;
+bool TaskScheduler::stopping = false;
+std::chrono::steady_clock::time_point TaskScheduler::startTime;
+
+// index of the calling thread in the scheduler, 0 for any thread that is not a worker
+static thread_local int threadIndex = 0;
+
+/*
+ * Starts one worker per core besides the thread running the statements.
+ */
+TaskScheduler::TaskScheduler() {
+  startTime = std::chrono::steady_clock::now();
+  reserve(std::thread::hardware_concurrency());
+}
+
+TaskScheduler::~TaskScheduler() {
+  {
+    std::lock_guard<std::mutex> guard(sleepLock);
+    stopping = true;
+  }
+  wakeup.notify_all();
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+}
+
+// number of threads that can run tasks at once, the statement thread included
+int TaskScheduler::getNumThreads() {
+  return numWorkers.load() + 1;
+}
+
+/*
+ * Starts workers until numThreads threads (the statement thread included, at most
+ * MAX_SCAN_THREADS) can run tasks at once. The pool never shrinks.
+ */
+void TaskScheduler::reserve(int numThreads) {
+  std::lock_guard<std::mutex> guard(startLock);
+  numThreads = std::min(numThreads, MAX_SCAN_THREADS);
+  while (numWorkers.load() + 1 < numThreads) {
+    int self = numWorkers.load() + 1;
+    workers.emplace_back(workerLoop, self);
+    numWorkers++;
+  }
+}
+
+void TaskScheduler::getWorkerStats(std::vector<WorkerStats> *stats) {
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  stats->clear();
+  for (int i = 0; i < getNumThreads(); i++) {
+    WorkerStats workerStats;
+    workerStats.tasks = counters[i].tasks.load();
+    workerStats.steals = counters[i].steals.load();
+    workerStats.busySeconds = counters[i].busyNanos.load() / 1e9;
+    workerStats.utilization = elapsed > 0 ? workerStats.busySeconds / elapsed : 0;
+    stats->push_back(workerStats);
+  }
+}
+
+void TaskScheduler::submit(Task task, int priority) {
+  TaskQueue &queue = queues[threadIndex];
+  {
+    std::lock_guard<std::mutex> guard(queue.lock);
+    queue.tasks[priority].push_back(std::move(task));
+  }
+  queuedTasks++;
+
+  // taking sleepLock orders the increment before a worker's check for work
+  { std::lock_guard<std::mutex> guard(sleepLock); }
+  wakeup.notify_one();
+}
+
+/*
+ * Takes the next task for thread self: for each priority from the highest, the
+ * newest task of its own deque, or else the oldest task of another thread's.
+ */
+bool TaskScheduler::take(int self, Task *task) {
+  if (queuedTasks.load() == 0) {
+    return false;
+  }
+
+  const int numThreads = getNumThreads();
+  for (int priority = 0; priority < TASK_PRIORITIES; priority++) {
+    {
+      TaskQueue &own = queues[self];
+      std::lock_guard<std::mutex> guard(own.lock);
+      if (!own.tasks[priority].empty()) {
+        *task = std::move(own.tasks[priority].back());
+        own.tasks[priority].pop_back();
+        queuedTasks--;
+        return true;
+      }
+    }
+
+    for (int i = 1; i < numThreads; i++) {
+      TaskQueue &victim = queues[(self + i) % numThreads];
+      std::lock_guard<std::mutex> guard(victim.lock);
+      if (!victim.tasks[priority].empty()) {
+        *task = std::move(victim.tasks[priority].front());
+        victim.tasks[priority].pop_front();
+        queuedTasks--;
+        counters[self].steals.fetch_add(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void TaskScheduler::execute(int self, Task &task) {
+  TaskGroup *group = task.group;
+  if (!group->isCancelled()) {
+    auto start = std::chrono::steady_clock::now();
+    int ret = task.run();
+    auto busy = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    counters[self].busyNanos.fetch_add(busy.count(), std::memory_order_relaxed);
+    counters[self].tasks.fetch_add(1, std::memory_order_relaxed);
+    if (ret != SUCCESS) {
+      group->cancel(ret);
+    }
+  }
+  group->finish();
+}
+
+// runs one queued task on the calling thread, if there is any
+bool TaskScheduler::runOne() {
+  Task task;
+  if (!take(threadIndex, &task)) {
+    return false;
+  }
+  execute(threadIndex, task);
+  return true;
+}
+
+void TaskScheduler::workerLoop(int self) {
+  threadIndex = self;
+  while (true) {
+    Task task;
+    if (take(self, &task)) {
+      execute(self, task);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> guard(sleepLock);
+    wakeup.wait(guard, [] { return stopping || queuedTasks.load() > 0; });
+    if (stopping) {
+      return;
+    }
+  }
+}
+
+TaskGroup::TaskGroup(int priority) : priority(priority), pending(0), cancelled(false), error(SUCCESS) {}
+
+TaskGroup::~TaskGroup() {
+  wait();
+}
+
+// queues task, unless the group has been cancelled
+void TaskGroup::run(std::function<int()> task) {
+  if (isCancelled()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    pending++;
+  }
+  TaskScheduler::submit(Task{std::move(task), this}, priority);
+}
+
+/*
+ * Waits until every task of the group has finished, running queued tasks (of
+ * this or any other group) meanwhile. Returns the error that cancelled the group,
+ * or SUCCESS.
+ */
+int TaskGroup::wait() {
+  while (true) {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      if (pending == 0) {
+        break;
+      }
+    }
+    if (TaskScheduler::runOne()) {
+      continue;
+    }
+
+    // the remaining tasks are running on other threads; check back now and then
+    // in case a task is queued that no worker is free to take
+    std::unique_lock<std::mutex> guard(lock);
+    done.wait_for(guard, std::chrono::milliseconds(1), [this] { return pending == 0; });
+  }
+  return error.load();
+}
+
+void TaskGroup::cancel(int error) {
+  int expected = SUCCESS;
+  this->error.compare_exchange_strong(expected, error);
+  cancelled = true;
+}
+
+void TaskGroup::finish() {
+  std::lock_guard<std::mutex> guard(lock);
+  pending--;
+  if (pending == 0) {
+    done.notify_all();
+  }
+}
@@ -0,0 +1,120 @@
+#ifndef NITCBASE_TASKSCHEDULER_H
+#define NITCBASE_TASKSCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../define/constants.h"
+
+enum TaskPriority
+{
+  TASK_PRIORITY_HIGH = 0,
+  TASK_PRIORITY_NORMAL = 1,
+  TASK_PRIORITY_LOW = 2,
+  TASK_PRIORITIES = 3
+};
+
+class TaskGroup;
+
+struct Task {
+  std::function<int()> run;
+  TaskGroup *group;
+};
+
+// the tasks queued by one thread of the scheduler, one deque per priority
+struct TaskQueue {
+  std::mutex lock;
+  std::deque<Task> tasks[TASK_PRIORITIES];
+};
+
+struct WorkerCounters {
+  std::atomic<long long> tasks;
+  std::atomic<long long> steals;     // tasks taken from the queue of another thread
+  std::atomic<long long> busyNanos;  // time spent running tasks
+};
+
+struct WorkerStats {
+  long long tasks;
+  long long steals;
+  double busySeconds;
+  double utilization;  // fraction of the time since the scheduler started spent running tasks
+};
+
+/*
+ * The tasks of one operator (a scan, a join, an index build ...). Tasks return
+ * SUCCESS or an error code; the first error cancels the group, so its tasks that
+ * have not started are dropped and the running ones can stop early by polling
+ * isCancelled(). wait() returns that first error.
+ */
+class TaskGroup {
+  friend class TaskScheduler;
+
+ public:
+  explicit TaskGroup(int priority = TASK_PRIORITY_NORMAL);
+  ~TaskGroup();
+
+  void run(std::function<int()> task);
+  int wait();
+  void cancel(int error);
+  bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+
+ private:
+  void finish();
+
+  int priority;
+  int pending;  // tasks queued or running, guarded by lock
+  std::mutex lock;
+  std::condition_variable done;
+  std::atomic<bool> cancelled;
+  std::atomic<int> error;
+};
+
+/*
+ * Work-stealing thread pool shared by every operator of the engine. Thread 0 is
+ * the thread running the statement, threads 1 .. numWorkers are workers. Every
+ * thread pushes the tasks it queues to the back of its own deque and takes its
+ * next task from there (so nested tasks run while their data is still cached);
+ * an idle thread steals from the front of the deques of the others. The tasks
+ * of a higher priority are always taken before those of a lower one.
+ *
+ * A thread waiting for a group runs queued tasks meanwhile, so an operator may
+ * queue tasks from within a task, and with no workers at all (a single core) the
+ * tasks simply run on the statement thread.
+ */
+class TaskScheduler {
+  friend class TaskGroup;
+
+ public:
+  TaskScheduler();
+  ~TaskScheduler();
+
+  static int getNumThreads();
+  static void reserve(int numThreads);
+  static void getWorkerStats(std::vector<WorkerStats> *stats);
+
+ private:
+  static void submit(Task task, int priority);
+  static bool runOne();
+  static bool take(int self, Task *task);
+  static void execute(int self, Task &task);
+  static void workerLoop(int self);
+
+  static TaskQueue queues[MAX_SCAN_THREADS];
+  static WorkerCounters counters[MAX_SCAN_THREADS];
+  static std::vector<std::thread> workers;
+  static std::atomic<int> numWorkers;
+  static std::atomic<int> queuedTasks;
+  static std::mutex startLock;
+  static std::mutex sleepLock;
+  static std::condition_variable wakeup;
+  static bool stopping;
+  static std::chrono::steady_clock::time_point startTime;
+};
+
+#endif  // NITCBASE_TASKSCHEDULER_H
@@ -1,13 +1,25 @@
 #include "Schema.h"
 #include <iostream>
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <string.h>
 
 using namespace std;
 
-int Schema::createRel(char relName[], int nAttrs, char attrs[][ATTR_SIZE], int attrtype[])
+/* Creates a relation with the given attributes. attrFormat gives the
+   AttributeFormat each attribute is stored in (FORMAT_DEFAULT for all of them
+   if it is nullptr), columnar whether its record blocks are columnar, and
+   compressed whether they are compressed on the disk (which only a disk of
+   COMPRESSED_BLOCK_VERSION can hold, and only of records that take at most
+   half a block, so that a block of one record always compresses into one). */
+int Schema::createRel(char relName[], int nAttrs, char attrs[][ATTR_SIZE], int attrtype[], int attrFormat[],
+                      bool columnar, bool compressed)
 {
+    if (compressed && Disk::getFormatVersion() < COMPRESSED_BLOCK_VERSION)
+    {
+        return E_NOTPERMITTED;
+    }
 
     // declare variable relNameAsAttribute of type Attribute
     // copy the relName into relNameAsAttribute.sVal
@@ -17,12 +29,11 @@ int Schema::createRel(char relName[], int nAttrs, char attrs[][ATTR_SIZE], int a
     // declare a variable targetRelId of type RecId
     RecId targetRelId;
 
-    // Reset the searchIndex using RelCacheTable::resetSearhIndex()
     // Search the relation catalog (relId given by the constant RELCAT_RELID)
     // for attribute value attribute "RelName" = relNameAsAttribute using
-    // BlockAccess::linearSearch() with OP = EQ
-    RelCacheTable::resetSearchIndex(RELCAT_RELID);
-    targetRelId = BlockAccess::linearSearch(RELCAT_RELID, (char *)RELCAT_ATTR_RELNAME, relNameAsAttribute, EQ);
+    // BlockAccess::linearSearch() with OP = EQ and a new scan cursor
+    ScanCursor relCatCursor;
+    targetRelId = BlockAccess::linearSearch(RELCAT_RELID, (char *)RELCAT_ATTR_RELNAME, relNameAsAttribute, EQ, &relCatCursor);
 
     // if a relation with name `relName` already exists  ( linearSearch() does
     //                                                     not return {-1,-1} )
@@ -56,15 +67,23 @@ int Schema::createRel(char relName[], int nAttrs, char attrs[][ATTR_SIZE], int a
     // offset RELCAT_NO_RECORDS_INDEX: 0
     // offset RELCAT_FIRST_BLOCK_INDEX: -1
     // offset RELCAT_LAST_BLOCK_INDEX: -1
-    // offset RELCAT_NO_SLOTS_PER_BLOCK_INDEX: floor((2016 / (16 * nAttrs + 1)))
-    // (number of slots is calculated as specified in the physical layer docs)
+    // offset RELCAT_NO_SLOTS_PER_BLOCK_INDEX: getSlotsPerBlock(recordSize, compressed)
+    // (as many slots as fit in a block, or the frame of a compressed block,
+    //  with their slot map, one bit per slot, with the size of a record given
+    //  by the formats of its attributes)
+    RecordLayout layout;
+    initRecordLayout(&layout, nAttrs, attrFormat, columnar, compressed);
+    if (compressed && layout.recordSize > Disk::getBlockSize() / 2)
+    {
+        return E_NOTPERMITTED;
+    }
 
     strcpy(relCatRecord[RELCAT_REL_NAME_INDEX].sVal, relName);
     relCatRecord[RELCAT_NO_ATTRIBUTES_INDEX].nVal = nAttrs;
     relCatRecord[RELCAT_NO_RECORDS_INDEX].nVal = 0;
     relCatRecord[RELCAT_FIRST_BLOCK_INDEX].nVal = -1;
     relCatRecord[RELCAT_LAST_BLOCK_INDEX].nVal = -1;
-    relCatRecord[RELCAT_NO_SLOTS_PER_BLOCK_INDEX].nVal = floor((2016 / (16 * nAttrs + 1)));
+    relCatRecord[RELCAT_NO_SLOTS_PER_BLOCK_INDEX].nVal = getSlotsPerBlock(layout.recordSize, compressed);
 
     // retVal = BlockAccess::insert(RELCAT_RELID(=0), relCatRecord);
     // if BlockAccess::insert fails return retVal
@@ -85,14 +104,22 @@ int Schema::createRel(char relName[], int nAttrs, char attrs[][ATTR_SIZE], int a
         // offset ATTRCAT_REL_NAME_INDEX: relName
         // offset ATTRCAT_ATTR_NAME_INDEX: attrNames[i]
         // offset ATTRCAT_ATTR_TYPE_INDEX: attrTypes[i]
-        // offset ATTRCAT_PRIMARY_FLAG_INDEX: -1
+        // offset ATTRCAT_PRIMARY_FLAG_INDEX: attrFormat[i] (the format of the attribute,
+        //                                   plus FORMAT_COLUMNAR for a columnar relation
+        //                                   and FORMAT_COMPRESSED for a compressed one)
         // offset ATTRCAT_ROOT_BLOCK_INDEX: -1
         // offset ATTRCAT_OFFSET_INDEX: i
         Attribute attrCatRecord[ATTRCAT_NO_ATTRS];
         strcpy(attrCatRecord[ATTRCAT_REL_NAME_INDEX].sVal, relName);
         strcpy(attrCatRecord[ATTRCAT_ATTR_NAME_INDEX].sVal, attrs[i]);
         attrCatRecord[ATTRCAT_ATTR_TYPE_INDEX].nVal = attrtype[i];
-        attrCatRecord[ATTRCAT_PRIMARY_FLAG_INDEX].nVal = -1;
+        attrCatRecord[ATTRCAT_PRIMARY_FLAG_INDEX].nVal = layout.formats[i];
+        if (columnar || compressed)
+        {
+            attrCatRecord[ATTRCAT_PRIMARY_FLAG_INDEX].nVal = max((int)layout.formats[i], 0) +
+                                                             (columnar ? FORMAT_COLUMNAR : 0) +
+                                                             (compressed ? FORMAT_COMPRESSED : 0);
+        }
         attrCatRecord[ATTRCAT_ROOT_BLOCK_INDEX].nVal = -1;
         attrCatRecord[ATTRCAT_OFFSET_INDEX].nVal = i;
 
@@ -179,6 +206,26 @@ int Schema::createIndex(char relName[ATTR_SIZE], char attrName[ATTR_SIZE])
     return BPlusTree::bPlusCreate(relId, attrName);
 }
 
+/* Creates B+ trees on several attributes of a relation with a single scan of
+   the relation (see BPlusTree::bPlusCreate()) */
+int Schema::createIndex(char relName[ATTR_SIZE], int numAttrs, char attrNames[][ATTR_SIZE])
+{
+    if (
+        strcmp(relName, (char *)RELCAT_RELNAME) == 0 ||
+        strcmp(relName, (char *)ATTRCAT_RELNAME) == 0)
+    {
+        return E_NOTPERMITTED;
+    }
+
+    int relId = OpenRelTable::getRelId(relName);
+    if (relId == E_RELNOTOPEN)
+    {
+        return E_RELNOTOPEN;
+    }
+
+    return BPlusTree::bPlusCreate(relId, numAttrs, attrNames);
+}
+
 int Schema::dropIndex(char *relName, char *attrName)
 {
     // if the relName is either Relation Catalog or Attribute Catalog,
@@ -2,15 +2,14 @@
 #define NITCBASE_CONSTANTS_H
 
 #define DISK_PATH "../Disk/disk"                           // Path to disk
-#define DISK_RUN_COPY_PATH "../Disk/disk_run_copy"         // Path to run copy of the disk
+#define DISK_WAL_PATH "../Disk/wal"                        // Path to write-ahead log of the disk
+#define DISK_BACKUP_PATH "../Disk/disk_backup"             // Path to copy of the disk kept while the XFS interface upgrades it
 #define Files_Path "../Files/"                             // Path to Files directory
 #define INPUT_FILES_PATH "../Files/Input_Files/"           // Path to Input_Files directory inside the Files directory
 #define OUTPUT_FILES_PATH "../Files/Output_Files/"         // Path to Output_Files directory inside the Files directory
 #define BATCH_FILES_PATH "../Files/Batch_Execution_Files/" // Path to Batch_Execution_Files directory inside the Files directory
 
-#define BLOCK_SIZE 2048            // Size of Block in bytes
 #define ATTR_SIZE 16               // Size of an attribute in bytes
-#define DISK_SIZE 16 * 1024 * 1024 // Size of Disk in bytes
 #define HEADER_SIZE 32             // Size of Header of a block in bytes (not including slotmap)
 #define LCHILD_SIZE 4              // Size of field Lchild in bytes
 #define RCHILD_SIZE 4              // Size of field Rchild in bytes
@@ -19,15 +18,52 @@
 #define SLOTNUM_SIZE 4             // Size of field SlotNum in bytes
 #define INDEX_BLOCK_UNUSED_BYTES 8 // Size of unused field in index block (in bytes)
 #define INTERNAL_ENTRY_SIZE 24     // Size of an Internal Index Entry in the Internal Index Block (in bytes)
-#define LEAF_ENTRY_SIZE 32         // Size of an Leaf Index Entry in the Leaf Index Block (in bytes)
+#define LEAF_ENTRY_SIZE 32         // Size of an Leaf Index Entry in the Leaf Index Block of a disk before PREFIX_LEAF_VERSION
+#define LEAF_RECID_SIZE 6          // Size of the rec-id (4 byte block, 2 byte slot) of a prefix compressed leaf entry
+#define LEAF_PREFIX_INFO_SIZE 2    // Size of the prefix length and key width of a prefix compressed leaf
+
+// The block size, the number of blocks and the blocks of the block allocation map
+// are read from the superblock at runtime (see Disk::getBlockSize() and friends)
+#define SUPERBLOCK 0                       // Disk block number of the superblock
+#define DISK_MAGIC "NITCBASE"              // Magic string at the start of the superblock
+#define DISK_FORMAT_VERSION 5              // Latest on-disk format version (1 is the legacy disk without a superblock)
+#define BITMAP_SLOT_MAP_VERSION 3          // First format version whose record blocks have a bitmap slot map
+#define COMPRESSED_BLOCK_VERSION 4         // First format version that may hold compressed record blocks
+#define PREFIX_LEAF_VERSION 5              // First format version whose leaf index blocks are prefix compressed
+#define MIN_BLOCK_SIZE 2048                // Smallest supported block size in bytes
+#define MAX_BLOCK_SIZE 65536               // Largest supported block size in bytes
+#define LEGACY_BLOCK_SIZE 2048             // Size of Block in bytes on a legacy disk
+#define LEGACY_DISK_BLOCKS 8192            // Number of blocks on a legacy disk
+#define LEGACY_BLOCK_ALLOCATION_MAP_SIZE 4 // Number of blocks given for Block Allocation Map on a legacy disk
+#define DISK_GROW_SIZE (16 * 1024 * 1024) // Number of bytes added to the disk each time it runs out of free blocks
+
+#define WAL_MAGIC "NITCWAL"                    // Magic string at the start of the write-ahead log
+#define WAL_CHECKPOINT_SIZE (64 * 1024 * 1024) // Size of the write-ahead log (in bytes) after which a commit checkpoints
+#define PAGE_LSN_OFFSET 28                     // Offset of the page LSN (HeadInfo.reserved) in record and index blocks
+#define COMMIT_DELAY 10000                     // Default time (in microseconds) a commit in a batch may wait to share an fsync
+#define COMMIT_BATCH_SIZE 64                   // Default maximum number of commits sharing one fsync
 
-#define DISK_BLOCKS 8192            // Number of block in disk
 #define BUFFER_CAPACITY 32          // Total number of blocks available in the Buffer (Capacity of the Buffer in blocks)
+#define COMPRESSED_FRAME_BLOCKS 4   // A buffered record block of a compressed relation holds this many blocks of records
+#define BUFFER_PARTITIONS 8         // Number of partitions of the table mapping blocks to buffers (each has its own lock)
 #define MAX_OPEN 12                 // Maximum number of relations allowed to be open and cached in Cache Layer.
-#define BLOCK_ALLOCATION_MAP_SIZE 4 // Number of blocks given for Block Allocation Map in the disk
-
-#define RELCAT_NO_ATTRS 6  // Number of attributes present in one entry / record of the Relation Catalog
-#define ATTRCAT_NO_ATTRS 6 // Number of attributes present in one entry / record of the Attribute Catalog
+#define RESULT_BUFFER_SIZE 65536    // Size of the buffer used while streaming query results (in bytes)
+#define AGG_MAX_GROUPS 4096         // Maximum number of groups held in memory by hash aggregation
+#define SCAN_MORSEL_BLOCKS 16       // Number of record blocks a parallel scan hands to a thread at a time
+#define MAX_SCAN_THREADS 64         // Maximum number of threads of a parallel scan
+#define JOIN_PARTITION_SIZE (256 * 1024) // Bytes of build side records per hash join partition (kept within the L2 cache)
+#define JOIN_MAX_RADIX_BITS 14      // Hash join partitions are at most 2^JOIN_MAX_RADIX_BITS
+#define LOAD_CHUNK_SIZE (256 * 1024) // Bytes of a csv file parsed by one task of a bulk load
+#define LOAD_ROUND_CHUNKS 16        // Minimum number of chunks a bulk load parses while appending the ones before
+#define STATEMENT_CACHE_SIZE 1024   // Number of parsed statements kept by the statement cache of the frontend
+#define BENCHMARK_PARSE_SECONDS 0.5 // Minimum time BENCHMARK PARSE spends on each way of parsing
+
+#define MAX_ATTRS 125           // Maximum number of attributes of a relation
+#define MAX_STRING_LENGTH 1024  // Maximum length of a string of a VARCHAR attribute
+#define LONG_STRING_PREFIX 8    // Number of bytes of a long string kept inline in its Attribute
+#define LONG_STRING_MARKER 0xFF // Byte after the prefix of a long string (it never occurs in UTF-8 text)
+#define RELCAT_NO_ATTRS 6       // Number of attributes present in one entry / record of the Relation Catalog
+#define ATTRCAT_NO_ATTRS 6      // Number of attributes present in one entry / record of the Attribute Catalog
 
 #define RELCAT_BLOCK 4  // Disk block number for the block of Relation Catalog
 #define ATTRCAT_BLOCK 5 // Disk block number for the first block of Attribute Catalog
@@ -35,6 +71,7 @@
 #define NO_OF_ATTRS_RELCAT_ATTRCAT 6   // Common variable to indicate the number of attributes present in one entry of Relation Catalog / Attribute Catalog
 #define SLOTMAP_SIZE_RELCAT_ATTRCAT 20 // Size of slotmap in both Relation Catalog and Attribute Catalog
 
+// (the slot maps of disks before BITMAP_SLOT_MAP_VERSION have one of these bytes per slot)
 #define SLOT_OCCUPIED '1'   // Value to mark a slot in Slotmap as Occupied
 #define SLOT_UNOCCUPIED '0' // Value to mark a slot in Slotmap as Unoccupied
 
@@ -55,6 +92,31 @@ enum AttributeType
   STRING = 1,
 };
 
+// How an attribute is stored in the records of its relation. It is kept in the
+// PrimaryFlag field of the attribute catalog entry, which was never used as a
+// flag: older disks hold -1 or 1 there, and every value below FORMAT_DOUBLE is
+// read as FORMAT_DEFAULT.
+enum AttributeFormat
+{
+  FORMAT_DEFAULT = -1, // NUMBER or STRING as a union Attribute of ATTR_SIZE bytes
+  FORMAT_DOUBLE = 2,   // NUMBER as an 8 byte double
+  FORMAT_INT32 = 3,    // NUMBER as a 4 byte integer
+  FORMAT_INT64 = 4,    // NUMBER as an 8 byte integer
+  FORMAT_VARCHAR = 5,  // STRING of up to MAX_STRING_LENGTH bytes; longer than ATTR_SIZE - 1 in an overflow block
+  FORMAT_CHAR = 16,    // STRING of at most n < ATTR_SIZE characters in n bytes, as FORMAT_CHAR + n
+};
+
+// Largest magnitude of a FORMAT_INT64 value, 2^53 - 1. A NUMBER is handled as
+// a double, which holds every integer below 2^53 but rounds 2^53 + 1 to 2^53.
+#define MAX_EXACT_INTEGER 9007199254740991.0
+
+// Added to the stored format of every attribute of a relation whose record
+// blocks are columnar (see RecordLayout).
+#define FORMAT_COLUMNAR 1024
+// Added to the stored format of every attribute of a relation whose record
+// blocks are compressed on the disk (see BlockCompression.h).
+#define FORMAT_COMPRESSED 2048
+
 enum ConditionalOperators
 {
   EQ, // =
@@ -65,13 +127,25 @@ enum ConditionalOperators
   NE  // !=
 };
 
+enum AggregateFunction
+{
+  AGG_COUNT,
+  AGG_SUM,
+  AGG_MIN,
+  AGG_MAX,
+  AGG_AVG
+};
+
 enum BlockType
 {
   REC,          // record block
   IND_INTERNAL, // internal index block
   IND_LEAF,     // leaf index block
   UNUSED_BLK,   // unused block
-  BMAP          // block allocation map
+  BMAP,         // block allocation map
+  OVERFLOW_BLK, // overflow block holding the long strings of a record block
+  COMPRESSED_REC // (only in the header of a record block as stored compressed on the disk,
+                 //  the block allocation map and the buffered block say REC)
 };
 
 enum OpenRelationEntryStatus
@@ -97,7 +171,7 @@ enum AttrCatFieldIndex
   ATTRCAT_REL_NAME_INDEX = 0,     // Relation Name
   ATTRCAT_ATTR_NAME_INDEX = 1,    // Attribute Name
   ATTRCAT_ATTR_TYPE_INDEX = 2,    // Attribute Type
-  ATTRCAT_PRIMARY_FLAG_INDEX = 3, // Primary Flag
+  ATTRCAT_PRIMARY_FLAG_INDEX = 3, // Primary Flag (the AttributeFormat of the attribute)
   ATTRCAT_ROOT_BLOCK_INDEX = 4,   // Root Block
   ATTRCAT_OFFSET_INDEX = 5        // Offset
 };
@@ -133,11 +207,9 @@ enum ReturnTypes
 
 #define TEMP ".temp" // Used for internal purposes
 
-// Global variables for B+ Tree Layer
-#define MAX_KEYS_INTERNAL 100    // Maximum number of keys allowed in an Internal Node of a B+ tree
-#define MIDDLE_INDEX_INTERNAL 50 // Index of the middle element in an Internal Node of a B+ tree
-#define MAX_KEYS_LEAF 63         // Maximum number of keys allowed in a Leaf Node of a B+ tree
-#define MIDDLE_INDEX_LEAF 31     // Index of the middle element in a Leaf Node of a B+ tree
+// The fanout of B+ tree nodes depends on the block size, see IndInternal::getMaxKeys()
+// and IndLeaf::getMaxKeys() (100 and 181 keys for 2048 byte blocks, 63 in a leaf of a
+// disk before PREFIX_LEAF_VERSION)
 
 // Name strings for Relation Catalog and Attribute Catalog (as it is stored in the Relation catalog)
 #define RELCAT_RELNAME "RELATIONCAT"
@@ -16,4 +16,13 @@ struct IndexId {
   int index;
 };
 
+/* The position of one scan over a relation. A cursor belongs to the operator
+   running the scan, so any number of scans over a relation can be open at once;
+   a new cursor (or one reset with `cursor = ScanCursor()`) starts at the first
+   record. */
+struct ScanCursor {
+  RecId recId = {-1, -1};      // last record returned by a linear search or project
+  IndexId indexId = {-1, -1};  // last leaf entry returned by a B+ tree search
+};
+
 #endif  // NITCBASE_ID_H
\ No newline at end of file
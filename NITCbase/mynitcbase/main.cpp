@@ -2,6 +2,7 @@
 #include "Cache/OpenRelTable.h"
 #include "Disk_Class/Disk.h"
 #include "FrontendInterface/FrontendInterface.h"
+#include "Scheduler/TaskScheduler.h"
 #include <iostream>
 #include <stdlib.h>
 #include <vector>
@@ -10,6 +11,7 @@
 using namespace std;
 int main(int argc, char *argv[])
 {
+  TaskScheduler scheduler;
   Disk disk_run;
   StaticBuffer buffer;
   OpenRelTable cache;